@@ -0,0 +1,42 @@
+# Find the zstd library
+#
+# Defines:
+#   Zstd_FOUND        - True if zstd was found
+#   ZSTD_INCLUDE_DIRS - The zstd include directories
+#   ZSTD_LIBRARIES    - The libraries needed to use zstd
+#   Zstd_lib          - Imported target
+include(FindPackageHandleStandardArgs)
+
+if(APPLE)
+    execute_process(
+        COMMAND brew --prefix zstd
+        OUTPUT_VARIABLE HOMEBREW_ZSTD_PREFIX
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        ERROR_QUIET
+    )
+    if(HOMEBREW_ZSTD_PREFIX)
+        list(APPEND CMAKE_PREFIX_PATH ${HOMEBREW_ZSTD_PREFIX})
+    endif()
+endif()
+
+find_path(ZSTD_INCLUDE_DIR "zstd.h")
+find_library(ZSTD_LIBRARY NAMES zstd zstd_static)
+
+find_package_handle_standard_args(Zstd
+                                  REQUIRED_VARS
+                                  ZSTD_LIBRARY
+                                  ZSTD_INCLUDE_DIR
+                                  FAIL_MESSAGE
+                                  "Could NOT find ZSTD")
+
+set(ZSTD_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+set(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+
+if(Zstd_FOUND)
+  add_library(Zstd_lib INTERFACE IMPORTED)
+  set_target_properties(Zstd_lib
+                        PROPERTIES INTERFACE_INCLUDE_DIRECTORIES
+                                   "${ZSTD_INCLUDE_DIRS}"
+                                   INTERFACE_LINK_LIBRARIES
+                                   "${ZSTD_LIBRARIES}")
+endif(Zstd_FOUND)
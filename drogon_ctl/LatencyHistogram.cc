@@ -0,0 +1,113 @@
+/**
+ *
+ *  LatencyHistogram.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace drogon_ctl;
+
+namespace
+{
+// 2^7 sub-buckets in the upper half of each bucket
+constexpr int kSubBucketHalfCountMagnitude{7};
+constexpr uint64_t kSubBucketHalfCount{1ULL << kSubBucketHalfCountMagnitude};
+constexpr uint64_t kSubBucketMask{(kSubBucketHalfCount << 1) - 1};
+
+int highestBit(uint64_t value)
+{
+    int bit = 63;
+    while (!(value >> bit))
+    {
+        --bit;
+    }
+    return bit;
+}
+}  // namespace
+
+LatencyHistogram::LatencyHistogram(uint64_t highestValue)
+    : highestValue_(std::max(highestValue, kSubBucketMask))
+{
+    counts_.resize(countsIndex(highestValue_) + 1);
+}
+
+size_t LatencyHistogram::countsIndex(uint64_t value) const
+{
+    // Values below 256 are counted exactly, the others in the bucket of
+    // their highest bit, by their 8 highest bits
+    auto bucketIndex =
+        highestBit(value | kSubBucketMask) - kSubBucketHalfCountMagnitude;
+    auto subBucketIndex = value >> bucketIndex;
+    return (static_cast<size_t>(bucketIndex + 1)
+            << kSubBucketHalfCountMagnitude) +
+           static_cast<size_t>(subBucketIndex - kSubBucketHalfCount);
+}
+
+uint64_t LatencyHistogram::highestValueAt(size_t index) const
+{
+    auto bucketIndex =
+        static_cast<int>(index >> kSubBucketHalfCountMagnitude) - 1;
+    auto subBucketIndex =
+        (index & (kSubBucketHalfCount - 1)) + kSubBucketHalfCount;
+    if (bucketIndex < 0)
+    {
+        subBucketIndex -= kSubBucketHalfCount;
+        bucketIndex = 0;
+    }
+    return (static_cast<uint64_t>(subBucketIndex) << bucketIndex) +
+           (1ULL << bucketIndex) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    value = std::min(value, highestValue_);
+    ++counts_[countsIndex(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += static_cast<double>(value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    auto size = std::min(counts_.size(), other.counts_.size());
+    for (size_t i = 0; i < size; ++i)
+    {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const
+{
+    if (count_ == 0)
+    {
+        return 0;
+    }
+    auto target = static_cast<uint64_t>(
+        std::ceil(std::min(percentile, 100.0) / 100.0 * count_));
+    target = std::max<uint64_t>(target, 1);
+    uint64_t total = 0;
+    for (size_t i = 0; i < counts_.size(); ++i)
+    {
+        total += counts_[i];
+        if (total >= target)
+        {
+            return std::min(highestValueAt(i), max_);
+        }
+    }
+    return max_;
+}
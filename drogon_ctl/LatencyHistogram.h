@@ -0,0 +1,74 @@
+/**
+ *
+ *  LatencyHistogram.h
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by the MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace drogon_ctl
+{
+/**
+ * @brief A histogram with the layout of HdrHistogram: the values are
+ * counted in buckets of powers of two, each one split in 128 linear
+ * sub-buckets. The percentiles are accurate to 1% of their values whatever
+ * their magnitude, with a fixed memory footprint (26KB up to one hour in
+ * microseconds).
+ */
+class LatencyHistogram
+{
+  public:
+    /// Larger values are counted as highestValue
+    explicit LatencyHistogram(uint64_t highestValue = 3600ULL * 1000 * 1000);
+
+    void record(uint64_t value);
+    void merge(const LatencyHistogram &other);
+
+    /// The value below which the percentage of the values fall, with
+    /// percentile in [0, 100]
+    uint64_t percentile(double percentile) const;
+
+    uint64_t count() const
+    {
+        return count_;
+    }
+
+    uint64_t min() const
+    {
+        return count_ ? min_ : 0;
+    }
+
+    uint64_t max() const
+    {
+        return max_;
+    }
+
+    double mean() const
+    {
+        return count_ ? sum_ / count_ : 0;
+    }
+
+  private:
+    size_t countsIndex(uint64_t value) const;
+    // The highest value counted at the index
+    uint64_t highestValueAt(size_t index) const;
+
+    const uint64_t highestValue_;
+    std::vector<uint64_t> counts_;
+    uint64_t count_{0};
+    uint64_t min_{UINT64_MAX};
+    uint64_t max_{0};
+    double sum_{0};
+};
+}  // namespace drogon_ctl
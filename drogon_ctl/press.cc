@@ -15,14 +15,16 @@
 #include "press.h"
 #include "cmd.h"
 #include <drogon/DrClassMap.h>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <iomanip>
 #include <cstdlib>
-#include <json/json.h>
+#include <future>
 #include <fstream>
 #include <string>
-#include <unordered_map>
+#include <thread>
 #ifndef _WIN32
 #include <unistd.h>
 #endif
@@ -33,14 +35,34 @@ std::string press::detail()
 {
     return "Use press command to do stress testing\n"
            "Usage:drogon_ctl press <options> <url>\n"
-           "  -n num    number of requests(default : 1)\n"
+           "  -n num    number of requests(default : 1 without -d)\n"
+           "  -d sec    duration of the test in seconds(default : "
+           "disenable)\n"
            "  -t num    number of threads(default : 1)\n"
            "  -c num    concurrent connections(default : 1)\n"
+           "  -p num    requests in flight on each connection, pipelined "
+           "when\n"
+           "            greater than 1(default : 1)\n"
+           "  -r num    send num requests per second whatever the response "
+           "time,\n"
+           "            latencies are measured from the time each request "
+           "should\n"
+           "            have been sent(default: disenable, send the next "
+           "request\n"
+           "            when a response is received)\n"
+           "  --sweep c1,c2,...\n"
+           "            run the test once for each number of connections\n"
            "  -k        disable SSL certificate validation(default: enable)\n"
            "  -f        customize http request json file(default: disenable)\n"
+           "            the file contains a request or an array of requests\n"
+           "            sent at random in proportion to their \"weight\"\n"
+           "  -o file   write the results in the json file(default: "
+           "disenable)\n"
            "  -q        no progress indication(default: show)\n\n"
            "example: drogon_ctl press -n 10000 -c 100 -t 4 -q "
-           "http://localhost:8080/index.html -f ./http_request.json\n";
+           "http://localhost:8080/index.html -f ./http_request.json\n"
+           "         drogon_ctl press -d 30 -r 20000 -c 100 -t 4 "
+           "--sweep 10,100,1000 -o report.json http://localhost:8080/\n";
 }
 
 void outputErrorAndExit(const std::string_view &err)
@@ -49,135 +71,212 @@ void outputErrorAndExit(const std::string_view &err)
     exit(1);
 }
 
-void press::handleCommand(std::vector<std::string> &parameters)
+// The value of an option given as "-x value" or "-xvalue"
+static std::string optionValue(std::vector<std::string>::iterator &iter,
+                               const std::vector<std::string>::iterator &end,
+                               size_t optionLength,
+                               const std::string_view &err)
 {
-    for (auto iter = parameters.begin(); iter != parameters.end(); iter++)
+    if (iter->length() > optionLength)
     {
-        auto &param = *iter;
-        if (param.find("-n") == 0)
+        return iter->substr(optionLength);
+    }
+    ++iter;
+    if (iter == end)
+    {
+        outputErrorAndExit(err);
+    }
+    return *iter;
+}
+
+static double positiveNumber(const std::string &num,
+                             const std::string_view &err)
+{
+    double value = 0;
+    try
+    {
+        value = std::stod(num);
+    }
+    catch (...)
+    {
+        outputErrorAndExit(err);
+    }
+    if (!(value > 0))
+    {
+        outputErrorAndExit(err);
+    }
+    return value;
+}
+
+static drogon::HttpMethod toHttpMethod(std::string methodStr)
+{
+    std::transform(methodStr.begin(),
+                   methodStr.end(),
+                   methodStr.begin(),
+                   ::toupper);
+    if (methodStr == "GET")
+    {
+        return drogon::HttpMethod::Get;
+    }
+    else if (methodStr == "POST")
+    {
+        return drogon::HttpMethod::Post;
+    }
+    else if (methodStr == "HEAD")
+    {
+        return drogon::HttpMethod::Head;
+    }
+    else if (methodStr == "PUT")
+    {
+        return drogon::HttpMethod::Put;
+    }
+    else if (methodStr == "DELETE")
+    {
+        return drogon::HttpMethod::Delete;
+    }
+    else if (methodStr == "OPTIONS")
+    {
+        return drogon::HttpMethod::Options;
+    }
+    else if (methodStr == "PATCH")
+    {
+        return drogon::HttpMethod::Patch;
+    }
+    else
+    {
+        outputErrorAndExit("invalid method");
+    }
+    return drogon::HttpMethod::Get;
+}
+
+static RequestTemplate parseRequestTemplate(const Json::Value &json,
+                                            const std::string &defaultPath)
+{
+    if (!json.isObject() || !json.isMember("method"))
+    {
+        outputErrorAndExit("No contain method");
+    }
+    RequestTemplate request;
+    request.method_ = toHttpMethod(json["method"].asString());
+    request.path_ = json.get("path", defaultPath).asString();
+    if (json.isMember("header"))
+    {
+        auto &jsonValue = json["header"];
+        for (const auto &key : jsonValue.getMemberNames())
         {
-            if (param == "-n")
+            if (jsonValue[key].isString())
             {
-                ++iter;
-                if (iter == parameters.end())
-                {
-                    outputErrorAndExit("No number of requests!");
-                }
-                auto &num = *iter;
-                try
-                {
-                    numOfRequests_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of requests!");
-                }
-                continue;
+                request.headers_.emplace_back(key, jsonValue[key].asString());
             }
             else
             {
-                auto num = param.substr(2);
-                try
-                {
-                    numOfRequests_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of requests!");
-                }
-                continue;
+                request.headers_.emplace_back(key,
+                                              jsonValue[key].toStyledString());
             }
         }
-        else if (param.find("-t") == 0)
+    }
+    if (json.isMember("body"))
+    {
+        if (json["body"].isString())
         {
-            if (param == "-t")
-            {
-                ++iter;
-                if (iter == parameters.end())
-                {
-                    outputErrorAndExit("No number of threads!");
-                }
-                auto &num = *iter;
-                try
-                {
-                    numOfThreads_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of threads!");
-                }
-                continue;
-            }
-            else
+            request.body_ = json["body"].asString();
+        }
+        else
+        {
+            Json::FastWriter fastWriter;
+            request.body_ = fastWriter.write(json["body"]);
+        }
+    }
+    if (json.isMember("weight"))
+    {
+        if (!json["weight"].isIntegral() || json["weight"].asInt() <= 0)
+        {
+            outputErrorAndExit("Invalid weight");
+        }
+        request.weight_ = json["weight"].asUInt();
+    }
+    return request;
+}
+
+void press::handleCommand(std::vector<std::string> &parameters)
+{
+    for (auto iter = parameters.begin(); iter != parameters.end(); iter++)
+    {
+        auto &param = *iter;
+        if (param == "--sweep")
+        {
+            auto list = optionValue(iter,
+                                    parameters.end(),
+                                    param.length(),
+                                    "No numbers of connections!");
+            for (auto &num : utils::splitString(list, ","))
             {
-                auto num = param.substr(2);
-                try
-                {
-                    numOfThreads_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of threads!");
-                }
-                continue;
+                connectionSweep_.push_back(static_cast<size_t>(
+                    positiveNumber(num, "Invalid numbers of connections!")));
             }
         }
+        else if (param.find("-n") == 0)
+        {
+            auto num = optionValue(iter,
+                                   parameters.end(),
+                                   2,
+                                   "No number of requests!");
+            numOfRequests_ = static_cast<size_t>(
+                positiveNumber(num, "Invalid number of requests!"));
+        }
+        else if (param.find("-t") == 0)
+        {
+            auto num = optionValue(iter,
+                                   parameters.end(),
+                                   2,
+                                   "No number of threads!");
+            numOfThreads_ = static_cast<size_t>(
+                positiveNumber(num, "Invalid number of threads!"));
+        }
         else if (param.find("-c") == 0)
         {
-            if (param == "-c")
-            {
-                ++iter;
-                if (iter == parameters.end())
-                {
-                    outputErrorAndExit("No number of connections!");
-                }
-                auto &num = *iter;
-                try
-                {
-                    numOfConnections_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of connections!");
-                }
-                continue;
-            }
-            else
-            {
-                auto num = param.substr(2);
-                try
-                {
-                    numOfConnections_ = std::stoll(num);
-                }
-                catch (...)
-                {
-                    outputErrorAndExit("Invalid number of connections!");
-                }
-                continue;
-            }
+            auto num = optionValue(iter,
+                                   parameters.end(),
+                                   2,
+                                   "No number of connections!");
+            numOfConnections_ = static_cast<size_t>(
+                positiveNumber(num, "Invalid number of connections!"));
+        }
+        else if (param.find("-p") == 0)
+        {
+            auto num = optionValue(iter,
+                                   parameters.end(),
+                                   2,
+                                   "No pipelining depth!");
+            pipeliningDepth_ = static_cast<size_t>(
+                positiveNumber(num, "Invalid pipelining depth!"));
+        }
+        else if (param.find("-r") == 0)
+        {
+            auto num =
+                optionValue(iter, parameters.end(), 2, "No request rate!");
+            requestRate_ = positiveNumber(num, "Invalid request rate!");
+        }
+        else if (param.find("-d") == 0)
+        {
+            auto num = optionValue(iter, parameters.end(), 2, "No duration!");
+            duration_ = positiveNumber(num, "Invalid duration!");
         }
         else if (param.find("-f") == 0)
         {
-            if (param == "-f")
-            {
-                ++iter;
-                if (iter == parameters.end())
-                {
-                    outputErrorAndExit("No http request json file!");
-                }
-                httpRequestJsonFile_ = *iter;
-                continue;
-            }
-            else
-            {
-                httpRequestJsonFile_ = param.substr(2);
-                continue;
-            }
+            httpRequestJsonFile_ = optionValue(iter,
+                                               parameters.end(),
+                                               2,
+                                               "No http request json file!");
+        }
+        else if (param.find("-o") == 0)
+        {
+            reportFile_ =
+                optionValue(iter, parameters.end(), 2, "No report file!");
         }
         else if (param == "-k")
         {
             certValidation_ = false;
-            continue;
         }
         else if (param == "-q")
         {
@@ -188,11 +287,10 @@ void press::handleCommand(std::vector<std::string> &parameters)
             url_ = param;
         }
     }
-    // std::cout << "n=" << numOfRequests_ << std::endl;
-    // std::cout << "t=" << numOfThreads_ << std::endl;
-    // std::cout << "c=" << numOfConnections_ << std::endl;
-    // std::cout << "q=" << processIndication_ << std::endl;
-    // std::cout << "url=" << url_ << std::endl;
+    if (numOfRequests_ == 0 && duration_ == 0)
+    {
+        numOfRequests_ = 1;
+    }
     if (url_.empty() || url_.compare(0, 4, "http") != 0 ||
         (url_.compare(4, 3, "://") != 0 && url_.compare(4, 4, "s://") != 0))
     {
@@ -213,7 +311,12 @@ void press::handleCommand(std::vector<std::string> &parameters)
             path_ = url_.substr(posOfPath);
         }
     }
+    loadRequestTemplates();
+    doTesting();
+}
 
+void press::loadRequestTemplates()
+{
     /*
     http_request.json
     {
@@ -226,8 +329,19 @@ void press::handleCommand(std::vector<std::string> &parameters)
             "account": "10001"
         }
     }
+    or a mix of requests, the path of the URL is used when they have none:
+    [
+        {"method": "GET", "path": "/items", "weight": 9},
+        {"method": "POST", "path": "/items", "body": "{}", "weight": 1}
+    ]
     */
-    if (!httpRequestJsonFile_.empty())
+    if (httpRequestJsonFile_.empty())
+    {
+        RequestTemplate request;
+        request.path_ = path_;
+        requestTemplates_.push_back(std::move(request));
+    }
+    else
     {
         Json::Value httpRequestJson;
         std::ifstream httpRequestFile(httpRequestJsonFile_,
@@ -237,238 +351,437 @@ void press::handleCommand(std::vector<std::string> &parameters)
             outputErrorAndExit(std::string{"No "} + httpRequestJsonFile_);
         }
         httpRequestFile >> httpRequestJson;
-
-        if (!httpRequestJson.isMember("method"))
+        if (httpRequestJson.isArray())
         {
-            outputErrorAndExit("No contain method");
-        }
-
-        auto methodStr = httpRequestJson["method"].asString();
-        std::transform(methodStr.begin(),
-                       methodStr.end(),
-                       methodStr.begin(),
-                       ::toupper);
-
-        auto toHttpMethod = [&]() -> drogon::HttpMethod {
-            if (methodStr == "GET")
-            {
-                return drogon::HttpMethod::Get;
-            }
-            else if (methodStr == "POST")
-            {
-                return drogon::HttpMethod::Post;
-            }
-            else if (methodStr == "HEAD")
-            {
-                return drogon::HttpMethod::Head;
-            }
-            else if (methodStr == "PUT")
-            {
-                return drogon::HttpMethod::Put;
-            }
-            else if (methodStr == "DELETE")
-            {
-                return drogon::HttpMethod::Delete;
-            }
-            else if (methodStr == "OPTIONS")
-            {
-                return drogon::HttpMethod::Options;
-            }
-            else if (methodStr == "PATCH")
-            {
-                return drogon::HttpMethod::Patch;
-            }
-            else
+            for (auto &request : httpRequestJson)
             {
-                outputErrorAndExit("invalid method");
+                requestTemplates_.push_back(
+                    parseRequestTemplate(request, path_));
             }
-            return drogon::HttpMethod::Get;
-        };
-
-        std::unordered_map<std::string, std::string> header;
-        if (httpRequestJson.isMember("header"))
-        {
-            auto &jsonValue = httpRequestJson["header"];
-            for (const auto &key : jsonValue.getMemberNames())
+            if (requestTemplates_.empty())
             {
-                if (jsonValue[key].isString())
-                {
-                    header[key] = jsonValue[key].asString();
-                }
-                else
-                {
-                    header[key] = jsonValue[key].toStyledString();
-                }
+                outputErrorAndExit("No request");
             }
         }
-
-        std::string body;
-        if (httpRequestJson.isMember("body"))
+        else
         {
-            Json::FastWriter fastWriter;
-            body = fastWriter.write(httpRequestJson["body"]);
+            requestTemplates_.push_back(
+                parseRequestTemplate(httpRequestJson, path_));
         }
-
-        createHttpRequestFunc_ = [this,
-                                  method = toHttpMethod(),
-                                  body = std::move(body),
-                                  header =
-                                      std::move(header)]() -> HttpRequestPtr {
-            auto request = HttpRequest::newHttpRequest();
-            request->setPath(path_);
-            request->setMethod(method);
-            for (const auto &[field, val] : header)
-                request->addHeader(field, val);
-            if (!body.empty())
-                request->setBody(body);
-            return request;
-        };
     }
-
-    // std::cout << "host=" << host_ << std::endl;
-    // std::cout << "path=" << path_ << std::endl;
-    doTesting();
+    for (auto &request : requestTemplates_)
+    {
+        totalWeight_ += request.weight_;
+    }
 }
 
 void press::doTesting()
 {
-    createRequestAndClients();
-    if (clients_.empty())
+    loopPool_ = std::make_unique<trantor::EventLoopThreadPool>(numOfThreads_);
+    loopPool_->start();
+
+    Json::Value report;
+    report["url"] = url_;
+    report["threads"] = static_cast<Json::UInt64>(numOfThreads_);
+    report["pipelining"] = static_cast<Json::UInt64>(pipeliningDepth_);
+    report["mode"] = requestRate_ > 0 ? "constant_rate" : "closed";
+    if (requestRate_ > 0)
+    {
+        report["rate"] = requestRate_;
+    }
+    if (numOfRequests_ > 0)
+    {
+        report["requests"] = static_cast<Json::UInt64>(numOfRequests_);
+    }
+    if (duration_ > 0)
+    {
+        report["duration"] = duration_;
+    }
+    report["runs"] = Json::arrayValue;
+    if (connectionSweep_.empty())
+    {
+        connectionSweep_.push_back(numOfConnections_);
+    }
+    for (auto numOfConnections : connectionSweep_)
+    {
+        report["runs"].append(runTest(numOfConnections));
+    }
+
+    if (!reportFile_.empty())
     {
-        outputErrorAndExit("No connection!");
+        std::ofstream reportFile(reportFile_);
+        if (!reportFile.is_open())
+        {
+            outputErrorAndExit(std::string{"Can't open "} + reportFile_);
+        }
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "  ";
+        std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+        writer->write(report, &reportFile);
+        reportFile << std::endl;
     }
+    exit(0);
+}
+
+Json::Value press::runTest(size_t numOfConnections)
+{
+    statistics_.numOfRequestsSent_ = 0;
+    statistics_.numOfGoodResponse_ = 0;
+    statistics_.numOfBadResponse_ = 0;
+    statistics_.numOfRequestsInFlight_ = 0;
+    statistics_.stopped_ = false;
+    createWorkersAndClients(numOfConnections);
     statistics_.startDate_ = trantor::Date::now();
-    for (auto &client : clients_)
+    for (auto &worker : workers_)
     {
-        sendRequest(client);
+        worker->loop_->runInLoop(
+            [this, worker = worker.get()]() { startWorker(worker); });
     }
-    loopPool_->wait();
+    waitForCompletion();
+    return collectResults(numOfConnections);
 }
 
-void press::createRequestAndClients()
+void press::createWorkersAndClients(size_t numOfConnections)
 {
-    loopPool_ = std::make_unique<trantor::EventLoopThreadPool>(numOfThreads_);
-    loopPool_->start();
-    for (size_t i = 0; i < numOfConnections_; ++i)
+    workers_.clear();
+    auto loops = loopPool_->getLoops();
+    for (size_t i = 0; i < loops.size(); ++i)
     {
+        auto worker = std::make_shared<Worker>();
+        worker->loop_ = loops[i];
+        worker->random_.seed(static_cast<std::mt19937::result_type>(i));
+        workers_.push_back(std::move(worker));
+    }
+    for (size_t i = 0; i < numOfConnections; ++i)
+    {
+        auto &worker = workers_[i % workers_.size()];
         auto client = HttpClient::newHttpClient(host_,
-                                                loopPool_->getNextLoop(),
+                                                worker->loop_,
                                                 false,
                                                 certValidation_);
         client->enableCookies();
-        clients_.push_back(client);
+        if (pipeliningDepth_ > 1)
+        {
+            client->setPipeliningDepth(pipeliningDepth_);
+        }
+        worker->clients_.push_back(client);
+    }
+    if (requestRate_ > 0)
+    {
+        // The rate is shared by the loops with connections
+        auto numOfWorkers = std::min(numOfConnections, workers_.size());
+        for (auto &worker : workers_)
+        {
+            worker->rate_ = requestRate_ / numOfWorkers;
+        }
     }
 }
 
-void press::sendRequest(const HttpClientPtr &client)
+void press::startWorker(Worker *worker)
 {
-    auto numOfRequest = statistics_.numOfRequestsSent_++;
-    if (numOfRequest >= numOfRequests_)
+    if (worker->clients_.empty())
     {
         return;
     }
+    if (requestRate_ > 0)
+    {
+        worker->timerId_ = worker->loop_->runEvery(
+            0.001, [this, worker]() { sendScheduledRequests(worker); });
+        return;
+    }
+    auto now = trantor::Date::now();
+    for (auto &client : worker->clients_)
+    {
+        for (size_t i = 0; i < pipeliningDepth_; ++i)
+        {
+            sendRequest(worker, client, now);
+        }
+    }
+}
 
-    HttpRequestPtr request;
-    if (createHttpRequestFunc_)
+void press::sendScheduledRequests(Worker *worker)
+{
+    auto elapsed = trantor::Date::now().microSecondsSinceEpoch() -
+                   statistics_.startDate_.microSecondsSinceEpoch();
+    auto numOfRequestsDue =
+        static_cast<size_t>(elapsed / 1000000.0 * worker->rate_);
+    while (worker->numOfRequestsScheduled_ < numOfRequestsDue &&
+           !statistics_.stopped_)
     {
-        request = createHttpRequestFunc_();
+        // Each request is timed from when it should have been sent, so the
+        // requests delayed by a slow server count its slowness (coordinated
+        // omission)
+        auto intendedDate = statistics_.startDate_.after(
+            worker->numOfRequestsScheduled_ / worker->rate_);
+        auto &client =
+            worker->clients_[worker->nextClient_++ % worker->clients_.size()];
+        ++worker->numOfRequestsScheduled_;
+        sendRequest(worker, client, intendedDate);
     }
-    else
+}
+
+HttpRequestPtr press::newRequest(Worker *worker)
+{
+    const RequestTemplate *requestTemplate = &requestTemplates_[0];
+    if (requestTemplates_.size() > 1)
+    {
+        std::uniform_int_distribution<unsigned int> distribution(
+            0, totalWeight_ - 1);
+        auto n = distribution(worker->random_);
+        for (auto &request : requestTemplates_)
+        {
+            if (n < request.weight_)
+            {
+                requestTemplate = &request;
+                break;
+            }
+            n -= request.weight_;
+        }
+    }
+    auto request = HttpRequest::newHttpRequest();
+    request->setPath(requestTemplate->path_);
+    request->setMethod(requestTemplate->method_);
+    for (const auto &[field, val] : requestTemplate->headers_)
+        request->addHeader(field, val);
+    if (!requestTemplate->body_.empty())
+        request->setBody(requestTemplate->body_);
+    return request;
+}
+
+void press::sendRequest(Worker *worker,
+                        const HttpClientPtr &client,
+                        const trantor::Date &intendedDate)
+{
+    // Counted before checking stopped_ so that the main thread can't miss
+    // a request sent while it stops the test
+    ++statistics_.numOfRequestsInFlight_;
+    if (statistics_.stopped_ ||
+        (numOfRequests_ > 0 &&
+         statistics_.numOfRequestsSent_++ >= numOfRequests_))
     {
-        request = HttpRequest::newHttpRequest();
-        request->setPath(path_);
-        request->setMethod(Get);
+        --statistics_.numOfRequestsInFlight_;
+        return;
     }
 
-    // std::cout << "send!" << std::endl;
     client->sendRequest(
-        request,
-        [this, client, request](ReqResult r, const HttpResponsePtr &resp) {
-            size_t goodNum, badNum;
+        newRequest(worker),
+        [this, worker, client, intendedDate](ReqResult r,
+                                             const HttpResponsePtr &resp) {
+            auto now = trantor::Date::now();
+            auto second = static_cast<size_t>(
+                (now.microSecondsSinceEpoch() -
+                 statistics_.startDate_.microSecondsSinceEpoch()) /
+                1000000);
+            if (worker->timeSeries_.size() <= second)
+            {
+                worker->timeSeries_.resize(second + 1);
+            }
+            auto &slot = worker->timeSeries_[second];
             if (r == ReqResult::Ok)
             {
-                // std::cout << "OK" << std::endl;
-                goodNum = ++statistics_.numOfGoodResponse_;
-                badNum = statistics_.numOfBadResponse_;
-                statistics_.bytesRecieved_ += resp->body().length();
-                auto delay = trantor::Date::now().microSecondsSinceEpoch() -
-                             request->creationDate().microSecondsSinceEpoch();
-                statistics_.totalDelay_ += delay;
+                auto latency = static_cast<uint64_t>(
+                    (std::max)(now.microSecondsSinceEpoch() -
+                                   intendedDate.microSecondsSinceEpoch(),
+                               static_cast<int64_t>(0)));
+                ++worker->numOfGoodResponse_;
+                worker->bytesRecieved_ += resp->body().length();
+                worker->histogram_.record(latency);
+                ++slot.completed_;
+                slot.latencySum_ += latency;
+                slot.latencyMax_ = (std::max)(slot.latencyMax_, latency);
+                ++statistics_.numOfGoodResponse_;
             }
             else
             {
-                goodNum = statistics_.numOfGoodResponse_;
-                badNum = ++statistics_.numOfBadResponse_;
-                if (badNum > numOfRequests_ / 10)
+                ++worker->numOfBadResponse_;
+                ++slot.errors_;
+                auto badNum = ++statistics_.numOfBadResponse_;
+                if (numOfRequests_ > 0 && badNum > numOfRequests_ / 10)
                 {
                     outputErrorAndExit("Too many errors");
                 }
             }
-            if (goodNum + badNum >= numOfRequests_)
+            --statistics_.numOfRequestsInFlight_;
+            if (requestRate_ > 0)
             {
-                outputResults();
+                return;
             }
             if (r == ReqResult::Ok)
-                sendRequest(client);
+            {
+                sendRequest(worker, client, now);
+            }
             else
             {
-                client->getLoop()->runAfter(1, [this, client]() {
-                    sendRequest(client);
+                // The worker is gone if the retry fires after the test
+                std::weak_ptr<Worker> weakWorker = worker->weak_from_this();
+                client->getLoop()->runAfter(1, [this, weakWorker, client]() {
+                    if (auto worker = weakWorker.lock())
+                    {
+                        sendRequest(worker.get(),
+                                    client,
+                                    trantor::Date::now());
+                    }
                 });
             }
+        });
+}
 
-            if (processIndication_)
+void press::waitForCompletion()
+{
+    size_t lastSecond = 0;
+    size_t lastGood = 0;
+    size_t lastBad = 0;
+    while (true)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        auto elapsed = trantor::Date::now().microSecondsSinceEpoch() -
+                       statistics_.startDate_.microSecondsSinceEpoch();
+        size_t good = statistics_.numOfGoodResponse_;
+        size_t bad = statistics_.numOfBadResponse_;
+        if (processIndication_ &&
+            static_cast<size_t>(elapsed / 1000000) > lastSecond)
+        {
+            ++lastSecond;
+            std::cout << lastSecond << "s: " << good - lastGood
+                      << " responses, " << bad - lastBad << " errors"
+                      << std::endl;
+            lastGood = good;
+            lastBad = bad;
+        }
+        if ((numOfRequests_ > 0 && good + bad >= numOfRequests_) ||
+            (duration_ > 0 && elapsed >= duration_ * 1000000))
+        {
+            break;
+        }
+    }
+    statistics_.stopped_ = true;
+    // Let the requests in flight complete, for 30 seconds at most
+    for (int i = 0; i < 3000 && statistics_.numOfRequestsInFlight_ > 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    statistics_.endDate_ = trantor::Date::now();
+}
+
+Json::Value press::collectResults(size_t numOfConnections)
+{
+    for (auto &worker : workers_)
+    {
+        std::promise<void> done;
+        auto f = done.get_future();
+        worker->loop_->runInLoop([worker = worker.get(), &done]() {
+            if (worker->timerId_ != trantor::InvalidTimerId)
             {
-                auto rec = goodNum + badNum;
-                if (rec % 100000 == 0)
-                {
-                    std::cout << rec << " responses are received" << std::endl
-                              << std::endl;
-                }
+                worker->loop_->invalidateTimer(worker->timerId_);
+            }
+            for (auto &client : worker->clients_)
+            {
+                worker->bytesSent_ += client->bytesSent();
+                worker->totalRecv_ += client->bytesReceived();
             }
+            worker->clients_.clear();
+            done.set_value();
         });
-}
+        f.get();
+    }
 
-void press::outputResults()
-{
+    LatencyHistogram histogram;
+    std::vector<TimeSlot> timeSeries;
+    size_t numOfGoodResponse = 0;
+    size_t numOfBadResponse = 0;
+    size_t bytesRecieved = 0;
     size_t totalSent = 0;
     size_t totalRecv = 0;
-    for (auto &client : clients_)
+    for (auto &worker : workers_)
     {
-        totalSent += client->bytesSent();
-        totalRecv += client->bytesReceived();
+        histogram.merge(worker->histogram_);
+        if (timeSeries.size() < worker->timeSeries_.size())
+        {
+            timeSeries.resize(worker->timeSeries_.size());
+        }
+        for (size_t i = 0; i < worker->timeSeries_.size(); ++i)
+        {
+            auto &slot = worker->timeSeries_[i];
+            timeSeries[i].completed_ += slot.completed_;
+            timeSeries[i].errors_ += slot.errors_;
+            timeSeries[i].latencySum_ += slot.latencySum_;
+            timeSeries[i].latencyMax_ =
+                (std::max)(timeSeries[i].latencyMax_, slot.latencyMax_);
+        }
+        numOfGoodResponse += worker->numOfGoodResponse_;
+        numOfBadResponse += worker->numOfBadResponse_;
+        bytesRecieved += worker->bytesRecieved_;
+        totalSent += worker->bytesSent_;
+        totalRecv += worker->totalRecv_;
     }
-    auto now = trantor::Date::now();
-    auto microSecs = now.microSecondsSinceEpoch() -
+
+    auto microSecs = statistics_.endDate_.microSecondsSinceEpoch() -
                      statistics_.startDate_.microSecondsSinceEpoch();
     double seconds = (double)microSecs / 1000000.0;
-    auto rps = static_cast<size_t>(statistics_.numOfGoodResponse_ / seconds);
+    auto rps = static_cast<size_t>(numOfGoodResponse / seconds);
+    auto goodNum = (std::max)(numOfGoodResponse, static_cast<size_t>(1));
     std::cout << std::endl;
-    std::cout << "TOTALS:   " << numOfConnections_ << " connect, "
-              << numOfRequests_ << " requests, "
-              << statistics_.numOfGoodResponse_ << " success, "
-              << statistics_.numOfBadResponse_ << " fail" << std::endl;
+    std::cout << "TOTALS:   " << numOfConnections << " connect, "
+              << numOfGoodResponse + numOfBadResponse << " requests, "
+              << numOfGoodResponse << " success, " << numOfBadResponse
+              << " fail" << std::endl;
 
-    std::cout << "TRAFFIC:  "
-              << statistics_.bytesRecieved_ / statistics_.numOfGoodResponse_
-              << " avg bytes, "
-              << (totalRecv - statistics_.bytesRecieved_) /
-                     statistics_.numOfGoodResponse_
-              << " avg overhead, " << statistics_.bytesRecieved_ << " bytes, "
-              << totalRecv - statistics_.bytesRecieved_ << " overhead"
-              << std::endl;
+    std::cout << "TRAFFIC:  " << bytesRecieved / goodNum << " avg bytes, "
+              << (totalRecv - bytesRecieved) / goodNum << " avg overhead, "
+              << bytesRecieved << " bytes, " << totalRecv - bytesRecieved
+              << " overhead" << std::endl;
 
     std::cout << std::setiosflags(std::ios::fixed) << std::setprecision(3)
               << "TIMING:   " << seconds << " seconds, " << rps << " rps, "
-              << (double)(statistics_.totalDelay_) /
-                     statistics_.numOfGoodResponse_ / 1000
-              << " ms avg req time" << std::endl;
+              << histogram.mean() / 1000 << " ms avg req time" << std::endl;
+
+    std::cout << "LATENCY:  " << histogram.percentile(50) / 1000.0
+              << " ms p50, " << histogram.percentile(90) / 1000.0
+              << " ms p90, " << histogram.percentile(99) / 1000.0
+              << " ms p99, " << histogram.percentile(99.9) / 1000.0
+              << " ms p99.9, " << histogram.max() / 1000.0 << " ms max"
+              << std::endl;
 
     std::cout << "SPEED:    download " << totalRecv / seconds / 1000
               << " kBps, upload " << totalSent / seconds / 1000 << " kBps"
               << std::endl
               << std::endl;
-    exit(0);
+
+    Json::Value run;
+    run["connections"] = static_cast<Json::UInt64>(numOfConnections);
+    run["success"] = static_cast<Json::UInt64>(numOfGoodResponse);
+    run["fail"] = static_cast<Json::UInt64>(numOfBadResponse);
+    run["seconds"] = seconds;
+    run["rps"] = static_cast<Json::UInt64>(rps);
+    run["bytes"] = static_cast<Json::UInt64>(bytesRecieved);
+    run["overhead_bytes"] =
+        static_cast<Json::UInt64>(totalRecv - bytesRecieved);
+    run["upload_bytes"] = static_cast<Json::UInt64>(totalSent);
+    auto &latency = run["latency_us"];
+    latency["min"] = static_cast<Json::UInt64>(histogram.min());
+    latency["mean"] = histogram.mean();
+    latency["p50"] = static_cast<Json::UInt64>(histogram.percentile(50));
+    latency["p90"] = static_cast<Json::UInt64>(histogram.percentile(90));
+    latency["p99"] = static_cast<Json::UInt64>(histogram.percentile(99));
+    latency["p999"] = static_cast<Json::UInt64>(histogram.percentile(99.9));
+    latency["max"] = static_cast<Json::UInt64>(histogram.max());
+    auto &series = run["timeseries"];
+    series = Json::arrayValue;
+    for (size_t i = 0; i < timeSeries.size(); ++i)
+    {
+        auto &slot = timeSeries[i];
+        Json::Value second;
+        second["second"] = static_cast<Json::UInt64>(i);
+        second["completed"] = static_cast<Json::UInt64>(slot.completed_);
+        second["errors"] = static_cast<Json::UInt64>(slot.errors_);
+        second["mean_latency_us"] =
+            slot.completed_ ? static_cast<double>(slot.latencySum_) /
+                                  slot.completed_
+                            : 0.0;
+        second["max_latency_us"] = static_cast<Json::UInt64>(slot.latencyMax_);
+        series.append(second);
+    }
+    return run;
 }
 
 // See create.cc for rationale.
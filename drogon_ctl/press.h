@@ -15,15 +15,19 @@
 #pragma once
 
 #include "CommandHandler.h"
+#include "LatencyHistogram.h"
 #include <drogon/DrObject.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/HttpClient.h>
+#include <json/json.h>
 #include <trantor/utils/Date.h>
 #include <trantor/net/EventLoopThreadPool.h>
 #include <functional>
 #include <string>
 #include <atomic>
 #include <memory>
+#include <random>
+#include <utility>
 #include <vector>
 
 using namespace drogon;
@@ -33,14 +37,54 @@ namespace drogon_ctl
 struct Statistics
 {
     std::atomic_size_t numOfRequestsSent_{0};
-    std::atomic_size_t bytesRecieved_{0};
     std::atomic_size_t numOfGoodResponse_{0};
     std::atomic_size_t numOfBadResponse_{0};
-    std::atomic_size_t totalDelay_{0};
+    std::atomic_size_t numOfRequestsInFlight_{0};
+    std::atomic_bool stopped_{false};
     trantor::Date startDate_;
     trantor::Date endDate_;
 };
 
+// A request of the mix given by the -f file
+struct RequestTemplate
+{
+    HttpMethod method_{Get};
+    std::string path_;
+    std::vector<std::pair<std::string, std::string>> headers_;
+    std::string body_;
+    unsigned int weight_{1};
+};
+
+// The responses received during one second of the test
+struct TimeSlot
+{
+    size_t completed_{0};
+    size_t errors_{0};
+    uint64_t latencySum_{0};
+    uint64_t latencyMax_{0};
+};
+
+// The clients and the results of one event loop, only accessed in the loop
+// while the test runs
+struct Worker : public std::enable_shared_from_this<Worker>
+{
+    trantor::EventLoop *loop_{nullptr};
+    std::vector<HttpClientPtr> clients_;
+    LatencyHistogram histogram_;
+    std::vector<TimeSlot> timeSeries_;
+    size_t numOfGoodResponse_{0};
+    size_t numOfBadResponse_{0};
+    size_t bytesRecieved_{0};
+    size_t bytesSent_{0};
+    size_t totalRecv_{0};
+    // The requests per second sent by the loop in the constant rate mode
+    double rate_{0};
+    size_t numOfRequestsScheduled_{0};
+    size_t nextClient_{0};
+    trantor::TimerId timerId_{trantor::InvalidTimerId};
+    std::mt19937 random_;
+};
+
 class press : public DrObject<press>, public CommandHandler
 {
   public:
@@ -61,21 +105,35 @@ class press : public DrObject<press>, public CommandHandler
 
   private:
     size_t numOfThreads_{1};
-    size_t numOfRequests_{1};
+    size_t numOfRequests_{0};
     size_t numOfConnections_{1};
+    std::vector<size_t> connectionSweep_;
+    size_t pipeliningDepth_{1};
+    double requestRate_{0};
+    double duration_{0};
     std::string httpRequestJsonFile_;
-    std::function<HttpRequestPtr()> createHttpRequestFunc_;
+    std::string reportFile_;
+    std::vector<RequestTemplate> requestTemplates_;
+    unsigned int totalWeight_{0};
     bool certValidation_{true};
     bool processIndication_{true};
     std::string url_;
     std::string host_;
     std::string path_;
+    void loadRequestTemplates();
     void doTesting();
-    void createRequestAndClients();
-    void sendRequest(const HttpClientPtr &client);
-    void outputResults();
+    Json::Value runTest(size_t numOfConnections);
+    void createWorkersAndClients(size_t numOfConnections);
+    void startWorker(Worker *worker);
+    void sendScheduledRequests(Worker *worker);
+    void sendRequest(Worker *worker,
+                     const HttpClientPtr &client,
+                     const trantor::Date &intendedDate);
+    HttpRequestPtr newRequest(Worker *worker);
+    void waitForCompletion();
+    Json::Value collectResults(size_t numOfConnections);
     std::unique_ptr<trantor::EventLoopThreadPool> loopPool_;
-    std::vector<HttpClientPtr> clients_;
+    std::vector<std::shared_ptr<Worker>> workers_;
     Statistics statistics_;
 };
 }  // namespace drogon_ctl
@@ -38,10 +38,14 @@ void SimpleReverseProxy::initAndStart(const Json::Value &config)
         LOG_ERROR << "invalid number of connection factor";
         abort();
     }
-    clients_.init(
-        [this](std::vector<HttpClientPtr> &clients, size_t ioLoopIndex) {
-            clients.resize(backendAddrs_.size() * connectionFactor_);
-        });
+    for (auto &addr : backendAddrs_)
+    {
+        // The connections of the pools are in the IO loops
+        auto pool =
+            HttpClientPool::newHttpClientPool(addr, 1, connectionFactor_);
+        pool->setPipeliningDepth(pipeliningDepth_);
+        pools_.push_back(std::move(pool));
+    }
     clientIndex_.init(
         [this](size_t &index, size_t ioLoopIndex) { index = ioLoopIndex; });
     drogon::app().registerPreRoutingAdvice([this](const HttpRequestPtr &req,
@@ -60,41 +64,16 @@ void SimpleReverseProxy::preRouting(const HttpRequestPtr &req,
                                     AdviceChainCallback &&)
 {
     size_t index;
-    auto &clientsVector = *clients_;
     if (sameClientToSameBackend_)
     {
         index = std::hash<uint32_t>{}(req->getPeerAddr().ipNetEndian()) %
-                clientsVector.size();
-        index = (index + (++(*clientIndex_)) * backendAddrs_.size()) %
-                clientsVector.size();
+                pools_.size();
     }
     else
     {
-        index = ++(*clientIndex_) % clientsVector.size();
-    }
-    auto &clientPtr = clientsVector[index];
-    if (!clientPtr)
-    {
-        auto &addr = backendAddrs_[index % backendAddrs_.size()];
-        clientPtr = HttpClient::newHttpClient(
-            addr, trantor::EventLoop::getEventLoopOfCurrentThread());
-        clientPtr->setPipeliningDepth(pipeliningDepth_);
+        index = ++(*clientIndex_) % pools_.size();
     }
-    req->setPassThrough(true);
-    clientPtr->sendRequest(
-        req,
-        [callback = std::move(callback)](ReqResult result,
-                                         const HttpResponsePtr &resp) {
-            if (result == ReqResult::Ok)
-            {
-                resp->setPassThrough(true);
-                callback(resp);
-            }
-            else
-            {
-                auto errResp = HttpResponse::newHttpResponse();
-                errResp->setStatusCode(k500InternalServerError);
-                callback(errResp);
-            }
-        });
+    // The response is relayed as it arrives, large bodies are never held
+    // in memory
+    pools_[index]->forwardRequest(req, std::move(callback));
 }
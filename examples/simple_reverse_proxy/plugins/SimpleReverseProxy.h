@@ -29,9 +29,9 @@ class SimpleReverseProxy : public drogon::Plugin<SimpleReverseProxy>
     void shutdown() override;
 
   private:
-    // Create 'connectionFactor_' HTTP clients for every backend in every IO
-    // event loop.
-    drogon::IOThreadStorage<std::vector<drogon::HttpClientPtr>> clients_;
+    // One pool per backend, with up to 'connectionFactor_' connections in
+    // every IO event loop.
+    std::vector<drogon::HttpClientPoolPtr> pools_;
     drogon::IOThreadStorage<size_t> clientIndex_{0};
     std::vector<std::string> backendAddrs_;
     bool sameClientToSameBackend_{false};
@@ -24,6 +24,7 @@
 #include <drogon/HttpFilter.h>
 #include <drogon/MultiPart.h>
 #include <drogon/NotFound.h>
+#include <drogon/WebSocketCompression.h>
 #include <drogon/drogon_callbacks.h>
 #include <drogon/utils/Utilities.h>
 #include <drogon/plugins/Plugin.h>
@@ -1161,6 +1162,87 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// Return true if brotli is enabled.
     virtual bool isBrotliEnabled() const = 0;
 
+    /// Enable zstd compression.
+    /**
+     * @param useZstd if the parameter is true, use zstd to compress the
+     * response body's content when the client accepts it. Brotli is preferred
+     * over zstd and zstd over gzip.
+     * The default value is false.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * It has no effect if drogon is built without zstd.
+     */
+    virtual HttpAppFramework &enableZstd(bool useZstd) = 0;
+
+    /// Return true if zstd is enabled.
+    virtual bool isZstdEnabled() const = 0;
+
+    /// Enable the compression of stream responses.
+    /**
+     * @param enable If true, the responses created by
+     * HttpResponse::newStreamResponse() and
+     * HttpResponse::newAsyncStreamResponse() are compressed on the fly with
+     * the enabled encoding (gzip, brotli or zstd) accepted by the client.
+     * Only text content types are compressed, and not if the response has a
+     * content-length or a content-encoding header.
+     * @param flushSize The compressed data is flushed to the client after
+     * this many bytes of the stream. 0 (the default) flushes after every
+     * ResponseStream::send() call, or every time the data callback of a
+     * stream response returns, so the client gets the data as early as it
+     * would uncompressed. ResponseStream::flush() flushes explicitly.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * The default value is false.
+     */
+    virtual HttpAppFramework &enableStreamCompression(bool enable,
+                                                      size_t flushSize = 0) = 0;
+
+    /// Return true if the compression of stream responses is enabled.
+    virtual bool isStreamCompressionEnabled() const = 0;
+
+    /// Enable HTTP/2.
+    /**
+     * @param enable If true, the HTTPS listeners offer h2 by ALPN and all the
+     * listeners accept HTTP/2 without TLS from clients knowing the server
+     * supports it (h2c with prior knowledge, the Upgrade header is not
+     * supported). HTTP/1.1 clients are served as before.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * The default value is false. It must be called before the app runs.
+     */
+    virtual HttpAppFramework &enableHttp2(bool enable) = 0;
+
+    /// Return true if HTTP/2 is enabled.
+    virtual bool isHttp2Enabled() const = 0;
+
+    /// Enable the cache of compressed response bodies.
+    /**
+     * @param bytes The maximum total size of the cached compressed bodies,
+     * 0 disables the cache. The default value is 0.
+     * @param gzipLevel The gzip level (0-9) of the cached bodies.
+     * @param brotliQuality The brotli quality (0-11) of the cached bodies.
+     * @param zstdLevel The zstd level (1-22) of the cached bodies.
+     * @param threadNum The number of threads compressing the bodies.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * Only the responses marked with HttpResponse::setCacheCompressedBody()
+     * and the static files without a precompressed variant are cached. The
+     * cache is keyed by the content of the bodies, a body is compressed once
+     * in the background and sent uncompressed until it is ready.
+     */
+    virtual HttpAppFramework &enableCompressionCache(size_t bytes,
+                                                     int gzipLevel = 9,
+                                                     int brotliQuality = 11,
+                                                     int zstdLevel = 19,
+                                                     size_t threadNum = 1) = 0;
+
+    /// Return the maximum total size of the cached compressed bodies.
+    virtual size_t compressionCacheSize() const = 0;
+
     /// Set the time in which the static file response is cached in memory.
     /**
      * @param cacheTime in seconds. 0 means always cached, negative means no
@@ -1174,6 +1256,20 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     /// Get the time set by the above method.
     virtual int staticFilesCacheTime() const = 0;
 
+    /// Set the maximum memory used by the static file cache.
+    /**
+     * @param bytes The total size of the cached file contents. The cache is
+     * shared by all IO threads, the least recently used files are evicted
+     * first. 64M by default.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setStaticFilesCacheSize(size_t bytes) = 0;
+
+    /// Get the size set by the above method.
+    virtual size_t staticFilesCacheSize() const = 0;
+
     /// Set the lifetime of the connection without read or write
     /**
      * @param timeout in seconds. 60 by default. Setting the timeout to 0 means
@@ -1604,6 +1700,19 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
 
     virtual HttpAppFramework &enableCompressedRequest(bool enable = true) = 0;
     virtual bool isCompressedRequestEnabled() const = 0;
+
+    /**
+     * @brief Enable the permessage-deflate extension (RFC 7692) on the
+     * WebSocket connections of the clients which offer it.
+     *
+     * @param options The parameters of the compression, which are negotiated
+     * with each client.
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &enableWebSocketCompression(
+        const WebSocketCompressionOptions &options = {}) = 0;
+
     /*
      * @brief get the number of active connections.
      */
@@ -1637,6 +1746,18 @@ class DROGON_EXPORT HttpAppFramework : public trantor::NonCopyable
     virtual HttpAppFramework &enableRequestStream(bool enable = true) = 0;
     virtual bool isRequestStreamEnabled() const = 0;
 
+    /**
+     * @brief Store the request headers in a flat, request-owned buffer.
+     *
+     * @param enable If true, the parser copies header lines into a buffer
+     * that is reused with the request object and looks them up linearly. The
+     * header and cookie maps are only built when HttpRequest::headers(),
+     * getHeader() or the cookie methods are called. This avoids most heap
+     * allocations for small requests. The default value is false.
+     */
+    virtual HttpAppFramework &enableFlatRequestHeaders(bool enable = true) = 0;
+    virtual bool isFlatRequestHeadersEnabled() const = 0;
+
   private:
     virtual void registerHttpController(
         const std::string &pathPattern,
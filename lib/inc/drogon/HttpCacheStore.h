@@ -0,0 +1,93 @@
+/**
+ *
+ *  @file HttpCacheStore.h
+ *  The storage of the HTTP cache of the clients
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpResponse.h>
+#include <trantor/utils/Date.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/// A response stored by the HTTP cache of a client, see
+/// HttpClient::setCacheStore()
+struct HttpCacheEntry
+{
+    /// The response, never given to the users: each request answered with it
+    /// gets a copy
+    HttpResponsePtr response;
+    /// When the response was generated, its age is counted from here
+    trantor::Date date;
+    /// How long the response is fresh, in seconds
+    double freshnessLifetime{0};
+    /// How long the response can be used after that while it is revalidated
+    /// in the background, in seconds
+    double staleWhileRevalidate{0};
+    /// Set if the response must not be used stale
+    bool mustRevalidate{false};
+    /// The names of the request headers listed by the Vary header of the
+    /// response, with their values in the request
+    std::vector<std::pair<std::string, std::string>> vary;
+    /// The approximate memory taken by the entry, in bytes
+    size_t size{0};
+
+    /// The age of the response at the given time, in seconds
+    double age(const trantor::Date &now) const
+    {
+        auto age = static_cast<double>(now.microSecondsSinceEpoch() -
+                                       date.microSecondsSinceEpoch()) /
+                   trantor::Date::MICRO_SECONDS_PER_SEC;
+        return age > 0 ? age : 0;
+    }
+};
+
+using HttpCacheEntryPtr = std::shared_ptr<const HttpCacheEntry>;
+
+/**
+ * @brief Stores the responses cached by the clients, keyed by the origin and
+ * target of the request. Implement this interface to keep the responses
+ * elsewhere than in the memory of the process.
+ *
+ * The methods are called in the event loops of the clients, a store shared
+ * by several clients must be thread safe.
+ */
+class DROGON_EXPORT HttpCacheStore
+{
+  public:
+    /// Return the entry stored for the key, or nullptr
+    virtual HttpCacheEntryPtr get(const std::string &key) = 0;
+
+    /// Store the entry, replacing the one of the key if any
+    virtual void put(const std::string &key,
+                     const HttpCacheEntryPtr &entry) = 0;
+
+    virtual void erase(const std::string &key) = 0;
+
+    virtual ~HttpCacheStore() = default;
+
+    /**
+     * @brief Create a thread safe store in memory. It holds entries up to the
+     * capacity (the sum of their sizes in bytes) and evicts the least
+     * recently used ones beyond it.
+     */
+    static std::shared_ptr<HttpCacheStore> newMemoryStore(
+        size_t capacity = 64 * 1024 * 1024);
+};
+
+using HttpCacheStorePtr = std::shared_ptr<HttpCacheStore>;
+}  // namespace drogon
@@ -17,6 +17,7 @@
 #include <drogon/exports.h>
 #include <drogon/HttpTypes.h>
 #include <drogon/drogon_callbacks.h>
+#include <drogon/HttpCacheStore.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/HttpRequest.h>
 #include <trantor/utils/NonCopyable.h>
@@ -25,6 +26,8 @@
 #include <functional>
 #include <memory>
 #include <future>
+#include <string>
+#include <vector>
 #include "drogon/HttpBinder.h"
 
 #ifdef __cpp_impl_coroutine
@@ -164,6 +167,52 @@ class DROGON_EXPORT HttpClient : public trantor::NonCopyable
     }
 #endif
 
+    /**
+     * @brief Send a request asynchronously to the server and receive the body
+     * of the response as it arrives instead of in the response object, so
+     * that large bodies are never held in memory.
+     *
+     * @param req The request sent to the server.
+     * @param headersCallback The callback is called with the response,
+     * without its body, once its headers are received, or with the error if
+     * the request fails before.
+     * @param dataCallback The callback is called with each piece of the body
+     * as it is received. The body is not decompressed, the content-encoding
+     * header of the response tells how it is encoded. Returning false stops
+     * the transfer: the connection is closed and finishCallback is not
+     * called.
+     * @param finishCallback The callback is called with `ReqResult::Ok` when
+     * the body is complete, or with the error which interrupted it. It is not
+     * called if headersCallback got an error.
+     * @param timeout In seconds, for the whole transfer. The zero value by
+     * default disables the timeout.
+     *
+     * @note The callbacks are called in the event loop of the client, which
+     * keeps reading from the connection meanwhile. A consumer that can't keep
+     * up should stop the transfer rather than buffer the data without bound.
+     */
+    virtual void sendStreamRequest(const HttpRequestPtr &req,
+                                   HttpReqCallback &&headersCallback,
+                                   HttpRespDataCallback &&dataCallback,
+                                   HttpRespFinishCallback &&finishCallback,
+                                   double timeout = 0) = 0;
+
+    /**
+     * @brief Forward a request to the server and call the callback with a
+     * response whose body is streamed from the response of the server as it
+     * arrives. This is the way for proxies to relay large responses.
+     *
+     * The response of the server is passed through with its headers (see
+     * HttpResponse::setPassThrough()). If the request fails before the
+     * headers of the response are received, the callback gets a 502 response.
+     * If the body is interrupted, the connection req was received on, if any,
+     * is closed so that its client sees the truncation. The transfer stops
+     * when that client goes away.
+     */
+    void forwardRequest(const HttpRequestPtr &req,
+                        std::function<void(const HttpResponsePtr &)> &&callback,
+                        double timeout = 0);
+
     /// Set socket options(before connecting)
     /**
      * @brief Set the callback which is called before connecting to the
@@ -227,6 +276,84 @@ class DROGON_EXPORT HttpClient : public trantor::NonCopyable
      */
     virtual void addCookie(const Cookie &cookie) = 0;
 
+    struct CoalescingMetrics
+    {
+        /// The requests sent to the server while coalescing is enabled
+        size_t sent{0};
+        /// The requests answered with the response of an identical request
+        /// already in flight
+        size_t merged{0};
+    };
+
+    /// Share the responses of identical requests in flight
+    /**
+     * When enabled, a GET or HEAD request without a body which is identical
+     * to a request already sent and not answered yet is not sent: its
+     * callback gets the response (or the error) of the first one. Requests
+     * are identical if they have the same method, path, query, parameters and
+     * values of the keyHeaders. This avoids a burst of requests for the same
+     * resource when it expires from a cache. The Authorization, Cookie and
+     * Proxy-Authorization headers and the cookies added to the request are
+     * always compared, so the requests of different users are not merged.
+     * Requests with a Range, If-Range, If-None-Match or If-Modified-Since
+     * header are never merged.
+     *
+     * @note The callbacks get the same response object, they must not modify
+     * it. A merged request has no timeout of its own, it ends with the first
+     * request. Call this method before sending requests.
+     */
+    virtual void enableRequestCoalescing(
+        bool flag = true,
+        const std::vector<std::string> &keyHeaders = {"accept",
+                                                      "accept-encoding",
+                                                      "authorization",
+                                                      "cookie"}) = 0;
+
+    /// Get the counters of the request coalescing
+    virtual CoalescingMetrics coalescingMetrics() const = 0;
+
+    struct CacheMetrics
+    {
+        /// The requests answered with a fresh stored response
+        size_t hits{0};
+        /// The requests answered with a stale stored response, which is
+        /// revalidated in the background
+        size_t staleHits{0};
+        /// The requests answered with a stored response after the server
+        /// confirmed it with 304 Not Modified
+        size_t revalidated{0};
+        /// The cacheable requests sent without a usable stored response
+        size_t misses{0};
+    };
+
+    /// Cache the responses of the server as RFC 9111 describes
+    /**
+     * GET requests are answered with the stored response while it is fresh
+     * (max-age, s-maxage or Expires), or while it is stale within its
+     * stale-while-revalidate time, a request then revalidates it in the
+     * background. Otherwise a stored response with an ETag or Last-Modified
+     * header is revalidated with a conditional request, and used again when
+     * the server answers 304. Responses varying on request headers are only
+     * used for requests with the same values. The successful responses to
+     * POST, PUT, PATCH and DELETE requests invalidate the stored response of
+     * their target.
+     *
+     * The cache serves every user of the client, it follows the rules of a
+     * shared cache: private responses are not stored, and the responses to
+     * requests with an Authorization header only when they allow it.
+     *
+     * @param store The storage of the responses, see
+     * HttpCacheStore::newMemoryStore(). It can be shared by several clients.
+     * nullptr disables the cache, which is the default.
+     * @note Every request answered from the store gets its own copy of the
+     * stored response, the copies share the body. Call this method before
+     * sending requests.
+     */
+    virtual void setCacheStore(const HttpCacheStorePtr &store) = 0;
+
+    /// Get the counters of the cache
+    virtual CacheMetrics cacheMetrics() const = 0;
+
     /**
      * @brief Set the user_agent header, the default value is 'DrogonClient' if
      * this method is not used.
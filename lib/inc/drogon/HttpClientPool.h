@@ -0,0 +1,245 @@
+/**
+ *
+ *  @file HttpClientPool.h
+ *  A pool of HTTP client connections to one server
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/HttpClient.h>
+#include <drogon/HttpTypes.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <trantor/utils/NonCopyable.h>
+#include <trantor/net/EventLoop.h>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef __cpp_impl_coroutine
+#include <drogon/utils/coroutine.h>
+#endif
+
+namespace drogon
+{
+class HttpClientPool;
+using HttpClientPoolPtr = std::shared_ptr<HttpClientPool>;
+#ifdef __cpp_impl_coroutine
+namespace internal
+{
+struct HttpPoolRespAwaiter : public CallbackAwaiter<HttpResponsePtr>
+{
+    HttpPoolRespAwaiter(HttpClientPool *pool,
+                        HttpRequestPtr req,
+                        double timeout)
+        : pool_(pool), req_(std::move(req)), timeout_(timeout)
+    {
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+  private:
+    HttpClientPool *pool_;
+    HttpRequestPtr req_;
+    double timeout_;
+};
+
+}  // namespace internal
+#endif
+
+/// A pool of persistent connections to one HTTP server
+/**
+ * The pool holds a set of connections per event loop. A request is sent in
+ * the loop of the calling thread when it is one of the loops of the pool,
+ * otherwise the loops are taken in turn. In a loop, the request goes to the
+ * connection with the fewest outstanding requests, a new connection is
+ * opened when all of them are busy and the maximum number is not reached.
+ *
+ * Connections idle for longer than the idle timeout are closed, except for
+ * the minimum number of connections which are kept open (and reopened when
+ * the server closes them) so that a burst of requests does not wait for new
+ * handshakes.
+ *
+ * Using the static method newHttpClientPool(...) to get shared_ptr of the
+ * object implementing the class.
+ */
+class DROGON_EXPORT HttpClientPool : public trantor::NonCopyable
+{
+  public:
+    struct Metrics
+    {
+        /// The number of connections held by the pool
+        size_t connections{0};
+        /// The number of connections with outstanding requests
+        size_t busyConnections{0};
+        /// The requests sent or waiting to be sent on the connections
+        size_t outstandingRequests{0};
+        /// The total number of requests dispatched by the pool
+        size_t requestsSent{0};
+        /// The total numbers of connections opened and closed by the pool
+        size_t connectionsOpened{0};
+        size_t connectionsClosed{0};
+    };
+
+    /**
+     * @brief Send a request asynchronously to the server, see
+     * HttpClient::sendRequest()
+     */
+    virtual void sendRequest(const HttpRequestPtr &req,
+                             const HttpReqCallback &callback,
+                             double timeout = 0) = 0;
+
+    /**
+     * @brief Send a request asynchronously to the server, see
+     * HttpClient::sendRequest()
+     */
+    virtual void sendRequest(const HttpRequestPtr &req,
+                             HttpReqCallback &&callback,
+                             double timeout = 0) = 0;
+
+    /**
+     * @brief Send a request synchronously to the server and return the
+     * response.
+     *
+     * @note Never call this function in an event loop thread of the pool,
+     * otherwise the thread will be blocked forever.
+     */
+    std::pair<ReqResult, HttpResponsePtr> sendRequest(const HttpRequestPtr &req,
+                                                      double timeout = 0)
+    {
+        std::promise<std::pair<ReqResult, HttpResponsePtr>> prom;
+        auto f = prom.get_future();
+        sendRequest(
+            req,
+            [&prom](ReqResult r, const HttpResponsePtr &resp) {
+                prom.set_value({r, resp});
+            },
+            timeout);
+        return f.get();
+    }
+
+#ifdef __cpp_impl_coroutine
+    /**
+     * @brief Send a request via coroutines to the server, see
+     * HttpClient::sendRequestCoro()
+     */
+    internal::HttpPoolRespAwaiter sendRequestCoro(HttpRequestPtr req,
+                                                  double timeout = 0)
+    {
+        return internal::HttpPoolRespAwaiter(this, std::move(req), timeout);
+    }
+#endif
+
+    /**
+     * @brief Send a request asynchronously to the server and receive the body
+     * of the response as it arrives, see HttpClient::sendStreamRequest()
+     */
+    virtual void sendStreamRequest(const HttpRequestPtr &req,
+                                   HttpReqCallback &&headersCallback,
+                                   HttpRespDataCallback &&dataCallback,
+                                   HttpRespFinishCallback &&finishCallback,
+                                   double timeout = 0) = 0;
+
+    /**
+     * @brief Forward a request to the server and relay its response as it
+     * arrives, see HttpClient::forwardRequest()
+     */
+    void forwardRequest(const HttpRequestPtr &req,
+                        std::function<void(const HttpResponsePtr &)> &&callback,
+                        double timeout = 0);
+
+    /// Get the statistics of the pool, summed over all its loops
+    virtual Metrics metrics() const = 0;
+
+    /**
+     * @brief Get the total number of outstanding requests (buffered +
+     * in-flight) of all the connections.
+     */
+    virtual std::size_t outstandingRequests() const = 0;
+
+    /**
+     * @brief The following methods configure the connections opened by the
+     * pool, they must be called before the first request is sent. See the
+     * methods of HttpClient with the same names.
+     */
+    virtual void setPipeliningDepth(size_t depth) = 0;
+    virtual void setUserAgent(const std::string &userAgent) = 0;
+    virtual void setSockOptCallback(std::function<void(int)> cb) = 0;
+    virtual void setCertPath(const std::string &cert,
+                             const std::string &key) = 0;
+    virtual void addSSLConfigs(
+        const std::vector<std::pair<std::string, std::string>>
+            &sslConfCmds) = 0;
+    virtual void setCacheStore(const HttpCacheStorePtr &store) = 0;
+
+    /// Get the event loops of the pool
+    virtual const std::vector<trantor::EventLoop *> &getLoops() const = 0;
+
+    /**
+     * @brief Create a pool of connections to the server identified by
+     * hostString, see HttpClient::newHttpClient() for its format.
+     *
+     * @param minConnections The number of connections kept open in each loop
+     * once the loop sent its first request.
+     * @param maxConnections The maximum number of connections in each loop.
+     * When all of them are busy, requests are queued or pipelined (see
+     * setPipeliningDepth()) on the least loaded one.
+     * @param loops The event loops of the connections. If empty, the IO loops
+     * of the application are used when it is running, the main loop
+     * otherwise.
+     * @param idleTimeout In seconds, connections beyond the minimum are closed
+     * after being idle this long. Zero disables closing them and reopening
+     * the minimum ones.
+     * @param useOldTLS If the parameter is set to true, the TLS1.0/1.1 are
+     * enabled for HTTPS.
+     * @param validateCert If the parameter is set to true, the client validates
+     * the server certificate when SSL handshaking.
+     */
+    static HttpClientPoolPtr newHttpClientPool(
+        const std::string &hostString,
+        size_t minConnections = 1,
+        size_t maxConnections = 8,
+        const std::vector<trantor::EventLoop *> &loops = {},
+        double idleTimeout = 60,
+        bool useOldTLS = false,
+        bool validateCert = true);
+
+    virtual ~HttpClientPool()
+    {
+    }
+
+  protected:
+    HttpClientPool() = default;
+};
+
+#ifdef __cpp_impl_coroutine
+inline void internal::HttpPoolRespAwaiter::await_suspend(
+    std::coroutine_handle<> handle)
+{
+    assert(pool_ != nullptr);
+    assert(req_ != nullptr);
+    pool_->sendRequest(
+        req_,
+        [handle, this](ReqResult result, const HttpResponsePtr &resp) {
+            if (result == ReqResult::Ok)
+                setValue(resp);
+            else
+                setException(std::make_exception_ptr(HttpException(result)));
+            handle.resume();
+        },
+        timeout_);
+}
+#endif
+
+}  // namespace drogon
@@ -22,8 +22,10 @@
 #include <drogon/HttpRequest.h>
 #include <drogon/HttpTypes.h>
 #include <drogon/HttpViewData.h>
+#include <drogon/SendQueueLimits.h>
 #include <drogon/utils/Utilities.h>
 #include <json/json.h>
+#include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -71,44 +73,109 @@ inline HttpResponsePtr toResponse<Json::Value &>(Json::Value &pJson)
     return toResponse((const Json::Value &)pJson);
 }
 
+class StreamEncoder;
+class SendQueue;
+
 class DROGON_EXPORT ResponseStream
 {
   public:
-    explicit ResponseStream(trantor::AsyncStreamPtr asyncStream)
-        : asyncStream_(std::move(asyncStream))
-    {
-    }
+    explicit ResponseStream(trantor::AsyncStreamPtr asyncStream);
 
-    ~ResponseStream()
-    {
-        close();
-    }
+    /**
+     * @brief Create a stream compressing the data it sends. The compressed
+     * data is flushed to the client every flushSize bytes (0 means after
+     * every send()) and on flush(). Without an encoder the data is sent as
+     * is. The data is sent in HTTP/1.1 chunks unless chunked is false, for
+     * transports framing the data themselves. The send queue measures the
+     * data not written to the connection yet, for the limits of the stream.
+     */
+    ResponseStream(trantor::AsyncStreamPtr asyncStream,
+                   std::shared_ptr<StreamEncoder> encoder,
+                   size_t flushSize,
+                   bool chunked = true,
+                   std::shared_ptr<SendQueue> sendQueue = nullptr);
 
-    bool send(const std::string &data)
-    {
-        if (!asyncStream_)
-        {
-            return false;
-        }
-        std::ostringstream oss;
-        oss << std::hex << data.length() << "\r\n";
-        oss << data << "\r\n";
-        return asyncStream_->send(oss.str());
-    }
+    ~ResponseStream();
+
+    /**
+     * @brief Send the data, false if the stream is closed or the data is
+     * dropped by the limits of the stream.
+     */
+    bool send(const std::string &data);
+
+    /**
+     * @brief Send the data the compressor is holding, if the response is
+     * compressed. Call it where the client should get all the data sent so
+     * far, e.g. at the end of an event. Without compression it does nothing.
+     */
+    bool flush();
+
+    void close();
+
+    /**
+     * @brief Drop the stream without ending the body, when the rest of the
+     * data is lost. The connection should then be closed for the client to
+     * see the body is truncated.
+     */
+    void abort();
 
-    void close()
+    /**
+     * @brief Limit the data queued on the connection when the client does not
+     * read the body as fast as it is sent. The data which would take the
+     * queue over the high water mark is dropped, held back or makes the
+     * connection close as the policy says, so the data sent should be made of
+     * whole events (e.g. server-sent events) when it may be dropped.
+     *
+     * @note The streams of HTTP/2 are limited by its flow control instead,
+     * the limits and the methods below do nothing for them.
+     */
+    void setSendQueueLimits(const SendQueueLimits &limits);
+
+    /// The bytes sent which are not written to the connection yet, with the
+    /// data held back by the limits
+    size_t sendQueueSize() const;
+
+    /// Return false from the time some data overflows the queue until the
+    /// queue drains to the low water mark
+    bool writable() const;
+
+    /// Set the callback called in the IO loop of the connection when the
+    /// queue drains to the low water mark after some data overflowed it
+    void setWritableCallback(const std::function<void()> &callback);
+
+    /// Return true if the queue is at or below the low water mark, with no
+    /// data held back
+    bool isDrained() const;
+
+    /**
+     * @brief Call the callback once the queue is drained (at once if it is).
+     * The parameter is false if the connection is closed first.
+     */
+    void whenDrained(std::function<void(bool)> &&callback);
+
+    /// The data dropped by the limits of the queue
+    uint64_t droppedMessages() const;
+
+#ifdef __cpp_impl_coroutine
+    /// Wait for the queue to drain, the result is false if the connection is
+    /// closed
+    internal::SendQueueDrainAwaiter<ResponseStream> drained()
     {
-        if (asyncStream_)
-        {
-            static std::string closeStream{"0\r\n\r\n"};
-            asyncStream_->send(closeStream);
-            asyncStream_->close();
-            asyncStream_.reset();
-        }
+        return internal::SendQueueDrainAwaiter<ResponseStream>(this);
     }
+#endif
 
   private:
+    bool sendData(const std::string &data);
+    bool flushEncoder();
+    bool sendChunk(const std::string &data);
+
     trantor::AsyncStreamPtr asyncStream_;
+    std::shared_ptr<StreamEncoder> encoder_;
+    size_t flushSize_{0};
+    size_t unflushed_{0};
+    bool chunked_{true};
+    std::shared_ptr<SendQueue> sendQueue_;
 };
 
 using ResponseStreamPtr = std::unique_ptr<ResponseStream>;
@@ -167,6 +234,15 @@ class DROGON_EXPORT HttpResponse
     /// Get whether the response allow compression.
     virtual bool allowCompression() const = 0;
 
+    /// Set whether the compressed variants of the body are cached. The body is
+    /// compressed once in the background and the variant is shared by all the
+    /// responses with the same body, see
+    /// HttpAppFramework::enableCompressionCache().
+    virtual void setCacheCompressedBody(bool flag) = 0;
+
+    /// Get whether the compressed variants of the body are cached.
+    virtual bool cacheCompressedBody() const = 0;
+
     /// Get the creation timestamp of the response.
     virtual const trantor::Date &creationDate() const = 0;
 
@@ -390,6 +466,20 @@ class DROGON_EXPORT HttpResponse
      */
     virtual void setPassThrough(bool flag) = 0;
 
+    /**
+     * @brief Freeze the status line and headers of the response. They are
+     * serialized once into a block that is shared (read-only) by this
+     * response and by all responses created from it with
+     * newHttpResponseFromTemplate(), only the content-length, cookies and date
+     * are rendered per send.
+     * Changing the status code, version, content type or headers of a frozen
+     * response gives it a private copy of its headers again.
+     *
+     * @note Stream responses and pass-through responses are not frozen. Freeze
+     * a template before sharing it between threads.
+     */
+    virtual void freezeHeaders() = 0;
+
     /**
      * @brief Get the certificate of the peer, if any.
      * @return The certificate of the peer. nullptr is none.
@@ -410,6 +500,13 @@ class DROGON_EXPORT HttpResponse
     /// Create a response with a status code and a content type
     static HttpResponsePtr newHttpResponse(HttpStatusCode code,
                                            ContentType type);
+    /// Create a response with the status, headers and cookies of
+    /// templateResponse and the given body. If the template is frozen (see
+    /// freezeHeaders()), its serialized header block is shared instead of
+    /// being rendered again for every response.
+    static HttpResponsePtr newHttpResponseFromTemplate(
+        const HttpResponsePtr &templateResponse,
+        std::string body);
     /// Create a response which returns a 404 page.
     static HttpResponsePtr newNotFoundResponse(
         const HttpRequestPtr &req = HttpRequestPtr());
@@ -14,21 +14,201 @@
 
 #pragma once
 
+#include <trantor/net/EventLoop.h>
 #include <trantor/utils/NonCopyable.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
 #include <functional>
 #include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace drogon
 {
 using SubscriberID = uint64_t;
 
+namespace internal
+{
+/**
+ * @brief A shared pointer to data which the readers get a snapshot of, and
+ * which the writers copy and replace instead of changing it. The readers
+ * never wait for the writers.
+ */
+template <typename T>
+class SnapshotPtr
+{
+  public:
+    SnapshotPtr() : SnapshotPtr(std::make_shared<const T>())
+    {
+    }
+
+    explicit SnapshotPtr(std::shared_ptr<const T> ptr)
+        : current_(ptr.get()), ptr_(std::move(ptr))
+    {
+    }
+
+    std::shared_ptr<const T> load() const
+    {
+#ifdef __cpp_lib_atomic_shared_ptr
+        return ptr_.load(std::memory_order_acquire);
+#else
+        return std::atomic_load_explicit(&ptr_, std::memory_order_acquire);
+#endif
+    }
+
+    /// Replace the data, returns the previous snapshot
+    std::shared_ptr<const T> exchange(std::shared_ptr<const T> ptr)
+    {
+        auto current = ptr.get();
+#ifdef __cpp_lib_atomic_shared_ptr
+        auto previous = ptr_.exchange(std::move(ptr));
+#else
+        auto previous = std::atomic_exchange(&ptr_, std::move(ptr));
+#endif
+        current_.store(current);
+        return previous;
+    }
+
+    /// Whether the data is the one of the current snapshot
+    bool isCurrent(const T *data) const
+    {
+        return current_.load() == data;
+    }
+
+  private:
+    std::atomic<const T *> current_;
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<const T>> ptr_;
+#else
+    std::shared_ptr<const T> ptr_;
+#endif
+};
+
+/// The readers of a snapshot, a copy of the snapshot starts with none
+struct SnapshotReaders
+{
+    SnapshotReaders() = default;
+
+    SnapshotReaders(const SnapshotReaders &) noexcept
+    {
+    }
+
+    SnapshotReaders &operator=(const SnapshotReaders &) noexcept
+    {
+        return *this;
+    }
+
+    mutable std::atomic<size_t> count{0};
+    // Set once the snapshot is replaced and a writer waits for its readers
+    mutable std::atomic<bool> retired{false};
+};
+
+/**
+ * @brief Lets the writers which replaced a snapshot wait for the readers
+ * still using the previous one. The readers are counted in the
+ * SnapshotReaders member (readers) of the snapshots, and the writers sleep
+ * until the last one is done.
+ */
+class GracePeriod : public trantor::NonCopyable
+{
+  public:
+    /// Reads the current snapshot until it is destroyed
+    template <typename T>
+    class ReadGuard : public trantor::NonCopyable
+    {
+      public:
+        ReadGuard(const GracePeriod &gracePeriod, const SnapshotPtr<T> &ptr)
+            : gracePeriod_(gracePeriod)
+        {
+            for (;;)
+            {
+                snapshot_ = ptr.load();
+                // Counted before it is checked to be current, the writers
+                // which replace it after that wait for this reader
+                snapshot_->readers.count.fetch_add(1);
+                if (ptr.isCurrent(snapshot_.get()))
+                    break;
+                gracePeriod_.release(snapshot_->readers);
+            }
+            activeReads().push_back(&snapshot_->readers);
+        }
+
+        ~ReadGuard()
+        {
+            activeReads().pop_back();
+            gracePeriod_.release(snapshot_->readers);
+        }
+
+        const T &operator*() const
+        {
+            return *snapshot_;
+        }
+
+        const T *operator->() const
+        {
+            return snapshot_.get();
+        }
+
+      private:
+        const GracePeriod &gracePeriod_;
+        std::shared_ptr<const T> snapshot_;
+    };
+
+    /**
+     * @brief Wait for the readers of a snapshot which was replaced. The
+     * reads of the current thread are not waited for, e.g. those of a
+     * handler unsubscribing while a message is published.
+     */
+    void wait(const SnapshotReaders &readers) const
+    {
+        auto &reads = activeReads();
+        auto own = static_cast<size_t>(
+            std::count(reads.begin(), reads.end(), &readers));
+        readers.retired.store(true);
+        if (readers.count.load() == own)
+            return;
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock,
+                        [&readers, own]() { return readers.count == own; });
+    }
+
+  private:
+    void release(const SnapshotReaders &readers) const
+    {
+        readers.count.fetch_sub(1);
+        if (readers.retired.load())
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            condition_.notify_all();
+        }
+    }
+
+    // The snapshots read by the current thread, innermost last
+    static std::vector<const SnapshotReaders *> &activeReads()
+    {
+        thread_local std::vector<const SnapshotReaders *> reads;
+        return reads;
+    }
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable condition_;
+};
+}  // namespace internal
+
 /**
  * @brief This class template presents an unnamed topic.
  *
+ * The subscribers are read from a snapshot, so publishing does not wait for
+ * the subscriptions and the other publishers. The handlers subscribed with
+ * an event loop are called in that loop instead of the publishing thread.
+ *
  * @tparam MessageType
  */
 template <typename MessageType>
@@ -49,10 +229,15 @@ class Topic : public trantor::NonCopyable
      */
     void publish(const MessageType &message) const
     {
-        std::shared_lock<SharedMutex> lock(mutex_);
-        for (auto &pair : handlersMap_)
+        internal::GracePeriod::ReadGuard<Subscribers> subscribers(
+            gracePeriod_, subscribers_);
+        for (auto &handler : subscribers->handlers)
+        {
+            (*handler.second)(message);
+        }
+        for (auto &group : subscribers->loops)
         {
-            pair.second(message);
+            post(group, message);
         }
     }
 
@@ -64,9 +249,7 @@ class Topic : public trantor::NonCopyable
      */
     SubscriberID subscribe(const MessageHandler &handler)
     {
-        std::unique_lock<SharedMutex> lock(mutex_);
-        handlersMap_[++id_] = handler;
-        return id_;
+        return subscribe(MessageHandler(handler));
     }
 
     /**
@@ -77,18 +260,75 @@ class Topic : public trantor::NonCopyable
      */
     SubscriberID subscribe(MessageHandler &&handler)
     {
-        std::unique_lock<SharedMutex> lock(mutex_);
-        handlersMap_[++id_] = std::move(handler);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto subscribers = std::make_shared<Subscribers>(*subscribers_.load());
+        subscribers->handlers.emplace_back(
+            ++id_, std::make_shared<const MessageHandler>(std::move(handler)));
+        subscribers_.exchange(std::move(subscribers));
         return id_;
     }
 
     /**
-     * @brief Unsubscribe from the topic.
+     * @brief Subscribe to the topic with the handler invoked in the event
+     * loop, e.g. the loop of the connection of the subscriber. The messages
+     * published while the loop is busy are handed to it in one task, and a
+     * slow handler does not make the publishers wait.
+     * @note The messages waiting for the loop are not bounded, a loop that
+     * cannot keep up with the publishers makes them pile up in memory.
+     *
+     * @param handler is invoked in the loop when a message arrives.
+     * @param loop The event loop of the subscriber.
+     * @return SubscriberID
+     */
+    SubscriberID subscribe(MessageHandler handler, trantor::EventLoop *loop)
+    {
+        assert(loop);
+        auto subscriber = std::make_shared<LoopSubscriber>();
+        subscriber->handler = std::move(handler);
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriber->id = ++id_;
+        auto subscribers = std::make_shared<Subscribers>(*subscribers_.load());
+        auto iter = std::find_if(subscribers->loops.begin(),
+                                 subscribers->loops.end(),
+                                 [loop](const LoopGroup &group) {
+                                     return group.mailbox->loop == loop;
+                                 });
+        if (iter == subscribers->loops.end())
+        {
+            subscribers->loops.push_back(
+                {std::make_shared<Mailbox>(loop),
+                 std::make_shared<const LoopSubscribers>(
+                     LoopSubscribers{std::move(subscriber)})});
+        }
+        else
+        {
+            auto group = std::make_shared<LoopSubscribers>(*iter->subscribers);
+            group->push_back(std::move(subscriber));
+            iter->subscribers = std::move(group);
+        }
+        subscribers_.exchange(std::move(subscribers));
+        return id_;
+    }
+
+    /**
+     * @brief Unsubscribe from the topic. The handlers invoked by the
+     * publishers of the other threads are not running any more when it
+     * returns, it waits for them without spinning. The handlers invoked in
+     * an event loop may be running in it, but get no message after it
+     * returns.
      */
     void unsubscribe(SubscriberID id)
     {
-        std::unique_lock<SharedMutex> lock(mutex_);
-        handlersMap_.erase(id);
+        std::shared_ptr<const Subscribers> previous;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto subscribers =
+                std::make_shared<Subscribers>(*subscribers_.load());
+            if (!subscribers->remove(id))
+                return;
+            previous = subscribers_.exchange(std::move(subscribers));
+        }
+        gracePeriod_.wait(previous->readers);
     }
 
     /**
@@ -99,8 +339,8 @@ class Topic : public trantor::NonCopyable
      */
     bool empty() const
     {
-        std::shared_lock<SharedMutex> lock(mutex_);
-        return handlersMap_.empty();
+        auto subscribers = subscribers_.load();
+        return subscribers->handlers.empty() && subscribers->loops.empty();
     }
 
     /**
@@ -109,13 +349,132 @@ class Topic : public trantor::NonCopyable
      */
     void clear()
     {
-        std::unique_lock<SharedMutex> lock(mutex_);
-        handlersMap_.clear();
+        std::shared_ptr<const Subscribers> previous;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            previous = subscribers_.exchange(std::make_shared<Subscribers>());
+        }
+        for (auto &group : previous->loops)
+        {
+            for (auto &subscriber : *group.subscribers)
+                subscriber->active.store(false, std::memory_order_release);
+        }
+        gracePeriod_.wait(previous->readers);
     }
 
   private:
-    std::unordered_map<SubscriberID, MessageHandler> handlersMap_;
-    mutable SharedMutex mutex_;
+    struct LoopSubscriber
+    {
+        SubscriberID id{0};
+        MessageHandler handler;
+        // Cleared when it unsubscribes, for the messages already posted
+        std::atomic<bool> active{true};
+    };
+
+    using LoopSubscribers = std::vector<std::shared_ptr<LoopSubscriber>>;
+
+    // The messages posted to a loop and not delivered yet, with the
+    // subscribers in the loop when each one was published. It is not
+    // bounded: a loop that falls behind the publishers keeps every message
+    // until it runs the delivering task.
+    struct Mailbox
+    {
+        explicit Mailbox(trantor::EventLoop *eventLoop) : loop(eventLoop)
+        {
+        }
+
+        trantor::EventLoop *loop;
+        std::mutex mutex;
+        std::vector<
+            std::pair<MessageType, std::shared_ptr<const LoopSubscribers>>>
+            messages;
+    };
+
+    struct LoopGroup
+    {
+        std::shared_ptr<Mailbox> mailbox;
+        std::shared_ptr<const LoopSubscribers> subscribers;
+    };
+
+    struct Subscribers
+    {
+        std::vector<
+            std::pair<SubscriberID, std::shared_ptr<const MessageHandler>>>
+            handlers;
+        std::vector<LoopGroup> loops;
+        // The publishers reading this snapshot
+        internal::SnapshotReaders readers;
+
+        bool remove(SubscriberID id)
+        {
+            for (auto iter = handlers.begin(); iter != handlers.end(); ++iter)
+            {
+                if (iter->first == id)
+                {
+                    handlers.erase(iter);
+                    return true;
+                }
+            }
+            for (auto iter = loops.begin(); iter != loops.end(); ++iter)
+            {
+                auto &group = *iter->subscribers;
+                auto subscriber = std::find_if(
+                    group.begin(),
+                    group.end(),
+                    [id](const std::shared_ptr<LoopSubscriber> &subscriber) {
+                        return subscriber->id == id;
+                    });
+                if (subscriber == group.end())
+                    continue;
+                (*subscriber)->active.store(false, std::memory_order_release);
+                if (group.size() == 1)
+                {
+                    loops.erase(iter);
+                    return true;
+                }
+                auto rest = std::make_shared<LoopSubscribers>(group);
+                rest->erase(rest->begin() + (subscriber - group.begin()));
+                iter->subscribers = std::move(rest);
+                return true;
+            }
+            return false;
+        }
+    };
+
+    static void post(const LoopGroup &group, const MessageType &message)
+    {
+        auto &mailbox = group.mailbox;
+        {
+            std::lock_guard<std::mutex> lock(mailbox->mutex);
+            mailbox->messages.emplace_back(message, group.subscribers);
+            // The task queued for the first message delivers this one too
+            if (mailbox->messages.size() > 1)
+                return;
+        }
+        mailbox->loop->queueInLoop([mailbox]() { deliver(*mailbox); });
+    }
+
+    static void deliver(Mailbox &mailbox)
+    {
+        decltype(mailbox.messages) messages;
+        {
+            std::lock_guard<std::mutex> lock(mailbox.mutex);
+            messages.swap(mailbox.messages);
+        }
+        for (auto &message : messages)
+        {
+            for (auto &subscriber : *message.second)
+            {
+                if (subscriber->active.load(std::memory_order_acquire))
+                    subscriber->handler(message.first);
+            }
+        }
+    }
+
+    internal::SnapshotPtr<Subscribers> subscribers_;
+    internal::GracePeriod gracePeriod_;
+    // Serializes the changes of the subscribers
+    std::mutex mutex_;
     SubscriberID id_{0};
 };
 
@@ -123,6 +482,10 @@ class Topic : public trantor::NonCopyable
  * @brief This class template implements a publish-subscribe pattern with
  * multiple named topics.
  *
+ * The topics are spread over shards by the hash of their names. Publishing
+ * reads a snapshot of the topics of a shard and of the subscribers of the
+ * topic, it does not wait for the subscriptions.
+ *
  * @tparam MessageType The message type.
  */
 template <typename MessageType>
@@ -143,20 +506,12 @@ class PubSubService : public trantor::NonCopyable
      */
     void publish(const std::string &topicName, const MessageType &message) const
     {
-        std::shared_ptr<Topic<MessageType>> topicPtr;
+        auto topics = shardOf(topicName).topics.load();
+        auto iter = topics->find(topicName);
+        if (iter != topics->end())
         {
-            std::shared_lock<SharedMutex> lock(mutex_);
-            auto iter = topicMap_.find(topicName);
-            if (iter != topicMap_.end())
-            {
-                topicPtr = iter->second;
-            }
-            else
-            {
-                return;
-            }
+            iter->second->publish(message);
         }
-        topicPtr->publish(message);
     }
 
     /**
@@ -169,7 +524,11 @@ class PubSubService : public trantor::NonCopyable
         auto topicHandler = [topicName, handler](const MessageType &message) {
             handler(topicName, message);
         };
-        return subscribeToTopic(topicName, std::move(topicHandler));
+        return subscribeToTopic(topicName,
+                                [&topicHandler](Topic<MessageType> &topic) {
+                                    return topic.subscribe(
+                                        std::move(topicHandler));
+                                });
     }
 
     /**
@@ -186,7 +545,35 @@ class PubSubService : public trantor::NonCopyable
                                 const MessageType &message) {
             handler(topicName, message);
         };
-        return subscribeToTopic(topicName, std::move(topicHandler));
+        return subscribeToTopic(topicName,
+                                [&topicHandler](Topic<MessageType> &topic) {
+                                    return topic.subscribe(
+                                        std::move(topicHandler));
+                                });
+    }
+
+    /**
+     * @brief Subscribe to a topic with the handler invoked in an event loop
+     * instead of the thread publishing, e.g. in the loop of the WebSocket
+     * connection of the subscriber. The messages published while the loop is
+     * busy are handed to it in one task.
+     * @param topicName Topic name.
+     * @param handler The message handler.
+     * @param loop The event loop of the subscriber.
+     * @return The subscriber ID.
+     */
+    SubscriberID subscribe(const std::string &topicName,
+                           MessageHandler handler,
+                           trantor::EventLoop *loop)
+    {
+        auto topicHandler = [topicName, handler = std::move(handler)](
+                                const MessageType &message) {
+            handler(topicName, message);
+        };
+        return subscribeToTopic(
+            topicName, [&topicHandler, loop](Topic<MessageType> &topic) {
+                return topic.subscribe(std::move(topicHandler), loop);
+            });
     }
 
     /**
@@ -197,25 +584,28 @@ class PubSubService : public trantor::NonCopyable
      */
     void unsubscribe(const std::string &topicName, SubscriberID id)
     {
-        {
-            std::shared_lock<SharedMutex> lock(mutex_);
-            auto iter = topicMap_.find(topicName);
-            if (iter == topicMap_.end())
-            {
-                return;
-            }
-            iter->second->unsubscribe(id);
-            if (!iter->second->empty())
-                return;
-        }
-        std::unique_lock<SharedMutex> lock(mutex_);
-        auto iter = topicMap_.find(topicName);
-        if (iter == topicMap_.end())
+        auto &shard = shardOf(topicName);
+        auto topics = shard.topics.load();
+        auto iter = topics->find(topicName);
+        if (iter == topics->end())
         {
             return;
         }
-        if (iter->second->empty())
-            topicMap_.erase(iter);
+        // Waits for the publishers of the topic, the shard is not locked
+        // meanwhile
+        auto topic = iter->second;
+        topic->unsubscribe(id);
+        if (!topic->empty())
+            return;
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        topics = shard.topics.load();
+        iter = topics->find(topicName);
+        // Subscribed to again or removed in the meantime
+        if (iter == topics->end() || iter->second != topic || !topic->empty())
+            return;
+        auto rest = std::make_shared<TopicMap>(*topics);
+        rest->erase(topicName);
+        shard.topics.exchange(std::move(rest));
     }
 
     /**
@@ -223,27 +613,58 @@ class PubSubService : public trantor::NonCopyable
      */
     size_t size() const
     {
-        std::shared_lock<SharedMutex> lock(mutex_);
-        return topicMap_.size();
+        size_t size{0};
+        for (auto &shard : shards_)
+        {
+            size += shard.topics.load()->size();
+        }
+        return size;
     }
 
     /**
-     * @brief remove all topics.
+     * @brief remove all topics. Like Topic::clear(), the subscribers get no
+     * message after it returns.
      */
     void clear()
     {
-        std::unique_lock<SharedMutex> lock(mutex_);
-        topicMap_.clear();
+        for (auto &shard : shards_)
+        {
+            std::shared_ptr<const TopicMap> removed;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                removed =
+                    shard.topics.exchange(std::make_shared<const TopicMap>());
+            }
+            // Waits for the publishers of the topics, the shard is not
+            // locked meanwhile
+            for (auto &topic : *removed)
+                topic.second->clear();
+        }
     }
 
     /**
-     * @brief Remove a topic
+     * @brief Remove a topic. Like Topic::clear(), the subscribers get no
+     * message after it returns.
      *
      */
     void removeTopic(const std::string &topicName)
     {
-        std::unique_lock<SharedMutex> lock(mutex_);
-        topicMap_.erase(topicName);
+        auto &shard = shardOf(topicName);
+        std::shared_ptr<Topic<MessageType>> removed;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto topics = shard.topics.load();
+            auto iter = topics->find(topicName);
+            if (iter == topics->end())
+                return;
+            removed = iter->second;
+            auto rest = std::make_shared<TopicMap>(*topics);
+            rest->erase(topicName);
+            shard.topics.exchange(std::move(rest));
+        }
+        // Waits for the publishers of the topic, the shard is not locked
+        // meanwhile
+        removed->clear();
     }
 
     /**
@@ -255,50 +676,53 @@ class PubSubService : public trantor::NonCopyable
      */
     bool isTopicEmpty(const std::string &topicName) const
     {
-        std::shared_ptr<Topic<MessageType>> topicPtr;
+        auto topics = shardOf(topicName).topics.load();
+        auto iter = topics->find(topicName);
+        if (iter == topics->end())
         {
-            std::shared_lock<SharedMutex> lock(mutex_);
-            auto iter = topicMap_.find(topicName);
-            if (iter != topicMap_.end())
-            {
-                topicPtr = iter->second;
-            }
-            else
-            {
-                return true;
-            }
+            return true;
         }
-        return topicPtr->empty();
+        return iter->second->empty();
     }
 
   private:
-    std::unordered_map<std::string, std::shared_ptr<Topic<MessageType>>>
-        topicMap_;
-    mutable SharedMutex mutex_;
-    SubscriberID subID_ = 0;
+    using TopicMap =
+        std::unordered_map<std::string, std::shared_ptr<Topic<MessageType>>>;
 
-    SubscriberID subscribeToTopic(
-        const std::string &topicName,
-        typename Topic<MessageType>::MessageHandler &&handler)
+    static constexpr size_t shardCount = 16;
+
+    struct alignas(64) Shard
     {
+        internal::SnapshotPtr<TopicMap> topics;
+        // Serializes the changes of the topics of the shard
+        std::mutex mutex;
+    };
+
+    Shard &shardOf(const std::string &topicName) const
+    {
+        return shards_[std::hash<std::string>{}(topicName) % shardCount];
+    }
+
+    template <typename Subscribe>
+    SubscriberID subscribeToTopic(const std::string &topicName,
+                                  const Subscribe &subscribe)
+    {
+        auto &shard = shardOf(topicName);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto topics = shard.topics.load();
+        auto iter = topics->find(topicName);
+        if (iter != topics->end())
         {
-            std::shared_lock<SharedMutex> lock(mutex_);
-            auto iter = topicMap_.find(topicName);
-            if (iter != topicMap_.end())
-            {
-                return iter->second->subscribe(std::move(handler));
-            }
-        }
-        std::unique_lock<SharedMutex> lock(mutex_);
-        auto iter = topicMap_.find(topicName);
-        if (iter != topicMap_.end())
-        {
-            return iter->second->subscribe(std::move(handler));
+            return subscribe(*iter->second);
         }
         auto topicPtr = std::make_shared<Topic<MessageType>>();
-        auto id = topicPtr->subscribe(std::move(handler));
-        topicMap_[topicName] = std::move(topicPtr);
+        auto id = subscribe(*topicPtr);
+        auto all = std::make_shared<TopicMap>(*topics);
+        all->emplace(topicName, std::move(topicPtr));
+        shard.topics.exchange(std::move(all));
         return id;
     }
+
+    mutable std::array<Shard, shardCount> shards_;
 };
 }  // namespace drogon
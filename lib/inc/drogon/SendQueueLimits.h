@@ -0,0 +1,92 @@
+/**
+ *
+ *  @file SendQueueLimits.h
+ *  The limits of the data queued on the connections of slow clients
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#ifdef __cpp_impl_coroutine
+#include <drogon/utils/coroutine.h>
+#endif
+#include <cstddef>
+
+namespace drogon
+{
+/// What is done with the messages sent while the queue is over its high
+/// water mark
+enum class SendQueueOverflowPolicy
+{
+    /// Drop the message sent
+    kDropNewest,
+    /// Hold the message back, dropping the oldest messages held back so
+    /// that they are not more than the high water mark. They are sent once
+    /// the queue drains to the low water mark.
+    kDropOldest,
+    /// Close the connection
+    kClose
+};
+
+/**
+ * @brief The limits of the data queued on a connection, which is sent but not
+ * written to the socket yet because the client does not read it fast enough.
+ *
+ * Without limits the data of a slow client is queued without bound. With
+ * them, the messages which would take the queue over the high water mark are
+ * handled as the policy says, and the connection is writable again once the
+ * queue drains to the low water mark.
+ */
+struct SendQueueLimits
+{
+    /// The bytes queued from which the messages overflow, 0 means unlimited
+    size_t highWaterMark{0};
+    /// The bytes queued at which the connection is writable again
+    size_t lowWaterMark{0};
+    SendQueueOverflowPolicy policy{SendQueueOverflowPolicy::kDropNewest};
+    /// The interval in seconds of the checks of the queue while someone
+    /// waits for it to drain
+    double checkInterval{0.01};
+};
+
+#ifdef __cpp_impl_coroutine
+namespace internal
+{
+/// Wait for the send queue of a connection or a stream to drain, the result
+/// is false if the connection is closed first
+template <typename Sender>
+struct [[nodiscard]] SendQueueDrainAwaiter : public CallbackAwaiter<bool>
+{
+    explicit SendQueueDrainAwaiter(Sender *sender) : sender_(sender)
+    {
+    }
+
+    bool await_ready()
+    {
+        if (!sender_->isDrained())
+            return false;
+        setValue(true);
+        return true;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        sender_->whenDrained([this, handle](bool drained) {
+            setValue(drained);
+            handle.resume();
+        });
+    }
+
+  private:
+    Sender *sender_;
+};
+}  // namespace internal
+#endif
+}  // namespace drogon
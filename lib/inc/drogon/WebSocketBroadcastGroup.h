@@ -0,0 +1,123 @@
+/**
+ *
+ *  @file WebSocketBroadcastGroup.h
+ *  Sends the same messages to many WebSocket connections
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/exports.h>
+#include <drogon/WebSocketConnection.h>
+#include <json/value.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace drogon
+{
+/**
+ * @brief A group of WebSocket connections of the server (a chat room, the
+ * subscribers of a feed...) which receive the same messages.
+ *
+ * A message is framed once into a buffer shared by the connections, and is
+ * handed to the IO loop of the connections with one task per loop. The
+ * connections with permessage-deflate and no context takeover share the
+ * compressed frames too. The other compressed connections compress each
+ * message for themselves.
+ *
+ * The connections which do not read fast enough (whose frames not written
+ * yet exceed the high water mark) are handled as the policy says, so that
+ * they do not hold an unbounded amount of memory.
+ *
+ * @code
+   // In a WebSocketController
+   void handleNewConnection(const HttpRequestPtr &req,
+                            const WebSocketConnectionPtr &conn) override
+   {
+       room_.add(conn);
+   }
+   void handleNewMessage(const WebSocketConnectionPtr &,
+                         std::string &&message,
+                         const WebSocketMessageType &type) override
+   {
+       room_.broadcast(message);
+   }
+   void handleConnectionClosed(const WebSocketConnectionPtr &conn) override
+   {
+       room_.remove(conn);
+   }
+   @endcode
+ */
+class DROGON_EXPORT WebSocketBroadcastGroup : public trantor::NonCopyable
+{
+  public:
+    enum class SlowConsumerPolicy
+    {
+        /// Skip the messages while the connection is over the mark
+        kDrop,
+        /// Keep the last message skipped and send it once the connection is
+        /// under the mark again, for feeds where only the latest value
+        /// matters
+        kCoalesce,
+        /// Close the connection
+        kClose
+    };
+
+    struct Options
+    {
+        /// The bytes queued on a connection from which it is slow
+        size_t highWaterMark{1024 * 1024};
+        SlowConsumerPolicy policy{SlowConsumerPolicy::kDrop};
+        /// The interval in seconds of the checks of the connections with a
+        /// coalesced message
+        double coalesceInterval{0.05};
+    };
+
+    WebSocketBroadcastGroup();
+    explicit WebSocketBroadcastGroup(const Options &options);
+    ~WebSocketBroadcastGroup();
+
+    /// Add a connection of the server, the closed connections are removed
+    /// by the next message. The connections of WebSocket clients, which
+    /// must mask their frames, are rejected.
+    void add(const WebSocketConnectionPtr &conn);
+
+    void remove(const WebSocketConnectionPtr &conn);
+
+    /// The number of connections, updated asynchronously in the IO loops
+    size_t size() const;
+
+    void broadcast(const char *msg,
+                   uint64_t len,
+                   WebSocketMessageType type = WebSocketMessageType::Text);
+    void broadcast(std::string_view msg,
+                   WebSocketMessageType type = WebSocketMessageType::Text);
+    void broadcastJson(const Json::Value &json,
+                       WebSocketMessageType type = WebSocketMessageType::Text);
+
+    /// The messages skipped or replaced by a later one on slow connections
+    uint64_t droppedMessages() const;
+
+    /// The connections closed because they were slow
+    uint64_t closedConnections() const;
+
+  private:
+    struct LoopGroup;
+    Options options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<trantor::EventLoop *, std::shared_ptr<LoopGroup>>
+        loops_;
+};
+}  // namespace drogon
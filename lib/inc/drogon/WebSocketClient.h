@@ -16,6 +16,7 @@
 
 #include <drogon/HttpRequest.h>
 #include <drogon/HttpResponse.h>
+#include <drogon/WebSocketCompression.h>
 #include <drogon/WebSocketConnection.h>
 #include <drogon/HttpTypes.h>
 #ifdef __cpp_impl_coroutine
@@ -115,6 +116,16 @@ class DROGON_EXPORT WebSocketClient
         const std::vector<std::pair<std::string, std::string>>
             &sslConfCmds) = 0;
 
+    /**
+     * @brief Offer the permessage-deflate extension (RFC 7692) to the server,
+     * the messages are compressed if the server accepts it.
+     *
+     * @param options The parameters of the compression offered.
+     * @note this method must be called before connecting to the server.
+     */
+    virtual void enableCompression(
+        const WebSocketCompressionOptions &options = {}) = 0;
+
 #ifdef __cpp_impl_coroutine
     /**
      * @brief Set messages handler. When a message is received from the server,
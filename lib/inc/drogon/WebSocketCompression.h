@@ -0,0 +1,52 @@
+/**
+ *
+ *  @file WebSocketCompression.h
+ *  The options of the permessage-deflate extension (RFC 7692)
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief The options of the permessage-deflate extension, which compresses
+ * the WebSocket messages. The extension is used when both peers support it,
+ * the parameters are negotiated in the handshake.
+ */
+struct WebSocketCompressionOptions
+{
+    /// Keep the compression context of the messages sent by the server (by
+    /// the client) between the messages. The ratios are much better for small
+    /// similar messages, at the cost of a context of about 300KB per
+    /// connection (with the default window and memory level).
+    bool serverContextTakeover{true};
+    bool clientContextTakeover{true};
+    /// The size in bits (9 to 15) of the window of the messages sent by the
+    /// server (by the client), the memory of a compressor is about
+    /// (1 << (windowBits + 2)) + (1 << (memLevel + 9)) bytes.
+    int serverMaxWindowBits{15};
+    int clientMaxWindowBits{15};
+    /// The zlib memory level of the compressors (1 to 9)
+    int memLevel{8};
+    /// The zlib compression level (1 to 9, -1 for the default of zlib)
+    int compressionLevel{-1};
+    /// The messages shorter than this are sent uncompressed
+    size_t minSize{64};
+    /// A dictionary preset in the compressors and decompressors, which
+    /// improves the ratio of the first messages (or of all of them without
+    /// context takeover). It is only used with a peer configured with the same
+    /// dictionary, which drogon negotiates with a parameter of its own.
+    std::string dictionary;
+};
+}  // namespace drogon
@@ -18,6 +18,8 @@
 #include <memory>
 #include <string>
 #include <drogon/HttpTypes.h>
+#include <drogon/SendQueueLimits.h>
+#include <functional>
 #include <string_view>
 #include <trantor/net/InetAddress.h>
 #include <trantor/utils/NonCopyable.h>
@@ -228,6 +230,64 @@ class WebSocketConnection
      */
     virtual void disablePing() = 0;
 
+    /**
+     * @brief Limit the bytes queued on the connection when the peer does not
+     * read the messages as fast as they are sent. The text and binary
+     * messages which would take the queue over the high water mark are
+     * dropped, held back or make the connection close as the policy says.
+     * The control frames are always sent.
+     *
+     * @note The messages held back are lost when the connection is shut down.
+     */
+    virtual void setSendQueueLimits(const SendQueueLimits &limits) = 0;
+
+    /// The bytes sent which are not written to the socket yet, with the
+    /// messages held back by the limits
+    virtual size_t sendQueueSize() const = 0;
+
+    /// Return false from the time a message overflows the queue until the
+    /// queue drains to the low water mark
+    virtual bool writable() const = 0;
+
+    /**
+     * @brief Set the callback called in the IO loop of the connection when
+     * the queue drains to the low water mark after a message overflowed it.
+     */
+    virtual void setWritableCallback(const std::function<void()> &callback) = 0;
+
+    /// Return true if the queue is at or below the low water mark, with no
+    /// message held back
+    virtual bool isDrained() const = 0;
+
+    /**
+     * @brief Call the callback once the queue is drained (at once if it is).
+     * The parameter is false if the connection is closed first.
+     */
+    virtual void whenDrained(std::function<void(bool)> &&callback) = 0;
+
+    /// The messages dropped by the limits of the queue
+    virtual uint64_t droppedMessages() const = 0;
+
+#ifdef __cpp_impl_coroutine
+    /**
+     * @brief Wait for the queue to drain, e.g. before sending the next part
+     * of a large transfer. The result is false if the connection is closed.
+     *
+     * @code
+       while (hasMore())
+       {
+           if (!co_await conn->drained())
+               break;
+           conn->send(nextPart(), WebSocketMessageType::Binary);
+       }
+       @endcode
+     */
+    internal::SendQueueDrainAwaiter<WebSocketConnection> drained()
+    {
+        return internal::SendQueueDrainAwaiter<WebSocketConnection>(this);
+    }
+#endif
+
   private:
     std::shared_ptr<void> contextPtr_;
 };
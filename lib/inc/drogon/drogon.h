@@ -22,6 +22,7 @@
 #include <drogon/CacheMap.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/HttpClient.h>
+#include <drogon/HttpClientPool.h>
 #include <drogon/HttpController.h>
 #include <drogon/HttpSimpleController.h>
 #include <drogon/utils/Utilities.h>
@@ -31,6 +31,8 @@ using AdviceDestroySessionCallback = std::function<void(const std::string &)>;
 using FilterCallback = std::function<void(const HttpResponsePtr &)>;
 using FilterChainCallback = std::function<void()>;
 using HttpReqCallback = std::function<void(ReqResult, const HttpResponsePtr &)>;
+using HttpRespDataCallback = std::function<bool(const char *, size_t)>;
+using HttpRespFinishCallback = std::function<void(ReqResult)>;
 
 using MiddlewareCallback = std::function<void(const HttpResponsePtr &)>;
 using MiddlewareNextCallback =
@@ -46,7 +46,44 @@ namespace plugin
                // The labels of the collector.
                "labels": ["method", "status"]
             }
-         ]
+         ],
+         // Record the requests handled by the server, by method and route
+         // pattern, in the following collectors:
+         // drogon_http_requests_total{method,route,status},
+         // drogon_http_requests_in_flight,
+         // drogon_http_request_duration_seconds{method,route},
+         // drogon_http_request_phase_seconds{method,route,phase} (the phases
+         // are queue, middleware, handler and send),
+         // drogon_http_request_size_bytes{method,route} and
+         // drogon_http_response_size_bytes{method,route}.
+         "request_metrics": {
+            // Disabled by default.
+            "enabled": false,
+            // The routes beyond this number are recorded as "<other>".
+            "max_routes": 500,
+            // The boundaries of the buckets of the durations, in seconds.
+            "latency_buckets": [0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                                0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10],
+            // The boundaries of the buckets of the sizes, in bytes.
+            "size_buckets": [64, 256, 1024, 4096, 16384, 65536, 262144,
+                             1048576, 4194304]
+         },
+         // Sample the event loops (io0..ioN, main, and db0.., redis0.. for the
+         // clients with their own loops) in the following collectors:
+         // drogon_event_loop_lag_seconds{loop},
+         // drogon_event_loop_queue_delay_seconds{loop},
+         // drogon_event_loop_busy_ratio{loop},
+         // drogon_event_loop_connections{loop} and
+         // drogon_event_loop_slow_callbacks_total{loop}.
+         "loop_metrics": {
+            // Disabled by default.
+            "enabled": false,
+            // The sampling interval, in seconds.
+            "interval": 0.1,
+            // The processing of the received data longer than this (in
+            // seconds) is logged with the requests processed, 0 to disable.
+            "slow_callback_threshold": 0
+         }
       }
     }
     @endcode
@@ -490,6 +490,10 @@ inline std::string getBlake2b(const std::string &originalString)
  * @param ndata the input data length
  */
 DROGON_EXPORT std::string gzipCompress(const char *data, const size_t ndata);
+/// Compress data using gzip lib with the given level (0-9).
+DROGON_EXPORT std::string gzipCompress(const char *data,
+                                       const size_t ndata,
+                                       int level);
 DROGON_EXPORT std::string gzipDecompress(const char *data, const size_t ndata);
 
 /// Compress or decompress data using brotli lib.
@@ -498,9 +502,25 @@ DROGON_EXPORT std::string gzipDecompress(const char *data, const size_t ndata);
  * @param ndata the input data length
  */
 DROGON_EXPORT std::string brotliCompress(const char *data, const size_t ndata);
+/// Compress data using brotli lib with the given quality (0-11).
+DROGON_EXPORT std::string brotliCompress(const char *data,
+                                         const size_t ndata,
+                                         int quality);
 DROGON_EXPORT std::string brotliDecompress(const char *data,
                                            const size_t ndata);
 
+/// Compress or decompress data using zstd lib.
+/**
+ * @param data the input data
+ * @param ndata the input data length
+ */
+DROGON_EXPORT std::string zstdCompress(const char *data, const size_t ndata);
+/// Compress data using zstd lib with the given level (1-22).
+DROGON_EXPORT std::string zstdCompress(const char *data,
+                                       const size_t ndata,
+                                       int level);
+DROGON_EXPORT std::string zstdDecompress(const char *data, const size_t ndata);
+
 /// Get the http full date string
 /**
  * rfc2616-3.3.1
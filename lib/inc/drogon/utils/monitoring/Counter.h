@@ -14,8 +14,9 @@
 
 #pragma once
 #include <drogon/utils/monitoring/Metric.h>
+#include <drogon/utils/monitoring/ShardedValue.h>
 #include <string_view>
-#include <mutex>
+#include <atomic>
 
 namespace drogon
 {
@@ -23,6 +24,7 @@ namespace monitoring
 {
 /**
  * This class is used to collect samples for a counter metric.
+ * The increments don't take locks, each thread adds to its own shard.
  * */
 class Counter : public Metric
 {
@@ -38,10 +40,7 @@ class Counter : public Metric
     {
         Sample s;
         s.name = name_;
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            s.value = value_;
-        }
+        s.value = offset_.load(std::memory_order_relaxed) + value_.sum();
         return {s};
     }
 
@@ -50,8 +49,7 @@ class Counter : public Metric
      * */
     void increment()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_++;
+        value_.add(1);
     }
 
     /**
@@ -59,14 +57,13 @@ class Counter : public Metric
      * */
     void increment(double value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ += value;
+        value_.add(value);
     }
 
     void reset()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ = 0;
+        // The shards are not cleared, they are offset
+        offset_.store(-value_.sum(), std::memory_order_relaxed);
     }
 
     static std::string_view type()
@@ -75,8 +72,8 @@ class Counter : public Metric
     }
 
   private:
-    mutable std::mutex mutex_;
-    double value_{0};
+    ShardedValue value_;
+    std::atomic<double> offset_{0};
 };
 }  // namespace monitoring
 }  // namespace drogon
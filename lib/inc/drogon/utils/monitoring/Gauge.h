@@ -14,6 +14,8 @@
 
 #pragma once
 #include <drogon/utils/monitoring/Metric.h>
+#include <drogon/utils/monitoring/ShardedValue.h>
+#include <trantor/utils/Date.h>
 #include <string_view>
 #include <atomic>
 
@@ -23,6 +25,8 @@ namespace monitoring
 {
 /**
  * This class is used to collect samples for a gauge metric.
+ * The increments and decrements don't take locks, each thread adds to its
+ * own shard.
  * */
 class Gauge : public Metric
 {
@@ -40,10 +44,10 @@ class Gauge : public Metric
     std::vector<Sample> collect() const override
     {
         Sample s;
-        std::lock_guard<std::mutex> lock(mutex_);
         s.name = name_;
-        s.value = value_;
-        s.timestamp = timestamp_;
+        s.value = offset_.load(std::memory_order_relaxed) + value_.sum();
+        s.timestamp =
+            trantor::Date(timestamp_.load(std::memory_order_relaxed));
         return {s};
     }
 
@@ -52,20 +56,17 @@ class Gauge : public Metric
      * */
     void increment()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ += 1;
+        value_.add(1);
     }
 
     void decrement()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ -= 1;
+        value_.add(-1);
     }
 
     void decrement(double value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ -= value;
+        value_.add(-value);
     }
 
     /**
@@ -73,20 +74,21 @@ class Gauge : public Metric
      * */
     void increment(double value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ += value;
+        value_.add(value);
     }
 
     void reset()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ = 0;
+        set(0);
     }
 
+    /**
+     * Set the value. The shards are not cleared but offset, the increments
+     * made at the same time by other threads may be overwritten.
+     * */
     void set(double value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ = value;
+        offset_.store(value - value_.sum(), std::memory_order_relaxed);
     }
 
     static std::string_view type()
@@ -96,14 +98,14 @@ class Gauge : public Metric
 
     void setToCurrentTime()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        timestamp_ = trantor::Date::now();
+        timestamp_.store(trantor::Date::now().microSecondsSinceEpoch(),
+                         std::memory_order_relaxed);
     }
 
   private:
-    mutable std::mutex mutex_;
-    double value_{0};
-    trantor::Date timestamp_{0};
+    ShardedValue value_;
+    std::atomic<double> offset_{0};
+    std::atomic<int64_t> timestamp_{0};
 };
 }  // namespace monitoring
 }  // namespace drogon
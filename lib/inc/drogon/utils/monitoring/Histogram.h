@@ -15,9 +15,12 @@
 #pragma once
 #include <drogon/exports.h>
 #include <drogon/utils/monitoring/Metric.h>
+#include <drogon/utils/monitoring/ShardedValue.h>
 #include <trantor/net/EventLoopThread.h>
 #include <string_view>
 #include <atomic>
+#include <chrono>
+#include <memory>
 #include <mutex>
 
 namespace drogon
@@ -25,7 +28,9 @@ namespace drogon
 namespace monitoring
 {
 /**
- * This class is used to collect samples for a counter metric.
+ * This class is used to collect samples for a histogram metric.
+ * The observations don't take locks, each thread counts them in its own
+ * shard and the shards are merged by collect().
  * */
 class DROGON_EXPORT Histogram : public Metric
 {
@@ -67,8 +72,6 @@ class DROGON_EXPORT Histogram : public Metric
                     "timeBucketsCount must be greater than 0");
             }
         }
-        timeBuckets_.emplace_back();
-        timeBuckets_.back().buckets.resize(bucketBoundaries.size() + 1);
         // check the bucket boundaries are sorted
         for (size_t i = 1; i < bucketBoundaries.size(); i++)
         {
@@ -78,6 +81,15 @@ class DROGON_EXPORT Histogram : public Metric
                     "The bucket boundaries must be sorted");
             }
         }
+        timeBucketsInUse_ =
+            maxAge > std::chrono::seconds(0) ? timeBucketsCount : 1;
+        auto shardCount = timeBucketsInUse_ * internal::shardCount();
+        shards_.reset(new Shard[shardCount]);
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            shards_[i].buckets.reset(
+                new std::atomic<uint64_t>[bucketBoundaries.size() + 1]());
+        }
     }
 
     void observe(double value);
@@ -97,27 +109,31 @@ class DROGON_EXPORT Histogram : public Metric
     }
 
   private:
-    std::deque<TimeBucket> timeBuckets_;
+    // The observations of one thread during one time bucket, on their own
+    // cache lines
+    struct alignas(64) Shard
+    {
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+        std::atomic<uint64_t> count{0};
+        std::atomic<double> sum{0};
+    };
+
+    // The shards of the time buckets, used as a ring: the shards of the time
+    // bucket i are at [i * shardCount(), (i + 1) * shardCount())
+    std::unique_ptr<Shard[]> shards_;
+    size_t timeBucketsInUse_{1};
+    std::atomic<size_t> currentTimeBucket_{0};
+    std::atomic<bool> rotationStarted_{false};
     std::unique_ptr<trantor::EventLoopThread> loopThreadPtr_;
     trantor::EventLoop *loopPtr_{nullptr};
+    // Serializes the rotation and the collection
     mutable std::mutex mutex_;
     std::chrono::duration<double> maxAge_;
     trantor::TimerId timerId_{trantor::InvalidTimerId};
     size_t timeBucketCount_{0};
     const std::vector<double> bucketBoundaries_;
-
-    void rotateTimeBuckets()
-    {
-        std::lock_guard<std::mutex> guard(mutex_);
-        TimeBucket bucket;
-        bucket.buckets.resize(bucketBoundaries_.size() + 1);
-        timeBuckets_.emplace_back(std::move(bucket));
-        if (timeBuckets_.size() > timeBucketCount_)
-        {
-            auto expiredTimeBucket = timeBuckets_.front();
-            timeBuckets_.erase(timeBuckets_.begin());
-        }
-    }
+    void startRotation();
+    void rotateTimeBuckets();
 };
 }  // namespace monitoring
 }  // namespace drogon
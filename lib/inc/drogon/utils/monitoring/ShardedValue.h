@@ -0,0 +1,101 @@
+/**
+ *
+ *  @file ShardedValue.h
+ *  Per-thread cells updated without locks by the metrics
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+namespace drogon
+{
+namespace monitoring
+{
+namespace internal
+{
+/**
+ * @brief The number of shards of a metric, the power of two above the number
+ * of cores (64 at most).
+ */
+inline size_t shardCount()
+{
+    static const size_t count = []() {
+        size_t n = 1;
+        auto cores = std::thread::hardware_concurrency();
+        while (n < cores && n < 64)
+            n <<= 1;
+        return n;
+    }();
+    return count;
+}
+
+/**
+ * @brief The shard updated by the current thread. Threads are given the
+ * shards in turn, so the IO threads started together get distinct shards.
+ */
+inline size_t currentShard()
+{
+    static std::atomic<size_t> nextThread{0};
+    thread_local const size_t shard =
+        nextThread.fetch_add(1, std::memory_order_relaxed) &
+        (shardCount() - 1);
+    return shard;
+}
+
+inline void atomicAdd(std::atomic<double> &target, double value)
+{
+    auto current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current,
+                                         current + value,
+                                         std::memory_order_relaxed))
+    {
+    }
+}
+}  // namespace internal
+
+/**
+ * @brief A sum split in a cell per shard, each on its own cache line. Threads
+ * add to their own cell without contending, and the cells are summed when the
+ * value is read.
+ */
+class ShardedValue
+{
+  public:
+    ShardedValue() : cells_(new Cell[internal::shardCount()])
+    {
+    }
+
+    void add(double value)
+    {
+        internal::atomicAdd(cells_[internal::currentShard()].value, value);
+    }
+
+    double sum() const
+    {
+        double sum = 0;
+        for (size_t i = 0; i < internal::shardCount(); ++i)
+            sum += cells_[i].value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+  private:
+    struct alignas(64) Cell
+    {
+        std::atomic<double> value{0};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+};
+}  // namespace monitoring
+}  // namespace drogon
@@ -0,0 +1,124 @@
+/**
+ *
+ *  @file CompressionCache.cc
+ *  Cache of compressed response bodies keyed by their content
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "CompressionCache.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <functional>
+
+using namespace drogon;
+
+void CompressionCache::init()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0 || workers_)
+        return;
+    workers_ = std::make_unique<trantor::ConcurrentTaskQueue>(
+        threadNum_ > 0 ? threadNum_ : 1, "CompressionCache");
+}
+
+void CompressionCache::reset()
+{
+    std::unique_ptr<trantor::ConcurrentTaskQueue> workers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        workers = std::move(workers_);
+        while (!nodes_.empty())
+            eraseNode(nodes_.begin());
+    }
+    // Joins the workers, which may be finishing a compression that needs the
+    // mutex
+    workers.reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+    pendingBytes_ = 0;
+}
+
+CompressionCache::BodyPtr CompressionCache::find(Encoding encoding,
+                                                 std::string_view body)
+{
+    Key key{std::hash<std::string_view>{}(body), body.length(), encoding};
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = index_.find(key);
+    if (iter != index_.end())
+    {
+        nodes_.splice(nodes_.begin(), nodes_, iter->second);
+        return iter->second->body;
+    }
+    if (!workers_ || pending_.count(key) ||
+        pendingBytes_ + body.length() > capacity_)
+        return nullptr;
+    pending_.insert(key);
+    pendingBytes_ += body.length();
+    // The response may be changed or released before the job runs
+    auto copy = std::make_shared<std::string>(body);
+    workers_->runTaskInQueue([this, key, copy]() { compress(key, copy); });
+    return nullptr;
+}
+
+void CompressionCache::compress(const Key &key,
+                                const std::shared_ptr<std::string> &body)
+{
+    std::string compressed;
+    switch (key.encoding)
+    {
+        case StreamEncoder::kGzip:
+            compressed =
+                utils::gzipCompress(body->data(), body->length(), gzipLevel_);
+            break;
+        case StreamEncoder::kBrotli:
+            compressed = utils::brotliCompress(body->data(),
+                                               body->length(),
+                                               brotliQuality_);
+            break;
+        case StreamEncoder::kZstd:
+            compressed =
+                utils::zstdCompress(body->data(), body->length(), zstdLevel_);
+            break;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.erase(key) == 0)
+    {
+        // Reset while compressing
+        return;
+    }
+    pendingBytes_ -= body->length();
+    if (compressed.empty())
+    {
+        LOG_ERROR << "Failed to compress a body of " << body->length()
+                  << " bytes for the compression cache";
+        return;
+    }
+    insert(key, std::make_shared<HttpMessageStringBody>(std::move(compressed)));
+}
+
+void CompressionCache::insert(const Key &key, BodyPtr body)
+{
+    if (body->length() > capacity_ || index_.count(key))
+        return;
+    size_ += body->length();
+    nodes_.push_front(Node{key, std::move(body)});
+    index_.emplace(key, nodes_.begin());
+    while (size_ > capacity_)
+    {
+        eraseNode(std::prev(nodes_.end()));
+    }
+}
+
+void CompressionCache::eraseNode(NodeList::iterator iter)
+{
+    size_ -= iter->body->length();
+    index_.erase(iter->key);
+    nodes_.erase(iter);
+}
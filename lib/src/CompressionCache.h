@@ -0,0 +1,165 @@
+/**
+ *
+ *  @file CompressionCache.h
+ *  Cache of compressed response bodies keyed by their content
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "HttpMessageBody.h"
+#include "StreamEncoder.h"
+#include <trantor/utils/ConcurrentTaskQueue.h>
+#include <trantor/utils/NonCopyable.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace drogon
+{
+/**
+ * @brief Caches the compressed variants of the bodies of the responses
+ * that opted in (HttpResponse::setCacheCompressedBody()).
+ *
+ * The variants are keyed by a hash and the length of the uncompressed body,
+ * so equal bodies share them whichever response they come from. A miss
+ * queues the compression in a worker pool and returns nothing, the
+ * uncompressed body is sent until the variant is ready. The cache is bounded
+ * by the total size of the compressed bodies and evicts them in LRU order.
+ *
+ * @note The hash is not cryptographic, only opt bodies that are not
+ * controlled by the clients into the cache.
+ */
+class CompressionCache : public trantor::NonCopyable
+{
+  public:
+    using Encoding = StreamEncoder::Encoding;
+    using BodyPtr = std::shared_ptr<HttpMessageBody>;
+
+    static CompressionCache &instance()
+    {
+        static CompressionCache cache;
+        return cache;
+    }
+
+    /// A capacity of 0 disables the cache
+    void setCapacity(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = bytes;
+    }
+
+    size_t capacity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    bool enabled() const
+    {
+        return capacity() > 0;
+    }
+
+    void setGzipLevel(int level)
+    {
+        gzipLevel_ = level;
+    }
+
+    void setBrotliQuality(int quality)
+    {
+        brotliQuality_ = quality;
+    }
+
+    void setZstdLevel(int level)
+    {
+        zstdLevel_ = level;
+    }
+
+    void setThreadNum(size_t threadNum)
+    {
+        threadNum_ = threadNum;
+    }
+
+    /// Start the worker pool if the cache is enabled
+    void init();
+    /// Stop the worker pool and drop all the variants
+    void reset();
+
+    /**
+     * @brief Return the compressed variant of the body, or nullptr if it is
+     * not cached yet. On a miss the compression is queued, unless the queued
+     * bodies already take as much memory as the cache.
+     */
+    BodyPtr find(Encoding encoding, std::string_view body);
+
+    /// The total size of the cached variants in bytes
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+  private:
+    struct Key
+    {
+        uint64_t hash;
+        size_t length;
+        Encoding encoding;
+
+        bool operator==(const Key &other) const
+        {
+            return hash == other.hash && length == other.length &&
+                   encoding == other.encoding;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        {
+            return static_cast<size_t>(key.hash) ^
+                   (key.length << 1 | static_cast<size_t>(key.encoding));
+        }
+    };
+
+    struct Node
+    {
+        Key key;
+        BodyPtr body;
+    };
+
+    using NodeList = std::list<Node>;
+
+    CompressionCache() = default;
+
+    void compress(const Key &key, const std::shared_ptr<std::string> &body);
+    // The following methods are called with mutex_ locked
+    void insert(const Key &key, BodyPtr body);
+    void eraseNode(NodeList::iterator iter);
+
+    mutable std::mutex mutex_;
+    // Most recently used first
+    NodeList nodes_;
+    std::unordered_map<Key, NodeList::iterator, KeyHash> index_;
+    std::unordered_set<Key, KeyHash> pending_;
+    size_t pendingBytes_{0};
+    size_t size_{0};
+    size_t capacity_{0};
+    int gzipLevel_{9};
+    int brotliQuality_{11};
+    int zstdLevel_{19};
+    size_t threadNum_{1};
+    std::unique_ptr<trantor::ConcurrentTaskQueue> workers_;
+};
+}  // namespace drogon
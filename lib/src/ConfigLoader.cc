@@ -444,8 +444,44 @@ static void loadApp(const Json::Value &app)
     drogon::app().enableGzip(useGzip);
     auto useBr = app.get("use_brotli", false).asBool();
     drogon::app().enableBrotli(useBr);
+    auto useZstd = app.get("use_zstd", false).asBool();
+    drogon::app().enableZstd(useZstd);
     auto staticFilesCacheTime = app.get("static_files_cache_time", 5).asInt();
     drogon::app().setStaticFilesCacheTime(staticFilesCacheTime);
+    auto staticFilesCacheSize =
+        app.get("static_files_cache_size", "64M").asString();
+    size_t cacheSize;
+    if (bytesSize(staticFilesCacheSize, cacheSize))
+    {
+        drogon::app().setStaticFilesCacheSize(cacheSize);
+    }
+    else
+    {
+        throw std::runtime_error("Error format of static_files_cache_size");
+    }
+    auto compressionCacheSize =
+        app.get("compression_cache_size", "0").asString();
+    if (!bytesSize(compressionCacheSize, cacheSize))
+    {
+        throw std::runtime_error("Error format of compression_cache_size");
+    }
+    drogon::app().enableCompressionCache(
+        cacheSize,
+        app.get("compression_cache_gzip_level", 9).asInt(),
+        app.get("compression_cache_brotli_quality", 11).asInt(),
+        app.get("compression_cache_zstd_level", 19).asInt(),
+        app.get("compression_cache_threads", 1).asUInt());
+    auto streamCompressionFlushSize =
+        app.get("stream_compression_flush_size", "0").asString();
+    size_t flushSize;
+    if (!bytesSize(streamCompressionFlushSize, flushSize))
+    {
+        throw std::runtime_error(
+            "Error format of stream_compression_flush_size");
+    }
+    drogon::app().enableStreamCompression(
+        app.get("stream_compression", false).asBool(), flushSize);
+    drogon::app().enableHttp2(app.get("enable_http2", false).asBool());
     loadControllers(app["simple_controllers_map"]);
     // Kick off idle connections
     auto kickOffTimeout = app.get("idle_connection_timeout", 60).asUInt64();
@@ -525,9 +561,53 @@ static void loadApp(const Json::Value &app)
     bool enableCompressedRequests =
         app.get("enabled_compressed_request", false).asBool();
     drogon::app().enableCompressedRequest(enableCompressedRequests);
+    auto &wsCompression = app["websocket_compression"];
+    if (wsCompression.get("enabled", false).asBool())
+    {
+        WebSocketCompressionOptions options;
+        options.serverContextTakeover =
+            wsCompression.get("server_context_takeover", true).asBool();
+        options.clientContextTakeover =
+            wsCompression.get("client_context_takeover", true).asBool();
+        options.serverMaxWindowBits =
+            wsCompression.get("server_max_window_bits", 15).asInt();
+        options.clientMaxWindowBits =
+            wsCompression.get("client_max_window_bits", 15).asInt();
+        options.memLevel = wsCompression.get("mem_level", 8).asInt();
+        options.compressionLevel = wsCompression.get("level", -1).asInt();
+        options.minSize = wsCompression.get("min_size", 64).asUInt64();
+        if (options.serverMaxWindowBits < 9 ||
+            options.serverMaxWindowBits > 15 ||
+            options.clientMaxWindowBits < 9 ||
+            options.clientMaxWindowBits > 15)
+        {
+            throw std::runtime_error(
+                "The window bits of websocket_compression must be between 9 "
+                "and 15");
+        }
+        auto dictionaryFile =
+            wsCompression.get("dictionary_file", "").asString();
+        if (!dictionaryFile.empty())
+        {
+            std::ifstream infile(drogon::utils::toNativePath(dictionaryFile),
+                                 std::ifstream::binary);
+            if (!infile)
+            {
+                throw std::runtime_error(
+                    "Failed to read the dictionary of websocket_compression: " +
+                    dictionaryFile);
+            }
+            std::stringstream buffer;
+            buffer << infile.rdbuf();
+            options.dictionary = buffer.str();
+        }
+        drogon::app().enableWebSocketCompression(options);
+    }
 
     drogon::app().enableRequestStream(
         app.get("enable_request_stream", false).asBool());
+    drogon::app().enableFlatRequestHeaders(
+        app.get("flat_request_headers", false).asBool());
 }
 
 static void loadDbClients(const Json::Value &dbClients)
@@ -0,0 +1,135 @@
+/**
+ *
+ *  @file ConnectionAttempts.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ConnectionAttempts.h"
+#include "DnsCache.h"
+#include <algorithm>
+
+using namespace drogon;
+
+ConnectionAttempts::ConnectionAttempts(trantor::EventLoop *loop,
+                                       double attemptDelay,
+                                       ClientFactory clientFactory,
+                                       ErrorCallback errorCallback)
+    : loop_(loop),
+      attemptDelay_(attemptDelay),
+      clientFactory_(std::move(clientFactory)),
+      errorCallback_(std::move(errorCallback))
+{
+}
+
+void ConnectionAttempts::start(const std::vector<trantor::InetAddress> &addrs)
+{
+    loop_->assertInLoopThread();
+    stop();
+    auto sorted = interleaveAddressFamilies(addrs);
+    pendingAddrs_.assign(sorted.begin(), sorted.end());
+    startNextAttempt();
+}
+
+void ConnectionAttempts::startNextAttempt()
+{
+    cancelTimer();
+    if (pendingAddrs_.empty())
+    {
+        return;
+    }
+    auto addr = pendingAddrs_.front();
+    pendingAddrs_.pop_front();
+    auto client = clientFactory_(addr);
+    if (!client)
+    {
+        return;
+    }
+    clients_.push_back(client);
+    // Armed first, a failing connect() may start the next attempt at once
+    if (!pendingAddrs_.empty())
+    {
+        std::weak_ptr<ConnectionAttempts> weakPtr = shared_from_this();
+        timerId_ = loop_->runAfter(attemptDelay_, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->timerId_ = trantor::InvalidTimerId;
+            thisPtr->startNextAttempt();
+        });
+    }
+    client->connect();
+}
+
+bool ConnectionAttempts::connected(const ClientPtr &client)
+{
+    auto iter = std::find(clients_.begin(), clients_.end(), client);
+    if (iter == clients_.end())
+    {
+        // Lost the race, it is being closed
+        return false;
+    }
+    clients_.erase(iter);
+    stop();
+    return true;
+}
+
+void ConnectionAttempts::failed(const ClientPtr &client, ReqResult result)
+{
+    auto iter = std::find(clients_.begin(), clients_.end(), client);
+    if (iter == clients_.end())
+    {
+        return;
+    }
+    clients_.erase(iter);
+    // The client is in its own callback, it is destroyed later
+    loop_->queueInLoop([client]() {});
+    if (!pendingAddrs_.empty())
+    {
+        startNextAttempt();
+    }
+    else if (clients_.empty())
+    {
+        // The last one, may start new attempts
+        errorCallback_(result);
+    }
+}
+
+void ConnectionAttempts::stop()
+{
+    cancelTimer();
+    pendingAddrs_.clear();
+    if (clients_.empty())
+    {
+        return;
+    }
+    // The dropped clients may still be in their callbacks
+    loop_->queueInLoop([clients = std::move(clients_)]() mutable {
+        for (auto &client : clients)
+        {
+            client->stop();
+        }
+    });
+    clients_.clear();
+}
+
+bool ConnectionAttempts::isAttempt(const ClientPtr &client) const
+{
+    return std::find(clients_.begin(), clients_.end(), client) !=
+           clients_.end();
+}
+
+void ConnectionAttempts::cancelTimer()
+{
+    if (timerId_ != trantor::InvalidTimerId)
+    {
+        loop_->invalidateTimer(timerId_);
+        timerId_ = trantor::InvalidTimerId;
+    }
+}
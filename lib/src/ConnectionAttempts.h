@@ -0,0 +1,90 @@
+/**
+ *
+ *  @file ConnectionAttempts.h
+ *  Happy eyeballs connections of the HTTP clients
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpTypes.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/InetAddress.h>
+#include <trantor/net/TcpClient.h>
+#include <trantor/utils/NonCopyable.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Connects to the first address which answers, as RFC 8305 (happy
+ * eyeballs) describes.
+ *
+ * The addresses are tried in turn, a new attempt starts when the previous
+ * one failed or did not connect within the attempt delay, and the first
+ * connection established is kept. An attempt failing (including its TLS
+ * handshake) only ends the others when it was the last one, the error
+ * callback then gets the error of that attempt.
+ *
+ * The clients are made by the client factory, whose callbacks report to
+ * connected() and failed(). Everything runs in the loop.
+ */
+class ConnectionAttempts
+    : public trantor::NonCopyable,
+      public std::enable_shared_from_this<ConnectionAttempts>
+{
+  public:
+    using ClientPtr = std::shared_ptr<trantor::TcpClient>;
+    using ClientFactory =
+        std::function<ClientPtr(const trantor::InetAddress &addr)>;
+    using ErrorCallback = std::function<void(ReqResult result)>;
+
+    ConnectionAttempts(trantor::EventLoop *loop,
+                       double attemptDelay,
+                       ClientFactory clientFactory,
+                       ErrorCallback errorCallback);
+
+    /// Try the addresses, the attempts in progress are stopped
+    void start(const std::vector<trantor::InetAddress> &addrs);
+
+    /// The client connected, false if it lost the race to another one
+    bool connected(const ClientPtr &client);
+
+    /// The client could not connect or its TLS handshake failed
+    void failed(const ClientPtr &client, ReqResult result);
+
+    /// Stop all the attempts
+    void stop();
+
+    /// Whether the client is an attempt in progress
+    bool isAttempt(const ClientPtr &client) const;
+
+    /// Whether an attempt is in progress
+    bool connecting() const
+    {
+        return !clients_.empty();
+    }
+
+  private:
+    void startNextAttempt();
+    void cancelTimer();
+
+    trantor::EventLoop *loop_;
+    double attemptDelay_;
+    ClientFactory clientFactory_;
+    ErrorCallback errorCallback_;
+    std::vector<ClientPtr> clients_;
+    std::deque<trantor::InetAddress> pendingAddrs_;
+    trantor::TimerId timerId_{trantor::InvalidTimerId};
+};
+}  // namespace drogon
@@ -0,0 +1,227 @@
+/**
+ *
+ *  @file DnsCache.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "DnsCache.h"
+#include <trantor/net/Resolver.h>
+#include <trantor/utils/Logger.h>
+#include <memory>
+
+using namespace drogon;
+
+namespace
+{
+// Expired entries are only swept when there are more hostnames than this
+constexpr size_t kMaxEntries{1024};
+
+// The resolvers report a failure with the any address
+bool isHostAddress(const trantor::InetAddress &addr)
+{
+    if (addr.isUnspecified())
+    {
+        return false;
+    }
+    if (!addr.isIpV6())
+    {
+        return addr.ipNetEndian() != 0;
+    }
+    auto ipaddr = addr.ip6NetEndian();
+    for (int i = 0; i < 4; ++i)
+    {
+        if (ipaddr[i] != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+}  // namespace
+
+DnsCache::DnsCache(ResolveFunction resolveFunc)
+    : resolveFunc_(std::move(resolveFunc))
+{
+    if (resolveFunc_)
+    {
+        return;
+    }
+    // The resolver runs its queries in its own thread without a loop. Its own
+    // cache is given the shortest timeout, 0 would keep the addresses forever.
+    std::shared_ptr<trantor::Resolver> resolver =
+        trantor::Resolver::newResolver(nullptr, 1);
+    resolveFunc_ = [resolver](const std::string &hostname,
+                              Callback &&callback) {
+        resolver->resolve(hostname,
+                          [callback = std::move(callback)](
+                              const std::vector<trantor::InetAddress> &addrs) {
+                              callback(addrs);
+                          });
+    };
+}
+
+void DnsCache::resolve(const std::string &hostname, Callback &&callback)
+{
+    auto now = trantor::Date::now();
+    Addresses addresses;
+    bool cached{true};
+    bool startQuery{false};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = entries_.find(hostname);
+        if (iter == entries_.end())
+        {
+            if (entries_.size() >= kMaxEntries)
+            {
+                evictExpired(now);
+            }
+            iter = entries_.emplace(hostname, Entry{}).first;
+        }
+        auto &entry = iter->second;
+        if (entry.resolved && now < entry.expiry)
+        {
+            addresses = entry.addresses;
+        }
+        else if (entry.resolved && !entry.addresses.empty() &&
+                 now < entry.expiry.after(staleTtl_))
+        {
+            // Stale while revalidate
+            addresses = entry.addresses;
+            startQuery = !entry.querying;
+            entry.querying = true;
+        }
+        else
+        {
+            entry.waiters.push_back(std::move(callback));
+            cached = false;
+            startQuery = !entry.querying;
+            entry.querying = true;
+        }
+    }
+    if (startQuery)
+    {
+        query(hostname);
+    }
+    if (cached)
+    {
+        callback(addresses);
+    }
+}
+
+void DnsCache::query(const std::string &hostname)
+{
+    LOG_TRACE << "dns query:" << hostname;
+    resolveFunc_(hostname, [this, hostname](const Addresses &addresses) {
+        onResolved(hostname, addresses);
+    });
+}
+
+void DnsCache::onResolved(const std::string &hostname,
+                          const Addresses &addresses)
+{
+    Addresses valid;
+    valid.reserve(addresses.size());
+    for (auto &addr : addresses)
+    {
+        if (isHostAddress(addr))
+        {
+            valid.push_back(addr);
+        }
+    }
+    auto now = trantor::Date::now();
+    std::vector<Callback> waiters;
+    Addresses result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &entry = entries_[hostname];
+        entry.querying = false;
+        if (!valid.empty())
+        {
+            entry.addresses = std::move(valid);
+            entry.expiry = now.after(ttl_);
+        }
+        else if (!entry.resolved || entry.addresses.empty() ||
+                 entry.expiry.after(staleTtl_) <= now)
+        {
+            entry.addresses.clear();
+            entry.expiry = now.after(negativeTtl_);
+        }
+        else
+        {
+            // Keep serving the stale addresses, the next lookup retries
+            LOG_WARN << "Failed to refresh the addresses of " << hostname;
+        }
+        entry.resolved = true;
+        waiters.swap(entry.waiters);
+        result = entry.addresses;
+    }
+    for (auto &waiter : waiters)
+    {
+        waiter(result);
+    }
+}
+
+void DnsCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto iter = entries_.begin(); iter != entries_.end();)
+    {
+        if (iter->second.querying)
+        {
+            iter->second.resolved = false;
+            iter->second.addresses.clear();
+            ++iter;
+        }
+        else
+        {
+            iter = entries_.erase(iter);
+        }
+    }
+}
+
+void DnsCache::evictExpired(const trantor::Date &now)
+{
+    for (auto iter = entries_.begin(); iter != entries_.end();)
+    {
+        auto &entry = iter->second;
+        if (!entry.querying && entry.expiry.after(staleTtl_) <= now)
+        {
+            iter = entries_.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+DnsCache::Addresses drogon::interleaveAddressFamilies(
+    const DnsCache::Addresses &addresses)
+{
+    DnsCache::Addresses v6, v4;
+    for (auto &addr : addresses)
+    {
+        (addr.isIpV6() ? v6 : v4).push_back(addr);
+    }
+    DnsCache::Addresses result;
+    result.reserve(addresses.size());
+    for (size_t i = 0; i < v6.size() || i < v4.size(); ++i)
+    {
+        if (i < v6.size())
+        {
+            result.push_back(v6[i]);
+        }
+        if (i < v4.size())
+        {
+            result.push_back(v4[i]);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,127 @@
+/**
+ *
+ *  @file DnsCache.h
+ *  Process-wide cache of the addresses of the servers the clients connect to
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Caches the results of the DNS queries of the HTTP clients, shared by
+ * all of them so that a reconnect does not wait for a query.
+ *
+ * - Addresses are kept for the TTL; failed queries (no valid address) for the
+ *   negative TTL, so a bad hostname does not send a query per request.
+ * - Once the TTL passed, the stale addresses are still returned for the stale
+ *   TTL while one query refreshes them in the background. They are kept if
+ *   the refreshing query fails.
+ * - The lookups of a hostname waiting for a query share it.
+ *
+ * The resolver of trantor does not report the TTLs of the records, the
+ * configured TTL is used for all of them.
+ */
+class DnsCache : public trantor::NonCopyable
+{
+  public:
+    using Addresses = std::vector<trantor::InetAddress>;
+    using Callback = std::function<void(const Addresses &)>;
+    /// Queries the addresses of a hostname, calls back with none on failure
+    using ResolveFunction =
+        std::function<void(const std::string &hostname, Callback &&callback)>;
+
+    /// The cache is built on the resolver of trantor when resolveFunc is empty
+    explicit DnsCache(ResolveFunction resolveFunc = {});
+
+    static DnsCache &instance()
+    {
+        static DnsCache cache;
+        return cache;
+    }
+
+    /// In seconds
+    void setTtl(double ttl)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ttl_ = ttl;
+    }
+
+    void setNegativeTtl(double ttl)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        negativeTtl_ = ttl;
+    }
+
+    void setStaleTtl(double ttl)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        staleTtl_ = ttl;
+    }
+
+    /**
+     * @brief Get the addresses of the hostname, none if it can't be resolved.
+     *
+     * @note The callback is called in the calling thread when the addresses
+     * are cached, in the thread of the resolver otherwise.
+     */
+    void resolve(const std::string &hostname, Callback &&callback);
+
+    /// Drop all the cached addresses, the queries in flight are kept
+    void clear();
+
+    /// The number of hostnames in the cache
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+  private:
+    struct Entry
+    {
+        Addresses addresses;
+        trantor::Date expiry;
+        bool resolved{false};
+        bool querying{false};
+        std::vector<Callback> waiters;
+    };
+
+    void query(const std::string &hostname);
+    void onResolved(const std::string &hostname, const Addresses &addresses);
+    // Called with mutex_ locked
+    void evictExpired(const trantor::Date &now);
+
+    ResolveFunction resolveFunc_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    double ttl_{60};
+    double negativeTtl_{5};
+    double staleTtl_{300};
+};
+
+/**
+ * @brief Order the addresses to connect to as RFC 8305 section 4 does: the
+ * families are interleaved, starting with IPv6, and the order of the
+ * addresses of each family is kept.
+ */
+DnsCache::Addresses interleaveAddressFamilies(
+    const DnsCache::Addresses &addresses);
+}  // namespace drogon
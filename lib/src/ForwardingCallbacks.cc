@@ -0,0 +1,136 @@
+/**
+ *
+ *  @file ForwardingCallbacks.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ForwardingCallbacks.h"
+#include "HttpResponseImpl.h"
+#include <drogon/HttpRequest.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/Logger.h>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using namespace drogon;
+
+namespace
+{
+// Shared by the loop of the client, which receives the body, and the loop of
+// the connection the response is sent on
+struct ForwardingState
+{
+    std::mutex mutex;
+    // Set once the headers of the response were sent to the client
+    ResponseStreamPtr stream;
+    // The data received before that
+    std::string pending;
+    bool finished{false};
+    bool failed{false};
+    std::weak_ptr<trantor::TcpConnection> downstream;
+};
+
+void endStream(ForwardingState &state)
+{
+    if (!state.failed)
+    {
+        state.stream->close();
+        return;
+    }
+    auto conn = state.downstream.lock();
+    if (!conn)
+    {
+        LOG_ERROR << "The forwarded body was interrupted";
+        state.stream->close();
+        return;
+    }
+    // Ending the body normally would make the truncated body look complete
+    LOG_ERROR << "The forwarded body was interrupted, closing the "
+                 "connection of "
+              << conn->peerAddr().toIpPort();
+    state.stream->abort();
+    conn->forceClose();
+}
+}  // namespace
+
+ForwardingCallbacks drogon::newForwardingCallbacks(
+    const HttpRequestPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    auto state = std::make_shared<ForwardingState>();
+    state->downstream = req->getConnectionPtr();
+    bool isHeadMethod = req->method() == Head;
+    ForwardingCallbacks callbacks;
+    callbacks.headersCallback = [state,
+                                 isHeadMethod,
+                                 callback = std::move(callback)](
+                                    ReqResult result,
+                                    const HttpResponsePtr &resp) {
+        if (result != ReqResult::Ok)
+        {
+            auto errResp = HttpResponse::newHttpResponse();
+            errResp->setStatusCode(k502BadGateway);
+            callback(errResp);
+            return;
+        }
+        auto respImplPtr = static_cast<HttpResponseImpl *>(resp.get());
+        respImplPtr->setPassThrough(true);
+        if (isHeadMethod || !respImplPtr->contentLengthIsAllowed() ||
+            respImplPtr->statusCode() == k304NotModified)
+        {
+            // No body
+            callback(resp);
+            return;
+        }
+        // A body of unknown length is relayed in chunks, see
+        // HttpResponseImpl::newResponseStream()
+        if (respImplPtr->getHeaderBy("content-length").empty())
+        {
+            respImplPtr->addHeader("transfer-encoding", "chunked");
+        }
+        respImplPtr->setAsyncStreamCallback(
+            [state](ResponseStreamPtr stream) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->pending.empty())
+                {
+                    stream->send(state->pending);
+                    state->pending.clear();
+                }
+                state->stream = std::move(stream);
+                if (state->finished)
+                {
+                    endStream(*state);
+                }
+            },
+            false);
+        callback(resp);
+    };
+    callbacks.dataCallback = [state](const char *data, size_t length) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->stream)
+        {
+            // False once the client went away
+            return state->stream->send(std::string(data, length));
+        }
+        state->pending.append(data, length);
+        return true;
+    };
+    callbacks.finishCallback = [state](ReqResult result) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->finished = true;
+        state->failed = result != ReqResult::Ok;
+        if (state->stream)
+        {
+            endStream(*state);
+        }
+    };
+    return callbacks;
+}
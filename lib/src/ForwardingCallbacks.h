@@ -0,0 +1,36 @@
+/**
+ *
+ *  @file ForwardingCallbacks.h
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/drogon_callbacks.h>
+#include <functional>
+
+namespace drogon
+{
+/**
+ * @brief The callbacks given to sendStreamRequest() by forwardRequest(): the
+ * response of the server becomes an async stream response, sent to the
+ * client of req with the body relayed as it arrives.
+ */
+struct ForwardingCallbacks
+{
+    HttpReqCallback headersCallback;
+    HttpRespDataCallback dataCallback;
+    HttpRespFinishCallback finishCallback;
+};
+
+ForwardingCallbacks newForwardingCallbacks(
+    const HttpRequestPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback);
+}  // namespace drogon
@@ -1,51 +1,93 @@
 #include <drogon/utils/monitoring/Histogram.h>
+#include <algorithm>
+
 using namespace drogon;
 using namespace drogon::monitoring;
 
 void Histogram::observe(double value)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
     if (maxAge_ > std::chrono::seconds(0) &&
-        timerId_ == trantor::InvalidTimerId)
+        !rotationStarted_.load(std::memory_order_acquire))
     {
-        std::weak_ptr<Histogram> weakPtr =
-            std::dynamic_pointer_cast<Histogram>(shared_from_this());
-        timerId_ = loopPtr_->runEvery(maxAge_ / timeBucketCount_, [weakPtr]() {
-            auto thisPtr = weakPtr.lock();
-            if (!thisPtr)
-                return;
-            thisPtr->rotateTimeBuckets();
-        });
+        startRotation();
     }
-    auto &currentBucket = timeBuckets_.back();
-    currentBucket.sum += value;
-    currentBucket.count += 1;
-    for (size_t i = 0; i < bucketBoundaries_.size(); i++)
+    auto &shard =
+        shards_[currentTimeBucket_.load(std::memory_order_acquire) *
+                    internal::shardCount() +
+                internal::currentShard()];
+    // The first bucket whose upper bound is not less than the value, the
+    // last one (+Inf) if there is none
+    auto index = std::lower_bound(bucketBoundaries_.begin(),
+                                  bucketBoundaries_.end(),
+                                  value) -
+                 bucketBoundaries_.begin();
+    shard.buckets[index].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    internal::atomicAdd(shard.sum, value);
+}
+
+void Histogram::startRotation()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (timerId_ != trantor::InvalidTimerId)
     {
-        if (value <= bucketBoundaries_[i])
-        {
-            currentBucket.buckets[i] += 1;
-            break;
-        }
+        return;
     }
-    if (value > bucketBoundaries_.back())
+    std::weak_ptr<Histogram> weakPtr =
+        std::dynamic_pointer_cast<Histogram>(shared_from_this());
+    timerId_ = loopPtr_->runEvery(maxAge_ / timeBucketCount_, [weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->rotateTimeBuckets();
+    });
+    rotationStarted_.store(true, std::memory_order_release);
+}
+
+void Histogram::rotateTimeBuckets()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    // The oldest time bucket expires and becomes the current one. A thread
+    // still writing to the previous one is counted in the previous one.
+    auto next = (currentTimeBucket_.load(std::memory_order_relaxed) + 1) %
+                timeBucketsInUse_;
+    for (size_t i = 0; i < internal::shardCount(); ++i)
     {
-        currentBucket.buckets.back() += 1;
+        auto &shard = shards_[next * internal::shardCount() + i];
+        for (size_t j = 0; j <= bucketBoundaries_.size(); ++j)
+        {
+            shard.buckets[j].store(0, std::memory_order_relaxed);
+        }
+        shard.count.store(0, std::memory_order_relaxed);
+        shard.sum.store(0, std::memory_order_relaxed);
     }
+    currentTimeBucket_.store(next, std::memory_order_release);
 }
 
 std::vector<Sample> Histogram::collect() const
 {
     std::vector<Sample> samples;
-    std::lock_guard<std::mutex> guard(mutex_);
+    TimeBucket total;
+    total.buckets.resize(bucketBoundaries_.size() + 1);
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (size_t i = 0; i < timeBucketsInUse_ * internal::shardCount(); ++i)
+        {
+            auto &shard = shards_[i];
+            for (size_t j = 0; j < total.buckets.size(); ++j)
+            {
+                total.buckets[j] +=
+                    shard.buckets[j].load(std::memory_order_relaxed);
+            }
+            total.count += shard.count.load(std::memory_order_relaxed);
+            total.sum += shard.sum.load(std::memory_order_relaxed);
+        }
+    }
     size_t count{0};
     for (size_t i = 0; i < bucketBoundaries_.size(); i++)
     {
         Sample sample;
-        for (auto &bucket : timeBuckets_)
-        {
-            count += bucket.buckets[i];
-        }
+        count += total.buckets[i];
         sample.name = name_ + "_bucket";
         sample.exLabels.emplace_back("le",
                                      std::to_string(bucketBoundaries_[i]));
@@ -53,28 +95,18 @@ std::vector<Sample> Histogram::collect() const
         samples.emplace_back(std::move(sample));
     }
     Sample sample;
-    for (auto &bucket : timeBuckets_)
-    {
-        count += bucket.buckets.back();
-    }
+    count += total.buckets.back();
     sample.name = name_ + "_bucket";
     sample.exLabels.emplace_back("le", "+Inf");
     sample.value = count;
     samples.emplace_back(std::move(sample));
-    double sum{0};
-    uint64_t totalCount{0};
-    for (auto &bucket : timeBuckets_)
-    {
-        sum += bucket.sum;
-        totalCount += bucket.count;
-    }
     Sample sumSample;
     sumSample.name = name_ + "_sum";
-    sumSample.value = sum;
+    sumSample.value = total.sum;
     samples.emplace_back(std::move(sumSample));
     Sample countSample;
     countSample.name = name_ + "_count";
-    countSample.value = totalCount;
+    countSample.value = total.count;
     samples.emplace_back(std::move(countSample));
     return samples;
 }
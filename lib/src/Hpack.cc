@@ -0,0 +1,625 @@
+/**
+ *
+ *  @file Hpack.cc
+ *  HPACK header compression for HTTP/2 (RFC 7541)
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Hpack.h"
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace drogon;
+using namespace drogon::hpack;
+
+namespace
+{
+struct HeaderField
+{
+    std::string_view name;
+    std::string_view value;
+};
+
+// RFC 7541 Appendix A
+const HeaderField staticTable[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+constexpr size_t staticTableSize = sizeof(staticTable) / sizeof(HeaderField);
+
+// RFC 7541 Appendix B, the code of each symbol aligned to the least
+// significant bit, and its length in bits
+const uint32_t huffmanCodes[256] = {
+    0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5,
+    0xfffffe6, 0xfffffe7, 0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9,
+    0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec, 0xfffffed, 0xfffffee,
+    0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+    0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9,
+    0xffffffa, 0xffffffb, 0x14, 0x3f8, 0x3f9, 0xffa,
+    0x1ff9, 0x15, 0xf8, 0x7fa, 0x3fa, 0x3fb,
+    0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+    0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b,
+    0x1c, 0x1d, 0x1e, 0x1f, 0x5c, 0xfb,
+    0x7ffc, 0x20, 0xffb, 0x3fc, 0x1ffa, 0x21,
+    0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+    0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e,
+    0x6f, 0x70, 0x71, 0x72, 0xfc, 0x73,
+    0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+    0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5,
+    0x25, 0x26, 0x27, 0x6, 0x74, 0x75,
+    0x28, 0x29, 0x2a, 0x7, 0x2b, 0x76,
+    0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+    0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd,
+    0x1ffd, 0xffffffc, 0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8,
+    0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9, 0x3fffd6, 0x7fffda,
+    0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+    0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1,
+    0x7fffe2, 0x7fffe3, 0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5,
+    0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef, 0x3fffda, 0x1fffdd,
+    0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+    0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf,
+    0x7fffeb, 0x7fffec, 0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2,
+    0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef, 0xfffea, 0x3fffe2,
+    0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+    0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2,
+    0x3fffe8, 0x1ffffec, 0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde,
+    0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed, 0x7fff2, 0x1fffe3,
+    0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+    0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3,
+    0x7ffffe4, 0x7ffffe5, 0xfffec, 0xfffff3, 0xfffed, 0x1fffe6,
+    0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3, 0x3fffea, 0x3fffeb,
+    0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+    0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8,
+    0x7ffffe9, 0x7ffffea, 0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed,
+    0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+};
+const uint8_t huffmanCodeLengths[256] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+};
+// The code of EOS, the padding of a Huffman string is a prefix of it
+constexpr uint32_t huffmanEos = 0x3fffffff;
+
+/**
+ * The decoding tree of the Huffman code, walked 8 bits at a time. A code
+ * shorter than 8 bits fills all the children of its prefix with the same
+ * leaf.
+ */
+struct HuffmanNode
+{
+    std::unique_ptr<std::array<HuffmanNode *, 256>> children;
+    uint8_t codeLength{0};
+    uint8_t symbol{0};
+};
+
+class HuffmanTree
+{
+  public:
+    HuffmanTree()
+    {
+        nodes_.emplace_back(new HuffmanNode);
+        root()->children = std::make_unique<std::array<HuffmanNode *, 256>>();
+        root()->children->fill(nullptr);
+        for (size_t sym = 0; sym < 256; ++sym)
+            addSymbol(static_cast<uint8_t>(sym),
+                      huffmanCodes[sym],
+                      huffmanCodeLengths[sym]);
+    }
+
+    HuffmanNode *root() const
+    {
+        return nodes_[0].get();
+    }
+
+  private:
+    void addSymbol(uint8_t symbol, uint32_t code, uint8_t length)
+    {
+        auto node = root();
+        while (length > 8)
+        {
+            length -= 8;
+            auto &child = (*node->children)[(code >> length) & 0xff];
+            if (!child)
+            {
+                child = new HuffmanNode;
+                nodes_.emplace_back(child);
+                child->children =
+                    std::make_unique<std::array<HuffmanNode *, 256>>();
+                child->children->fill(nullptr);
+            }
+            node = child;
+        }
+        // The leaf holds the length of the last part of the code
+        auto leaf = new HuffmanNode;
+        nodes_.emplace_back(leaf);
+        leaf->codeLength = length;
+        leaf->symbol = symbol;
+        auto shift = 8 - length;
+        auto start = (code << shift) & 0xff;
+        for (size_t i = start; i < start + (size_t{1} << shift); ++i)
+            (*node->children)[i] = leaf;
+    }
+
+    std::vector<std::unique_ptr<HuffmanNode>> nodes_;
+};
+
+const HuffmanTree &huffmanTree()
+{
+    static const HuffmanTree tree;
+    return tree;
+}
+
+// The index of the first static entry of each name
+const std::unordered_map<std::string_view, size_t> &staticNames()
+{
+    static const auto names = []() {
+        std::unordered_map<std::string_view, size_t> names;
+        for (size_t i = staticTableSize; i > 0; --i)
+            names[staticTable[i - 1].name] = i;
+        return names;
+    }();
+    return names;
+}
+
+// Fields whose values rarely repeat are not worth a dynamic table entry
+bool shouldIndex(std::string_view name)
+{
+    return name != "content-length" && name != "content-range" &&
+           name != "etag" && name != "last-modified" && name != "location" &&
+           name != "age" && name != "expires" && name != ":path";
+}
+
+// Never indexed, intermediaries must not compress them either
+bool isSensitive(std::string_view name)
+{
+    return name == "set-cookie" || name == "cookie" ||
+           name == "authorization" || name == "proxy-authorization";
+}
+
+void encodeInteger(size_t value,
+                   int prefixBits,
+                   uint8_t flags,
+                   std::string &out)
+{
+    size_t limit = (size_t{1} << prefixBits) - 1;
+    if (value < limit)
+    {
+        out.push_back(static_cast<char>(flags | value));
+        return;
+    }
+    out.push_back(static_cast<char>(flags | limit));
+    value -= limit;
+    while (value >= 128)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool decodeInteger(const uint8_t *&data,
+                   const uint8_t *end,
+                   int prefixBits,
+                   size_t &value)
+{
+    if (data >= end)
+        return false;
+    size_t limit = (size_t{1} << prefixBits) - 1;
+    value = *data++ & limit;
+    if (value < limit)
+        return true;
+    unsigned shift = 0;
+    while (data < end)
+    {
+        auto byte = *data++;
+        // Larger values are not sensible for any field of a header block
+        if (shift > 28)
+            return false;
+        value += static_cast<size_t>(byte & 0x7f) << shift;
+        shift += 7;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+void encodeString(std::string_view str, std::string &out)
+{
+    auto huffmanLength = huffmanEncodedLength(str);
+    if (huffmanLength < str.length())
+    {
+        encodeInteger(huffmanLength, 7, 0x80, out);
+        huffmanEncode(str, out);
+    }
+    else
+    {
+        encodeInteger(str.length(), 7, 0, out);
+        out.append(str.data(), str.length());
+    }
+}
+}  // namespace
+
+void DynamicTable::add(std::string_view name, std::string_view value)
+{
+    auto size = entrySize(name, value);
+    if (size > maxSize_)
+    {
+        // An entry larger than the table empties it (RFC 7541 4.4)
+        entries_.clear();
+        size_ = 0;
+        return;
+    }
+    evict(size);
+    entries_.emplace_front(std::string(name), std::string(value));
+    size_ += size;
+}
+
+void DynamicTable::setMaxSize(size_t maxSize)
+{
+    maxSize_ = maxSize;
+    evict(0);
+}
+
+void DynamicTable::evict(size_t required)
+{
+    while (!entries_.empty() && size_ + required > maxSize_)
+    {
+        auto &entry = entries_.back();
+        size_ -= entrySize(entry.first, entry.second);
+        entries_.pop_back();
+    }
+}
+
+size_t hpack::huffmanEncodedLength(std::string_view data)
+{
+    size_t bits = 0;
+    for (unsigned char c : data)
+        bits += huffmanCodeLengths[c];
+    return (bits + 7) / 8;
+}
+
+void hpack::huffmanEncode(std::string_view data, std::string &out)
+{
+    uint64_t bits = 0;
+    unsigned count = 0;
+    for (unsigned char c : data)
+    {
+        bits = (bits << huffmanCodeLengths[c]) | huffmanCodes[c];
+        count += huffmanCodeLengths[c];
+        while (count >= 8)
+        {
+            count -= 8;
+            out.push_back(static_cast<char>(bits >> count));
+        }
+    }
+    if (count > 0)
+    {
+        // Pad with the most significant bits of EOS
+        bits = (bits << (8 - count)) | (huffmanEos >> (22 + count));
+        out.push_back(static_cast<char>(bits));
+    }
+}
+
+bool hpack::huffmanDecode(const uint8_t *data, size_t len, std::string &out)
+{
+    auto root = huffmanTree().root();
+    auto node = root;
+    uint32_t bits = 0;
+    unsigned count = 0;
+    // Bits consumed since the last symbol, the padding must be shorter
+    // than 8 bits
+    unsigned sinceSymbol = 0;
+    for (size_t i = 0; i < len; ++i)
+    {
+        bits = (bits << 8) | data[i];
+        count += 8;
+        sinceSymbol += 8;
+        while (count >= 8)
+        {
+            node = (*node->children)[(bits >> (count - 8)) & 0xff];
+            if (!node)
+                return false;
+            if (node->children)
+            {
+                count -= 8;
+                continue;
+            }
+            out.push_back(static_cast<char>(node->symbol));
+            count -= node->codeLength;
+            sinceSymbol = count;
+            node = root;
+        }
+    }
+    while (count > 0)
+    {
+        auto next = (*node->children)[(bits << (8 - count)) & 0xff];
+        if (!next || next->children || next->codeLength > count)
+            break;
+        out.push_back(static_cast<char>(next->symbol));
+        count -= next->codeLength;
+        sinceSymbol = count;
+        node = root;
+    }
+    if (sinceSymbol > 7)
+        return false;
+    // The padding is made of the most significant bits of EOS, all ones
+    uint32_t mask = (1u << count) - 1;
+    return (bits & mask) == mask;
+}
+
+bool HpackDecoder::decodeString(const uint8_t *&data,
+                                const uint8_t *end,
+                                std::string &out)
+{
+    if (data >= end)
+        return false;
+    bool huffman = (*data & 0x80) != 0;
+    size_t length;
+    if (!decodeInteger(data, end, 7, length) ||
+        length > static_cast<size_t>(end - data))
+        return false;
+    out.clear();
+    if (huffman)
+    {
+        if (!hpack::huffmanDecode(data, length, out))
+            return false;
+    }
+    else
+    {
+        out.assign(reinterpret_cast<const char *>(data), length);
+    }
+    data += length;
+    return true;
+}
+
+bool HpackDecoder::field(size_t index,
+                         std::string_view &name,
+                         std::string_view &value)
+{
+    if (index == 0)
+        return false;
+    if (index <= staticTableSize)
+    {
+        name = staticTable[index - 1].name;
+        value = staticTable[index - 1].value;
+        return true;
+    }
+    index -= staticTableSize + 1;
+    if (index >= table_.count())
+        return false;
+    auto &entry = table_.at(index);
+    name = entry.first;
+    value = entry.second;
+    return true;
+}
+
+bool HpackDecoder::decode(const uint8_t *data,
+                          size_t len,
+                          const HeaderCallback &cb)
+{
+    auto end = data + len;
+    bool fieldSeen = false;
+    size_t listSize = 0;
+    headerListTooLarge_ = false;
+    // A few bytes referencing a large entry of the table make a large header
+    // list, the fields past the limit are dropped
+    auto emit = [this, &cb, &listSize](std::string_view name,
+                                       std::string_view value) {
+        if (headerListTooLarge_)
+            return;
+        listSize += hpack::entrySize(name, value);
+        if (maxHeaderListSize_ > 0 && listSize > maxHeaderListSize_)
+        {
+            headerListTooLarge_ = true;
+            return;
+        }
+        cb(name, value);
+    };
+    while (data < end)
+    {
+        auto byte = *data;
+        size_t index;
+        std::string_view name, value;
+        if (byte & 0x80)
+        {
+            // Indexed field
+            if (!decodeInteger(data, end, 7, index) ||
+                !field(index, name, value))
+                return false;
+            emit(name, value);
+            fieldSeen = true;
+            continue;
+        }
+        if ((byte & 0xe0) == 0x20)
+        {
+            // Dynamic table size update, only allowed before the fields
+            if (fieldSeen || !decodeInteger(data, end, 5, index) ||
+                index > maxTableSize_)
+                return false;
+            table_.setMaxSize(index);
+            continue;
+        }
+        // Literal with incremental indexing (6 bit prefix), without indexing
+        // or never indexed (4 bit prefix)
+        bool indexing = (byte & 0xc0) == 0x40;
+        if (!decodeInteger(data, end, indexing ? 6 : 4, index))
+            return false;
+        if (index == 0)
+        {
+            if (!decodeString(data, end, name_))
+                return false;
+            name = name_;
+        }
+        else
+        {
+            std::string_view unused;
+            if (!field(index, name, unused))
+                return false;
+            // The name may be evicted by the insertion below
+            name_.assign(name.data(), name.length());
+            name = name_;
+        }
+        if (!decodeString(data, end, value_))
+            return false;
+        value = value_;
+        if (indexing)
+            table_.add(name, value);
+        emit(name, value);
+        fieldSeen = true;
+    }
+    return true;
+}
+
+void HpackEncoder::setMaxTableSize(size_t size)
+{
+    // Use 4096 bytes at most whatever the peer allows
+    size = (std::min)(size, size_t{4096});
+    if (!sizeUpdatePending_ || size < pendingMinSize_)
+        pendingMinSize_ = size;
+    sizeUpdatePending_ = true;
+    table_.setMaxSize(size);
+}
+
+void HpackEncoder::beginBlock(std::string &out)
+{
+    if (!sizeUpdatePending_)
+        return;
+    sizeUpdatePending_ = false;
+    if (pendingMinSize_ < table_.maxSize())
+        encodeInteger(pendingMinSize_, 5, 0x20, out);
+    encodeInteger(table_.maxSize(), 5, 0x20, out);
+}
+
+void HpackEncoder::encode(std::string_view name,
+                          std::string_view value,
+                          std::string &out)
+{
+    size_t nameIndex = 0;
+    auto &names = staticNames();
+    auto iter = names.find(name);
+    if (iter != names.end())
+    {
+        nameIndex = iter->second;
+        for (auto i = nameIndex;
+             i <= staticTableSize && staticTable[i - 1].name == name;
+             ++i)
+        {
+            if (staticTable[i - 1].value == value)
+            {
+                encodeInteger(i, 7, 0x80, out);
+                return;
+            }
+        }
+    }
+    bool sensitive = isSensitive(name);
+    if (!sensitive)
+    {
+        for (size_t i = 0; i < table_.count(); ++i)
+        {
+            auto &entry = table_.at(i);
+            if (entry.first != name)
+                continue;
+            if (entry.second == value)
+            {
+                encodeInteger(staticTableSize + 1 + i, 7, 0x80, out);
+                return;
+            }
+            if (nameIndex == 0)
+                nameIndex = staticTableSize + 1 + i;
+        }
+    }
+    bool indexing = !sensitive && shouldIndex(name) &&
+                    entrySize(name, value) <= table_.maxSize() / 2;
+    if (indexing)
+        encodeInteger(nameIndex, 6, 0x40, out);
+    else
+        encodeInteger(nameIndex, 4, sensitive ? 0x10 : 0, out);
+    if (nameIndex == 0)
+        encodeString(name, out);
+    encodeString(value, out);
+    if (indexing)
+        table_.add(name, value);
+}
@@ -0,0 +1,162 @@
+/**
+ *
+ *  @file Hpack.h
+ *  HPACK header compression for HTTP/2 (RFC 7541)
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace drogon
+{
+namespace hpack
+{
+/// The size of a table entry, its name and value plus 32 bytes of overhead
+inline size_t entrySize(std::string_view name, std::string_view value)
+{
+    return name.length() + value.length() + 32;
+}
+
+/// The table of the header fields added by the literals with indexing
+class DynamicTable
+{
+  public:
+    explicit DynamicTable(size_t maxSize) : maxSize_(maxSize)
+    {
+    }
+
+    void add(std::string_view name, std::string_view value);
+    void setMaxSize(size_t maxSize);
+
+    size_t maxSize() const
+    {
+        return maxSize_;
+    }
+
+    size_t count() const
+    {
+        return entries_.size();
+    }
+
+    /// The entry at index (0 is the newest one)
+    const std::pair<std::string, std::string> &at(size_t index) const
+    {
+        return entries_[index];
+    }
+
+  private:
+    void evict(size_t required);
+
+    std::deque<std::pair<std::string, std::string>> entries_;
+    size_t size_{0};
+    size_t maxSize_;
+};
+
+/// Append the Huffman encoding of data
+void huffmanEncode(std::string_view data, std::string &out);
+/// The length of the Huffman encoding of data
+size_t huffmanEncodedLength(std::string_view data);
+/// Append the decoding of data, false if it is not valid
+bool huffmanDecode(const uint8_t *data, size_t len, std::string &out);
+}  // namespace hpack
+
+/**
+ * @brief Decodes the header blocks received on an HTTP/2 connection. Any
+ * error is a connection error of type COMPRESSION_ERROR.
+ */
+class HpackDecoder
+{
+  public:
+    using HeaderCallback =
+        std::function<void(std::string_view name, std::string_view value)>;
+
+    /// maxTableSize is the SETTINGS_HEADER_TABLE_SIZE sent to the peer
+    explicit HpackDecoder(size_t maxTableSize = 4096)
+        : table_(maxTableSize), maxTableSize_(maxTableSize)
+    {
+    }
+
+    /**
+     * @brief Limit the size of the decoded header lists, the sum of the
+     * entry sizes of their fields (SETTINGS_MAX_HEADER_LIST_SIZE). 0, the
+     * default, means no limit.
+     */
+    void setMaxHeaderListSize(size_t size)
+    {
+        maxHeaderListSize_ = size;
+    }
+
+    /**
+     * @brief Decode a complete header block, calling cb for each field.
+     * Once the header list is over its limit, the rest of the block is
+     * decoded for the state of the table but cb is not called any more.
+     * @return false if the block is not valid.
+     */
+    bool decode(const uint8_t *data, size_t len, const HeaderCallback &cb);
+
+    /// Whether the last block decoded was over the header list size limit
+    bool headerListTooLarge() const
+    {
+        return headerListTooLarge_;
+    }
+
+  private:
+    bool decodeString(const uint8_t *&data,
+                      const uint8_t *end,
+                      std::string &out);
+    bool field(size_t index, std::string_view &name, std::string_view &value);
+
+    hpack::DynamicTable table_;
+    size_t maxTableSize_;
+    size_t maxHeaderListSize_{0};
+    bool headerListTooLarge_{false};
+    std::string name_;
+    std::string value_;
+};
+
+/**
+ * @brief Encodes the header blocks sent on an HTTP/2 connection, fields
+ * found in the tables are sent as indexes and the others are added to the
+ * dynamic table unless their values rarely repeat.
+ */
+class HpackEncoder
+{
+  public:
+    HpackEncoder() : table_(4096)
+    {
+    }
+
+    /// Apply the SETTINGS_HEADER_TABLE_SIZE of the peer
+    void setMaxTableSize(size_t size);
+
+    /// Start a header block, before the first encode() call
+    void beginBlock(std::string &out);
+
+    /// Encode a field, the name must be in lower case
+    void encode(std::string_view name,
+                std::string_view value,
+                std::string &out);
+
+  private:
+    hpack::DynamicTable table_;
+    // The smallest size set by the peer since the last block, sent at the
+    // start of the next one
+    size_t pendingMinSize_{0};
+    bool sizeUpdatePending_{false};
+};
+}  // namespace drogon
@@ -0,0 +1,1290 @@
+/**
+ *
+ *  @file Http2Connection.cc
+ *  The HTTP/2 framing layer of a server connection (RFC 9113)
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "Http2Connection.h"
+#include "HttpAppFrameworkImpl.h"
+#include "HttpRequestImpl.h"
+#include "HttpResponseImpl.h"
+#include "ObjectPool.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace drogon;
+
+namespace
+{
+enum FrameType : uint8_t
+{
+    kData = 0x0,
+    kHeaders = 0x1,
+    kPriority = 0x2,
+    kRstStream = 0x3,
+    kSettings = 0x4,
+    kPushPromise = 0x5,
+    kPing = 0x6,
+    kGoAway = 0x7,
+    kWindowUpdate = 0x8,
+    kContinuation = 0x9,
+    kPriorityUpdate = 0x10
+};
+
+enum FrameFlag : uint8_t
+{
+    kEndStream = 0x1,
+    kAck = 0x1,
+    kEndHeaders = 0x4,
+    kPadded = 0x8,
+    kPriorityFlag = 0x20
+};
+
+enum ErrorCode : uint32_t
+{
+    kNoError = 0x0,
+    kProtocolError = 0x1,
+    kInternalError = 0x2,
+    kFlowControlError = 0x3,
+    kStreamClosed = 0x5,
+    kFrameSizeError = 0x6,
+    kRefusedStream = 0x7,
+    kCompressionError = 0x9,
+    kEnhanceYourCalm = 0xb
+};
+
+enum SettingId : uint16_t
+{
+    kHeaderTableSize = 0x1,
+    kEnablePush = 0x2,
+    kMaxConcurrentStreams = 0x3,
+    kInitialWindowSize = 0x4,
+    kMaxFrameSize = 0x5,
+    kMaxHeaderListSize = 0x6
+};
+
+constexpr size_t frameHeaderLength = 9;
+// The SETTINGS_MAX_FRAME_SIZE of the server is left to its default
+constexpr size_t maxFrameSize = 16384;
+constexpr int64_t maxWindowSize = 0x7fffffff;
+
+uint32_t readUint32(const uint8_t *p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+           (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+void writeUint32(char *p, uint32_t value)
+{
+    p[0] = static_cast<char>(value >> 24);
+    p[1] = static_cast<char>(value >> 16);
+    p[2] = static_cast<char>(value >> 8);
+    p[3] = static_cast<char>(value);
+}
+
+bool isConnectionSpecific(std::string_view name)
+{
+    return name == "connection" || name == "keep-alive" ||
+           name == "proxy-connection" || name == "transfer-encoding" ||
+           name == "upgrade";
+}
+
+bool hasUpperCase(std::string_view name)
+{
+    return std::any_of(name.begin(), name.end(), [](char c) {
+        return c >= 'A' && c <= 'Z';
+    });
+}
+
+/// Parse an RFC 9218 priority field value, e.g. "u=1, i"
+void parsePriority(std::string_view value, uint8_t &urgency, bool &incremental)
+{
+    while (!value.empty())
+    {
+        auto comma = value.find(',');
+        auto item = value.substr(0, comma);
+        value = comma == std::string_view::npos ? std::string_view{}
+                                                : value.substr(comma + 1);
+        while (!item.empty() && item.front() == ' ')
+            item.remove_prefix(1);
+        while (!item.empty() && item.back() == ' ')
+            item.remove_suffix(1);
+        if (item.size() == 3 && item[0] == 'u' && item[1] == '=' &&
+            item[2] >= '0' && item[2] <= '7')
+        {
+            urgency = static_cast<uint8_t>(item[2] - '0');
+        }
+        else if (item == "i" || item == "i=?1")
+        {
+            incremental = true;
+        }
+        else if (item == "i=?0")
+        {
+            incremental = false;
+        }
+    }
+}
+
+/// Read a range of a file for the DATA frames of a stream
+std::function<std::size_t(char *, std::size_t)> fileReader(
+    const std::string &path,
+    size_t offset,
+    size_t length)
+{
+    auto file = std::make_shared<std::ifstream>(utils::toNativePath(path),
+                                                std::ios::binary);
+    if (!*file)
+        return nullptr;
+    if (length == 0)
+    {
+        file->seekg(0, std::ios::end);
+        auto size = static_cast<size_t>(file->tellg());
+        if (size < offset)
+            return nullptr;
+        length = size - offset;
+    }
+    file->seekg(static_cast<std::streamoff>(offset));
+    return [file = std::move(file),
+            remaining = length](char *buffer, size_t size) mutable -> size_t {
+        if (!buffer)
+        {
+            file->close();
+            return 0;
+        }
+        auto len = (std::min)(size, remaining);
+        if (len == 0)
+            return 0;
+        file->read(buffer, static_cast<std::streamsize>(len));
+        auto count = static_cast<size_t>(file->gcount());
+        remaining -= count;
+        return count;
+    };
+}
+}  // namespace
+
+/**
+ * The transport of the async stream responses. The data is queued in the
+ * loop of the connection, so the stream can be used from any thread.
+ */
+class Http2Connection::AsyncStream : public trantor::AsyncStream
+{
+  public:
+    AsyncStream(std::weak_ptr<Http2Connection> connection, uint32_t streamId)
+        : connection_(std::move(connection)), streamId_(streamId)
+    {
+    }
+
+    ~AsyncStream() override
+    {
+        close();
+    }
+
+    using trantor::AsyncStream::send;
+
+    bool send(const char *data, size_t len) override
+    {
+        if (closed_)
+            return false;
+        auto connection = connection_.lock();
+        if (!connection)
+            return false;
+        if (len == 0)
+            return true;
+        auto loop = connection->getLoop();
+        loop->queueInLoop([connection = std::move(connection),
+                           streamId = streamId_,
+                           data = std::string(data, len)]() mutable {
+            connection->sendStreamData(streamId, std::move(data));
+        });
+        return true;
+    }
+
+    void close() override
+    {
+        if (closed_)
+            return;
+        closed_ = true;
+        if (auto connection = connection_.lock())
+        {
+            auto loop = connection->getLoop();
+            loop->queueInLoop(
+                [connection = std::move(connection), streamId = streamId_]() {
+                    connection->endStreamData(streamId);
+                });
+        }
+    }
+
+  private:
+    std::weak_ptr<Http2Connection> connection_;
+    uint32_t streamId_;
+    bool closed_{false};
+};
+
+Http2Connection::Http2Connection(trantor::EventLoop *loop) : loop_(loop)
+{
+    decoder_.setMaxHeaderListSize(maxHeaderListSize);
+}
+
+Http2Connection::~Http2Connection()
+{
+    onClose();
+}
+
+void Http2Connection::start()
+{
+    // SETTINGS, then a WINDOW_UPDATE opening the connection window
+    const std::pair<uint16_t, uint32_t> settings[] = {
+        {kMaxConcurrentStreams, maxConcurrentStreams},
+        {kInitialWindowSize, streamWindowSize},
+        {kMaxHeaderListSize, maxHeaderListSize}};
+    writeFrameHeader(sizeof(settings) / sizeof(settings[0]) * 6,
+                     kSettings,
+                     0,
+                     0);
+    for (auto &setting : settings)
+    {
+        char entry[6];
+        entry[0] = static_cast<char>(setting.first >> 8);
+        entry[1] = static_cast<char>(setting.first);
+        writeUint32(entry + 2, setting.second);
+        output_.append(entry, sizeof(entry));
+    }
+    writeWindowUpdate(0, connectionWindowSize - 65535);
+    connRecvWindow_ = connectionWindowSize;
+    flush();
+}
+
+void Http2Connection::onMessage(trantor::MsgBuffer *buffer)
+{
+    if (!prefaceReceived_ && !closed_)
+    {
+        auto len = (std::min)(buffer->readableBytes(), clientPreface.size());
+        if (memcmp(buffer->peek(), clientPreface.data(), len) != 0)
+        {
+            connectionError(kProtocolError);
+        }
+        else if (len < clientPreface.size())
+        {
+            return;
+        }
+        else
+        {
+            buffer->retrieve(clientPreface.size());
+            prefaceReceived_ = true;
+        }
+    }
+    while (!closed_ && buffer->readableBytes() >= frameHeaderLength)
+    {
+        auto header = reinterpret_cast<const uint8_t *>(buffer->peek());
+        size_t length = (size_t(header[0]) << 16) | (size_t(header[1]) << 8) |
+                        size_t(header[2]);
+        if (length > maxFrameSize)
+        {
+            connectionError(kFrameSizeError);
+            break;
+        }
+        if (buffer->readableBytes() < frameHeaderLength + length)
+            break;
+        processFrame(header[3],
+                     header[4],
+                     readUint32(header + 5) & 0x7fffffff,
+                     header + frameHeaderLength,
+                     length);
+        buffer->retrieve(frameHeaderLength + length);
+    }
+    if (closed_)
+        buffer->retrieveAll();
+    flush();
+}
+
+void Http2Connection::onClose()
+{
+    closed_ = true;
+    for (auto &item : streams_)
+    {
+        auto &stream = item.second;
+        if (stream.dataCallback)
+        {
+            stream.dataCallback(nullptr, 0);
+            stream.dataCallback = nullptr;
+        }
+    }
+    streams_.clear();
+}
+
+void Http2Connection::onWriteComplete()
+{
+    unconfirmedBytes_ = 0;
+    if (closed_)
+        return;
+    sendPendingData();
+    flush();
+}
+
+void Http2Connection::processFrame(uint8_t type,
+                                   uint8_t flags,
+                                   uint32_t streamId,
+                                   const uint8_t *payload,
+                                   size_t length)
+{
+    // The first frame of the client is its SETTINGS, and nothing can come
+    // between the frames of a header block
+    if ((!settingsReceived_ && (type != kSettings || (flags & kAck))) ||
+        (continuationStreamId_ != 0 &&
+         (type != kContinuation || streamId != continuationStreamId_)))
+    {
+        connectionError(kProtocolError);
+        return;
+    }
+    switch (type)
+    {
+        case kData:
+            onData(flags, streamId, payload, length);
+            break;
+        case kHeaders:
+            onHeaders(flags, streamId, payload, length);
+            break;
+        case kPriority:
+            if (streamId == 0)
+                connectionError(kProtocolError);
+            else if (length != 5)
+                resetStream(streamId, kFrameSizeError);
+            break;
+        case kRstStream:
+        {
+            if (streamId == 0 || streamId > lastStreamId_)
+            {
+                connectionError(kProtocolError);
+                break;
+            }
+            if (length != 4)
+            {
+                connectionError(kFrameSizeError);
+                break;
+            }
+            auto iter = streams_.find(streamId);
+            if (iter != streams_.end())
+                eraseStream(iter);
+            countReset();
+            break;
+        }
+        case kSettings:
+            onSettings(flags, payload, length);
+            break;
+        case kPushPromise:
+            // Clients never push
+            connectionError(kProtocolError);
+            break;
+        case kPing:
+            if (streamId != 0)
+            {
+                connectionError(kProtocolError);
+                break;
+            }
+            if (length != 8)
+            {
+                connectionError(kFrameSizeError);
+                break;
+            }
+            if (!(flags & kAck))
+            {
+                writeFrameHeader(8, kPing, kAck, 0);
+                output_.append(reinterpret_cast<const char *>(payload), 8);
+            }
+            break;
+        case kGoAway:
+            if (streamId != 0)
+            {
+                connectionError(kProtocolError);
+                break;
+            }
+            // Finish the streams being processed, accept no new one
+            goingAway_ = true;
+            if (streams_.empty() && closeCallback_)
+            {
+                closed_ = true;
+                closeCallback_();
+            }
+            break;
+        case kWindowUpdate:
+            if (length != 4)
+            {
+                connectionError(kFrameSizeError);
+                break;
+            }
+            onWindowUpdate(streamId, payload);
+            break;
+        case kContinuation:
+        {
+            if (continuationStreamId_ == 0)
+            {
+                connectionError(kProtocolError);
+                break;
+            }
+            if (headerBlock_.size() + length > maxHeaderBlockSize)
+            {
+                connectionError(kProtocolError);
+                break;
+            }
+            headerBlock_.append(reinterpret_cast<const char *>(payload),
+                                length);
+            if (flags & kEndHeaders)
+            {
+                continuationStreamId_ = 0;
+                onHeaderBlock(streamId, continuationEndStream_);
+            }
+            break;
+        }
+        case kPriorityUpdate:
+            if (streamId != 0)
+            {
+                connectionError(kProtocolError);
+                break;
+            }
+            onPriorityUpdate(payload, length);
+            break;
+        default:
+            // Unknown frame types are ignored
+            break;
+    }
+}
+
+void Http2Connection::onData(uint8_t flags,
+                             uint32_t streamId,
+                             const uint8_t *payload,
+                             size_t length)
+{
+    if (streamId == 0 || streamId > lastStreamId_)
+    {
+        connectionError(kProtocolError);
+        return;
+    }
+    // The whole frame counts for flow control, padding included
+    connRecvWindow_ -= static_cast<int64_t>(length);
+    if (connRecvWindow_ < 0)
+    {
+        connectionError(kFlowControlError);
+        return;
+    }
+    connRecvUnacked_ += length;
+    if (connRecvUnacked_ >= connectionWindowSize / 2)
+    {
+        writeWindowUpdate(0, static_cast<uint32_t>(connRecvUnacked_));
+        connRecvWindow_ += static_cast<int64_t>(connRecvUnacked_);
+        connRecvUnacked_ = 0;
+    }
+
+    size_t padding = 0;
+    if (flags & kPadded)
+    {
+        if (length < 1 || payload[0] >= length)
+        {
+            connectionError(kProtocolError);
+            return;
+        }
+        padding = payload[0];
+        ++payload;
+        length -= padding + 1;
+    }
+    auto iter = streams_.find(streamId);
+    if (iter == streams_.end())
+    {
+        // Closed or reset, the window was updated above
+        return;
+    }
+    auto &stream = iter->second;
+    if (stream.remoteClosed)
+    {
+        resetStream(streamId, kStreamClosed);
+        return;
+    }
+    stream.recvWindow -= static_cast<int64_t>(length + padding);
+    if (stream.recvWindow < 0)
+    {
+        resetStream(streamId, kFlowControlError);
+        return;
+    }
+    if (!stream.bodyTooLarge && !stream.headersTooLarge && length > 0)
+    {
+        auto &req = stream.request;
+        if (req->bodyLength() + length >
+            HttpAppFrameworkImpl::instance().getClientMaxBodySize())
+        {
+            // Answered right away, the rest of the body is dropped
+            stream.bodyTooLarge = true;
+            dispatch(stream);
+            return;
+        }
+        else
+        {
+            req->appendToBody(reinterpret_cast<const char *>(payload),
+                              length);
+        }
+    }
+    if (flags & kEndStream)
+    {
+        stream.remoteClosed = true;
+        dispatch(stream);
+        return;
+    }
+    stream.recvUnacked += length + padding;
+    if (stream.recvUnacked >= streamWindowSize / 2)
+    {
+        writeWindowUpdate(streamId, static_cast<uint32_t>(stream.recvUnacked));
+        stream.recvWindow += static_cast<int64_t>(stream.recvUnacked);
+        stream.recvUnacked = 0;
+    }
+}
+
+void Http2Connection::onHeaders(uint8_t flags,
+                                uint32_t streamId,
+                                const uint8_t *payload,
+                                size_t length)
+{
+    if (streamId == 0 || (streamId & 1) == 0)
+    {
+        connectionError(kProtocolError);
+        return;
+    }
+    size_t offset = 0;
+    size_t padding = 0;
+    if (flags & kPadded)
+    {
+        if (length < 1)
+        {
+            connectionError(kProtocolError);
+            return;
+        }
+        padding = payload[0];
+        offset = 1;
+    }
+    if (flags & kPriorityFlag)
+    {
+        // RFC 7540 priorities are ignored
+        offset += 5;
+    }
+    if (offset + padding > length)
+    {
+        connectionError(kProtocolError);
+        return;
+    }
+    headerBlock_.assign(reinterpret_cast<const char *>(payload) + offset,
+                        length - offset - padding);
+    if (flags & kEndHeaders)
+    {
+        onHeaderBlock(streamId, flags & kEndStream);
+        return;
+    }
+    continuationStreamId_ = streamId;
+    continuationEndStream_ = flags & kEndStream;
+}
+
+void Http2Connection::onHeaderBlock(uint32_t streamId, bool endStream)
+{
+    auto iter = streams_.find(streamId);
+    bool isNew = iter == streams_.end();
+    if (isNew && streamId <= lastStreamId_)
+    {
+        // Headers on a closed stream
+        connectionError(kStreamClosed);
+        return;
+    }
+    HttpRequestImplPtr req;
+    bool refused = false;
+    if (isNew)
+    {
+        lastStreamId_ = streamId;
+        refused = goingAway_ || streams_.size() >= maxConcurrentStreams;
+        if (!refused)
+        {
+            req = ObjectPool<HttpRequestImpl>::acquire(loop_);
+            req->setVersion(Version::kHttp11);
+        }
+    }
+    // The block is decoded even when its fields are dropped, for the state
+    // of the decoder
+    bool malformed = false;
+    bool pseudoHeadersDone = false;
+    bool hasMethod = false;
+    bool hasPath = false;
+    bool hasScheme = false;
+    bool hasHost = false;
+    std::string authority;
+    uint8_t urgency = 3;
+    bool incremental = false;
+    auto decoded = decoder_.decode(
+        reinterpret_cast<const uint8_t *>(headerBlock_.data()),
+        headerBlock_.size(),
+        [&](std::string_view name, std::string_view value) {
+            if (!req || malformed)
+                return;
+            if (!name.empty() && name[0] == ':')
+            {
+                if (pseudoHeadersDone)
+                {
+                    malformed = true;
+                }
+                else if (name == ":method")
+                {
+                    malformed = hasMethod ||
+                                !req->setMethod(value.data(),
+                                                value.data() + value.size());
+                    hasMethod = true;
+                }
+                else if (name == ":path")
+                {
+                    malformed = hasPath || value.empty();
+                    hasPath = true;
+                    auto question = value.find('?');
+                    if (question == std::string_view::npos)
+                    {
+                        req->setPath(value.data(),
+                                     value.data() + value.size());
+                    }
+                    else
+                    {
+                        req->setPath(value.data(), value.data() + question);
+                        req->setQuery(value.data() + question + 1,
+                                      value.data() + value.size());
+                    }
+                }
+                else if (name == ":scheme")
+                {
+                    malformed = hasScheme;
+                    hasScheme = true;
+                }
+                else if (name == ":authority")
+                {
+                    authority.assign(value);
+                }
+                else
+                {
+                    malformed = true;
+                }
+                return;
+            }
+            pseudoHeadersDone = true;
+            if (hasUpperCase(name) || isConnectionSpecific(name) ||
+                (name == "te" && value != "trailers"))
+            {
+                malformed = true;
+                return;
+            }
+            if (name == "host")
+                hasHost = true;
+            else if (name == "priority")
+                parsePriority(value, urgency, incremental);
+            // The parser of HTTP/1 requests expects "name:value"
+            scratch_.assign(name);
+            scratch_.push_back(':');
+            scratch_.append(value);
+            req->addHeader(scratch_.data(),
+                           scratch_.data() + name.size(),
+                           scratch_.data() + scratch_.size());
+        });
+    headerBlock_.clear();
+    if (!decoded)
+    {
+        connectionError(kCompressionError);
+        return;
+    }
+    if (!isNew)
+    {
+        // Trailers, their fields are dropped
+        if (iter->second.remoteClosed)
+        {
+            resetStream(streamId, kStreamClosed);
+        }
+        else if (!endStream)
+        {
+            resetStream(streamId, kProtocolError);
+        }
+        else
+        {
+            iter->second.remoteClosed = true;
+            dispatch(iter->second);
+        }
+        return;
+    }
+    if (refused)
+    {
+        resetStream(streamId, kRefusedStream);
+        return;
+    }
+    if (decoder_.headerListTooLarge())
+    {
+        // Answered right away, the body is dropped
+        auto &stream = streams_[streamId];
+        stream.id = streamId;
+        stream.request = std::move(req);
+        stream.sendWindow = peerInitialWindow_;
+        stream.recvWindow = streamWindowSize;
+        stream.remoteClosed = endStream;
+        stream.headersTooLarge = true;
+        dispatch(stream);
+        return;
+    }
+    if (malformed || !hasMethod || !hasPath || !hasScheme)
+    {
+        resetStream(streamId, kProtocolError);
+        return;
+    }
+    if (!hasHost && !authority.empty())
+    {
+        static const std::string_view host{"host:"};
+        scratch_.assign(host);
+        scratch_.append(authority);
+        req->addHeader(scratch_.data(),
+                       scratch_.data() + host.size() - 1,
+                       scratch_.data() + scratch_.size());
+    }
+    req->setCreationDate(trantor::Date::date());
+    auto &stream = streams_[streamId];
+    stream.id = streamId;
+    stream.request = std::move(req);
+    stream.sendWindow = peerInitialWindow_;
+    stream.recvWindow = streamWindowSize;
+    stream.urgency = urgency;
+    stream.incremental = incremental;
+    if (endStream)
+    {
+        stream.remoteClosed = true;
+        dispatch(stream);
+    }
+}
+
+void Http2Connection::onSettings(uint8_t flags,
+                                 const uint8_t *payload,
+                                 size_t length)
+{
+    if (flags & kAck)
+    {
+        if (length != 0)
+            connectionError(kFrameSizeError);
+        return;
+    }
+    if (length % 6 != 0)
+    {
+        connectionError(kFrameSizeError);
+        return;
+    }
+    settingsReceived_ = true;
+    for (size_t i = 0; i < length; i += 6)
+    {
+        auto id = static_cast<uint16_t>((payload[i] << 8) | payload[i + 1]);
+        auto value = readUint32(payload + i + 2);
+        switch (id)
+        {
+            case kHeaderTableSize:
+                encoder_.setMaxTableSize(value);
+                break;
+            case kEnablePush:
+                if (value > 1)
+                {
+                    connectionError(kProtocolError);
+                    return;
+                }
+                break;
+            case kInitialWindowSize:
+            {
+                if (value > maxWindowSize)
+                {
+                    connectionError(kFlowControlError);
+                    return;
+                }
+                // The difference applies to the windows of all the streams
+                auto delta = static_cast<int64_t>(value) - peerInitialWindow_;
+                peerInitialWindow_ = value;
+                for (auto &item : streams_)
+                {
+                    item.second.sendWindow += delta;
+                    if (item.second.sendWindow > maxWindowSize)
+                    {
+                        connectionError(kFlowControlError);
+                        return;
+                    }
+                }
+                break;
+            }
+            case kMaxFrameSize:
+                if (value < 16384 || value > 16777215)
+                {
+                    connectionError(kProtocolError);
+                    return;
+                }
+                peerMaxFrameSize_ = value;
+                break;
+            default:
+                // SETTINGS_MAX_CONCURRENT_STREAMS is about pushes, which are
+                // never sent, unknown settings are ignored
+                break;
+        }
+    }
+    writeFrameHeader(0, kSettings, kAck, 0);
+    sendPendingData();
+}
+
+void Http2Connection::onWindowUpdate(uint32_t streamId, const uint8_t *payload)
+{
+    auto increment = readUint32(payload) & 0x7fffffff;
+    if (streamId == 0)
+    {
+        if (increment == 0)
+        {
+            connectionError(kProtocolError);
+            return;
+        }
+        connSendWindow_ += increment;
+        if (connSendWindow_ > maxWindowSize)
+        {
+            connectionError(kFlowControlError);
+            return;
+        }
+    }
+    else
+    {
+        if (streamId > lastStreamId_)
+        {
+            connectionError(kProtocolError);
+            return;
+        }
+        auto iter = streams_.find(streamId);
+        if (iter == streams_.end())
+            return;
+        if (increment == 0)
+        {
+            resetStream(streamId, kProtocolError);
+            return;
+        }
+        iter->second.sendWindow += increment;
+        if (iter->second.sendWindow > maxWindowSize)
+        {
+            resetStream(streamId, kFlowControlError);
+            return;
+        }
+    }
+    sendPendingData();
+}
+
+void Http2Connection::onPriorityUpdate(const uint8_t *payload, size_t length)
+{
+    if (length < 4)
+    {
+        connectionError(kFrameSizeError);
+        return;
+    }
+    auto iter = streams_.find(readUint32(payload) & 0x7fffffff);
+    if (iter == streams_.end())
+        return;
+    auto &stream = iter->second;
+    // A missing parameter takes its default value
+    stream.urgency = 3;
+    stream.incremental = false;
+    parsePriority(std::string_view(reinterpret_cast<const char *>(payload) + 4,
+                                   length - 4),
+                  stream.urgency,
+                  stream.incremental);
+}
+
+void Http2Connection::dispatch(Stream &stream)
+{
+    if (stream.bodyTooLarge)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(k413RequestEntityTooLarge);
+        sendResponse(stream.id, resp, false);
+        return;
+    }
+    if (stream.headersTooLarge)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(k431RequestHeaderFieldsTooLarge);
+        sendResponse(stream.id, resp, false);
+        return;
+    }
+    // The stream may be erased by a response sent right away
+    auto req = stream.request;
+    if (requestCallback_)
+        requestCallback_(req, stream.id);
+}
+
+void Http2Connection::sendResponse(uint32_t streamId,
+                                   const HttpResponsePtr &response,
+                                   bool isHeadMethod)
+{
+    loop_->assertInLoopThread();
+    auto iter = streams_.find(streamId);
+    if (closed_ || iter == streams_.end() || iter->second.responseStarted)
+        return;
+    auto &stream = iter->second;
+    stream.responseStarted = true;
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+
+    // The headers are rendered as for HTTP/1.1 then encoded line by line
+    trantor::MsgBuffer rendered;
+    respImplPtr->renderHeadersToBuffer(rendered);
+    std::string_view text(rendered.peek(), rendered.readableBytes());
+    auto lineEnd = text.find("\r\n");
+    auto space = text.find(' ');
+    if (lineEnd == std::string_view::npos || space + 4 > lineEnd)
+    {
+        LOG_ERROR << "Bad status line in a response";
+        resetStream(streamId, kInternalError);
+        flush();
+        return;
+    }
+    std::string block;
+    encoder_.beginBlock(block);
+    encoder_.encode(":status", text.substr(space + 1, 3), block);
+    for (auto pos = lineEnd + 2; pos < text.size();)
+    {
+        auto end = text.find("\r\n", pos);
+        if (end == std::string_view::npos || end == pos)
+            break;
+        auto line = text.substr(pos, end - pos);
+        pos = end + 2;
+        auto colon = line.find(':');
+        if (colon == std::string_view::npos)
+            continue;
+        scratch_.assign(line.data(), colon);
+        std::transform(scratch_.begin(),
+                       scratch_.end(),
+                       scratch_.begin(),
+                       [](unsigned char c) { return tolower(c); });
+        if (isConnectionSpecific(scratch_))
+            continue;
+        auto value = line.substr(colon + 1);
+        while (!value.empty() && value.front() == ' ')
+            value.remove_prefix(1);
+        encoder_.encode(scratch_, value, block);
+    }
+
+    bool hasBody = !isHeadMethod && respImplPtr->contentLengthIsAllowed();
+    auto &asyncStreamCallback = respImplPtr->asyncStreamCallback();
+    if (hasBody)
+    {
+        if (asyncStreamCallback)
+        {
+            // Keeps the callback alive until it is called below
+            stream.response = response;
+        }
+        else if (respImplPtr->streamCallback())
+        {
+            stream.dataCallback = respImplPtr->encodedStreamCallback();
+        }
+        else if (!respImplPtr->sendfileName().empty())
+        {
+            const auto &range = respImplPtr->sendfileRange();
+            stream.dataCallback = fileReader(respImplPtr->sendfileName(),
+                                             range.first,
+                                             range.second);
+            if (!stream.dataCallback)
+            {
+                LOG_ERROR << "Can't open " << respImplPtr->sendfileName();
+                resetStream(streamId, kInternalError);
+                flush();
+                return;
+            }
+        }
+        else if (respImplPtr->getBodyLength() > 0)
+        {
+            // Sent from the response, which is kept until then
+            stream.response = response;
+            stream.body = std::string_view(respImplPtr->getBodyData(),
+                                           respImplPtr->getBodyLength());
+            stream.dataEnd = true;
+        }
+        else
+        {
+            hasBody = false;
+        }
+    }
+    writeHeaders(streamId, block, !hasBody);
+    if (!hasBody)
+    {
+        finishStream(iter);
+        flush();
+        return;
+    }
+    if (asyncStreamCallback)
+    {
+        asyncStreamCallback(respImplPtr->newResponseStream(
+            std::make_unique<AsyncStream>(weak_from_this(), streamId), false));
+    }
+    sendPendingData();
+    flush();
+}
+
+void Http2Connection::sendStreamData(uint32_t streamId, std::string data)
+{
+    auto iter = streams_.find(streamId);
+    if (closed_ || iter == streams_.end())
+        return;
+    iter->second.chunks.push_back(std::move(data));
+    sendPendingData();
+    flush();
+}
+
+void Http2Connection::endStreamData(uint32_t streamId)
+{
+    auto iter = streams_.find(streamId);
+    if (closed_ || iter == streams_.end())
+        return;
+    iter->second.dataEnd = true;
+    sendPendingData();
+    flush();
+}
+
+void Http2Connection::sendPendingData()
+{
+    while (!closed_ &&
+           unconfirmedBytes_ + output_.readableBytes() < maxBufferedBytes)
+    {
+        auto stream = nextStreamToSend();
+        if (!stream)
+            break;
+        auto streamId = stream->id;
+        if (sendDataFrame(*stream))
+            finishStream(streams_.find(streamId));
+    }
+}
+
+Http2Connection::Stream *Http2Connection::nextStreamToSend()
+{
+    Stream *best = nullptr;
+    bool bestIsNext = false;
+    // The streams are visited in the order of their ids
+    for (auto &item : streams_)
+    {
+        auto &stream = item.second;
+        if (!stream.responseStarted)
+            continue;
+        bool hasData = !stream.body.empty() || !stream.chunks.empty() ||
+                       (stream.dataCallback && !stream.dataEnd);
+        if (hasData ? connSendWindow_ <= 0 || stream.sendWindow <= 0
+                    : !stream.dataEnd)
+        {
+            continue;
+        }
+        bool isNext = stream.id > lastSentStreamId_;
+        if (!best || stream.urgency < best->urgency ||
+            (stream.urgency == best->urgency && best->incremental &&
+             (!stream.incremental || (!bestIsNext && isNext))))
+        {
+            // Non-incremental streams go one after another, incremental ones
+            // take turns, starting after the last stream sent
+            best = &stream;
+            bestIsNext = isNext;
+        }
+    }
+    return best;
+}
+
+bool Http2Connection::sendDataFrame(Stream &stream)
+{
+    auto window = (std::min)(connSendWindow_, stream.sendWindow);
+    auto maxLength =
+        window > 0 ? (std::min)(peerMaxFrameSize_, static_cast<size_t>(window))
+                   : 0;
+    size_t length = 0;
+    bool endStream = false;
+    if (!stream.body.empty())
+    {
+        length = (std::min)(maxLength, stream.body.size());
+        endStream = length == stream.body.size();
+        writeFrameHeader(length, kData, endStream ? kEndStream : 0, stream.id);
+        output_.append(stream.body.data(), length);
+        stream.body.remove_prefix(length);
+    }
+    else if (!stream.chunks.empty())
+    {
+        // Small chunks share a frame
+        size_t pending = 0;
+        for (auto &chunk : stream.chunks)
+            pending += chunk.size();
+        length = (std::min)(maxLength, pending);
+        endStream = stream.dataEnd && length == pending;
+        writeFrameHeader(length, kData, endStream ? kEndStream : 0, stream.id);
+        auto remaining = length;
+        while (remaining > 0)
+        {
+            auto &chunk = stream.chunks.front();
+            auto len = (std::min)(remaining, chunk.size());
+            output_.append(chunk.data(), len);
+            remaining -= len;
+            if (len == chunk.size())
+                stream.chunks.pop_front();
+            else
+                chunk.erase(0, len);
+        }
+    }
+    else if (stream.dataCallback && !stream.dataEnd)
+    {
+        scratch_.resize(maxLength);
+        length = stream.dataCallback(&scratch_[0], maxLength);
+        if (length == 0)
+        {
+            stream.dataEnd = true;
+            stream.dataCallback(nullptr, 0);
+            stream.dataCallback = nullptr;
+        }
+        endStream = stream.dataEnd;
+        writeFrameHeader(length, kData, endStream ? kEndStream : 0, stream.id);
+        output_.append(scratch_.data(), length);
+    }
+    else
+    {
+        // Everything was sent, only the end of the stream is missing
+        endStream = true;
+        writeFrameHeader(0, kData, kEndStream, stream.id);
+    }
+    connSendWindow_ -= static_cast<int64_t>(length);
+    stream.sendWindow -= static_cast<int64_t>(length);
+    lastSentStreamId_ = stream.id;
+    return endStream;
+}
+
+void Http2Connection::finishStream(std::map<uint32_t, Stream>::iterator iter)
+{
+    if (!iter->second.remoteClosed)
+    {
+        // The response is complete, the rest of the request is not needed
+        writeRstStream(iter->first, kNoError);
+    }
+    eraseStream(iter);
+}
+
+void Http2Connection::eraseStream(std::map<uint32_t, Stream>::iterator iter)
+{
+    auto &stream = iter->second;
+    if (stream.dataCallback)
+        stream.dataCallback(nullptr, 0);
+    streams_.erase(iter);
+    if (goingAway_ && streams_.empty() && !closed_)
+    {
+        flush();
+        closed_ = true;
+        if (closeCallback_)
+            closeCallback_();
+    }
+}
+
+void Http2Connection::writeFrameHeader(size_t length,
+                                       uint8_t type,
+                                       uint8_t flags,
+                                       uint32_t streamId)
+{
+    char header[frameHeaderLength];
+    header[0] = static_cast<char>(length >> 16);
+    header[1] = static_cast<char>(length >> 8);
+    header[2] = static_cast<char>(length);
+    header[3] = static_cast<char>(type);
+    header[4] = static_cast<char>(flags);
+    writeUint32(header + 5, streamId);
+    output_.append(header, sizeof(header));
+}
+
+void Http2Connection::writeHeaders(uint32_t streamId,
+                                   const std::string &block,
+                                   bool endStream)
+{
+    // Blocks larger than a frame continue in CONTINUATION frames
+    size_t pos = 0;
+    do
+    {
+        auto length = (std::min)(block.size() - pos, peerMaxFrameSize_);
+        bool last = pos + length == block.size();
+        uint8_t flags = last ? kEndHeaders : 0;
+        if (pos == 0 && endStream)
+            flags |= kEndStream;
+        writeFrameHeader(length,
+                         pos == 0 ? kHeaders : kContinuation,
+                         flags,
+                         streamId);
+        output_.append(block.data() + pos, length);
+        pos += length;
+    } while (pos < block.size());
+}
+
+void Http2Connection::writeWindowUpdate(uint32_t streamId, uint32_t increment)
+{
+    writeFrameHeader(4, kWindowUpdate, 0, streamId);
+    char payload[4];
+    writeUint32(payload, increment);
+    output_.append(payload, sizeof(payload));
+}
+
+void Http2Connection::writeRstStream(uint32_t streamId, uint32_t errorCode)
+{
+    writeFrameHeader(4, kRstStream, 0, streamId);
+    char payload[4];
+    writeUint32(payload, errorCode);
+    output_.append(payload, sizeof(payload));
+}
+
+void Http2Connection::resetStream(uint32_t streamId, uint32_t errorCode)
+{
+    writeRstStream(streamId, errorCode);
+    auto iter = streams_.find(streamId);
+    if (iter != streams_.end())
+        eraseStream(iter);
+    // The streams reset for errors of the client count as its resets
+    if (errorCode != kInternalError)
+        countReset();
+}
+
+void Http2Connection::countReset()
+{
+    auto now = trantor::Date::date();
+    if (resetWindowStart_.after(resetWindowSeconds) < now)
+    {
+        resetWindowStart_ = now;
+        resetCount_ = 0;
+    }
+    if (++resetCount_ > maxResetStreams)
+    {
+        LOG_DEBUG << "Too many HTTP/2 streams reset";
+        connectionError(kEnhanceYourCalm);
+    }
+}
+
+void Http2Connection::connectionError(uint32_t errorCode)
+{
+    if (closed_)
+        return;
+    LOG_DEBUG << "HTTP/2 connection error " << errorCode;
+    writeFrameHeader(8, kGoAway, 0, 0);
+    char payload[8];
+    writeUint32(payload, lastStreamId_);
+    writeUint32(payload + 4, errorCode);
+    output_.append(payload, sizeof(payload));
+    flush();
+    onClose();
+    if (closeCallback_)
+        closeCallback_();
+}
+
+void Http2Connection::flush()
+{
+    auto len = output_.readableBytes();
+    if (len == 0)
+        return;
+    if (sendCallback_)
+    {
+        unconfirmedBytes_ += len;
+        sendCallback_(output_.peek(), len);
+    }
+    output_.retrieveAll();
+}
@@ -0,0 +1,233 @@
+/**
+ *
+ *  @file Http2Connection.h
+ *  The HTTP/2 framing layer of a server connection (RFC 9113)
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "Hpack.h"
+#include "impl_forwards.h"
+#include <drogon/HttpTypes.h>
+#include <trantor/net/AsyncStream.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <trantor/utils/NonCopyable.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace trantor
+{
+class EventLoop;
+}
+
+namespace drogon
+{
+/**
+ * @brief An HTTP/2 server connection. It decodes the frames received from
+ * the client into requests, one per stream, and encodes the responses. The
+ * transport is abstracted by the send and close callbacks, all the methods
+ * are called in the loop of the connection.
+ *
+ * The bodies of the responses are sent under the flow control of the
+ * client. When several streams have data to send, the scheduler follows
+ * the extensible priorities of RFC 9218 (the priority header and the
+ * PRIORITY_UPDATE frame): lower urgencies first, non-incremental responses
+ * one after another and incremental ones interleaved. RFC 7540 priority
+ * signals are parsed and ignored as RFC 9113 allows.
+ */
+class Http2Connection : public trantor::NonCopyable,
+                        public std::enable_shared_from_this<Http2Connection>
+{
+  public:
+    /// Called for each complete request with the id of its stream
+    using RequestCallback =
+        std::function<void(const HttpRequestImplPtr &, uint32_t streamId)>;
+    using SendCallback = std::function<void(const char *data, size_t len)>;
+    using CloseCallback = std::function<void()>;
+
+    /// The connection preface sent by the clients
+    static constexpr std::string_view clientPreface{
+        "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"};
+    static constexpr uint32_t maxConcurrentStreams = 100;
+    // The windows of the request bodies, large enough for the uploads not to
+    // wait for WINDOW_UPDATE frames on most links
+    static constexpr uint32_t streamWindowSize = 256 * 1024;
+    static constexpr uint32_t connectionWindowSize = 1024 * 1024;
+    static constexpr size_t maxHeaderBlockSize = 64 * 1024;
+    // The decoded size of the header lists (RFC 7541 entry sizes), as much
+    // as the parser of HTTP/1 requests accepts. Small blocks referencing
+    // large table entries are answered with 431.
+    static constexpr size_t maxHeaderListSize = 64 * 1024;
+    // The connection is closed with ENHANCE_YOUR_CALM when more streams are
+    // reset within the window, by the client or refused by the server
+    static constexpr size_t maxResetStreams = 1000;
+    static constexpr double resetWindowSeconds = 10.0;
+    // Response bodies produced on demand (files, stream callbacks) are not
+    // read further while this much is waiting to be written to the socket
+    static constexpr size_t maxBufferedBytes = 1024 * 1024;
+
+    explicit Http2Connection(trantor::EventLoop *loop);
+    ~Http2Connection();
+
+    trantor::EventLoop *getLoop() const
+    {
+        return loop_;
+    }
+
+    void setRequestCallback(RequestCallback cb)
+    {
+        requestCallback_ = std::move(cb);
+    }
+
+    void setSendCallback(SendCallback cb)
+    {
+        sendCallback_ = std::move(cb);
+    }
+
+    void setCloseCallback(CloseCallback cb)
+    {
+        closeCallback_ = std::move(cb);
+    }
+
+    /// Send the server connection preface
+    void start();
+
+    /// Process the bytes received, everything complete is consumed
+    void onMessage(trantor::MsgBuffer *buffer);
+
+    /// The transport is closed, drop all the streams
+    void onClose();
+
+    /// Everything sent so far was written to the socket
+    void onWriteComplete();
+
+    /// Send the response of a stream, ignored if the stream was reset
+    void sendResponse(uint32_t streamId,
+                      const HttpResponsePtr &response,
+                      bool isHeadMethod);
+
+    size_t streamCount() const
+    {
+        return streams_.size();
+    }
+
+  private:
+    struct Stream
+    {
+        uint32_t id;
+        HttpRequestImplPtr request;
+        int64_t sendWindow;
+        int64_t recvWindow;
+        size_t recvUnacked{0};
+        bool remoteClosed{false};
+        bool responseStarted{false};
+        bool bodyTooLarge{false};
+        bool headersTooLarge{false};
+        // The body being sent: a view of the body of the response, the data
+        // of an async stream or the data returned by a callback
+        HttpResponsePtr response;
+        std::string_view body;
+        std::deque<std::string> chunks;
+        std::function<std::size_t(char *, std::size_t)> dataCallback;
+        bool dataEnd{false};
+        // RFC 9218
+        uint8_t urgency{3};
+        bool incremental{false};
+    };
+
+    class AsyncStream;
+    friend class AsyncStream;
+
+    void processFrame(uint8_t type,
+                      uint8_t flags,
+                      uint32_t streamId,
+                      const uint8_t *payload,
+                      size_t length);
+    void onData(uint8_t flags,
+                uint32_t streamId,
+                const uint8_t *payload,
+                size_t length);
+    void onHeaders(uint8_t flags,
+                   uint32_t streamId,
+                   const uint8_t *payload,
+                   size_t length);
+    void onHeaderBlock(uint32_t streamId, bool endStream);
+    void onSettings(uint8_t flags, const uint8_t *payload, size_t length);
+    void onWindowUpdate(uint32_t streamId, const uint8_t *payload);
+    void onPriorityUpdate(const uint8_t *payload, size_t length);
+    void dispatch(Stream &stream);
+
+    void writeFrameHeader(size_t length,
+                          uint8_t type,
+                          uint8_t flags,
+                          uint32_t streamId);
+    void writeHeaders(uint32_t streamId,
+                      const std::string &block,
+                      bool endStream);
+    void writeWindowUpdate(uint32_t streamId, uint32_t increment);
+    void writeRstStream(uint32_t streamId, uint32_t errorCode);
+    void resetStream(uint32_t streamId, uint32_t errorCode);
+    /// Count a reset stream, the connection is closed when there are too
+    /// many of them
+    void countReset();
+    void connectionError(uint32_t errorCode);
+    void flush();
+
+    /// Send the DATA frames the windows allow
+    void sendPendingData();
+    Stream *nextStreamToSend();
+    /// Send a DATA frame of the stream, false if it has nothing to send
+    bool sendDataFrame(Stream &stream);
+    void finishStream(std::map<uint32_t, Stream>::iterator iter);
+    void eraseStream(std::map<uint32_t, Stream>::iterator iter);
+
+    /// Data of an async stream, in the loop thread
+    void sendStreamData(uint32_t streamId, std::string data);
+    void endStreamData(uint32_t streamId);
+
+    trantor::EventLoop *loop_;
+    RequestCallback requestCallback_;
+    SendCallback sendCallback_;
+    CloseCallback closeCallback_;
+    trantor::MsgBuffer output_;
+    HpackDecoder decoder_;
+    HpackEncoder encoder_;
+    std::map<uint32_t, Stream> streams_;
+    bool prefaceReceived_{false};
+    bool settingsReceived_{false};
+    bool closed_{false};
+    bool goingAway_{false};
+    uint32_t lastStreamId_{0};
+    uint32_t lastSentStreamId_{0};
+    // The streams reset since the start of the window
+    size_t resetCount_{0};
+    trantor::Date resetWindowStart_;
+    // A header block split in CONTINUATION frames
+    std::string headerBlock_;
+    uint32_t continuationStreamId_{0};
+    bool continuationEndStream_{false};
+    // Flow control
+    int64_t connSendWindow_{65535};
+    int64_t connRecvWindow_{65535};
+    size_t connRecvUnacked_{0};
+    int64_t peerInitialWindow_{65535};
+    size_t peerMaxFrameSize_{16384};
+    // Bytes given to the transport since it last emptied its buffer
+    size_t unconfirmedBytes_{0};
+    std::string scratch_;
+};
+}  // namespace drogon
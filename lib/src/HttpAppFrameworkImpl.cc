@@ -22,6 +22,7 @@
 #include <trantor/utils/AsyncFileLogger.h>
 #include <algorithm>
 #include "AOPAdvice.h"
+#include "CompressionCache.h"
 #include "ConfigLoader.h"
 #include "DbClientManager.h"
 #include "HttpClientImpl.h"
@@ -32,6 +33,7 @@
 #include "HttpServer.h"
 #include "HttpUtils.h"
 #include "ListenerManager.h"
+#include "LoopMetrics.h"
 #include "PluginsManager.h"
 #include "RedisClientManager.h"
 #include "SessionManager.h"
@@ -110,7 +112,7 @@ std::string getGitCommit()
 
 HttpResponsePtr defaultErrorHandler(HttpStatusCode code, const HttpRequestPtr &)
 {
-    return std::make_shared<HttpResponseImpl>(code, CT_TEXT_HTML);
+    return HttpResponseImpl::newPooledResponse(code, CT_TEXT_HTML);
 }
 
 void defaultExceptionHandler(
@@ -201,6 +203,38 @@ int HttpAppFrameworkImpl::staticFilesCacheTime() const
     return StaticFileRouter::instance().staticFilesCacheTime();
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::setStaticFilesCacheSize(size_t bytes)
+{
+    StaticFileRouter::instance().setStaticFilesCacheSize(bytes);
+    return *this;
+}
+
+size_t HttpAppFrameworkImpl::staticFilesCacheSize() const
+{
+    return StaticFileRouter::instance().staticFilesCacheSize();
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::enableCompressionCache(
+    size_t bytes,
+    int gzipLevel,
+    int brotliQuality,
+    int zstdLevel,
+    size_t threadNum)
+{
+    auto &cache = CompressionCache::instance();
+    cache.setCapacity(bytes);
+    cache.setGzipLevel(gzipLevel);
+    cache.setBrotliQuality(brotliQuality);
+    cache.setZstdLevel(zstdLevel);
+    cache.setThreadNum(threadNum);
+    return *this;
+}
+
+size_t HttpAppFrameworkImpl::compressionCacheSize() const
+{
+    return CompressionCache::instance().capacity();
+}
+
 HttpAppFramework &HttpAppFrameworkImpl::setGzipStatic(bool useGzipStatic)
 {
     StaticFileRouter::instance().setGzipStatic(useGzipStatic);
@@ -616,8 +650,10 @@ void HttpAppFrameworkImpl::run()
     for (size_t i = 0; i < threadNum_; ++i)
     {
         ioLoops[i]->setIndex(i);
+        LoopMetrics::instance().watch(ioLoops[i], "io");
     }
     getLoop()->setIndex(threadNum_);
+    LoopMetrics::instance().watch(getLoop(), "main");
 
     // Create all listeners.
     listenerManagerPtr_->createListeners(sslCertPath_,
@@ -671,6 +707,7 @@ void HttpAppFrameworkImpl::run()
     routersInit_ = true;
     HttpControllersRouter::instance().init(ioLoops);
     StaticFileRouter::instance().init(ioLoops);
+    CompressionCache::instance().init();
     getLoop()->queueInLoop([this]() {
         for (auto &adv : beginningAdvices_)
         {
@@ -1040,6 +1077,7 @@ void HttpAppFrameworkImpl::quit()
             listenerManagerPtr_->stopListening();
             listenerManagerPtr_.reset();
             StaticFileRouter::instance().reset();
+            CompressionCache::instance().reset();
             HttpControllersRouter::instance().reset();
             pluginsManagerPtr_.reset();
             redisClientManagerPtr_.reset();
@@ -1262,6 +1300,17 @@ bool HttpAppFrameworkImpl::isRequestStreamEnabled() const
     return enableRequestStream_;
 }
 
+HttpAppFramework &HttpAppFrameworkImpl::enableFlatRequestHeaders(bool enable)
+{
+    enableFlatRequestHeaders_ = enable;
+    return *this;
+}
+
+bool HttpAppFrameworkImpl::isFlatRequestHeadersEnabled() const
+{
+    return enableFlatRequestHeaders_;
+}
+
 // AOP registration methods
 
 HttpAppFramework &HttpAppFrameworkImpl::registerNewConnectionAdvice(
@@ -19,6 +19,7 @@
 #include <json/json.h>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include "SessionManager.h"
@@ -336,8 +337,57 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return useBrotli_;
     }
 
+    HttpAppFramework &enableZstd(bool useZstd) override
+    {
+        useZstd_ = useZstd;
+        return *this;
+    }
+
+    bool isZstdEnabled() const override
+    {
+        return useZstd_;
+    }
+
+    HttpAppFramework &enableStreamCompression(bool enable,
+                                              size_t flushSize) override
+    {
+        useStreamCompression_ = enable;
+        streamCompressionFlushSize_ = flushSize;
+        return *this;
+    }
+
+    bool isStreamCompressionEnabled() const override
+    {
+        return useStreamCompression_;
+    }
+
+    size_t streamCompressionFlushSize() const
+    {
+        return streamCompressionFlushSize_;
+    }
+
+    HttpAppFramework &enableHttp2(bool enable) override
+    {
+        useHttp2_ = enable;
+        return *this;
+    }
+
+    bool isHttp2Enabled() const override
+    {
+        return useHttp2_;
+    }
+
+    HttpAppFramework &enableCompressionCache(size_t bytes,
+                                             int gzipLevel,
+                                             int brotliQuality,
+                                             int zstdLevel,
+                                             size_t threadNum) override;
+    size_t compressionCacheSize() const override;
+
     HttpAppFramework &setStaticFilesCacheTime(int cacheTime) override;
     int staticFilesCacheTime() const override;
+    HttpAppFramework &setStaticFilesCacheSize(size_t bytes) override;
+    size_t staticFilesCacheSize() const override;
 
     HttpAppFramework &setIdleConnectionTimeout(size_t timeout) override
     {
@@ -649,6 +699,19 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
         return enableCompressedRequest_;
     }
 
+    HttpAppFramework &enableWebSocketCompression(
+        const WebSocketCompressionOptions &options) override
+    {
+        webSocketCompression_ = options;
+        return *this;
+    }
+
+    const std::optional<WebSocketCompressionOptions> &webSocketCompression()
+        const
+    {
+        return webSocketCompression_;
+    }
+
     HttpAppFramework &registerCustomExtensionMime(
         const std::string &ext,
         const std::string &mime) override;
@@ -670,6 +733,8 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
 
     HttpAppFramework &enableRequestStream(bool enable) override;
     bool isRequestStreamEnabled() const override;
+    HttpAppFramework &enableFlatRequestHeaders(bool enable) override;
+    bool isFlatRequestHeadersEnabled() const override;
 
   private:
     void registerHttpController(const std::string &pathPattern,
@@ -733,6 +798,10 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
     bool useSendfile_{true};
     bool useGzip_{true};
     bool useBrotli_{false};
+    bool useZstd_{false};
+    bool useStreamCompression_{false};
+    size_t streamCompressionFlushSize_{0};
+    bool useHttp2_{false};
     bool usingUnicodeEscaping_{true};
     std::pair<unsigned int, std::string> floatPrecisionInJson_{0,
                                                                "significant"};
@@ -761,8 +830,10 @@ class HttpAppFrameworkImpl final : public HttpAppFramework
 
     ExceptionHandler exceptionHandler_{defaultExceptionHandler};
     bool enableCompressedRequest_{false};
+    std::optional<WebSocketCompressionOptions> webSocketCompression_;
 
     bool enableRequestStream_{false};
+    bool enableFlatRequestHeaders_{false};
 };
 
 }  // namespace drogon
@@ -0,0 +1,374 @@
+/**
+ *
+ *  @file HttpClientCache.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpClientCache.h"
+#include "HttpResponseImpl.h"
+#include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+using namespace drogon;
+
+namespace
+{
+std::string toLower(std::string_view str)
+{
+    std::string lower(str);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    });
+    return lower;
+}
+
+// Delta-seconds (RFC 9111 section 1.2.2), negative if invalid
+double parseSeconds(std::string_view value)
+{
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+    {
+        value = value.substr(1, value.size() - 2);
+    }
+    if (value.empty() ||
+        !std::all_of(value.begin(), value.end(), [](char c) {
+            return std::isdigit(static_cast<unsigned char>(c));
+        }))
+    {
+        return -1;
+    }
+    return std::strtod(std::string(value).c_str(), nullptr);
+}
+
+// The Date and Expires headers, false if absent or invalid
+bool parseDate(const std::string &value, trantor::Date &date)
+{
+    if (value.empty())
+    {
+        return false;
+    }
+    date = utils::getHttpDate(value);
+    return date.microSecondsSinceEpoch() !=
+           std::numeric_limits<int64_t>::max();
+}
+
+double secondsBetween(const trantor::Date &from, const trantor::Date &to)
+{
+    return static_cast<double>(to.microSecondsSinceEpoch() -
+                               from.microSecondsSinceEpoch()) /
+           trantor::Date::MICRO_SECONDS_PER_SEC;
+}
+
+// The status codes cacheable by default, RFC 9110 section 15.1
+bool isCacheableStatus(HttpStatusCode code)
+{
+    switch (code)
+    {
+        case k200OK:
+        case k203NonAuthoritativeInformation:
+        case k204NoContent:
+        case k300MultipleChoices:
+        case k301MovedPermanently:
+        case k308PermanentRedirect:
+        case k404NotFound:
+        case k405MethodNotAllowed:
+        case k410Gone:
+        case k414RequestURITooLarge:
+        case k501NotImplemented:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// The freshness lifetime given by the headers of the response, negative if
+// there is none, RFC 9111 section 4.2.1
+double freshnessLifetime(const HttpResponse &resp,
+                         const CacheControl &cacheControl,
+                         const trantor::Date &now)
+{
+    if (cacheControl.sMaxAge >= 0)
+    {
+        return cacheControl.sMaxAge;
+    }
+    if (cacheControl.maxAge >= 0)
+    {
+        return cacheControl.maxAge;
+    }
+    auto &expiresHeader = resp.getHeader("expires");
+    if (expiresHeader.empty())
+    {
+        return -1;
+    }
+    trantor::Date expires;
+    if (!parseDate(expiresHeader, expires))
+    {
+        // An invalid date means already expired
+        return 0;
+    }
+    trantor::Date date;
+    if (!parseDate(resp.getHeader("date"), date))
+    {
+        date = now;
+    }
+    return std::max(secondsBetween(date, expires), 0.0);
+}
+
+// When the response was generated, corrected by its Age header
+trantor::Date responseDate(const HttpResponse &resp, const trantor::Date &now)
+{
+    auto age = parseSeconds(resp.getHeader("age"));
+    if (age <= 0)
+    {
+        return now;
+    }
+    return now.after(-age);
+}
+
+class HttpCacheMemoryStore final : public HttpCacheStore
+{
+  public:
+    explicit HttpCacheMemoryStore(size_t capacity) : capacity_(capacity)
+    {
+    }
+
+    HttpCacheEntryPtr get(const std::string &key) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = index_.find(key);
+        if (iter == index_.end())
+        {
+            return nullptr;
+        }
+        nodes_.splice(nodes_.begin(), nodes_, iter->second);
+        return iter->second->second;
+    }
+
+    void put(const std::string &key, const HttpCacheEntryPtr &entry) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        eraseKey(key);
+        if (entry->size > capacity_)
+        {
+            return;
+        }
+        nodes_.emplace_front(key, entry);
+        index_[key] = nodes_.begin();
+        size_ += entry->size;
+        while (size_ > capacity_)
+        {
+            eraseKey(nodes_.back().first);
+        }
+    }
+
+    void erase(const std::string &key) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        eraseKey(key);
+    }
+
+  private:
+    using NodeList = std::list<std::pair<std::string, HttpCacheEntryPtr>>;
+
+    void eraseKey(const std::string &key)
+    {
+        auto iter = index_.find(key);
+        if (iter == index_.end())
+        {
+            return;
+        }
+        size_ -= iter->second->second->size;
+        nodes_.erase(iter->second);
+        index_.erase(iter);
+    }
+
+    std::mutex mutex_;
+    // Most recently used first
+    NodeList nodes_;
+    std::unordered_map<std::string, NodeList::iterator> index_;
+    size_t size_{0};
+    const size_t capacity_;
+};
+}  // namespace
+
+CacheControl drogon::parseCacheControl(std::string_view value)
+{
+    CacheControl cacheControl;
+    for (auto directive : utils::splitStringView(value, ","))
+    {
+        std::string_view argument;
+        auto pos = directive.find('=');
+        if (pos != std::string_view::npos)
+        {
+            argument = utils::trim(directive.substr(pos + 1));
+            directive = utils::trim(directive.substr(0, pos));
+        }
+        auto name = toLower(directive);
+        if (name == "no-store")
+        {
+            cacheControl.noStore = true;
+        }
+        else if (name == "no-cache")
+        {
+            // Also with a list of fields, which only restricts the reuse
+            cacheControl.noCache = true;
+        }
+        else if (name == "private")
+        {
+            cacheControl.isPrivate = true;
+        }
+        else if (name == "public")
+        {
+            cacheControl.isPublic = true;
+        }
+        else if (name == "must-revalidate" || name == "proxy-revalidate")
+        {
+            cacheControl.mustRevalidate = true;
+        }
+        else if (name == "max-age")
+        {
+            cacheControl.maxAge = parseSeconds(argument);
+        }
+        else if (name == "s-maxage")
+        {
+            cacheControl.sMaxAge = parseSeconds(argument);
+        }
+        else if (name == "stale-while-revalidate")
+        {
+            cacheControl.staleWhileRevalidate =
+                std::max(parseSeconds(argument), 0.0);
+        }
+    }
+    return cacheControl;
+}
+
+HttpCacheEntryPtr drogon::newHttpCacheEntry(
+    const HttpResponsePtr &resp,
+    const SafeStringMap<std::string> &reqHeaders,
+    const trantor::Date &now)
+{
+    if (!isCacheableStatus(resp->statusCode()))
+    {
+        return nullptr;
+    }
+    auto cacheControl = parseCacheControl(resp->getHeader("cache-control"));
+    if (cacheControl.noStore || cacheControl.isPrivate)
+    {
+        return nullptr;
+    }
+    // RFC 9111 section 3.5
+    if (reqHeaders.find("authorization") != reqHeaders.end() &&
+        !cacheControl.isPublic && !cacheControl.mustRevalidate &&
+        cacheControl.sMaxAge < 0)
+    {
+        return nullptr;
+    }
+    auto entry = std::make_shared<HttpCacheEntry>();
+    for (auto field : utils::splitStringView(resp->getHeader("vary"), ","))
+    {
+        if (field == "*")
+        {
+            return nullptr;
+        }
+        auto name = toLower(field);
+        auto iter = reqHeaders.find(name);
+        entry->vary.emplace_back(std::move(name),
+                                 iter == reqHeaders.end() ? std::string()
+                                                          : iter->second);
+    }
+    auto lifetime = freshnessLifetime(*resp, cacheControl, now);
+    bool hasValidator = !resp->getHeader("etag").empty() ||
+                        !resp->getHeader("last-modified").empty();
+    if ((lifetime <= 0 || cacheControl.noCache) && !hasValidator)
+    {
+        // Never fresh and can't be revalidated
+        return nullptr;
+    }
+    // The response given to the user is not the stored one
+    entry->response = copyCachedResponse(resp);
+    entry->date = responseDate(*resp, now);
+    entry->freshnessLifetime =
+        cacheControl.noCache ? 0 : std::max(lifetime, 0.0);
+    entry->staleWhileRevalidate = cacheControl.staleWhileRevalidate;
+    entry->mustRevalidate = cacheControl.mustRevalidate ||
+                            cacheControl.noCache ||
+                            cacheControl.sMaxAge >= 0;
+    // The body, the headers and a rough overhead for the objects
+    entry->size = resp->body().length() + 256;
+    for (auto &header : resp->headers())
+    {
+        entry->size += header.first.length() + header.second.length();
+    }
+    for (auto &field : entry->vary)
+    {
+        entry->size += field.first.length() + field.second.length();
+    }
+    return entry;
+}
+
+HttpCacheEntryPtr drogon::refreshHttpCacheEntry(
+    const HttpCacheEntry &entry,
+    const HttpResponsePtr &notModified,
+    const trantor::Date &now)
+{
+    auto refreshed = std::make_shared<HttpCacheEntry>(entry);
+    refreshed->date = responseDate(*notModified, now);
+    auto &cacheControlHeader = notModified->getHeader("cache-control");
+    if (cacheControlHeader.empty() &&
+        notModified->getHeader("expires").empty())
+    {
+        // The stored freshness applies again
+        return refreshed;
+    }
+    auto cacheControl = parseCacheControl(cacheControlHeader);
+    refreshed->freshnessLifetime =
+        cacheControl.noCache
+            ? 0
+            : std::max(freshnessLifetime(*notModified, cacheControl, now),
+                       0.0);
+    refreshed->staleWhileRevalidate = cacheControl.staleWhileRevalidate;
+    refreshed->mustRevalidate = cacheControl.mustRevalidate ||
+                                cacheControl.noCache ||
+                                cacheControl.sMaxAge >= 0;
+    return refreshed;
+}
+
+HttpResponsePtr drogon::copyCachedResponse(const HttpResponsePtr &resp)
+{
+    auto copy = std::make_shared<HttpResponseImpl>(
+        *static_cast<const HttpResponseImpl *>(resp.get()));
+    // Drops the parsed JSON and the rendered response, which are shared
+    copy->initFromTemplate();
+    return copy;
+}
+
+bool drogon::httpCacheVaryMatches(const HttpCacheEntry &entry,
+                                  const HttpRequest &req)
+{
+    for (auto &field : entry.vary)
+    {
+        if (req.getHeader(field.first) != field.second)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<HttpCacheStore> HttpCacheStore::newMemoryStore(
+    size_t capacity)
+{
+    return std::make_shared<HttpCacheMemoryStore>(capacity);
+}
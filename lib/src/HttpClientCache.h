@@ -0,0 +1,78 @@
+/**
+ *
+ *  @file HttpClientCache.h
+ *  The rules of RFC 9111 applied by the HTTP cache of the clients
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpCacheStore.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <trantor/utils/Date.h>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/// The directives of a Cache-Control header used by the cache
+struct CacheControl
+{
+    bool noStore{false};
+    bool noCache{false};
+    bool isPrivate{false};
+    bool isPublic{false};
+    bool mustRevalidate{false};
+    // In seconds, negative when absent
+    double maxAge{-1};
+    double sMaxAge{-1};
+    double staleWhileRevalidate{0};
+};
+
+CacheControl parseCacheControl(std::string_view value);
+
+/**
+ * @brief Build the entry storing the response to a GET request, nullptr if
+ * it must not be stored.
+ *
+ * The cache of a client serves all the users of the client, it stores the
+ * responses as a shared cache does: private responses are not stored,
+ * s-maxage applies, and responses to requests with credentials are only
+ * stored when they explicitly allow it.
+ *
+ * @param reqHeaders The headers of the request, as given by the user
+ * @param now The time the response was received
+ */
+HttpCacheEntryPtr newHttpCacheEntry(
+    const HttpResponsePtr &resp,
+    const SafeStringMap<std::string> &reqHeaders,
+    const trantor::Date &now);
+
+/**
+ * @brief The entry updated by a 304 response to a conditional request
+ * revalidating it, see RFC 9111 section 4.3.4.
+ */
+HttpCacheEntryPtr refreshHttpCacheEntry(const HttpCacheEntry &entry,
+                                        const HttpResponsePtr &notModified,
+                                        const trantor::Date &now);
+
+/**
+ * @brief A copy of a stored response for one request. The users of the
+ * client answered with the same entry, in any thread, can change their
+ * response without changing the others or the stored one. The body is
+ * never changed in place, the copies share it.
+ */
+HttpResponsePtr copyCachedResponse(const HttpResponsePtr &resp);
+
+/// Whether the entry was stored for a request with the same varying headers
+bool httpCacheVaryMatches(const HttpCacheEntry &entry,
+                          const HttpRequest &req);
+}  // namespace drogon
@@ -13,7 +13,11 @@
  */
 
 #include "HttpClientImpl.h"
+#include "ConnectionAttempts.h"
+#include "DnsCache.h"
+#include "ForwardingCallbacks.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpClientCache.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 #include "HttpResponseParser.h"
@@ -26,16 +30,82 @@ using namespace trantor;
 using namespace drogon;
 using namespace std::placeholders;
 
-namespace trantor
+// The delay before the next address is tried while an attempt is pending
+static constexpr double kConnectionAttemptDelay{0.25};
+
+void HttpClientImpl::createTcpClient()
 {
-static const size_t kDefaultDNSTimeout{600};
+    connectTo({serverAddr_});
 }
 
-void HttpClientImpl::createTcpClient()
+void HttpClientImpl::connectTo(const std::vector<trantor::InetAddress> &addrs)
+{
+    if (!attempts_)
+    {
+        std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+        attempts_ = std::make_shared<ConnectionAttempts>(
+            loop_,
+            kConnectionAttemptDelay,
+            [weakPtr](const trantor::InetAddress &addr)
+                -> std::shared_ptr<trantor::TcpClient> {
+                auto thisPtr = weakPtr.lock();
+                if (!thisPtr)
+                    return nullptr;
+                return thisPtr->newTcpClient(addr);
+            },
+            [weakPtr](ReqResult result) {
+                if (auto thisPtr = weakPtr.lock())
+                    thisPtr->onError(result);
+            });
+    }
+    attempts_->start(addrs);
+}
+
+bool HttpClientImpl::onAttemptConnected(
+    const std::shared_ptr<trantor::TcpClient> &client)
 {
-    LOG_TRACE << "New TcpClient," << serverAddr_.toIpPort();
-    tcpClientPtr_ =
-        std::make_shared<trantor::TcpClient>(loop_, serverAddr_, "httpClient");
+    if (!attempts_ || !attempts_->connected(client))
+    {
+        return false;
+    }
+    // Retrieve port from old serverAddr_
+    auto port = serverAddr_.portNetEndian();
+    serverAddr_ = client->connection()->peerAddr();
+    serverAddr_.setPortNetEndian(port);
+    tcpClientPtr_ = client;
+    return true;
+}
+
+void HttpClientImpl::stopAttempts()
+{
+    if (attempts_)
+    {
+        attempts_->stop();
+    }
+}
+
+static ReqResult toReqResult(trantor::SSLError err)
+{
+    switch (err)
+    {
+        case trantor::SSLError::kSSLHandshakeError:
+            return ReqResult::HandshakeError;
+        case trantor::SSLError::kSSLInvalidCertificate:
+            return ReqResult::InvalidCertificate;
+        case trantor::SSLError::kSSLProtocolError:
+            return ReqResult::EncryptionFailure;
+        default:
+            LOG_FATAL << "Invalid value for SSLError";
+            abort();
+    }
+}
+
+std::shared_ptr<trantor::TcpClient> HttpClientImpl::newTcpClient(
+    const trantor::InetAddress &addr)
+{
+    LOG_TRACE << "New TcpClient," << addr.toIpPort();
+    auto tcpClient =
+        std::make_shared<trantor::TcpClient>(loop_, addr, "httpClient");
 
     if (useSSL_ && utils::supportsTls())
     {
@@ -48,25 +118,34 @@ void HttpClientImpl::createTcpClient()
             .setConfCmds(sslConfCmds_)
             .setCertPath(clientCertPath_)
             .setKeyPath(clientKeyPath_);
-        tcpClientPtr_->enableSSL(std::move(policy));
+        tcpClient->enableSSL(std::move(policy));
     }
 
     auto thisPtr = shared_from_this();
     std::weak_ptr<HttpClientImpl> weakPtr = thisPtr;
-    tcpClientPtr_->setSockOptCallback([weakPtr](int fd) {
+    // The callbacks of the clients other than tcpClientPtr_ (attempts which
+    // lost the race, or closed connections) are ignored
+    std::weak_ptr<trantor::TcpClient> weakClient = tcpClient;
+    tcpClient->setSockOptCallback([weakPtr](int fd) {
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
         if (thisPtr->sockOptCallback_)
             thisPtr->sockOptCallback_(fd);
     });
-    tcpClientPtr_->setConnectionCallback(
-        [weakPtr](const trantor::TcpConnectionPtr &connPtr) {
+    tcpClient->setConnectionCallback(
+        [weakPtr, weakClient](const trantor::TcpConnectionPtr &connPtr) {
             auto thisPtr = weakPtr.lock();
-            if (!thisPtr)
+            auto client = weakClient.lock();
+            if (!thisPtr || !client)
                 return;
             if (connPtr->connected())
             {
+                if (client != thisPtr->tcpClientPtr_ &&
+                    !thisPtr->onAttemptConnected(client))
+                {
+                    return;
+                }
                 connPtr->setContext(
                     std::make_shared<HttpResponseParser>(connPtr));
                 // send request;
@@ -87,6 +166,8 @@ void HttpClientImpl::createTcpClient()
             }
             else
             {
+                if (client != thisPtr->tcpClientPtr_)
+                    return;
                 LOG_TRACE << "connection disconnect";
                 auto responseParser = connPtr->getContext<HttpResponseParser>();
                 if (responseParser && responseParser->parseResponseOnClose() &&
@@ -112,14 +193,15 @@ void HttpClientImpl::createTcpClient()
                 thisPtr->onError(ReqResult::NetworkFailure);
             }
         });
-    tcpClientPtr_->setConnectionErrorCallback([weakPtr]() {
+    tcpClient->setConnectionErrorCallback([weakPtr, weakClient]() {
         auto thisPtr = weakPtr.lock();
-        if (!thisPtr)
+        auto client = weakClient.lock();
+        if (!thisPtr || !client)
             return;
-        // can't connect to server
-        thisPtr->onError(ReqResult::BadServerAddress);
+        if (thisPtr->attempts_)
+            thisPtr->attempts_->failed(client, ReqResult::BadServerAddress);
     });
-    tcpClientPtr_->setMessageCallback(
+    tcpClient->setMessageCallback(
         [weakPtr](const trantor::TcpConnectionPtr &connPtr,
                   trantor::MsgBuffer *msg) {
             auto thisPtr = weakPtr.lock();
@@ -128,23 +210,21 @@ void HttpClientImpl::createTcpClient()
                 thisPtr->onRecvMessage(connPtr, msg);
             }
         });
-    tcpClientPtr_->setSSLErrorCallback([weakPtr](SSLError err) {
+    tcpClient->setSSLErrorCallback([weakPtr, weakClient](SSLError err) {
         auto thisPtr = weakPtr.lock();
-        if (!thisPtr)
+        auto client = weakClient.lock();
+        if (!thisPtr || !client)
             return;
-        if (err == trantor::SSLError::kSSLHandshakeError)
-            thisPtr->onError(ReqResult::HandshakeError);
-        else if (err == trantor::SSLError::kSSLInvalidCertificate)
-            thisPtr->onError(ReqResult::InvalidCertificate);
-        else if (err == trantor::SSLError::kSSLProtocolError)
-            thisPtr->onError(ReqResult::EncryptionFailure);
-        else
+        if (client != thisPtr->tcpClientPtr_)
         {
-            LOG_FATAL << "Invalid value for SSLError";
-            abort();
+            // The other addresses being tried may still work
+            if (thisPtr->attempts_)
+                thisPtr->attempts_->failed(client, toReqResult(err));
+            return;
         }
+        thisPtr->onError(toReqResult(err));
     });
-    tcpClientPtr_->connect();
+    return tcpClient;
 }
 
 HttpClientImpl::HttpClientImpl(trantor::EventLoop *loop,
@@ -262,11 +342,6 @@ HttpClientImpl::HttpClientImpl(trantor::EventLoop *loop,
 HttpClientImpl::~HttpClientImpl()
 {
     LOG_TRACE << "Deconstruction HttpClient";
-    if (resolverPtr_ && !(loop_->isInLoopThread()))
-    {
-        // Make sure the resolverPtr_ is destroyed in the correct thread.
-        loop_->queueInLoop([resolverPtr = std::move(resolverPtr_)]() {});
-    }
 }
 
 void HttpClientImpl::sendRequest(const drogon::HttpRequestPtr &req,
@@ -275,7 +350,7 @@ void HttpClientImpl::sendRequest(const drogon::HttpRequestPtr &req,
 {
     auto thisPtr = shared_from_this();
     loop_->runInLoop([thisPtr, req, callback = callback, timeout]() mutable {
-        thisPtr->sendRequestInLoop(req, std::move(callback), timeout);
+        thisPtr->cacheRequestInLoop(req, std::move(callback), timeout);
     });
 }
 
@@ -286,7 +361,423 @@ void HttpClientImpl::sendRequest(const drogon::HttpRequestPtr &req,
     auto thisPtr = shared_from_this();
     loop_->runInLoop(
         [thisPtr, req, callback = std::move(callback), timeout]() mutable {
-            thisPtr->sendRequestInLoop(req, std::move(callback), timeout);
+            thisPtr->cacheRequestInLoop(req, std::move(callback), timeout);
+        });
+}
+
+// The path, query and parameters of the request
+static std::string requestTarget(const HttpRequestPtr &req)
+{
+    std::string target(req->path());
+    target.append("?").append(req->query());
+    // Sorted, the map is unordered
+    std::vector<std::pair<std::string, std::string>> params(
+        req->parameters().begin(), req->parameters().end());
+    std::sort(params.begin(), params.end());
+    for (auto &param : params)
+    {
+        target.append("&").append(param.first);
+        target.append("=").append(param.second);
+    }
+    return target;
+}
+
+static std::string coalescingKey(const HttpRequestPtr &req,
+                                 const std::vector<std::string> &keyHeaders)
+{
+    std::string key(req->methodString());
+    key.append(" ").append(requestTarget(req));
+    // Lengths prefixed, the values can contain any separator
+    auto appendValue = [&key](const std::string &value) {
+        key.append("\n").append(std::to_string(value.length()));
+        key.append(":").append(value);
+    };
+    for (auto &header : keyHeaders)
+    {
+        appendValue(req->getHeader(header));
+    }
+    // The requests of different users are never merged, whatever the key
+    // headers are: the credentials and the cookies added to the request are
+    // always part of the key
+    static const char *const credentialHeaders[] = {"authorization",
+                                                    "cookie",
+                                                    "proxy-authorization"};
+    key.append("\n");
+    for (auto header : credentialHeaders)
+    {
+        appendValue(req->getHeader(header));
+    }
+    auto &cookies = req->cookies();
+    if (!cookies.empty())
+    {
+        std::vector<std::pair<std::string, std::string>> sorted(
+            cookies.begin(), cookies.end());
+        std::sort(sorted.begin(), sorted.end());
+        for (auto &cookie : sorted)
+        {
+            appendValue(cookie.first);
+            appendValue(cookie.second);
+        }
+    }
+    return key;
+}
+
+// Make the request conditional, false if the entry has no validator
+static bool addValidators(const HttpCacheEntry &entry,
+                          const HttpRequestPtr &req)
+{
+    auto &etag = entry.response->getHeader("etag");
+    if (!etag.empty())
+    {
+        req->addHeader("if-none-match", etag);
+    }
+    auto &lastModified = entry.response->getHeader("last-modified");
+    if (!lastModified.empty())
+    {
+        req->addHeader("if-modified-since", lastModified);
+    }
+    return !etag.empty() || !lastModified.empty();
+}
+
+// A GET request like req, the validators are added to it and not to the
+// request of the user, which may be reused
+static HttpRequestPtr copyGetRequest(const HttpRequestPtr &req)
+{
+    auto copy = HttpRequest::newHttpRequest();
+    copy->setPath(req->path());
+    static_cast<HttpRequestImpl *>(copy.get())->setQuery(req->query());
+    for (auto &param : req->parameters())
+    {
+        copy->setParameter(param.first, param.second);
+    }
+    for (auto &header : req->headers())
+    {
+        copy->addHeader(header.first, header.second);
+    }
+    for (auto &cookie : req->cookies())
+    {
+        copy->addCookie(cookie.first, cookie.second);
+    }
+    return copy;
+}
+
+void HttpClientImpl::cacheRequestInLoop(const HttpRequestPtr &req,
+                                        HttpReqCallback &&callback,
+                                        double timeout)
+{
+    if (!cacheStore_ ||
+        static_cast<HttpRequestImpl *>(req.get())->passThrough())
+    {
+        coalesceRequestInLoop(req, std::move(callback), timeout);
+        return;
+    }
+    auto method = req->method();
+    if (method != Get)
+    {
+        if (method != Post && method != Put && method != Patch &&
+            method != Delete)
+        {
+            coalesceRequestInLoop(req, std::move(callback), timeout);
+            return;
+        }
+        // A successful unsafe request invalidates the stored response of
+        // its target, RFC 9111 section 4.4
+        coalesceRequestInLoop(
+            req,
+            [store = cacheStore_,
+             key = cacheKey(req),
+             callback = std::move(callback)](ReqResult result,
+                                             const HttpResponsePtr &resp) {
+                if (result == ReqResult::Ok &&
+                    resp->statusCode() < k400BadRequest)
+                {
+                    store->erase(key);
+                }
+                callback(result, resp);
+            },
+            timeout);
+        return;
+    }
+    auto cacheControl = parseCacheControl(req->getHeader("cache-control"));
+    // The conditional requests of the user are answered by the server
+    if (cacheControl.noStore || !req->getHeader("if-none-match").empty() ||
+        !req->getHeader("if-modified-since").empty())
+    {
+        coalesceRequestInLoop(req, std::move(callback), timeout);
+        return;
+    }
+    auto key = cacheKey(req);
+    auto entry = cacheStore_->get(key);
+    if (entry && !httpCacheVaryMatches(*entry, *req))
+    {
+        entry.reset();
+    }
+    if (entry && !cacheControl.noCache && cacheControl.maxAge != 0)
+    {
+        auto age = entry->age(trantor::Date::now());
+        if (age < entry->freshnessLifetime)
+        {
+            cacheHits_.fetch_add(1, std::memory_order_relaxed);
+            callback(ReqResult::Ok, copyCachedResponse(entry->response));
+            return;
+        }
+        if (!entry->mustRevalidate &&
+            age < entry->freshnessLifetime + entry->staleWhileRevalidate)
+        {
+            cacheStaleHits_.fetch_add(1, std::memory_order_relaxed);
+            callback(ReqResult::Ok, copyCachedResponse(entry->response));
+            revalidateInBackground(key, req, entry);
+            return;
+        }
+    }
+    // Taken before the validators and the headers of the client are added
+    auto reqHeaders = req->headers();
+    if (entry)
+    {
+        auto conditional = copyGetRequest(req);
+        if (addValidators(*entry, conditional))
+        {
+            sendCacheableRequest(key,
+                                 conditional,
+                                 reqHeaders,
+                                 entry,
+                                 std::move(callback),
+                                 timeout);
+            return;
+        }
+        entry.reset();
+    }
+    cacheMisses_.fetch_add(1, std::memory_order_relaxed);
+    sendCacheableRequest(
+        key, req, reqHeaders, entry, std::move(callback), timeout);
+}
+
+void HttpClientImpl::sendCacheableRequest(
+    const std::string &key,
+    const HttpRequestPtr &req,
+    const SafeStringMap<std::string> &reqHeaders,
+    const HttpCacheEntryPtr &entry,
+    HttpReqCallback &&callback,
+    double timeout)
+{
+    coalesceRequestInLoop(
+        req,
+        [thisPtr = shared_from_this(),
+         store = cacheStore_,
+         key,
+         reqHeaders,
+         entry,
+         callback = std::move(callback)](ReqResult result,
+                                         const HttpResponsePtr &resp) {
+            if (result != ReqResult::Ok)
+            {
+                callback(result, resp);
+                return;
+            }
+            auto now = trantor::Date::now();
+            if (entry && resp->statusCode() == k304NotModified)
+            {
+                store->put(key, refreshHttpCacheEntry(*entry, resp, now));
+                thisPtr->cacheRevalidated_.fetch_add(
+                    1, std::memory_order_relaxed);
+                callback(result, copyCachedResponse(entry->response));
+                return;
+            }
+            auto newEntry = newHttpCacheEntry(resp, reqHeaders, now);
+            if (newEntry)
+            {
+                store->put(key, newEntry);
+            }
+            else if (entry)
+            {
+                // Replaced by a response which can't be stored
+                store->erase(key);
+            }
+            callback(result, resp);
+        },
+        timeout);
+}
+
+void HttpClientImpl::revalidateInBackground(const std::string &key,
+                                            const HttpRequestPtr &req,
+                                            const HttpCacheEntryPtr &entry)
+{
+    if (!revalidatingKeys_.insert(key).second)
+    {
+        return;
+    }
+    // The request of the user is already answered, it may be reused
+    auto revalidation = copyGetRequest(req);
+    auto reqHeaders = revalidation->headers();
+    addValidators(*entry, revalidation);
+    sendCacheableRequest(
+        key,
+        revalidation,
+        reqHeaders,
+        entry,
+        [thisPtr = shared_from_this(), key](ReqResult,
+                                            const HttpResponsePtr &) {
+            thisPtr->revalidatingKeys_.erase(key);
+        },
+        0);
+}
+
+std::string HttpClientImpl::cacheKey(const HttpRequestPtr &req) const
+{
+    // The store can be shared by the clients of several servers
+    std::string key(useSSL_ ? "https://" : "http://");
+    key.append(host()).append(":").append(std::to_string(port()));
+    key.append(requestTarget(req));
+    return key;
+}
+
+// Ranged and conditional requests get a 206 or a 304 which only answers
+// them, whatever the key headers are
+static bool isPartialOrConditional(const HttpRequestPtr &req)
+{
+    static const char *const headers[] = {"range",
+                                          "if-range",
+                                          "if-none-match",
+                                          "if-modified-since"};
+    for (auto header : headers)
+    {
+        if (!req->getHeader(header).empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HttpClientImpl::coalesceRequestInLoop(const HttpRequestPtr &req,
+                                           HttpReqCallback &&callback,
+                                           double timeout)
+{
+    if (!coalescing_ ||
+        (req->method() != Get && req->method() != Head) ||
+        !req->body().empty() || isPartialOrConditional(req))
+    {
+        sendRequestInLoop(req, std::move(callback), timeout);
+        return;
+    }
+    auto key = coalescingKey(req, coalescingKeyHeaders_);
+    auto iter = coalescedCallbacks_.find(key);
+    if (iter != coalescedCallbacks_.end())
+    {
+        iter->second.push_back(std::move(callback));
+        coalescingMerged_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    coalescedCallbacks_.emplace(key, std::vector<HttpReqCallback>{});
+    coalescingSent_.fetch_add(1, std::memory_order_relaxed);
+    sendRequestInLoop(
+        req,
+        [thisPtr = shared_from_this(),
+         key = std::move(key),
+         callback = std::move(callback)](ReqResult result,
+                                         const HttpResponsePtr &resp) {
+            std::vector<HttpReqCallback> callbacks;
+            auto iter = thisPtr->coalescedCallbacks_.find(key);
+            if (iter != thisPtr->coalescedCallbacks_.end())
+            {
+                callbacks = std::move(iter->second);
+                thisPtr->coalescedCallbacks_.erase(iter);
+            }
+            callback(result, resp);
+            for (auto &cb : callbacks)
+            {
+                cb(result, resp);
+            }
+        },
+        timeout);
+}
+
+void HttpClientImpl::sendStreamRequest(const HttpRequestPtr &req,
+                                       HttpReqCallback &&headersCallback,
+                                       HttpRespDataCallback &&dataCallback,
+                                       HttpRespFinishCallback &&finishCallback,
+                                       double timeout)
+{
+    auto handler = std::make_shared<StreamHandler>();
+    handler->headersCallback = std::move(headersCallback);
+    handler->dataCallback = std::move(dataCallback);
+    handler->finishCallback = std::move(finishCallback);
+    auto thisPtr = shared_from_this();
+    loop_->runInLoop([thisPtr, req, handler, timeout]() {
+        assert(thisPtr->streamHandlers_.find(req.get()) ==
+               thisPtr->streamHandlers_.end());
+        thisPtr->streamHandlers_[req.get()] = handler;
+        thisPtr->sendRequestInLoop(
+            req,
+            [thisPtr, req, handler](ReqResult result,
+                                    const HttpResponsePtr &resp) {
+                thisPtr->finishStream(req, handler, result, resp);
+            },
+            timeout);
+    });
+}
+
+// Called when the request is answered or failed, in any way
+void HttpClientImpl::finishStream(const HttpRequestPtr &req,
+                                  const StreamHandlerPtr &handler,
+                                  ReqResult result,
+                                  const HttpResponsePtr &resp)
+{
+    auto iter = streamHandlers_.find(req.get());
+    if (iter != streamHandlers_.end() && iter->second == handler)
+    {
+        streamHandlers_.erase(iter);
+    }
+    if (handler->done)
+    {
+        return;
+    }
+    handler->done = true;
+    if (!handler->headersDelivered)
+    {
+        handler->headersDelivered = true;
+        handler->headersCallback(result, resp);
+        if (result != ReqResult::Ok)
+        {
+            return;
+        }
+    }
+    if (!handler->stopped)
+    {
+        handler->finishCallback(result);
+    }
+}
+
+void HttpClientImpl::attachStreamHandler(HttpResponseParser &parser,
+                                         const HttpRequestPtr &req)
+{
+    auto iter = streamHandlers_.find(req.get());
+    if (iter == streamHandlers_.end())
+    {
+        return;
+    }
+    auto &handler = iter->second;
+    parser.setStreamCallbacks(
+        [handler, resp = parser.responseImpl()]() {
+            if (!handler->headersDelivered && !handler->done)
+            {
+                handler->headersDelivered = true;
+                handler->headersCallback(ReqResult::Ok, resp);
+            }
+        },
+        [handler](const char *data, size_t length) {
+            // The request timed out or the consumer stopped the transfer,
+            // the connection is closed
+            if (handler->done || handler->stopped)
+            {
+                return false;
+            }
+            if (!handler->dataCallback(data, length))
+            {
+                handler->stopped = true;
+                return false;
+            }
+            return true;
         });
 }
 
@@ -385,6 +876,72 @@ static bool isValidIpAddr(const trantor::InetAddress &addr)
     return false;
 }
 
+void HttpClientImpl::connectInLoop()
+{
+    loop_->assertInLoopThread();
+    if (tcpClientPtr_ || dns_ || (attempts_ && attempts_->connecting()))
+    {
+        return;
+    }
+    if (domain_.empty() || !isDomainName_)
+    {
+        if (isValidIpAddr(serverAddr_))
+        {
+            createTcpClient();
+        }
+        return;
+    }
+    resolveAndConnect();
+}
+
+void HttpClientImpl::resolveAndConnect()
+{
+    // A dns query is on going.
+    if (dns_)
+    {
+        return;
+    }
+
+    // Always look the domain up when (re)connects, the addresses are cached
+    // by all the clients.
+    dns_ = true;
+    auto thisPtr = shared_from_this();
+    DnsCache::instance().resolve(
+        domain_, [thisPtr](const DnsCache::Addresses &addrs) {
+            thisPtr->loop_->runInLoop([thisPtr, addrs]() {
+                thisPtr->dns_ = false;
+                // Retrieve port from old serverAddr_
+                auto port = thisPtr->serverAddr_.portNetEndian();
+                std::vector<trantor::InetAddress> validAddrs;
+                for (auto addr : addrs)
+                {
+                    addr.setPortNetEndian(port);
+                    if (isValidIpAddr(addr))
+                    {
+                        validAddrs.push_back(addr);
+                    }
+                }
+                LOG_TRACE << "dns:domain=" << thisPtr->domain_
+                          << ";addresses=" << validAddrs.size();
+                if (!validAddrs.empty())
+                {
+                    thisPtr->connectTo(validAddrs);
+                    return;
+                }
+
+                // DNS fail to get valid ip address,
+                // respond all requests with BadServerAddress
+                while (!(thisPtr->requestsBuffer_).empty())
+                {
+                    auto &reqAndCb = (thisPtr->requestsBuffer_).front();
+                    reqAndCb.second(ReqResult::BadServerAddress, nullptr);
+
+                    thisPtr->popFrontRequest();
+                }
+            });
+        });
+}
+
 void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
                                        drogon::HttpReqCallback &&callback)
 {
@@ -428,6 +985,11 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
                                      const HttpResponsePtr &response) {
                            (*callbackPtr)(result, response);
                        });
+        // Sent once a connection being attempted is established
+        if (attempts_ && attempts_->connecting())
+        {
+            return;
+        }
 
         if (domain_.empty() || !isDomainName_)
         {
@@ -446,49 +1008,7 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
             return;
         }
 
-        // A dns query is on going.
-        if (dns_)
-        {
-            return;
-        }
-
-        // Always do dns query when (re)connects a domain.
-        dns_ = true;
-        if (!resolverPtr_)
-        {
-            resolverPtr_ =
-                trantor::Resolver::newResolver(loop_, kDefaultDNSTimeout);
-        }
-        auto thisPtr = shared_from_this();
-        resolverPtr_->resolve(
-            domain_, [thisPtr](const trantor::InetAddress &addr) {
-                thisPtr->loop_->runInLoop([thisPtr, addr]() {
-                    // Retrieve port from old serverAddr_
-                    auto port = thisPtr->serverAddr_.portNetEndian();
-                    thisPtr->serverAddr_ = addr;
-                    thisPtr->serverAddr_.setPortNetEndian(port);
-                    LOG_TRACE << "dns:domain=" << thisPtr->domain_
-                              << ";ip=" << thisPtr->serverAddr_.toIp();
-                    thisPtr->dns_ = false;
-
-                    if (isValidIpAddr(thisPtr->serverAddr_))
-                    {
-                        thisPtr->createTcpClient();
-                        return;
-                    }
-
-                    // DNS fail to get valid ip address,
-                    // respond all requests with BadServerAddress
-                    while (!(thisPtr->requestsBuffer_).empty())
-                    {
-                        auto &reqAndCb = (thisPtr->requestsBuffer_).front();
-                        reqAndCb.second(ReqResult::BadServerAddress, nullptr);
-
-                        thisPtr->popFrontRequest();
-                    }
-                });
-            });
-
+        resolveAndConnect();
         return;
     }
 
@@ -550,17 +1070,22 @@ void HttpClientImpl::handleResponse(
     const trantor::TcpConnectionPtr &connPtr)
 {
     assert(!pipeliningCallbacks_.empty());
-    auto &coding = resp->getHeaderBy("content-encoding");
-    if (coding == "gzip")
+    // Streamed bodies are passed on as they were received
+    if (streamHandlers_.empty() ||
+        streamHandlers_.find(reqAndCb.first.get()) == streamHandlers_.end())
     {
-        resp->gunzip();
-    }
+        auto &coding = resp->getHeaderBy("content-encoding");
+        if (coding == "gzip")
+        {
+            resp->gunzip();
+        }
 #ifdef USE_BROTLI
-    else if (coding == "br")
-    {
-        resp->brDecompress();
-    }
+        else if (coding == "br")
+        {
+            resp->brDecompress();
+        }
 #endif
+    }
     auto cb = std::move(reqAndCb);
     pipeliningCallbacks_.pop();
     pipeliningCallbacksSize_.fetch_sub(1, std::memory_order_relaxed);
@@ -621,6 +1146,11 @@ void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
         {
             responseParser->setForHeadMethod();
         }
+        if (!streamHandlers_.empty() && responseParser->atResponseStart() &&
+            !responseParser->streaming())
+        {
+            attachStreamHandler(*responseParser, firstReq.first);
+        }
         if (!responseParser->parseResponse(msg))
         {
             onError(ReqResult::BadResponse);
@@ -672,8 +1202,24 @@ HttpClientPtr HttpClient::newHttpClient(const std::string &hostString,
         validateCert);
 }
 
+void HttpClient::forwardRequest(
+    const HttpRequestPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback,
+    double timeout)
+{
+    auto callbacks = newForwardingCallbacks(req, std::move(callback));
+    req->setPassThrough(true);
+    sendStreamRequest(req,
+                      std::move(callbacks.headersCallback),
+                      std::move(callbacks.dataCallback),
+                      std::move(callbacks.finishCallback),
+                      timeout);
+}
+
 void HttpClientImpl::onError(ReqResult result)
 {
+    // Before the callbacks, which may send new requests
+    stopAttempts();
     while (!pipeliningCallbacks_.empty())
     {
         auto cb = std::move(pipeliningCallbacks_.front());
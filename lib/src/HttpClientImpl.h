@@ -17,7 +17,6 @@
 #include <drogon/Cookie.h>
 #include <drogon/HttpClient.h>
 #include <trantor/net/EventLoop.h>
-#include <trantor/net/Resolver.h>
 #include <trantor/net/TcpClient.h>
 #include <atomic>
 #include <cstddef>
@@ -26,11 +25,17 @@
 #include <list>
 #include <mutex>
 #include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "impl_forwards.h"
 
 namespace drogon
 {
+class ConnectionAttempts;
+class HttpResponseParser;
+
 class HttpClientImpl final : public HttpClient,
                              public std::enable_shared_from_this<HttpClientImpl>
 {
@@ -50,6 +55,11 @@ class HttpClientImpl final : public HttpClient,
     void sendRequest(const HttpRequestPtr &req,
                      HttpReqCallback &&callback,
                      double timeout = 0) override;
+    void sendStreamRequest(const HttpRequestPtr &req,
+                           HttpReqCallback &&headersCallback,
+                           HttpRespDataCallback &&dataCallback,
+                           HttpRespFinishCallback &&finishCallback,
+                           double timeout = 0) override;
 
     trantor::EventLoop *getLoop() override
     {
@@ -78,6 +88,38 @@ class HttpClientImpl final : public HttpClient,
         validCookies_.emplace_back(cookie);
     }
 
+    void enableRequestCoalescing(
+        bool flag,
+        const std::vector<std::string> &keyHeaders) override
+    {
+        coalescing_ = flag;
+        coalescingKeyHeaders_ = keyHeaders;
+    }
+
+    CoalescingMetrics coalescingMetrics() const override
+    {
+        CoalescingMetrics metrics;
+        metrics.sent = coalescingSent_.load(std::memory_order_relaxed);
+        metrics.merged = coalescingMerged_.load(std::memory_order_relaxed);
+        return metrics;
+    }
+
+    void setCacheStore(const HttpCacheStorePtr &store) override
+    {
+        cacheStore_ = store;
+    }
+
+    CacheMetrics cacheMetrics() const override
+    {
+        CacheMetrics metrics;
+        metrics.hits = cacheHits_.load(std::memory_order_relaxed);
+        metrics.staleHits = cacheStaleHits_.load(std::memory_order_relaxed);
+        metrics.revalidated =
+            cacheRevalidated_.load(std::memory_order_relaxed);
+        metrics.misses = cacheMisses_.load(std::memory_order_relaxed);
+        return metrics;
+    }
+
     size_t bytesSent() const override
     {
         return bytesSent_;
@@ -146,6 +188,12 @@ class HttpClientImpl final : public HttpClient,
         }
     }
 
+    /**
+     * @brief Open the connection without sending a request, nothing is done
+     * if it is open or being opened. Called in the loop thread.
+     */
+    void connectInLoop();
+
     using RequestBufferIter =
         std::list<std::pair<HttpRequestPtr, HttpReqCallback>>::iterator;
 
@@ -156,6 +204,19 @@ class HttpClientImpl final : public HttpClient,
     }
 
   private:
+    // The callbacks of a request sent by sendStreamRequest()
+    struct StreamHandler
+    {
+        HttpReqCallback headersCallback;
+        HttpRespDataCallback dataCallback;
+        HttpRespFinishCallback finishCallback;
+        bool headersDelivered{false};
+        bool done{false};
+        bool stopped{false};
+    };
+
+    using StreamHandlerPtr = std::shared_ptr<StreamHandler>;
+
     std::shared_ptr<trantor::TcpClient> tcpClientPtr_;
     trantor::EventLoop *loop_;
     trantor::InetAddress serverAddr_;
@@ -168,13 +229,49 @@ class HttpClientImpl final : public HttpClient,
     void sendRequestInLoop(const HttpRequestPtr &req,
                            HttpReqCallback &&callback,
                            double timeout);
+    // Answers the request from the cache, or passes it on to
+    // coalesceRequestInLoop()
+    void cacheRequestInLoop(const HttpRequestPtr &req,
+                            HttpReqCallback &&callback,
+                            double timeout);
+    // Sends the request, stores its response or refreshes entry with it
+    void sendCacheableRequest(const std::string &key,
+                              const HttpRequestPtr &req,
+                              const SafeStringMap<std::string> &reqHeaders,
+                              const HttpCacheEntryPtr &entry,
+                              HttpReqCallback &&callback,
+                              double timeout);
+    void revalidateInBackground(const std::string &key,
+                                const HttpRequestPtr &req,
+                                const HttpCacheEntryPtr &entry);
+    // The key of the response to the request in the cache store
+    std::string cacheKey(const HttpRequestPtr &req) const;
+    // Joins an identical request in flight or sends it
+    void coalesceRequestInLoop(const HttpRequestPtr &req,
+                               HttpReqCallback &&callback,
+                               double timeout);
     void handleCookies(const HttpResponseImplPtr &resp);
     void handleResponse(const HttpResponseImplPtr &resp,
                         std::pair<HttpRequestPtr, HttpReqCallback> &&reqAndCb,
                         const trantor::TcpConnectionPtr &connPtr);
     void createTcpClient();
+    void resolveAndConnect();
+    // Happy eyeballs (RFC 8305), see ConnectionAttempts
+    void connectTo(const std::vector<trantor::InetAddress> &addrs);
+    std::shared_ptr<trantor::TcpClient> newTcpClient(
+        const trantor::InetAddress &addr);
+    bool onAttemptConnected(const std::shared_ptr<trantor::TcpClient> &client);
+    void stopAttempts();
+    void attachStreamHandler(HttpResponseParser &parser,
+                             const HttpRequestPtr &req);
+    void finishStream(const HttpRequestPtr &req,
+                      const StreamHandlerPtr &handler,
+                      ReqResult result,
+                      const HttpResponsePtr &resp);
     std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> pipeliningCallbacks_;
     std::list<std::pair<HttpRequestPtr, HttpReqCallback>> requestsBuffer_;
+    // The streamed requests waiting for their responses, few at a time
+    std::unordered_map<const HttpRequest *, StreamHandlerPtr> streamHandlers_;
     void onRecvMessage(const trantor::TcpConnectionPtr &, trantor::MsgBuffer *);
     void onError(ReqResult result);
     std::string domain_;
@@ -183,11 +280,27 @@ class HttpClientImpl final : public HttpClient,
     std::atomic<std::size_t> pipeliningCallbacksSize_{0};
     size_t pipeliningDepth_{0};
     bool enableCookies_{false};
+    bool coalescing_{false};
+    std::vector<std::string> coalescingKeyHeaders_;
+    // The callbacks of the requests merged into the one in flight, by key
+    std::unordered_map<std::string, std::vector<HttpReqCallback>>
+        coalescedCallbacks_;
+    std::atomic<size_t> coalescingSent_{0};
+    std::atomic<size_t> coalescingMerged_{0};
+    HttpCacheStorePtr cacheStore_;
+    // The keys of the stale entries being revalidated in the background
+    std::unordered_set<std::string> revalidatingKeys_;
+    std::atomic<size_t> cacheHits_{0};
+    std::atomic<size_t> cacheStaleHits_{0};
+    std::atomic<size_t> cacheRevalidated_{0};
+    std::atomic<size_t> cacheMisses_{0};
     std::vector<Cookie> validCookies_;
     size_t bytesSent_{0};
     size_t bytesReceived_{0};
     bool dns_{false};
-    std::shared_ptr<trantor::Resolver> resolverPtr_;
+    // The connections being attempted, tcpClientPtr_ is set to the first one
+    // established
+    std::shared_ptr<ConnectionAttempts> attempts_;
     bool useOldTLS_{false};
     std::string userAgent_{"DrogonClient"};
     std::vector<std::pair<std::string, std::string>> sslConfCmds_;
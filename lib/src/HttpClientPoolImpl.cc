@@ -0,0 +1,341 @@
+/**
+ *
+ *  @file HttpClientPoolImpl.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpClientPoolImpl.h"
+#include "ForwardingCallbacks.h"
+#include "HttpAppFrameworkImpl.h"
+#include <algorithm>
+#include <limits>
+
+using namespace drogon;
+
+HttpClientPoolImpl::HttpClientPoolImpl(
+    std::string hostString,
+    size_t minConnections,
+    size_t maxConnections,
+    const std::vector<trantor::EventLoop *> &loops,
+    double idleTimeout,
+    bool useOldTLS,
+    bool validateCert)
+    : hostString_(std::move(hostString)),
+      maxConnections_(std::max<size_t>(maxConnections, 1)),
+      idleTimeout_(idleTimeout),
+      useOldTLS_(useOldTLS),
+      validateCert_(validateCert),
+      loops_(loops)
+{
+    minConnections_ = std::min(minConnections, maxConnections_);
+    loopPools_.reserve(loops_.size());
+    for (auto loop : loops_)
+    {
+        loopPools_.emplace_back(std::make_unique<LoopPool>(loop));
+    }
+}
+
+HttpClientPoolImpl::~HttpClientPoolImpl()
+{
+    for (auto &pool : loopPools_)
+    {
+        if (pool->timerStarted.load(std::memory_order_acquire))
+        {
+            pool->loop->invalidateTimer(pool->timerId);
+        }
+    }
+}
+
+void HttpClientPoolImpl::sendRequest(const HttpRequestPtr &req,
+                                     const HttpReqCallback &callback,
+                                     double timeout)
+{
+    auto cb = callback;
+    sendRequest(req, std::move(cb), timeout);
+}
+
+void HttpClientPoolImpl::sendRequest(const HttpRequestPtr &req,
+                                     HttpReqCallback &&callback,
+                                     double timeout)
+{
+    auto &pool = pickLoopPool();
+    pool.loop->runInLoop([thisPtr = shared_from_this(),
+                          &pool,
+                          req,
+                          callback = std::move(callback),
+                          timeout]() mutable {
+        thisPtr->selectClient(pool)->sendRequest(req,
+                                                 std::move(callback),
+                                                 timeout);
+    });
+}
+
+void HttpClientPoolImpl::sendStreamRequest(
+    const HttpRequestPtr &req,
+    HttpReqCallback &&headersCallback,
+    HttpRespDataCallback &&dataCallback,
+    HttpRespFinishCallback &&finishCallback,
+    double timeout)
+{
+    auto &pool = pickLoopPool();
+    pool.loop->runInLoop(
+        [thisPtr = shared_from_this(),
+         &pool,
+         req,
+         headersCallback = std::move(headersCallback),
+         dataCallback = std::move(dataCallback),
+         finishCallback = std::move(finishCallback),
+         timeout]() mutable {
+            thisPtr->selectClient(pool)->sendStreamRequest(
+                req,
+                std::move(headersCallback),
+                std::move(dataCallback),
+                std::move(finishCallback),
+                timeout);
+        });
+}
+
+HttpClientPoolImpl::LoopPool &HttpClientPoolImpl::pickLoopPool()
+{
+    if (loopPools_.size() == 1)
+    {
+        return *loopPools_[0];
+    }
+    // Stay in the loop of the caller, the response is handled there
+    auto currentLoop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (currentLoop)
+    {
+        for (auto &pool : loopPools_)
+        {
+            if (pool->loop == currentLoop)
+            {
+                return *pool;
+            }
+        }
+    }
+    return *loopPools_[nextLoop_.fetch_add(1, std::memory_order_relaxed) %
+                       loopPools_.size()];
+}
+
+HttpClientImplPtr HttpClientPoolImpl::selectClient(LoopPool &pool)
+{
+    pool.loop->assertInLoopThread();
+    if (!pool.started)
+    {
+        start(pool);
+    }
+    Connection *target = nullptr;
+    auto least = std::numeric_limits<size_t>::max();
+    for (auto &conn : pool.connections)
+    {
+        auto outstanding = conn.client->outstandingRequests();
+        if (outstanding < least)
+        {
+            least = outstanding;
+            target = &conn;
+            if (outstanding == 0)
+            {
+                break;
+            }
+        }
+    }
+    // Every connection is busy, open one more rather than queue or pipeline
+    // the request behind others
+    if ((!target || least > 0) && pool.connections.size() < maxConnections_)
+    {
+        target = &addConnection(pool);
+    }
+    target->lastActive = trantor::Date::now();
+    requestsSent_.fetch_add(1, std::memory_order_relaxed);
+    return target->client;
+}
+
+void HttpClientPoolImpl::start(LoopPool &pool)
+{
+    pool.started = true;
+    while (pool.connections.size() < minConnections_)
+    {
+        addConnection(pool).client->connectInLoop();
+    }
+    if (idleTimeout_ <= 0)
+    {
+        return;
+    }
+    std::weak_ptr<HttpClientPoolImpl> weakPtr = shared_from_this();
+    pool.timerId = pool.loop->runEvery(idleTimeout_ / 2, [weakPtr, &pool]() {
+        auto thisPtr = weakPtr.lock();
+        if (thisPtr)
+        {
+            thisPtr->checkIdleConnections(pool);
+        }
+    });
+    pool.timerStarted.store(true, std::memory_order_release);
+}
+
+HttpClientPoolImpl::Connection &HttpClientPoolImpl::addConnection(
+    LoopPool &pool)
+{
+    auto client = std::make_shared<HttpClientImpl>(pool.loop,
+                                                   hostString_,
+                                                   useOldTLS_,
+                                                   validateCert_);
+    client->setPipeliningDepth(pipeliningDepth_);
+    client->setUserAgent(userAgent_);
+    if (sockOptCallback_)
+    {
+        client->setSockOptCallback(sockOptCallback_);
+    }
+    if (!clientCertPath_.empty())
+    {
+        client->setCertPath(clientCertPath_, clientKeyPath_);
+    }
+    if (!sslConfCmds_.empty())
+    {
+        client->addSSLConfigs(sslConfCmds_);
+    }
+    if (cacheStore_)
+    {
+        client->setCacheStore(cacheStore_);
+    }
+    connectionsOpened_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.connections.push_back({std::move(client), trantor::Date::now()});
+    return pool.connections.back();
+}
+
+void HttpClientPoolImpl::checkIdleConnections(LoopPool &pool)
+{
+    auto now = trantor::Date::now();
+    std::vector<Connection> closed;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        // The first connections are the warm ones, only those beyond them
+        // are closed
+        for (size_t i = minConnections_; i < pool.connections.size();)
+        {
+            auto &conn = pool.connections[i];
+            if (conn.client->outstandingRequests() == 0 &&
+                conn.lastActive.after(idleTimeout_) < now)
+            {
+                closed.push_back(std::move(conn));
+                pool.connections.erase(pool.connections.begin() + i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+    connectionsClosed_.fetch_add(closed.size(), std::memory_order_relaxed);
+    for (auto &conn : pool.connections)
+    {
+        if (conn.client->outstandingRequests() > 0)
+        {
+            // Long requests don't count as idle time
+            conn.lastActive = now;
+        }
+    }
+    // Reopen the warm connections closed by the server
+    for (size_t i = 0; i < minConnections_ && i < pool.connections.size(); ++i)
+    {
+        pool.connections[i].client->connectInLoop();
+    }
+}
+
+HttpClientPool::Metrics HttpClientPoolImpl::metrics() const
+{
+    Metrics metrics;
+    for (auto &pool : loopPools_)
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        metrics.connections += pool->connections.size();
+        for (auto &conn : pool->connections)
+        {
+            auto outstanding = conn.client->outstandingRequests();
+            if (outstanding > 0)
+            {
+                ++metrics.busyConnections;
+                metrics.outstandingRequests += outstanding;
+            }
+        }
+    }
+    metrics.requestsSent = requestsSent_.load(std::memory_order_relaxed);
+    metrics.connectionsOpened =
+        connectionsOpened_.load(std::memory_order_relaxed);
+    metrics.connectionsClosed =
+        connectionsClosed_.load(std::memory_order_relaxed);
+    return metrics;
+}
+
+std::size_t HttpClientPoolImpl::outstandingRequests() const
+{
+    std::size_t outstanding = 0;
+    for (auto &pool : loopPools_)
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        for (auto &conn : pool->connections)
+        {
+            outstanding += conn.client->outstandingRequests();
+        }
+    }
+    return outstanding;
+}
+
+void HttpClientPool::forwardRequest(
+    const HttpRequestPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback,
+    double timeout)
+{
+    auto callbacks = newForwardingCallbacks(req, std::move(callback));
+    req->setPassThrough(true);
+    sendStreamRequest(req,
+                      std::move(callbacks.headersCallback),
+                      std::move(callbacks.dataCallback),
+                      std::move(callbacks.finishCallback),
+                      timeout);
+}
+
+HttpClientPoolPtr HttpClientPool::newHttpClientPool(
+    const std::string &hostString,
+    size_t minConnections,
+    size_t maxConnections,
+    const std::vector<trantor::EventLoop *> &loops,
+    double idleTimeout,
+    bool useOldTLS,
+    bool validateCert)
+{
+    auto poolLoops = loops;
+    if (poolLoops.empty())
+    {
+        auto &app = HttpAppFrameworkImpl::instance();
+        if (app.isRunning())
+        {
+            for (size_t i = 0; i < app.getThreadNum(); ++i)
+            {
+                auto loop = app.getIOLoop(i);
+                if (loop)
+                {
+                    poolLoops.push_back(loop);
+                }
+            }
+        }
+        if (poolLoops.empty())
+        {
+            poolLoops.push_back(app.getLoop());
+        }
+    }
+    return std::make_shared<HttpClientPoolImpl>(hostString,
+                                                minConnections,
+                                                maxConnections,
+                                                poolLoops,
+                                                idleTimeout,
+                                                useOldTLS,
+                                                validateCert);
+}
@@ -0,0 +1,148 @@
+/**
+ *
+ *  @file HttpClientPoolImpl.h
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "HttpClientImpl.h"
+#include <drogon/HttpClientPool.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Date.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+class HttpClientPoolImpl final
+    : public HttpClientPool,
+      public std::enable_shared_from_this<HttpClientPoolImpl>
+{
+  public:
+    HttpClientPoolImpl(std::string hostString,
+                       size_t minConnections,
+                       size_t maxConnections,
+                       const std::vector<trantor::EventLoop *> &loops,
+                       double idleTimeout,
+                       bool useOldTLS,
+                       bool validateCert);
+    ~HttpClientPoolImpl();
+
+    void sendRequest(const HttpRequestPtr &req,
+                     const HttpReqCallback &callback,
+                     double timeout = 0) override;
+    void sendRequest(const HttpRequestPtr &req,
+                     HttpReqCallback &&callback,
+                     double timeout = 0) override;
+    void sendStreamRequest(const HttpRequestPtr &req,
+                           HttpReqCallback &&headersCallback,
+                           HttpRespDataCallback &&dataCallback,
+                           HttpRespFinishCallback &&finishCallback,
+                           double timeout = 0) override;
+
+    Metrics metrics() const override;
+    std::size_t outstandingRequests() const override;
+
+    void setPipeliningDepth(size_t depth) override
+    {
+        pipeliningDepth_ = depth;
+    }
+
+    void setUserAgent(const std::string &userAgent) override
+    {
+        userAgent_ = userAgent;
+    }
+
+    void setSockOptCallback(std::function<void(int)> cb) override
+    {
+        sockOptCallback_ = std::move(cb);
+    }
+
+    void setCertPath(const std::string &cert, const std::string &key) override
+    {
+        clientCertPath_ = cert;
+        clientKeyPath_ = key;
+    }
+
+    void addSSLConfigs(const std::vector<std::pair<std::string, std::string>>
+                           &sslConfCmds) override
+    {
+        sslConfCmds_.insert(sslConfCmds_.end(),
+                            sslConfCmds.begin(),
+                            sslConfCmds.end());
+    }
+
+    void setCacheStore(const HttpCacheStorePtr &store) override
+    {
+        cacheStore_ = store;
+    }
+
+    const std::vector<trantor::EventLoop *> &getLoops() const override
+    {
+        return loops_;
+    }
+
+  private:
+    struct Connection
+    {
+        HttpClientImplPtr client;
+        trantor::Date lastActive;
+    };
+
+    // The connections of a loop are only used in the loop thread, the mutex
+    // guards the changes of the vector against the readers of the metrics.
+    struct LoopPool
+    {
+        explicit LoopPool(trantor::EventLoop *l) : loop(l)
+        {
+        }
+
+        trantor::EventLoop *loop;
+        std::vector<Connection> connections;
+        mutable std::mutex mutex;
+        bool started{false};
+        trantor::TimerId timerId{};
+        std::atomic<bool> timerStarted{false};
+    };
+
+    LoopPool &pickLoopPool();
+    /// The connection a request of the loop is sent on
+    HttpClientImplPtr selectClient(LoopPool &pool);
+    void start(LoopPool &pool);
+    Connection &addConnection(LoopPool &pool);
+    void checkIdleConnections(LoopPool &pool);
+
+    const std::string hostString_;
+    size_t minConnections_;
+    size_t maxConnections_;
+    const double idleTimeout_;
+    const bool useOldTLS_;
+    const bool validateCert_;
+    std::vector<trantor::EventLoop *> loops_;
+    std::vector<std::unique_ptr<LoopPool>> loopPools_;
+    std::atomic<size_t> nextLoop_{0};
+
+    std::atomic<size_t> requestsSent_{0};
+    std::atomic<size_t> connectionsOpened_{0};
+    std::atomic<size_t> connectionsClosed_{0};
+
+    size_t pipeliningDepth_{0};
+    std::string userAgent_{"DrogonClient"};
+    std::function<void(int)> sockOptCallback_;
+    std::string clientCertPath_;
+    std::string clientKeyPath_;
+    std::vector<std::pair<std::string, std::string>> sslConfCmds_;
+    HttpCacheStorePtr cacheStore_;
+};
+}  // namespace drogon
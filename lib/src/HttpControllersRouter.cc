@@ -68,11 +68,20 @@ void HttpControllersRouter::init(
         initMiddlewaresAndCorsMethods(router);
     }
 
-    for (auto &router : ctrlVector_)
+    ctrlTree_.clear();
+    regexCtrlIndices_.clear();
+    for (size_t i = 0; i < ctrlVector_.size(); ++i)
     {
+        auto &router = ctrlVector_[i];
         router.regex_ = std::regex(router.pathParameterPattern_,
                                    std::regex_constants::icase);
         initMiddlewaresAndCorsMethods(router);
+        // Only the patterns that really need regex features are left to the
+        // linear regex scan.
+        if (!ctrlTree_.insert(router.pathParameterPattern_, i))
+        {
+            regexCtrlIndices_.push_back(i);
+        }
     }
 
     for (auto &p : ctrlMap_)
@@ -89,6 +98,8 @@ void HttpControllersRouter::reset()
     simpleCtrlMap_.clear();
     ctrlMap_.clear();
     ctrlVector_.clear();
+    ctrlTree_.clear();
+    regexCtrlIndices_.clear();
     wsCtrlMap_.clear();
     wsCtrlVector_.clear();
 }
@@ -623,25 +634,43 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
     // Find http controller
     HttpControllerRouterItem *routerItemPtr = nullptr;
     std::smatch result;
+    RouteTree::Captures captures;
+    size_t captureCount = 0;
     auto it = ctrlMap_.find(loweredPath);
-    // Try to find a controller in the hash map. If can't linear search
-    // with regex.
+    // Try to find a controller in the hash map. If can't, search the route
+    // tree and then the routes that require regex. The earliest registered
+    // route wins, as with a linear search over all routes.
     if (it != ctrlMap_.end())
     {
         routerItemPtr = &it->second;
     }
     else
     {
-        for (auto &item : ctrlVector_)
+        auto method = req->method();
+        auto index = ctrlTree_.match(
+            loweredPath,
+            [this, method](size_t i) {
+                return ctrlVector_[i].binders_[method] != nullptr;
+            },
+            captures,
+            captureCount);
+        for (auto i : regexCtrlIndices_)
         {
-            const auto &ctrlRegex = item.regex_;
-            if (item.binders_[req->method()] &&
-                std::regex_match(req->path(), result, ctrlRegex))
+            if (i >= index)
+                break;
+            auto &item = ctrlVector_[i];
+            if (item.binders_[method] &&
+                std::regex_match(req->path(), result, item.regex_))
             {
-                routerItemPtr = &item;
+                index = i;
+                captureCount = 0;
                 break;
             }
         }
+        if (index != RouteTree::npos)
+        {
+            routerItemPtr = &ctrlVector_[index];
+        }
     }
 
     // No handler found
@@ -658,10 +687,7 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
         return {RouteResult::MethodNotAllowed, nullptr};
     }
     std::vector<std::string> params;
-    for (size_t j = 1; j < result.size(); ++j)
-    {
-        if (!result[j].matched)
-            continue;
+    auto setParameter = [&params, &binder](size_t j, std::string_view value) {
         size_t place = j;
         if (j <= binder->parameterPlaces_.size())
         {
@@ -669,8 +695,29 @@ RouteResult HttpControllersRouter::route(const HttpRequestImplPtr &req)
         }
         if (place > params.size())
             params.resize(place);
-        params[place - 1] = result[j].str();
+        params[place - 1] = value;
         LOG_TRACE << "place=" << place << " para:" << params[place - 1];
+    };
+    if (captureCount > 0)
+    {
+        // Captures refer to the lowered path, take the original characters
+        const auto &path = req->path();
+        for (size_t j = 0; j < captureCount; ++j)
+        {
+            auto offset = captures[j].data() - loweredPath.data();
+            setParameter(j + 1,
+                         std::string_view(path).substr(offset,
+                                                       captures[j].size()));
+        }
+    }
+    else
+    {
+        for (size_t j = 1; j < result.size(); ++j)
+        {
+            if (!result[j].matched)
+                continue;
+            setParameter(j, result[j].str());
+        }
     }
 
     if (!binder->queryParametersPlaces_.empty())
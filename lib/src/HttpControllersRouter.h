@@ -16,6 +16,7 @@
 
 #include "impl_forwards.h"
 #include "ControllerBinderBase.h"
+#include "RouteTree.h"
 #include <trantor/utils/NonCopyable.h>
 #include <memory>
 #include <regex>
@@ -103,6 +104,10 @@ class HttpControllersRouter : public trantor::NonCopyable
     std::unordered_map<std::string, SimpleControllerRouterItem> simpleCtrlMap_;
     std::unordered_map<std::string, HttpControllerRouterItem> ctrlMap_;
     std::vector<HttpControllerRouterItem> ctrlVector_;  // for regexp path
+    // Compiled from ctrlVector_ on init(), indices refer to ctrlVector_
+    RouteTree ctrlTree_;
+    // Indices of the items in ctrlVector_ that must be matched with regex
+    std::vector<size_t> regexCtrlIndices_;
     std::unordered_map<std::string, WebSocketControllerRouterItem> wsCtrlMap_;
     std::vector<RegExWebSocketControllerRouterItem> wsCtrlVector_;
 };
@@ -106,6 +106,27 @@ class HttpMessageStringBody : public HttpMessageBody
         body_.append(buf, len);
     }
 
+    // Used to reuse the body of a recycled response
+    void assign(const char *buf, size_t len)
+    {
+        body_.assign(buf, len);
+    }
+
+    void assign(std::string &&body)
+    {
+        body_ = std::move(body);
+    }
+
+    void clear()
+    {
+        body_.clear();
+    }
+
+    size_t capacity() const
+    {
+        return body_.capacity();
+    }
+
   private:
     std::string body_;
 };
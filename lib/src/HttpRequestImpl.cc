@@ -36,8 +36,8 @@ void HttpRequestImpl::parseJson() const
     if (input.empty())
         return;
     if (contentType_ == CT_APPLICATION_JSON ||
-        getHeaderBy("content-type").find("application/json") !=
-            std::string::npos)
+        getHeaderViewBy("content-type").find("application/json") !=
+            std::string_view::npos)
     {
         static std::once_flag once;
         static Json::CharReaderBuilder builder;
@@ -192,6 +192,8 @@ void HttpRequestImpl::parseParameters() const
 
 void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
 {
+    materializeHeaders();
+    materializeCookies();
     switch (method_)
     {
         case Get:
@@ -464,83 +466,189 @@ void HttpRequestImpl::addHeader(const char *start,
     if (field.length() == 6 && field == "cookie")
     {
         LOG_TRACE << "cookies!!!:" << value;
-        std::string::size_type pos;
-        while ((pos = value.find(';')) != std::string::npos)
+        materializeCookies();
+        parseCookieHeader(std::move(value));
+    }
+    else
+    {
+        handleSpecialHeader(field, value);
+        materializeHeaders();
+        headers_.emplace(std::move(field), std::move(value));
+    }
+}
+
+void HttpRequestImpl::addHeaderToFlatStorage(const char *start,
+                                             const char *colon,
+                                             const char *end)
+{
+    const char *valueStart = colon + 1;
+    while (valueStart < end &&
+           isspace(static_cast<unsigned char>(*valueStart)))
+    {
+        ++valueStart;
+    }
+    while (end > valueStart && isspace(static_cast<unsigned char>(*(end - 1))))
+    {
+        --end;
+    }
+    if (headerSlices_.capacity() == 0)
+    {
+        headerSlices_.reserve(16);
+    }
+    HeaderSlice slice;
+    slice.nameOffset = static_cast<uint32_t>(headerArena_.size());
+    slice.nameLength = static_cast<uint32_t>(colon - start);
+    headerArena_.append(start, colon);
+    // Field name is case-insensitive.so we transform it to lower;(rfc2616-4.2)
+    std::transform(headerArena_.begin() + slice.nameOffset,
+                   headerArena_.end(),
+                   headerArena_.begin() + slice.nameOffset,
+                   [](unsigned char c) { return tolower(c); });
+    slice.valueOffset = static_cast<uint32_t>(headerArena_.size());
+    slice.valueLength = static_cast<uint32_t>(end - valueStart);
+    headerArena_.append(valueStart, end);
+    headerSlices_.push_back(slice);
+
+    auto field = headerName(slice);
+    if (field.length() == 6 && field == "cookie")
+    {
+        cookiesMaterialized_ = false;
+    }
+    else
+    {
+        headersMaterialized_ = false;
+        handleSpecialHeader(field, headerValue(slice));
+    }
+}
+
+std::string_view HttpRequestImpl::getHeaderViewBy(
+    std::string_view lowerField) const
+{
+    if (!headersMaterialized_)
+    {
+        // The header map is not built yet, all headers are in the flat storage
+        if (lowerField == "cookie")
+            return {};
+        for (auto &slice : headerSlices_)
         {
-            std::string coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string::npos)
+            if (slice.nameLength == lowerField.length() &&
+                headerName(slice) == lowerField)
             {
-                std::string cookie_name = coo.substr(0, epos);
-                std::string::size_type cpos = 0;
-                while (cpos < cookie_name.length() &&
-                       isspace(static_cast<unsigned char>(cookie_name[cpos])))
-                    ++cpos;
-                cookie_name = cookie_name.substr(cpos);
-                std::string cookie_value = coo.substr(epos + 1);
-                cpos = 0;
-                while (cpos < cookie_value.length() &&
-                       isspace(static_cast<unsigned char>(cookie_value[cpos])))
-                    ++cpos;
-                cookie_value = cookie_value.substr(cpos);
-                cookies_[std::move(cookie_name)] = std::move(cookie_value);
+                return headerValue(slice);
             }
-            value = value.substr(pos + 1);
         }
-        if (value.length() > 0)
+        return {};
+    }
+    auto it = headers_.find(std::string(lowerField));
+    if (it != headers_.end())
+    {
+        return it->second;
+    }
+    return {};
+}
+
+void HttpRequestImpl::buildHeaderMap() const
+{
+    for (auto &slice : headerSlices_)
+    {
+        auto field = headerName(slice);
+        if (field.length() == 6 && field == "cookie")
+            continue;
+        headers_.emplace(std::string(field), std::string(headerValue(slice)));
+    }
+}
+
+void HttpRequestImpl::buildCookieMap() const
+{
+    for (auto &slice : headerSlices_)
+    {
+        auto field = headerName(slice);
+        if (field.length() == 6 && field == "cookie")
         {
-            std::string &coo = value;
-            auto epos = coo.find('=');
-            if (epos != std::string::npos)
-            {
-                std::string cookie_name = coo.substr(0, epos);
-                std::string::size_type cpos = 0;
-                while (cpos < cookie_name.length() &&
-                       isspace(static_cast<unsigned char>(cookie_name[cpos])))
-                    ++cpos;
-                cookie_name = cookie_name.substr(cpos);
-                std::string cookie_value = coo.substr(epos + 1);
-                cpos = 0;
-                while (cpos < cookie_value.length() &&
-                       isspace(static_cast<unsigned char>(cookie_value[cpos])))
-                    ++cpos;
-                cookie_value = cookie_value.substr(cpos);
-                cookies_[std::move(cookie_name)] = std::move(cookie_value);
-            }
+            parseCookieHeader(std::string(headerValue(slice)));
         }
     }
-    else
+}
+
+void HttpRequestImpl::handleSpecialHeader(std::string_view field,
+                                          std::string_view value)
+{
+    switch (field.length())
     {
-        switch (field.length())
+        case 6:
+            if (field == "expect")
+            {
+                expectPtr_ = std::make_unique<std::string>(value);
+            }
+            break;
+        case 10:
         {
-            case 6:
-                if (field == "expect")
+            if (field == "connection")
+            {
+                if (version_ == Version::kHttp11)
                 {
-                    expectPtr_ = std::make_unique<std::string>(value);
+                    if (value.length() == 5 && value == "close")
+                        keepAlive_ = false;
                 }
-                break;
-            case 10:
-            {
-                if (field == "connection")
+                else if (value.length() == 10 &&
+                         (value == "Keep-Alive" || value == "keep-alive"))
                 {
-                    if (version_ == Version::kHttp11)
-                    {
-                        if (value.length() == 5 && value == "close")
-                            keepAlive_ = false;
-                    }
-                    else if (value.length() == 10 &&
-                             (value == "Keep-Alive" || value == "keep-alive"))
-                    {
-                        keepAlive_ = true;
-                    }
+                    keepAlive_ = true;
                 }
             }
+        }
+        break;
+
+        default:
             break;
+    }
+}
 
-            default:
-                break;
+void HttpRequestImpl::parseCookieHeader(std::string value) const
+{
+    std::string::size_type pos;
+    while ((pos = value.find(';')) != std::string::npos)
+    {
+        std::string coo = value.substr(0, pos);
+        auto epos = coo.find('=');
+        if (epos != std::string::npos)
+        {
+            std::string cookie_name = coo.substr(0, epos);
+            std::string::size_type cpos = 0;
+            while (cpos < cookie_name.length() &&
+                   isspace(static_cast<unsigned char>(cookie_name[cpos])))
+                ++cpos;
+            cookie_name = cookie_name.substr(cpos);
+            std::string cookie_value = coo.substr(epos + 1);
+            cpos = 0;
+            while (cpos < cookie_value.length() &&
+                   isspace(static_cast<unsigned char>(cookie_value[cpos])))
+                ++cpos;
+            cookie_value = cookie_value.substr(cpos);
+            cookies_[std::move(cookie_name)] = std::move(cookie_value);
+        }
+        value = value.substr(pos + 1);
+    }
+    if (value.length() > 0)
+    {
+        std::string &coo = value;
+        auto epos = coo.find('=');
+        if (epos != std::string::npos)
+        {
+            std::string cookie_name = coo.substr(0, epos);
+            std::string::size_type cpos = 0;
+            while (cpos < cookie_name.length() &&
+                   isspace(static_cast<unsigned char>(cookie_name[cpos])))
+                ++cpos;
+            cookie_name = cookie_name.substr(cpos);
+            std::string cookie_value = coo.substr(epos + 1);
+            cpos = 0;
+            while (cpos < cookie_value.length() &&
+                   isspace(static_cast<unsigned char>(cookie_value[cpos])))
+                ++cpos;
+            cookie_value = cookie_value.substr(cpos);
+            cookies_[std::move(cookie_name)] = std::move(cookie_value);
         }
-        headers_.emplace(std::move(field), std::move(value));
     }
 }
 
@@ -609,6 +717,10 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(query_, that.query_);
     swap(headers_, that.headers_);
     swap(cookies_, that.cookies_);
+    swap(headerArena_, that.headerArena_);
+    swap(headerSlices_, that.headerSlices_);
+    swap(headersMaterialized_, that.headersMaterialized_);
+    swap(cookiesMaterialized_, that.cookiesMaterialized_);
     swap(contentLengthHeaderValue_, that.contentLengthHeaderValue_);
     swap(realContentLength_, that.realContentLength_);
     swap(parameters_, that.parameters_);
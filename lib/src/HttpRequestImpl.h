@@ -77,6 +77,10 @@ class HttpRequestImpl : public HttpRequest
         flagForParsingJson_ = false;
         headers_.clear();
         cookies_.clear();
+        headerArena_.clear();
+        headerSlices_.clear();
+        headersMaterialized_ = true;
+        cookiesMaterialized_ = true;
         contentLengthHeaderValue_.reset();
         realContentLength_ = 0;
         flagForParsingParameters_ = false;
@@ -88,7 +92,10 @@ class HttpRequestImpl : public HttpRequest
         parameters_.clear();
         jsonPtr_.reset();
         sessionPtr_.reset();
-        attributesPtr_.reset();
+        if (attributesPtr_.use_count() == 1)
+            attributesPtr_->clear();
+        else
+            attributesPtr_.reset();
         cacheFilePtr_.reset();
         expectPtr_.reset();
         content_.clear();
@@ -96,6 +103,8 @@ class HttpRequestImpl : public HttpRequest
         flagForParsingContentType_ = false;
         contentTypeString_.clear();
         keepAlive_ = true;
+        isOnSecureConnection_ = false;
+        passThrough_ = false;
         jsonParsingErrorPtr_.reset();
         peerCertificate_.reset();
         routingParams_.clear();
@@ -106,8 +115,24 @@ class HttpRequestImpl : public HttpRequest
         streamExceptionPtr_ = nullptr;
         startProcessing_ = false;
         connPtr_.reset();
+        processingTimes_ = ProcessingTimes();
+    }
+
+    /**
+     * @brief Called by ObjectPool when the request returns to the pool of
+     * its IO thread. The buffers of large requests are released.
+     */
+    void recycle()
+    {
+        reset();
+        if (content_.capacity() > maxRecycledBufferSize)
+            std::string().swap(content_);
+        if (headerArena_.capacity() > maxRecycledBufferSize)
+            std::string().swap(headerArena_);
     }
 
+    static constexpr size_t maxRecycledBufferSize = 16 * 1024;
+
     trantor::EventLoop *getLoop()
     {
         return loop_;
@@ -342,6 +367,24 @@ class HttpRequestImpl : public HttpRequest
 
     void addHeader(const char *start, const char *colon, const char *end);
 
+    /**
+     * @brief Record a header line in the flat header storage. The field name
+     * and value are copied into a request-owned arena and looked up linearly,
+     * the map returned by headers() is only built when it is used.
+     */
+    void addHeaderToFlatStorage(const char *start,
+                                const char *colon,
+                                const char *end);
+
+    /**
+     * @brief Get the value of a header without building the header map.
+     *
+     * @param lowerField The lower-cased field name.
+     * @note The returned view is invalidated by any modification of the
+     * headers.
+     */
+    std::string_view getHeaderViewBy(std::string_view lowerField) const;
+
     void removeHeader(std::string key) override
     {
         transform(key.begin(), key.end(), key.begin(), [](unsigned char c) {
@@ -352,11 +395,13 @@ class HttpRequestImpl : public HttpRequest
 
     void removeHeaderBy(const std::string &lowerKey)
     {
+        materializeHeaders();
         headers_.erase(lowerKey);
     }
 
     void clearHeaders() override
     {
+        materializeHeaders();
         headers_.clear();
     }
 
@@ -372,6 +417,7 @@ class HttpRequestImpl : public HttpRequest
     const std::string &getHeaderBy(const std::string &lowerField) const
     {
         static const std::string defaultVal;
+        materializeHeaders();
         auto it = headers_.find(lowerField);
         if (it != headers_.end())
         {
@@ -383,6 +429,7 @@ class HttpRequestImpl : public HttpRequest
     const std::string &getCookie(const std::string &field) const override
     {
         static const std::string defaultVal;
+        materializeCookies();
         auto it = cookies_.find(field);
         if (it != cookies_.end())
         {
@@ -393,11 +440,13 @@ class HttpRequestImpl : public HttpRequest
 
     const SafeStringMap<std::string> &headers() const override
     {
+        materializeHeaders();
         return headers_;
     }
 
     const SafeStringMap<std::string> &cookies() const override
     {
+        materializeCookies();
         return cookies_;
     }
 
@@ -466,6 +515,7 @@ class HttpRequestImpl : public HttpRequest
                   field.end(),
                   field.begin(),
                   [](unsigned char c) { return tolower(c); });
+        materializeHeaders();
         headers_[std::move(field)] = value;
     }
 
@@ -475,11 +525,13 @@ class HttpRequestImpl : public HttpRequest
                   field.end(),
                   field.begin(),
                   [](unsigned char c) { return tolower(c); });
+        materializeHeaders();
         headers_[std::move(field)] = std::move(value);
     }
 
     void addCookie(std::string key, std::string value) override
     {
+        materializeCookies();
         cookies_[std::move(key)] = std::move(value);
     }
 
@@ -653,6 +705,23 @@ class HttpRequestImpl : public HttpRequest
         return startProcessing_;
     }
 
+    /**
+     * @brief The times (in microseconds since the epoch) at which the request
+     * reached the steps of its processing, recorded by RequestMetrics. 0 when
+     * not reached or when the metrics are disabled.
+     */
+    struct ProcessingTimes
+    {
+        int64_t routing{0};
+        int64_t handling{0};
+        int64_t responded{0};
+    };
+
+    ProcessingTimes &processingTimes()
+    {
+        return processingTimes_;
+    }
+
     ~HttpRequestImpl() override;
 
   protected:
@@ -673,23 +742,22 @@ class HttpRequestImpl : public HttpRequest
         if (!flagForParsingContentType_)
         {
             flagForParsingContentType_ = true;
-            auto &contentTypeString = getHeaderBy("content-type");
-            if (contentTypeString == "")
+            auto contentTypeString = getHeaderViewBy("content-type");
+            if (contentTypeString.empty())
             {
                 contentType_ = CT_NONE;
             }
             else
             {
                 auto pos = contentTypeString.find(';');
-                if (pos != std::string::npos)
+                if (pos != std::string_view::npos)
                 {
                     contentType_ = parseContentType(
                         std::string_view(contentTypeString.data(), pos));
                 }
                 else
                 {
-                    contentType_ =
-                        parseContentType(std::string_view(contentTypeString));
+                    contentType_ = parseContentType(contentTypeString);
                 }
 
                 if (contentType_ == CT_NONE)
@@ -715,6 +783,50 @@ class HttpRequestImpl : public HttpRequest
 
     void createTmpFile();
     void parseJson() const;
+    void handleSpecialHeader(std::string_view field, std::string_view value);
+    void parseCookieHeader(std::string value) const;
+
+    // Build headers_ (or cookies_) from the flat header storage on first use
+    void materializeHeaders() const
+    {
+        if (!headersMaterialized_)
+        {
+            headersMaterialized_ = true;
+            buildHeaderMap();
+        }
+    }
+
+    void materializeCookies() const
+    {
+        if (!cookiesMaterialized_)
+        {
+            cookiesMaterialized_ = true;
+            buildCookieMap();
+        }
+    }
+
+    void buildHeaderMap() const;
+    void buildCookieMap() const;
+
+    struct HeaderSlice
+    {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t valueOffset;
+        uint32_t valueLength;
+    };
+
+    std::string_view headerName(const HeaderSlice &slice) const
+    {
+        return std::string_view(headerArena_.data() + slice.nameOffset,
+                                slice.nameLength);
+    }
+
+    std::string_view headerValue(const HeaderSlice &slice) const
+    {
+        return std::string_view(headerArena_.data() + slice.valueOffset,
+                                slice.valueLength);
+    }
 #ifdef USE_BROTLI
     StreamDecompressStatus decompressBodyBrotli() noexcept;
 #endif
@@ -735,8 +847,14 @@ class HttpRequestImpl : public HttpRequest
     bool pathEncode_{true};
     std::string_view matchedPathPattern_{""};
     std::string query_;
-    SafeStringMap<std::string> headers_;
-    SafeStringMap<std::string> cookies_;
+    mutable SafeStringMap<std::string> headers_;
+    mutable SafeStringMap<std::string> cookies_;
+    // Flat header storage, the capacities are kept when the request object
+    // is recycled by the parser.
+    std::string headerArena_;
+    std::vector<HeaderSlice> headerSlices_;
+    mutable bool headersMaterialized_{true};
+    mutable bool cookiesMaterialized_{true};
     std::optional<size_t> contentLengthHeaderValue_;
     size_t realContentLength_{0};
     mutable SafeStringMap<std::string> parameters_;
@@ -761,6 +879,7 @@ class HttpRequestImpl : public HttpRequest
     std::exception_ptr streamExceptionPtr_;
     bool startProcessing_{false};
     std::weak_ptr<trantor::TcpConnection> connPtr_;
+    ProcessingTimes processingTimes_;
 
   protected:
     std::string content_;
@@ -16,11 +16,15 @@
 #include <drogon/HttpTypes.h>
 #include <trantor/utils/Logger.h>
 #include <trantor/utils/MsgBuffer.h>
+#include <charconv>
+#include <cstring>
 #include <iostream>
 #include "HttpAppFrameworkImpl.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 #include "HttpUtils.h"
+#include "ObjectPool.h"
+#include "utils/HttpScan.h"
 
 using namespace trantor;
 using namespace drogon;
@@ -32,13 +36,19 @@ static constexpr size_t TRUNK_LEN_MAX_LEN = 16;  // 0xFFFFFFFF,FFFFFFFF
 HttpRequestParser::HttpRequestParser(const trantor::TcpConnectionPtr &connPtr)
     : status_(HttpRequestParseStatus::kExpectMethod),
       loop_(connPtr->getLoop()),
-      conn_(connPtr)
+      conn_(connPtr),
+      flatHeaders_(
+          HttpAppFrameworkImpl::instance().isFlatRequestHeadersEnabled())
 {
 }
 
 bool HttpRequestParser::processRequestLine(const char *begin, const char *end)
 {
     bool succeed = false;
+    if (utils::findControlChar(begin, end) != end)
+    {
+        return false;
+    }
     const char *start = begin;
     const char *space = std::find(start, end, ' ');
     if (space != end)
@@ -84,52 +94,15 @@ bool HttpRequestParser::processRequestLine(const char *begin, const char *end)
     return succeed;
 }
 
-HttpRequestImplPtr HttpRequestParser::makeRequestForPool(HttpRequestImpl *ptr)
-{
-    return std::shared_ptr<HttpRequestImpl>(
-        ptr, [weakPtr = weak_from_this()](HttpRequestImpl *p) {
-            auto thisPtr = weakPtr.lock();
-            if (thisPtr)
-            {
-                if (thisPtr->loop_->isInLoopThread())
-                {
-                    p->reset();
-                    thisPtr->requestsPool_.emplace_back(
-                        thisPtr->makeRequestForPool(p));
-                }
-                else
-                {
-                    auto &loop = thisPtr->loop_;
-                    loop->queueInLoop([thisPtr = std::move(thisPtr), p]() {
-                        p->reset();
-                        thisPtr->requestsPool_.emplace_back(
-                            thisPtr->makeRequestForPool(p));
-                    });
-                }
-            }
-            else
-            {
-                delete p;
-            }
-        });
-}
-
 void HttpRequestParser::reset()
 {
     assert(loop_->isInLoopThread());
     remainContentLength_ = 0;
     status_ = HttpRequestParseStatus::kExpectMethod;
-    if (requestsPool_.empty())
-    {
-        request_ = makeRequestForPool(new HttpRequestImpl(loop_));
-    }
-    else
-    {
-        auto req = std::move(requestsPool_.back());
-        requestsPool_.pop_back();
-        request_ = std::move(req);
-        request_->setCreationDate(trantor::Date::now());
-    }
+    // Requests are recycled by the pool of the IO thread rather than by the
+    // connection, so short connections benefit too
+    request_ = ObjectPool<HttpRequestImpl>::acquire(loop_);
+    request_->setCreationDate(trantor::Date::now());
 }
 
 /**
@@ -171,7 +144,8 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
             }
             case HttpRequestParseStatus::kExpectRequestLine:
             {
-                const char *crlf = buf->findCRLF();
+                const char *crlf =
+                    utils::findCRLF(buf->peek(), buf->beginWrite());
                 if (!crlf)
                 {
                     if (buf->readableBytes() >= 64 * 1024)
@@ -194,7 +168,8 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
             }
             case HttpRequestParseStatus::kExpectHeaders:
             {
-                const char *crlf = buf->findCRLF();
+                const char *crlf =
+                    utils::findCRLF(buf->peek(), buf->beginWrite());
                 if (!crlf)
                 {
                     if (buf->readableBytes() >= 64 * 1024)
@@ -206,11 +181,29 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                     return 0;
                 }
 
-                const char *colon = std::find(buf->peek(), crlf, ':');
+                auto colon = static_cast<const char *>(
+                    memchr(buf->peek(), ':', crlf - buf->peek()));
                 // found colon
-                if (colon != crlf)
+                if (colon)
                 {
-                    request_->addHeader(buf->peek(), colon, crlf);
+                    // The field name must be a token and the value must not
+                    // contain control characters (rfc9110-5.1, 5.5)
+                    if (colon == buf->peek() ||
+                        utils::findNonTokenChar(buf->peek(), colon) != colon ||
+                        utils::findControlChar(colon + 1, crlf) != crlf)
+                    {
+                        return -k400BadRequest;
+                    }
+                    if (flatHeaders_)
+                    {
+                        request_->addHeaderToFlatStorage(buf->peek(),
+                                                         colon,
+                                                         crlf);
+                    }
+                    else
+                    {
+                        request_->addHeader(buf->peek(), colon, crlf);
+                    }
                     buf->retrieveUntil(crlf + CRLF_LEN);
                     continue;
                 }
@@ -221,18 +214,19 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 // and maintainability.
 
                 // process header information
-                auto &len = request_->getHeaderBy("content-length");
+                auto len = request_->getHeaderViewBy("content-length");
                 if (!len.empty())
                 {
-                    try
-                    {
-                        remainContentLength_ =
-                            static_cast<size_t>(std::stoull(len));
-                    }
-                    catch (...)
+                    unsigned long long length;
+                    auto result = std::from_chars(len.data(),
+                                                  len.data() + len.size(),
+                                                  length);
+                    if (result.ec != std::errc() ||
+                        result.ptr != len.data() + len.size())
                     {
                         return -k400BadRequest;
                     }
+                    remainContentLength_ = static_cast<size_t>(length);
                     request_->contentLengthHeaderValue_ = remainContentLength_;
                     if (remainContentLength_ == 0)
                     {
@@ -246,8 +240,8 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
                 }
                 else
                 {
-                    const std::string &encode =
-                        request_->getHeaderBy("transfer-encoding");
+                    auto encode =
+                        request_->getHeaderViewBy("transfer-encoding");
                     if (encode.empty())
                     {
                         // no content-length and no transfer-encoding,
@@ -355,7 +349,8 @@ int HttpRequestParser::parseRequest(MsgBuffer *buf)
             }
             case HttpRequestParseStatus::kExpectChunkLen:
             {
-                const char *crlf = buf->findCRLF();
+                const char *crlf =
+                    utils::findCRLF(buf->peek(), buf->beginWrite());
                 if (!crlf)
                 {
                     if (buf->readableBytes() > TRUNK_LEN_MAX_LEN + CRLF_LEN)
@@ -77,6 +77,23 @@ class HttpRequestParser : public trantor::NonCopyable,
         websockConnPtr_ = conn;
     }
 
+    const Http2ConnectionPtr &http2Connection() const
+    {
+        return http2ConnPtr_;
+    }
+
+    void setHttp2Connection(const Http2ConnectionPtr &conn)
+    {
+        http2ConnPtr_ = conn;
+    }
+
+    /// Nothing was parsed yet, an HTTP/2 preface can still come
+    bool atConnectionStart() const
+    {
+        return requestsCounter_ == 0 &&
+               status_ == HttpRequestParseStatus::kExpectMethod;
+    }
+
     // to support request pipelining(rfc2616-8.1.2.2)
     void pushRequestToPipelining(const HttpRequestPtr &, bool isHeadMethod);
     bool pushResponseToPipelining(const HttpRequestPtr &, HttpResponsePtr);
@@ -136,13 +153,13 @@ class HttpRequestParser : public trantor::NonCopyable,
     }
 
   private:
-    HttpRequestImplPtr makeRequestForPool(HttpRequestImpl *p);
     bool processRequestLine(const char *begin, const char *end);
     HttpRequestParseStatus status_;
     trantor::EventLoop *loop_;
     HttpRequestImplPtr request_;
     bool firstRequest_{true};
     WebSocketConnectionImplPtr websockConnPtr_;
+    Http2ConnectionPtr http2ConnPtr_;
     std::deque<std::pair<HttpRequestPtr, std::pair<HttpResponsePtr, bool>>>
         requestPipelining_;
     size_t requestsCounter_{0};
@@ -152,9 +169,9 @@ class HttpRequestParser : public trantor::NonCopyable,
     std::unique_ptr<std::vector<std::pair<HttpResponsePtr, bool>>>
         responseBuffer_;
     std::unique_ptr<std::vector<HttpRequestImplPtr>> requestBuffer_;
-    std::vector<HttpRequestImplPtr> requestsPool_;
     size_t currentChunkLength_{0};
     size_t remainContentLength_{0};
+    bool flatHeaders_{false};
 };
 
 }  // namespace drogon
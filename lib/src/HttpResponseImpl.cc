@@ -16,6 +16,7 @@
 #include "AOPAdvice.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpUtils.h"
+#include "ObjectPool.h"
 #include <drogon/HttpViewData.h>
 #include <drogon/IOThreadStorage.h>
 #include <filesystem>
@@ -66,7 +67,7 @@ bool HttpResponseImpl::allowCompression() const
 
 HttpResponsePtr HttpResponse::newHttpResponse()
 {
-    auto res = std::make_shared<HttpResponseImpl>(k200OK, CT_TEXT_HTML);
+    auto res = HttpResponseImpl::newPooledResponse(k200OK, CT_TEXT_HTML);
     AopAdvice::instance().passResponseCreationAdvices(res);
     return res;
 }
@@ -74,14 +75,27 @@ HttpResponsePtr HttpResponse::newHttpResponse()
 HttpResponsePtr HttpResponse::newHttpResponse(HttpStatusCode code,
                                               ContentType type)
 {
-    auto res = std::make_shared<HttpResponseImpl>(code, type);
+    auto res = HttpResponseImpl::newPooledResponse(code, type);
+    AopAdvice::instance().passResponseCreationAdvices(res);
+    return res;
+}
+
+HttpResponsePtr HttpResponse::newHttpResponseFromTemplate(
+    const HttpResponsePtr &templateResponse,
+    std::string body)
+{
+    auto res = std::make_shared<HttpResponseImpl>(
+        *static_cast<HttpResponseImpl *>(templateResponse.get()));
+    res->initFromTemplate();
+    res->setBody(std::move(body));
     AopAdvice::instance().passResponseCreationAdvices(res);
     return res;
 }
 
 HttpResponsePtr HttpResponse::newHttpJsonResponse(const Json::Value &data)
 {
-    auto res = std::make_shared<HttpResponseImpl>(k200OK, CT_APPLICATION_JSON);
+    auto res =
+        HttpResponseImpl::newPooledResponse(k200OK, CT_APPLICATION_JSON);
     res->setJsonObject(data);
     AopAdvice::instance().passResponseCreationAdvices(res);
     return res;
@@ -89,7 +103,8 @@ HttpResponsePtr HttpResponse::newHttpJsonResponse(const Json::Value &data)
 
 HttpResponsePtr HttpResponse::newHttpJsonResponse(Json::Value &&data)
 {
-    auto res = std::make_shared<HttpResponseImpl>(k200OK, CT_APPLICATION_JSON);
+    auto res =
+        HttpResponseImpl::newPooledResponse(k200OK, CT_APPLICATION_JSON);
     res->setJsonObject(std::move(data));
     AopAdvice::instance().passResponseCreationAdvices(res);
     return res;
@@ -198,7 +213,7 @@ HttpResponsePtr HttpResponse::newRedirectionResponse(
     const std::string &location,
     HttpStatusCode status)
 {
-    auto res = std::make_shared<HttpResponseImpl>();
+    auto res = HttpResponseImpl::newPooledResponse();
     res->setStatusCode(status);
     res->redirect(location);
     AopAdvice::instance().passResponseCreationAdvices(res);
@@ -220,7 +235,7 @@ HttpResponsePtr HttpResponse::newFileResponse(
     const std::string &typeString)
 {
     // Make Raw HttpResponse
-    auto resp = std::make_shared<HttpResponseImpl>();
+    auto resp = HttpResponseImpl::newPooledResponse();
 
     // Set response body and length
     resp->setBody(
@@ -296,7 +311,7 @@ HttpResponsePtr HttpResponse::newFileResponse(
         auto resp = HttpResponse::newNotFoundResponse(req);
         return resp;
     }
-    auto resp = std::make_shared<HttpResponseImpl>();
+    auto resp = HttpResponseImpl::newPooledResponse();
     std::streambuf *pbuf = infile.rdbuf();
     size_t filesize =
         static_cast<size_t>(pbuf->pubseekoff(0, std::ifstream::end));
@@ -420,7 +435,7 @@ HttpResponsePtr HttpResponse::newStreamResponse(
         auto resp = HttpResponse::newNotFoundResponse();
         return resp;
     }
-    auto resp = std::make_shared<HttpResponseImpl>();
+    auto resp = HttpResponseImpl::newPooledResponse();
     resp->setStreamCallback(callback);
     resp->setStatusCode(k200OK);
 
@@ -476,7 +491,7 @@ HttpResponsePtr HttpResponse::newAsyncStreamResponse(
         auto resp = HttpResponse::newNotFoundResponse();
         return resp;
     }
-    auto resp = std::make_shared<HttpResponseImpl>();
+    auto resp = HttpResponseImpl::newPooledResponse();
     resp->setAsyncStreamCallback(callback, disableKickoffTimeout);
     resp->setStatusCode(k200OK);
     AopAdvice::instance().passResponseCreationAdvices(resp);
@@ -687,7 +702,8 @@ void HttpResponse::addCorsHeaders(
         removeHeader("Access-Control-Allow-Credentials");
 }
 
-void HttpResponseImpl::makeHeaderString(trantor::MsgBuffer &buffer)
+void HttpResponseImpl::makeHeaderString(trantor::MsgBuffer &buffer,
+                                        bool withContentLength)
 {
     buffer.ensureWritableBytes(128);
     int len{0};
@@ -734,10 +750,8 @@ void HttpResponseImpl::makeHeaderString(trantor::MsgBuffer &buffer)
     generateBodyFromJson();
     if (!passThrough_)
     {
-        buffer.ensureWritableBytes(64);
         if (!contentLengthIsAllowed())
         {
-            len = 0;
             if ((bodyPtr_ && bodyPtr_->length() > 0) ||
                 !sendfileName_.empty() || streamCallback_ ||
                 asyncStreamCallback_)
@@ -756,25 +770,11 @@ void HttpResponseImpl::makeHeaderString(trantor::MsgBuffer &buffer)
                 LOG_DEBUG << "send stream with transfer-encoding chunked";
                 headers_["transfer-encoding"] = "chunked";
             }
-            len = 0;
-        }
-        else if (sendfileName_.empty())
-        {
-            auto bodyLength = bodyPtr_ ? bodyPtr_->length() : 0;
-            len = snprintf(buffer.beginWrite(),
-                           buffer.writableBytes(),
-                           contentLengthFormatString<decltype(bodyLength)>(),
-                           bodyLength);
         }
-        else
+        else if (withContentLength)
         {
-            auto bodyLength = sendfileRange_.second;
-            len = snprintf(buffer.beginWrite(),
-                           buffer.writableBytes(),
-                           contentLengthFormatString<decltype(bodyLength)>(),
-                           bodyLength);
+            appendContentLength(buffer);
         }
-        buffer.hasWritten(len);
         if (headers_.find("connection") == headers_.end())
         {
             if (closeConnection_)
@@ -809,16 +809,62 @@ void HttpResponseImpl::makeHeaderString(trantor::MsgBuffer &buffer)
     }
 }
 
-void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer)
+void HttpResponseImpl::appendContentLength(trantor::MsgBuffer &buffer) const
 {
-    if (expriedTime_ >= 0)
+    buffer.ensureWritableBytes(64);
+    auto bodyLength = sendfileName_.empty()
+                          ? (bodyPtr_ ? bodyPtr_->length() : size_t{0})
+                          : sendfileRange_.second;
+    auto len = snprintf(buffer.beginWrite(),
+                        buffer.writableBytes(),
+                        contentLengthFormatString<decltype(bodyLength)>(),
+                        bodyLength);
+    buffer.hasWritten(len);
+}
+
+void HttpResponseImpl::freezeHeaders()
+{
+    if (frozenHeaders_)
+        return;
+    if (passThrough_ || streamCallback_ || asyncStreamCallback_)
     {
-        auto strPtr = renderToBuffer();
-        buffer.append(strPtr->peek(), strPtr->readableBytes());
+        LOG_DEBUG << "Stream and pass-through responses are not frozen";
         return;
     }
+    trantor::MsgBuffer buffer(256);
+    makeHeaderString(buffer, false);
+    auto frozen = std::make_shared<FrozenHeaders>();
+    frozen->block.assign(buffer.peek(), buffer.readableBytes());
+    frozen->headers.swap(headers_);
+    frozenHeaders_ = std::move(frozen);
+    fullHeaderString_.reset();
+}
+
+// Reset the state that belongs to a single response after copying a template
+void HttpResponseImpl::initFromTemplate()
+{
+    creationDate_ = trantor::Date::now();
+    expriedTime_ = -1;
+    httpString_.reset();
+    datePos_ = std::string::npos;
+    jsonPtr_.reset();
+    jsonParsingErrorPtr_.reset();
+    flagForParsingJson_ = false;
+    flagForSerializingJson_ = true;
+}
 
-    if (!fullHeaderString_)
+// Status line, headers and cookies, without the date header and the empty
+// line
+void HttpResponseImpl::renderHeaders(trantor::MsgBuffer &buffer)
+{
+    if (frozenHeaders_)
+    {
+        generateBodyFromJson();
+        buffer.append(frozenHeaders_->block);
+        if (contentLengthIsAllowed())
+            appendContentLength(buffer);
+    }
+    else if (!fullHeaderString_)
     {
         makeHeaderString(buffer);
     }
@@ -835,6 +881,11 @@ void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer)
             buffer.append(it->second.cookieString());
         }
     }
+}
+
+void HttpResponseImpl::renderHeadersToBuffer(trantor::MsgBuffer &buffer)
+{
+    renderHeaders(buffer);
 
     // output Date header
     if (!passThrough_ &&
@@ -848,10 +899,61 @@ void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer)
     {
         buffer.append("\r\n");
     }
+}
+
+void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer)
+{
+    if (expriedTime_ >= 0)
+    {
+        auto strPtr = renderToBuffer();
+        buffer.append(strPtr->peek(), strPtr->readableBytes());
+        return;
+    }
+
+    renderHeadersToBuffer(buffer);
     if (bodyPtr_ && contentLengthIsAllowed())
         buffer.append(bodyPtr_->data(), bodyPtr_->length());
 }
 
+void HttpResponseImpl::renderToBatch(
+    trantor::MsgBuffer &buffer,
+    const std::function<void(const char *, size_t)> &send)
+{
+    auto flush = [&buffer, &send]() {
+        if (buffer.readableBytes() > 0)
+        {
+            send(buffer.peek(), buffer.readableBytes());
+            buffer.retrieveAll();
+        }
+    };
+    if (expriedTime_ >= 0)
+    {
+        // The cached string already contains the body
+        auto strPtr = renderToBuffer();
+        if (strPtr->readableBytes() < largeBodySize)
+        {
+            buffer.append(strPtr->peek(), strPtr->readableBytes());
+        }
+        else
+        {
+            flush();
+            send(strPtr->peek(), strPtr->readableBytes());
+        }
+        return;
+    }
+
+    renderHeadersToBuffer(buffer);
+    if (!bodyPtr_ || !contentLengthIsAllowed())
+        return;
+    if (bodyPtr_->length() < largeBodySize)
+    {
+        buffer.append(bodyPtr_->data(), bodyPtr_->length());
+        return;
+    }
+    flush();
+    send(bodyPtr_->data(), bodyPtr_->length());
+}
+
 std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::renderToBuffer()
 {
     if (expriedTime_ >= 0)
@@ -889,24 +991,11 @@ std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::renderToBuffer()
                 return httpString_;
         }
     }
-    auto httpString = std::make_shared<trantor::MsgBuffer>(256);
-    if (!fullHeaderString_)
-    {
-        makeHeaderString(*httpString);
-    }
-    else
-    {
-        httpString->append(*fullHeaderString_);
-    }
-
-    // output cookies
-    if (!cookies_.empty())
-    {
-        for (auto it = cookies_.begin(); it != cookies_.end(); ++it)
-        {
-            httpString->append(it->second.cookieString());
-        }
-    }
+    // A frozen header block has a known size, allocate everything at once
+    auto httpString = std::make_shared<trantor::MsgBuffer>(
+        frozenHeaders_ ? frozenHeaders_->block.size() + getBodyLength() + 128
+                       : 256);
+    renderHeaders(*httpString);
 
     // output Date header
     if (!passThrough_ &&
@@ -939,23 +1028,7 @@ std::shared_ptr<trantor::MsgBuffer> HttpResponseImpl::
     renderHeaderForHeadMethod()
 {
     auto httpString = std::make_shared<trantor::MsgBuffer>(256);
-    if (!fullHeaderString_)
-    {
-        makeHeaderString(*httpString);
-    }
-    else
-    {
-        httpString->append(*fullHeaderString_);
-    }
-
-    // output cookies
-    if (!cookies_.empty())
-    {
-        for (auto it = cookies_.begin(); it != cookies_.end(); ++it)
-        {
-            httpString->append(it->second.cookieString());
-        }
-    }
+    renderHeaders(*httpString);
 
     // output Date header
     if (!passThrough_ &&
@@ -978,6 +1051,7 @@ void HttpResponseImpl::addHeader(const char *start,
                                  const char *colon,
                                  const char *end)
 {
+    thawHeaders();
     fullHeaderString_.reset();
     std::string field(start, colon);
     transform(field.begin(), field.end(), field.begin(), [](unsigned char c) {
@@ -1092,14 +1166,17 @@ void HttpResponseImpl::swap(HttpResponseImpl &that) noexcept
     swap(statusMessage_, that.statusMessage_);
     swap(closeConnection_, that.closeConnection_);
     bodyPtr_.swap(that.bodyPtr_);
+    spareBody_.swap(that.spareBody_);
     swap(contentType_, that.contentType_);
     swap(flagForParsingContentType_, that.flagForParsingContentType_);
     swap(flagForParsingJson_, that.flagForParsingJson_);
     swap(sendfileName_, that.sendfileName_);
     swap(streamCallback_, that.streamCallback_);
     swap(asyncStreamCallback_, that.asyncStreamCallback_);
+    streamEncoder_.swap(that.streamEncoder_);
     jsonPtr_.swap(that.jsonPtr_);
     fullHeaderString_.swap(that.fullHeaderString_);
+    frozenHeaders_.swap(that.frozenHeaders_);
     httpString_.swap(that.httpString_);
     swap(datePos_, that.datePos_);
     swap(jsonParsingErrorPtr_, that.jsonParsingErrorPtr_);
@@ -1111,6 +1188,7 @@ void HttpResponseImpl::clear()
     version_ = Version::kHttp11;
     statusMessage_ = std::string_view{};
     fullHeaderString_.reset();
+    frozenHeaders_.reset();
     jsonParsingErrorPtr_.reset();
     sendfileName_.clear();
     if (streamCallback_)
@@ -1124,6 +1202,7 @@ void HttpResponseImpl::clear()
         // asyncStreamCallback_(nullptr);
         asyncStreamCallback_ = {};
     }
+    streamEncoder_.reset();
     headers_.clear();
     cookies_.clear();
     bodyPtr_.reset();
@@ -1134,6 +1213,75 @@ void HttpResponseImpl::clear()
     flagForParsingJson_ = false;
 }
 
+void HttpResponseImpl::recycle()
+{
+    headers_.clear();
+    cookies_.clear();
+    customStatusCode_ = -1;
+    statusCode_ = kUnknown;
+    statusMessage_ = std::string_view{};
+    version_ = Version::kHttp11;
+    closeConnection_ = false;
+    // Keep a string body that nothing else refers to, unless it is large
+    if (bodyPtr_ && bodyPtr_.use_count() == 1 &&
+        bodyPtr_->bodyType() == HttpMessageBody::BodyType::kString)
+    {
+        auto body = std::static_pointer_cast<HttpMessageStringBody>(
+            std::move(bodyPtr_));
+        if (body->capacity() <= largeBodySize)
+        {
+            body->clear();
+            spareBody_ = std::move(body);
+        }
+    }
+    bodyPtr_.reset();
+    expriedTime_ = -1;
+    sendfileName_.clear();
+    sendfileRange_ = {0, 0};
+    streamCallback_ = nullptr;
+    asyncStreamCallback_ = nullptr;
+    streamEncoder_.reset();
+    asyncStreamDisableKickoff_ = false;
+    jsonPtr_.reset();
+    fullHeaderString_.reset();
+    frozenHeaders_.reset();
+    peerCertificate_.reset();
+    httpString_.reset();
+    datePos_ = std::string::npos;
+    httpStringDate_ = -1;
+    flagForParsingJson_ = false;
+    flagForSerializingJson_ = true;
+    contentType_ = CT_TEXT_PLAIN;
+    flagForParsingContentType_ = false;
+    jsonParsingErrorPtr_.reset();
+    contentTypeString_.assign("text/html; charset=utf-8");
+    passThrough_ = false;
+    allowCompression_ = true;
+    cacheCompressedBody_ = false;
+}
+
+HttpResponseImplPtr HttpResponseImpl::newPooledResponse()
+{
+    auto resp = ObjectPool<HttpResponseImpl>::acquire();
+    resp->creationDate_ = trantor::Date::now();
+    return resp;
+}
+
+HttpResponseImplPtr HttpResponseImpl::newPooledResponse(HttpStatusCode code,
+                                                        ContentType type)
+{
+    auto resp = ObjectPool<HttpResponseImpl>::acquire(code, type);
+    // Set the same fields as the constructor for a recycled response
+    resp->statusCode_ = code;
+    resp->statusMessage_ = statusCodeToString(code);
+    resp->creationDate_ = trantor::Date::now();
+    resp->contentType_ = type;
+    resp->flagForParsingContentType_ = true;
+    auto mime = contentTypeToMime(type);
+    resp->contentTypeString_.assign(mime.data(), mime.size());
+    return resp;
+}
+
 void HttpResponseImpl::parseJson() const
 {
     static std::once_flag once;
@@ -1190,9 +1338,61 @@ bool HttpResponseImpl::shouldBeCompressed() const
     return true;
 }
 
+bool HttpResponseImpl::streamShouldBeCompressed() const
+{
+    if (!allowCompression_ || !(streamCallback_ || asyncStreamCallback_) ||
+        !contentLengthIsAllowed() || passThrough_ ||
+        !getHeaderBy("content-encoding").empty() ||
+        !getHeaderBy("content-length").empty())
+    {
+        return false;
+    }
+    // Streams are often text/event-stream, which has no content type code
+    auto type = contentType();
+    return type < CT_APPLICATION_OCTET_STREAM ||
+           (type == CT_CUSTOM &&
+            contentTypeString_.compare(0, 5, "text/") == 0);
+}
+
+std::function<std::size_t(char *, std::size_t)>
+HttpResponseImpl::encodedStreamCallback() const
+{
+    if (streamEncoder_)
+    {
+        return compressStreamCallback(
+            streamCallback_,
+            streamEncoder_,
+            HttpAppFrameworkImpl::instance().streamCompressionFlushSize());
+    }
+    return streamCallback_;
+}
+
+ResponseStreamPtr HttpResponseImpl::newResponseStream(
+    trantor::AsyncStreamPtr asyncStream,
+    bool chunked,
+    std::shared_ptr<SendQueue> sendQueue) const
+{
+    // A body of known length is sent as is
+    if (chunked && !getHeaderBy("content-length").empty())
+    {
+        chunked = false;
+    }
+    if (streamEncoder_ || !chunked || sendQueue)
+    {
+        return std::make_unique<ResponseStream>(
+            std::move(asyncStream),
+            streamEncoder_,
+            HttpAppFrameworkImpl::instance().streamCompressionFlushSize(),
+            chunked,
+            std::move(sendQueue));
+    }
+    return std::make_unique<ResponseStream>(std::move(asyncStream));
+}
+
 void HttpResponseImpl::setContentTypeString(const char *typeString,
                                             size_t typeStringLength)
 {
+    thawHeaders();
     std::string sv(typeString, typeStringLength);
     auto contentType = parseContentType(sv);
     if (contentType == CT_NONE)
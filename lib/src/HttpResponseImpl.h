@@ -16,6 +16,7 @@
 
 #include "HttpUtils.h"
 #include "HttpMessageBody.h"
+#include "StreamEncoder.h"
 #include <drogon/exports.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/utils/Utilities.h>
@@ -33,6 +34,7 @@ namespace drogon
 class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 {
     friend class HttpResponseParser;
+    friend class Http2Connection;
 
   public:
     HttpResponseImpl() : creationDate_(trantor::Date::now())
@@ -51,9 +53,18 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void setPassThrough(bool flag) override
     {
+        if (flag != passThrough_)
+            thawHeaders();
         passThrough_ = flag;
     }
 
+    void freezeHeaders() override;
+
+    bool headersFrozen() const
+    {
+        return frozenHeaders_ != nullptr;
+    }
+
     HttpStatusCode statusCode() const override
     {
         return statusCode_;
@@ -66,12 +77,15 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void setStatusCode(HttpStatusCode code) override
     {
+        thawHeaders();
         statusCode_ = code;
         setStatusMessage(statusCodeToString(code));
     }
 
     void setVersion(const Version v) override
     {
+        if (v != version_ || (v == Version::kHttp10 && !closeConnection_))
+            thawHeaders();
         version_ = v;
         if (version_ == Version::kHttp10)
         {
@@ -88,6 +102,8 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void setCloseConnection(bool on) override
     {
+        if (on != closeConnection_)
+            thawHeaders();
         closeConnection_ = on;
     }
 
@@ -98,9 +114,10 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void setContentTypeCode(ContentType type) override
     {
+        thawHeaders();
         contentType_ = type;
         auto ct = contentTypeToMime(type);
-        contentTypeString_ = std::string(ct.data(), ct.size());
+        contentTypeString_.assign(ct.data(), ct.size());
         flagForParsingContentType_ = true;
     }
 
@@ -135,14 +152,15 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     const SafeStringMap<std::string> &headers() const override
     {
-        return headers_;
+        return frozenHeaders_ ? frozenHeaders_->headers : headers_;
     }
 
     const std::string &getHeaderBy(const std::string &lowerKey) const
     {
         static const std::string defaultVal;
-        auto iter = headers_.find(lowerKey);
-        if (iter == headers_.end())
+        auto &headers = this->headers();
+        auto iter = headers.find(lowerKey);
+        if (iter == headers.end())
         {
             return defaultVal;
         }
@@ -151,12 +169,14 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void removeHeaderBy(const std::string &lowerKey)
     {
+        thawHeaders();
         fullHeaderString_.reset();
         headers_.erase(lowerKey);
     }
 
     void addHeader(std::string field, const std::string &value) override
     {
+        thawHeaders();
         fullHeaderString_.reset();
         transform(field.begin(),
                   field.end(),
@@ -167,6 +187,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void addHeader(std::string field, std::string &&value) override
     {
+        thawHeaders();
         fullHeaderString_.reset();
         transform(field.begin(),
                   field.end(),
@@ -215,7 +236,16 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void setBody(const std::string &body) override
     {
-        bodyPtr_ = std::make_shared<HttpMessageStringBody>(body);
+        // Copies of a recycled response share the spare body
+        if (spareBody_.use_count() == 1)
+        {
+            spareBody_->assign(body.data(), body.length());
+            bodyPtr_ = std::move(spareBody_);
+        }
+        else
+        {
+            bodyPtr_ = std::make_shared<HttpMessageStringBody>(body);
+        }
         if (passThrough_)
         {
             addHeader("content-length", std::to_string(bodyPtr_->length()));
@@ -224,7 +254,17 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void setBody(std::string &&body) override
     {
-        bodyPtr_ = std::make_shared<HttpMessageStringBody>(std::move(body));
+        // Copies of a recycled response share the spare body
+        if (spareBody_.use_count() == 1)
+        {
+            spareBody_->assign(std::move(body));
+            bodyPtr_ = std::move(spareBody_);
+        }
+        else
+        {
+            bodyPtr_ =
+                std::make_shared<HttpMessageStringBody>(std::move(body));
+        }
         if (passThrough_)
         {
             addHeader("content-length", std::to_string(bodyPtr_->length()));
@@ -233,13 +273,42 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void redirect(const std::string &url)
     {
+        thawHeaders();
         headers_["location"] = url;
     }
 
     std::shared_ptr<trantor::MsgBuffer> renderToBuffer();
     void renderToBuffer(trantor::MsgBuffer &buffer);
+
+    /**
+     * @brief Render the response as a part of a batch of pipelined responses.
+     * Small responses are appended to the buffer. A body of at least
+     * largeBodySize bytes is not copied: the buffered data is passed to send
+     * first and then the body itself.
+     */
+    void renderToBatch(trantor::MsgBuffer &buffer,
+                       const std::function<void(const char *, size_t)> &send);
+    static constexpr size_t largeBodySize = 16 * 1024;
     std::shared_ptr<trantor::MsgBuffer> renderHeaderForHeadMethod();
     void clear() override;
+    void initFromTemplate();
+
+    /**
+     * @brief Take a response from the object pool of the current IO thread,
+     * see ObjectPool. Other threads get a new response.
+     */
+    static std::shared_ptr<HttpResponseImpl> newPooledResponse();
+    static std::shared_ptr<HttpResponseImpl> newPooledResponse(
+        HttpStatusCode code,
+        ContentType type);
+
+    /**
+     * @brief Reset the response to the state of a default constructed one
+     * when it returns to its pool. The header and cookie maps, the content
+     * type string and a small string body keep their memory.
+     * @note Any new member must be reset here too.
+     */
+    void recycle();
 
     void setExpiredTime(ssize_t expiredTime) override
     {
@@ -356,6 +425,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     void setStreamCallback(
         const std::function<std::size_t(char *, std::size_t)> &callback)
     {
+        thawHeaders();
         streamCallback_ = callback;
     }
 
@@ -369,6 +439,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
         const std::function<void(ResponseStreamPtr)> &callback,
         bool disableKickoffTimeout)
     {
+        thawHeaders();
         asyncStreamCallback_ = callback;
         asyncStreamDisableKickoff_ = disableKickoffTimeout;
     }
@@ -378,8 +449,37 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
         return asyncStreamDisableKickoff_;
     }
 
+    // The compressor of the stream, set when the content-encoding of a stream
+    // response is chosen
+    const StreamEncoderPtr &streamEncoder() const
+    {
+        return streamEncoder_;
+    }
+
+    void setStreamEncoder(StreamEncoderPtr encoder)
+    {
+        streamEncoder_ = std::move(encoder);
+    }
+
+    bool streamShouldBeCompressed() const;
+
+    /// The stream callback, wrapped by the compressor if there is one
+    std::function<std::size_t(char *, std::size_t)> encodedStreamCallback()
+        const;
+
+    /// The stream given to the async stream callback, the data is sent in
+    /// chunks unless the transport frames it (HTTP/2). The send queue of the
+    /// connection enables the limits of the stream.
+    ResponseStreamPtr newResponseStream(
+        trantor::AsyncStreamPtr asyncStream,
+        bool chunked = true,
+        std::shared_ptr<SendQueue> sendQueue = nullptr) const;
+
     void makeHeaderString()
     {
+        // A frozen response already has its header block
+        if (frozenHeaders_)
+            return;
         fullHeaderString_ = std::make_shared<trantor::MsgBuffer>(128);
         makeHeaderString(*fullHeaderString_);
     }
@@ -428,8 +528,43 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 #endif
     ~HttpResponseImpl() override = default;
 
+    void setCacheCompressedBody(bool flag) override
+    {
+        cacheCompressedBody_ = flag;
+    }
+
+    bool cacheCompressedBody() const override
+    {
+        return cacheCompressedBody_;
+    }
+
+    // Share a body, e.g. a variant held by the compression cache
+    void setSharedBody(std::shared_ptr<HttpMessageBody> body)
+    {
+        bodyPtr_ = std::move(body);
+        if (passThrough_)
+        {
+            addHeader("content-length", std::to_string(bodyPtr_->length()));
+        }
+    }
+
   protected:
-    void makeHeaderString(trantor::MsgBuffer &headerString);
+    void makeHeaderString(trantor::MsgBuffer &headerString,
+                          bool withContentLength = true);
+    void appendContentLength(trantor::MsgBuffer &buffer) const;
+    void renderHeaders(trantor::MsgBuffer &buffer);
+    void renderHeadersToBuffer(trantor::MsgBuffer &buffer);
+
+    // Give a frozen response its own copy of the headers before they (or
+    // anything else rendered into the frozen block) are modified.
+    void thawHeaders()
+    {
+        if (frozenHeaders_)
+        {
+            headers_ = frozenHeaders_->headers;
+            frozenHeaders_.reset();
+        }
+    }
 
     void parseContentTypeAndString() const
     {
@@ -464,6 +599,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
   private:
     bool allowCompression_{true};
+    bool cacheCompressedBody_{false};
 
     void setAllowCompression(bool allow) override;
 
@@ -482,6 +618,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
                                            const char *typeString,
                                            size_t typeStringLength) override
     {
+        thawHeaders();
         contentType_ = type;
         flagForParsingContentType_ = true;
 
@@ -506,6 +643,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
                              size_t messageLength) override
     {
         assert(code >= 0);
+        thawHeaders();
         customStatusCode_ = code;
         statusMessage_ = std::string_view{message, messageLength};
     }
@@ -521,16 +659,31 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
     Version version_{Version::kHttp11};
     bool closeConnection_{false};
     mutable std::shared_ptr<HttpMessageBody> bodyPtr_;
+    // The body of the previous use of a recycled response, reused by
+    // setBody()
+    std::shared_ptr<HttpMessageStringBody> spareBody_;
     ssize_t expriedTime_{-1};
     std::string sendfileName_;
     SendfileRange sendfileRange_{0, 0};
     std::function<std::size_t(char *, std::size_t)> streamCallback_;
     std::function<void(ResponseStreamPtr)> asyncStreamCallback_;
+    StreamEncoderPtr streamEncoder_;
     bool asyncStreamDisableKickoff_{false};
 
     mutable std::shared_ptr<Json::Value> jsonPtr_;
 
     std::shared_ptr<trantor::MsgBuffer> fullHeaderString_;
+
+    // The status line and headers of a frozen response, shared by all the
+    // responses created from the same template. headers_ is empty while the
+    // response is frozen.
+    struct FrozenHeaders
+    {
+        std::string block;
+        SafeStringMap<std::string> headers;
+    };
+
+    std::shared_ptr<const FrozenHeaders> frozenHeaders_;
     trantor::CertificatePtr peerCertificate_;
     mutable std::shared_ptr<trantor::MsgBuffer> httpString_;
     mutable size_t datePos_{static_cast<size_t>(-1)};
@@ -545,8 +698,7 @@ class DROGON_EXPORT HttpResponseImpl : public HttpResponse
 
     void setContentType(const std::string_view &contentType)
     {
-        contentTypeString_ =
-            std::string(contentType.data(), contentType.size());
+        contentTypeString_.assign(contentType.data(), contentType.size());
     }
 
     void setStatusMessage(const std::string_view &message)
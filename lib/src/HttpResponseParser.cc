@@ -30,6 +30,8 @@ void HttpResponseParser::reset()
     parseResponseForHeadMethod_ = false;
     leftBodyLength_ = 0;
     currentChunkLength_ = 0;
+    headersCallback_ = nullptr;
+    bodyCallback_ = nullptr;
 }
 
 HttpResponseParser::HttpResponseParser(const trantor::TcpConnectionPtr &connPtr)
@@ -75,6 +77,20 @@ bool HttpResponseParser::processResponseLine(const char *begin, const char *end)
     return false;
 }
 
+bool HttpResponseParser::appendBody(const char *data, size_t length)
+{
+    if (bodyCallback_)
+    {
+        return length == 0 || bodyCallback_(data, length);
+    }
+    if (!responsePtr_->bodyPtr_)
+    {
+        responsePtr_->bodyPtr_ = std::make_shared<HttpMessageStringBody>();
+    }
+    responsePtr_->bodyPtr_->append(data, length);
+    return true;
+}
+
 bool HttpResponseParser::parseResponseOnClose()
 {
     if (status_ == HttpResponseParseStatus::kExpectClose)
@@ -189,6 +205,10 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
                         status_ = HttpResponseParseStatus::kGotAll;
                         hasMore = false;
                     }
+                    if (headersCallback_)
+                    {
+                        headersCallback_();
+                    }
                 }
                 buf->retrieveUntil(crlf + 2);
             }
@@ -209,25 +229,23 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
                 }
                 break;
             }
-            if (!responsePtr_->bodyPtr_)
-            {
-                responsePtr_->bodyPtr_ =
-                    std::make_shared<HttpMessageStringBody>();
-            }
             if (leftBodyLength_ >= buf->readableBytes())
             {
                 leftBodyLength_ -= buf->readableBytes();
 
-                responsePtr_->bodyPtr_->append(buf->peek(),
-                                               buf->readableBytes());
+                ok = appendBody(buf->peek(), buf->readableBytes());
                 buf->retrieveAll();
             }
             else
             {
-                responsePtr_->bodyPtr_->append(buf->peek(), leftBodyLength_);
+                ok = appendBody(buf->peek(), leftBodyLength_);
                 buf->retrieve(leftBodyLength_);
                 leftBodyLength_ = 0;
             }
+            if (!ok)
+            {
+                return false;
+            }
             if (leftBodyLength_ == 0)
             {
                 status_ = HttpResponseParseStatus::kGotAll;
@@ -239,12 +257,7 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
         }
         else if (status_ == HttpResponseParseStatus::kExpectClose)
         {
-            if (!responsePtr_->bodyPtr_)
-            {
-                responsePtr_->bodyPtr_ =
-                    std::make_shared<HttpMessageStringBody>();
-            }
-            responsePtr_->bodyPtr_->append(buf->peek(), buf->readableBytes());
+            ok = appendBody(buf->peek(), buf->readableBytes());
             buf->retrieveAll();
             break;
         }
@@ -283,19 +296,32 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
         {
             // LOG_TRACE<<"expect chunk
             // len="<<currentChunkLength_;
+            if (bodyCallback_ && currentChunkLength_ > 0 &&
+                buf->readableBytes() > 0)
+            {
+                // Streamed as it arrives, currentChunkLength_ is what is left
+                // of the chunk
+                auto length =
+                    (std::min)(currentChunkLength_, buf->readableBytes());
+                ok = appendBody(buf->peek(), length);
+                buf->retrieve(length);
+                if (!ok)
+                {
+                    return false;
+                }
+                currentChunkLength_ -= length;
+            }
             if (buf->readableBytes() >= (currentChunkLength_ + 2))
             {
                 if (*(buf->peek() + currentChunkLength_) == '\r' &&
                     *(buf->peek() + currentChunkLength_ + 1) == '\n')
                 {
-                    if (!responsePtr_->bodyPtr_)
+                    ok = appendBody(buf->peek(), currentChunkLength_);
+                    buf->retrieve(currentChunkLength_ + 2);
+                    if (!ok)
                     {
-                        responsePtr_->bodyPtr_ =
-                            std::make_shared<HttpMessageStringBody>();
+                        return false;
                     }
-                    responsePtr_->bodyPtr_->append(buf->peek(),
-                                                   currentChunkLength_);
-                    buf->retrieve(currentChunkLength_ + 2);
                     currentChunkLength_ = 0;
                     status_ = HttpResponseParseStatus::kExpectChunkLen;
                 }
@@ -319,10 +345,14 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
             {
                 buf->retrieveUntil(crlf + 2);
                 status_ = HttpResponseParseStatus::kGotAll;
-                responsePtr_->addHeader("content-length",
-                                        std::to_string(
-                                            responsePtr_->getBody().length()));
-                responsePtr_->removeHeaderBy("transfer-encoding");
+                // A streamed response keeps the headers it was received with
+                if (!bodyCallback_)
+                {
+                    responsePtr_->addHeader(
+                        "content-length",
+                        std::to_string(responsePtr_->getBody().length()));
+                    responsePtr_->removeHeaderBy("transfer-encoding");
+                }
                 break;
             }
             else
@@ -18,6 +18,7 @@
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/TcpConnection.h>
 #include <trantor/utils/MsgBuffer.h>
+#include <functional>
 #include <list>
 #include <mutex>
 
@@ -56,6 +57,31 @@ class HttpResponseParser : public trantor::NonCopyable
         parseResponseForHeadMethod_ = true;
     }
 
+    /**
+     * @brief Stream the body of the response being parsed: headersCallback
+     * is called once the headers are parsed, then bodyCallback with each
+     * piece of the body as it arrives instead of storing it in the response,
+     * large chunks are not buffered until they are complete. The transfer
+     * is a parsing error if bodyCallback returns false. Cleared by reset().
+     */
+    void setStreamCallbacks(std::function<void()> headersCallback,
+                            std::function<bool(const char *, size_t)>
+                                bodyCallback)
+    {
+        headersCallback_ = std::move(headersCallback);
+        bodyCallback_ = std::move(bodyCallback);
+    }
+
+    bool streaming() const
+    {
+        return static_cast<bool>(bodyCallback_);
+    }
+
+    bool atResponseStart() const
+    {
+        return status_ == HttpResponseParseStatus::kExpectResponseLine;
+    }
+
     void reset();
 
     const HttpResponseImplPtr &responseImpl() const
@@ -65,6 +91,7 @@ class HttpResponseParser : public trantor::NonCopyable
 
   private:
     bool processResponseLine(const char *begin, const char *end);
+    bool appendBody(const char *data, size_t length);
 
     HttpResponseParseStatus status_;
     HttpResponseImplPtr responsePtr_;
@@ -72,6 +99,8 @@ class HttpResponseParser : public trantor::NonCopyable
     size_t leftBodyLength_{0};
     size_t currentChunkLength_{0};
     std::weak_ptr<trantor::TcpConnection> conn_;
+    std::function<void()> headersCallback_;
+    std::function<bool(const char *, size_t)> bodyCallback_;
 };
 
 }  // namespace drogon
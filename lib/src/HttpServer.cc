@@ -16,18 +16,25 @@
 #include <drogon/HttpResponse.h>
 #include <drogon/utils/Utilities.h>
 #include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <utility>
 #include "AOPAdvice.h"
+#include "CompressionCache.h"
 #include "MiddlewaresFunction.h"
 #include "HttpAppFrameworkImpl.h"
+#include "Http2Connection.h"
 #include "HttpConnectionLimit.h"
 #include "HttpControllerBinder.h"
 #include "HttpRequestImpl.h"
 #include "HttpRequestParser.h"
 #include "HttpResponseImpl.h"
 #include "HttpControllersRouter.h"
+#include "LoopMetrics.h"
+#include "RequestMetrics.h"
+#include "SendQueue.h"
 #include "StaticFileRouter.h"
 #include "WebSocketConnectionImpl.h"
 #include "impl_forwards.h"
@@ -62,6 +69,11 @@ static void handleInvalidHttpMethod(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback);
 
+static void negotiateWebSocketCompression(
+    const HttpRequestImplPtr &req,
+    const HttpResponsePtr &resp,
+    const WebSocketConnectionImplPtr &wsConnPtr);
+
 static void handleHttpOptions(
     const HttpRequestImplPtr &req,
     const std::string &allowMethods,
@@ -116,6 +128,8 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
         auto parser = std::make_shared<HttpRequestParser>(conn);
         parser->reset();
         conn->setContext(parser);
+        if (LoopMetrics::instance().enabled())
+            LoopMetrics::instance().onConnection(true);
         if (!HttpConnectionLimit::instance().tryAddConnection(conn))
         {
             LOG_ERROR << "too much connections!force close!";
@@ -125,6 +139,13 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
         if (!AopAdvice::instance().passNewConnectionAdvices(conn))
         {
             conn->forceClose();
+            return;
+        }
+        // HTTP/2 negotiated by ALPN
+        if (conn->isSSLConnection() && conn->applicationProtocol() == "h2" &&
+            HttpAppFrameworkImpl::instance().isHttp2Enabled())
+        {
+            startHttp2(conn, parser);
         }
     }
     else if (conn->disconnected())
@@ -138,7 +159,13 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
             // `releaseConnection()` for conn with context.
             // Never call `conn->clearContext()` in other places
             HttpConnectionLimit::instance().releaseConnection(conn);
-            if (requestParser->webSocketConn())
+            if (LoopMetrics::instance().enabled())
+                LoopMetrics::instance().onConnection(false);
+            if (requestParser->http2Connection())
+            {
+                requestParser->http2Connection()->onClose();
+            }
+            else if (requestParser->webSocketConn())
             {
                 requestParser->webSocketConn()->onClose();
             }
@@ -162,12 +189,33 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
     auto requestParser = conn->getContext<HttpRequestParser>();
     if (!requestParser)
         return;
+    LoopMetrics::BusyScope busyScope;
+    if (auto &http2Conn = requestParser->http2Connection())
+    {
+        http2Conn->onMessage(buf);
+        return;
+    }
     if (requestParser->webSocketConn())
     {
         // Websocket payload
         requestParser->webSocketConn()->onNewMessage(conn, buf);
         return;
     }
+    if (requestParser->atConnectionStart() &&
+        HttpAppFrameworkImpl::instance().isHttp2Enabled())
+    {
+        // HTTP/2 with prior knowledge (h2c) starts with the client preface
+        auto &preface = Http2Connection::clientPreface;
+        auto len = (std::min)(buf->readableBytes(), preface.size());
+        if (memcmp(buf->peek(), preface.data(), len) == 0)
+        {
+            if (len < preface.size())
+                return;
+            startHttp2(conn, requestParser);
+            requestParser->http2Connection()->onMessage(buf);
+            return;
+        }
+    }
 
     auto &requests = requestParser->getRequestBuffer();
     // With the pipelining feature or web socket, it is possible to receive
@@ -244,6 +292,7 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
     if (!requests.empty())
     {
         onRequests(conn, requests, requestParser);
+        busyScope.describe(requests);
         requests.clear();
     }
 }
@@ -302,6 +351,7 @@ void HttpServer::onRequests(
                         AopAdvice::instance().passPreSendingAdvices(req, resp);
                         if (resp->statusCode() == k101SwitchingProtocols)
                         {
+                            negotiateWebSocketCompression(req, resp, wsConn);
                             requestParser->setWebsockConnection(wsConn);
                         }
                         auto httpString =
@@ -409,6 +459,108 @@ void HttpServer::onRequests(
     }
 }
 
+void HttpServer::startHttp2(
+    const TcpConnectionPtr &conn,
+    const std::shared_ptr<HttpRequestParser> &requestParser)
+{
+    auto http2Conn = std::make_shared<Http2Connection>(conn->getLoop());
+    std::weak_ptr<TcpConnection> weakConn = conn;
+    std::weak_ptr<Http2Connection> weakHttp2Conn = http2Conn;
+    http2Conn->setSendCallback([weakConn](const char *data, size_t len) {
+        if (auto conn = weakConn.lock())
+            conn->send(data, len);
+    });
+    http2Conn->setCloseCallback([weakConn]() {
+        if (auto conn = weakConn.lock())
+            conn->shutdown();
+    });
+    http2Conn->setRequestCallback(
+        [weakConn, weakHttp2Conn](const HttpRequestImplPtr &req,
+                                  uint32_t streamId) {
+            auto conn = weakConn.lock();
+            auto http2Conn = weakHttp2Conn.lock();
+            if (conn && http2Conn)
+                onHttp2Request(conn, http2Conn, req, streamId);
+        });
+    // Response bodies read on demand wait for the socket to drain
+    SendQueue::reserveWriteCompleteCallback(conn);
+    conn->setWriteCompleteCallback([weakHttp2Conn](const TcpConnectionPtr &) {
+        if (auto http2Conn = weakHttp2Conn.lock())
+            http2Conn->onWriteComplete();
+    });
+    requestParser->setHttp2Connection(http2Conn);
+    http2Conn->start();
+}
+
+void HttpServer::onHttp2Request(const TcpConnectionPtr &conn,
+                                const Http2ConnectionPtr &http2Conn,
+                                const HttpRequestImplPtr &req,
+                                uint32_t streamId)
+{
+    req->setPeerAddr(conn->peerAddr());
+    req->setLocalAddr(conn->localAddr());
+    req->setSecure(conn->isSSLConnection());
+    req->setPeerCertificate(conn->peerCertificate());
+    req->setConnectionPtr(conn);
+    req->startProcessing();
+    bool isHeadMethod = (req->method() == Head);
+    if (isHeadMethod)
+    {
+        req->setMethod(Get);
+    }
+    // Streams are independent, responses are sent as soon as they are ready
+    auto callback = [weakHttp2Conn = std::weak_ptr<Http2Connection>(http2Conn),
+                     req,
+                     streamId,
+                     isHeadMethod](const HttpResponsePtr &response) {
+        auto http2Conn = weakHttp2Conn.lock();
+        auto &metrics = RequestMetrics::instance();
+        if (!response || !http2Conn)
+        {
+            if (response && metrics.enabled())
+                metrics.onResponseDropped(*req);
+            return;
+        }
+        if (metrics.enabled())
+            metrics.onResponse(*req);
+        auto resp =
+            HttpAppFrameworkImpl::instance().handleSessionForResponse(req,
+                                                                      response);
+        AopAdvice::instance().passPreSendingAdvices(req, resp);
+        auto newResp = getCompressedResponse(req, resp, isHeadMethod);
+        if (metrics.enabled())
+            metrics.onResponseQueued(*req, *newResp);
+        auto loop = http2Conn->getLoop();
+        if (loop->isInLoopThread())
+        {
+            http2Conn->sendResponse(streamId, newResp, isHeadMethod);
+        }
+        else
+        {
+            loop->queueInLoop([http2Conn = std::move(http2Conn),
+                               streamId,
+                               newResp = std::move(newResp),
+                               isHeadMethod]() {
+                http2Conn->sendResponse(streamId, newResp, isHeadMethod);
+            });
+        }
+    };
+    if (auto resp = AopAdvice::instance().passSyncAdvices(req))
+    {
+        // Rejected by sync advice
+        http2Conn->sendResponse(streamId,
+                                getCompressedResponse(req, resp, isHeadMethod),
+                                isHeadMethod);
+        return;
+    }
+    if (auto errResp = tryDecompressRequest(req))
+    {
+        callback(errResp);
+        return;
+    }
+    onHttpRequest(req, std::move(callback));
+}
+
 void HttpServer::onHttpRequest(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
@@ -417,6 +569,9 @@ void HttpServer::onHttpRequest(
               << req->localAddr().toIpPort();
     LOG_TRACE << "Headers " << req->methodString() << " " << req->path();
     LOG_TRACE << "http path=" << req->path();
+    auto &metrics = RequestMetrics::instance();
+    if (metrics.enabled())
+        metrics.onRouting(*req);
     if (req->method() == Options && (req->path() == "*" || req->path() == "/*"))
     {
         auto resp = HttpResponse::newHttpResponse();
@@ -642,6 +797,9 @@ void HttpServer::httpRequestHandling(
     std::shared_ptr<ControllerBinderBase> &&binderPtr,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    auto &metrics = RequestMetrics::instance();
+    if (metrics.enabled())
+        metrics.onHandling(*req);
     // Check cached response
     auto &cachedResp = *(binderPtr->responseCache_);
     if (cachedResp)
@@ -783,8 +941,16 @@ void HttpServer::handleResponse(
 
     if (!response)
         return;
+    auto &metrics = RequestMetrics::instance();
     if (!conn->connected())
+    {
+        if (metrics.enabled() &&
+            !paramPack->responseSent_.exchange(true, std::memory_order_acq_rel))
+        {
+            metrics.onResponseDropped(*req);
+        }
         return;
+    }
 
     if (paramPack->responseSent_.exchange(true, std::memory_order_acq_rel))
     {
@@ -793,6 +959,8 @@ void HttpServer::handleResponse(
         return;
     }
 
+    if (metrics.enabled())
+        metrics.onResponse(*req);
     auto resp =
         HttpAppFrameworkImpl::instance().handleSessionForResponse(req,
                                                                   response);
@@ -801,6 +969,8 @@ void HttpServer::handleResponse(
     AopAdvice::instance().passPreSendingAdvices(req, resp);
 
     auto newResp = getCompressedResponse(req, resp, isHeadMethod);
+    if (metrics.enabled())
+        metrics.onResponseQueued(*req, *newResp);
     if (conn->getLoop()->isInLoopThread())
     {
         /*
@@ -970,6 +1140,17 @@ static std::size_t chunkingCallback(
     //    return nHeaderLen + nDataSize + 2;
 }
 
+static ResponseStreamPtr newResponseStream(const TcpConnectionPtr &conn,
+                                           HttpResponseImpl *respImplPtr)
+{
+    auto sendQueue = std::make_shared<SendQueue>(conn);
+    sendQueue->watchWrites();
+    return respImplPtr->newResponseStream(
+        conn->sendAsyncStream(respImplPtr->asyncStreamKickoffDisabled()),
+        true,
+        std::move(sendQueue));
+}
+
 void HttpServer::sendResponse(const TcpConnectionPtr &conn,
                               const HttpResponsePtr &response,
                               bool isHeadMethod)
@@ -978,8 +1159,24 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
     auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
     if (!isHeadMethod)
     {
-        auto httpString = respImplPtr->renderToBuffer();
-        conn->send(httpString);
+        if (respImplPtr->expiredTime() < 0 &&
+            respImplPtr->getBodyLength() >= HttpResponseImpl::largeBodySize)
+        {
+            // Send large bodies (e.g. cached static files) from where they
+            // are instead of copying them behind the headers
+            trantor::MsgBuffer buffer;
+            respImplPtr->renderToBatch(buffer,
+                                       [&conn](const char *data, size_t len) {
+                                           conn->send(data, len);
+                                       });
+            if (buffer.readableBytes() > 0)
+                conn->send(buffer);
+        }
+        else
+        {
+            auto httpString = respImplPtr->renderToBuffer();
+            conn->send(httpString);
+        }
         if (!respImplPtr->contentLengthIsAllowed())
             return;
         auto &asyncStreamCallback = respImplPtr->asyncStreamCallback();
@@ -987,9 +1184,7 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
         {
             if (respImplPtr->version() != Version::kHttp10)
             {
-                asyncStreamCallback(
-                    std::make_unique<ResponseStream>(conn->sendAsyncStream(
-                        respImplPtr->asyncStreamKickoffDisabled())));
+                asyncStreamCallback(newResponseStream(conn, respImplPtr));
             }
             else
             {
@@ -1013,12 +1208,13 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
                 {
                     conn->sendStream(
                         [ctx = std::make_shared<ChunkingParams>(
-                             streamCallback)](char *buffer, size_t len) {
+                             respImplPtr->encodedStreamCallback())](
+                            char *buffer, size_t len) {
                             return chunkingCallback(ctx, buffer, len);
                         });
                 }
                 else
-                    conn->sendStream(streamCallback);
+                    conn->sendStream(respImplPtr->encodedStreamCallback());
             }
             else
             {
@@ -1055,13 +1251,17 @@ void HttpServer::sendResponses(
         sendResponse(conn, responses[0].first, responses[0].second);
         return;
     }
+    // Large bodies are sent from where they are instead of being copied into
+    // the buffer
+    std::function<void(const char *, size_t)> send =
+        [&conn](const char *data, size_t len) { conn->send(data, len); };
     for (auto const &resp : responses)
     {
         auto respImplPtr = static_cast<HttpResponseImpl *>(resp.first.get());
         if (!resp.second)
         {
             // Not HEAD method
-            respImplPtr->renderToBuffer(buffer);
+            respImplPtr->renderToBatch(buffer, send);
             if (!respImplPtr->contentLengthIsAllowed())
                 continue;
             auto &asyncStreamCallback = respImplPtr->asyncStreamCallback();
@@ -1071,9 +1271,7 @@ void HttpServer::sendResponses(
                 buffer.retrieveAll();
                 if (respImplPtr->version() != Version::kHttp10)
                 {
-                    asyncStreamCallback(
-                        std::make_unique<ResponseStream>(conn->sendAsyncStream(
-                            respImplPtr->asyncStreamKickoffDisabled())));
+                    asyncStreamCallback(newResponseStream(conn, respImplPtr));
                 }
                 else
                 {
@@ -1099,12 +1297,14 @@ void HttpServer::sendResponses(
                     {
                         conn->sendStream(
                             [ctx = std::make_shared<ChunkingParams>(
-                                 streamCallback)](char *buffer, size_t len) {
+                                 respImplPtr->encodedStreamCallback())](
+                                char *buffer, size_t len) {
                                 return chunkingCallback(ctx, buffer, len);
                             });
                     }
                     else
-                        conn->sendStream(streamCallback);
+                        conn->sendStream(
+                            respImplPtr->encodedStreamCallback());
                 }
                 else
                 {
@@ -1146,17 +1346,18 @@ static inline bool isWebSocket(const HttpRequestImplPtr &req)
     if (req->method() != Get)
         return false;
 
-    auto &headers = req->headers();
-    if (headers.find("upgrade") == headers.end() ||
-        headers.find("connection") == headers.end())
+    // Use the views to avoid building the header map for every GET request
+    auto upgradeView = req->getHeaderViewBy("upgrade");
+    auto connectionView = req->getHeaderViewBy("connection");
+    if (upgradeView.empty() || connectionView.empty())
         return false;
 
-    auto connectionField = req->getHeaderBy("connection");
+    std::string connectionField(connectionView);
     std::transform(connectionField.begin(),
                    connectionField.end(),
                    connectionField.begin(),
                    [](unsigned char c) { return tolower(c); });
-    auto upgradeField = req->getHeaderBy("upgrade");
+    std::string upgradeField(upgradeView);
     std::transform(upgradeField.begin(),
                    upgradeField.end(),
                    upgradeField.begin(),
@@ -1238,69 +1439,155 @@ static inline bool passSyncAdvices(
     return true;
 }
 
-static inline HttpResponsePtr getCompressedResponse(
-    const HttpRequestImplPtr &req,
+static inline HttpResponsePtr setCompressedBody(
     const HttpResponsePtr &response,
-    bool isHeadMethod)
+    std::shared_ptr<HttpMessageBody> body,
+    const char *encoding)
 {
-    if (isHeadMethod ||
-        !static_cast<HttpResponseImpl *>(response.get())->shouldBeCompressed())
+    auto newResp = response;
+    if (response->expiredTime() >= 0)
     {
+        // cached response,we need to make a clone
+        newResp = std::make_shared<HttpResponseImpl>(
+            *static_cast<HttpResponseImpl *>(response.get()));
+        newResp->setExpiredTime(-1);
+    }
+    static_cast<HttpResponseImpl *>(newResp.get())
+        ->setSharedBody(std::move(body));
+    newResp->addHeader("Content-Encoding", encoding);
+    return newResp;
+}
+
+static inline std::string compressBody(const std::string_view &body,
+                                       StreamEncoder::Encoding encoding)
+{
+    switch (encoding)
+    {
+        case StreamEncoder::kBrotli:
+            return drogon::utils::brotliCompress(body.data(), body.length());
+        case StreamEncoder::kZstd:
+            return drogon::utils::zstdCompress(body.data(), body.length());
+        default:
+            return drogon::utils::gzipCompress(body.data(), body.length());
+    }
+}
+
+static inline HttpResponsePtr compressResponse(
+    const HttpResponsePtr &response,
+    StreamEncoder::Encoding encoding)
+{
+    const char *name = StreamEncoder::encodingName(encoding);
+    auto &cache = CompressionCache::instance();
+    if (response->cacheCompressedBody() && cache.enabled())
+    {
+        auto body = cache.find(encoding, response->getBody());
+        if (!body)
+        {
+            // Being compressed in the background, send it as is meanwhile
+            return response;
+        }
+        return setCompressedBody(response, std::move(body), name);
+    }
+    auto strCompress = compressBody(response->getBody(), encoding);
+    if (strCompress.empty())
+    {
+        LOG_ERROR << name << " got 0 length result";
         return response;
     }
+    return setCompressedBody(
+        response,
+        std::make_shared<HttpMessageStringBody>(std::move(strCompress)),
+        name);
+}
+
+/**
+ * @brief Choose the encoding of the response among the ones accepted by the
+ * client, brotli is preferred over zstd and zstd over gzip.
+ *
+ * @return false if the client accepts none of the enabled encodings.
+ */
+static inline bool chooseEncoding(const HttpRequestImplPtr &req,
+                                  StreamEncoder::Encoding &encoding)
+{
+    auto acceptEncoding = req->getHeaderViewBy("accept-encoding");
 #ifdef USE_BROTLI
     if (app().isBrotliEnabled() &&
-        req->getHeaderBy("accept-encoding").find("br") != std::string::npos)
+        acceptEncoding.find("br") != std::string_view::npos)
     {
-        auto newResp = response;
-        auto strCompress =
-            drogon::utils::brotliCompress(response->getBody().data(),
-                                          response->getBody().length());
-        if (!strCompress.empty())
-        {
-            if (response->expiredTime() >= 0)
-            {
-                // cached response,we need to make a clone
-                newResp = std::make_shared<HttpResponseImpl>(
-                    *static_cast<HttpResponseImpl *>(response.get()));
-                newResp->setExpiredTime(-1);
-            }
-            newResp->setBody(std::move(strCompress));
-            newResp->addHeader("Content-Encoding", "br");
-        }
-        else
-        {
-            LOG_ERROR << "brotli got 0 length result";
-        }
-        return newResp;
+        encoding = StreamEncoder::kBrotli;
+        return true;
+    }
+#endif
+#ifdef USE_ZSTD
+    if (app().isZstdEnabled() &&
+        acceptEncoding.find("zstd") != std::string_view::npos)
+    {
+        encoding = StreamEncoder::kZstd;
+        return true;
     }
 #endif
     if (app().isGzipEnabled() &&
-        req->getHeaderBy("accept-encoding").find("gzip") != std::string::npos)
+        acceptEncoding.find("gzip") != std::string_view::npos)
+    {
+        encoding = StreamEncoder::kGzip;
+        return true;
+    }
+    return false;
+}
+
+static inline HttpResponsePtr getCompressedResponse(
+    const HttpRequestImplPtr &req,
+    const HttpResponsePtr &response,
+    bool isHeadMethod)
+{
+    if (isHeadMethod)
+    {
+        return response;
+    }
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+    StreamEncoder::Encoding encoding;
+    if (respImplPtr->streamCallback() || respImplPtr->asyncStreamCallback())
     {
-        auto newResp = response;
-        auto strCompress =
-            drogon::utils::gzipCompress(response->getBody().data(),
-                                        response->getBody().length());
-        if (!strCompress.empty())
+        // Stream responses are sent once, the compressor is attached to the
+        // response and wraps the stream when it is sent
+        if (HttpAppFrameworkImpl::instance().isStreamCompressionEnabled() &&
+            respImplPtr->streamShouldBeCompressed() &&
+            chooseEncoding(req, encoding))
         {
-            if (response->expiredTime() >= 0)
+            if (auto encoder = StreamEncoder::newEncoder(encoding))
             {
-                // cached response,we need to make a clone
-                newResp = std::make_shared<HttpResponseImpl>(
-                    *static_cast<HttpResponseImpl *>(response.get()));
-                newResp->setExpiredTime(-1);
+                respImplPtr->setStreamEncoder(std::move(encoder));
+                response->addHeader("Content-Encoding",
+                                    StreamEncoder::encodingName(encoding));
             }
-            newResp->setBody(std::move(strCompress));
-            newResp->addHeader("Content-Encoding", "gzip");
         }
-        else
-        {
-            LOG_ERROR << "gzip got 0 length result";
-        }
-        return newResp;
+        return response;
+    }
+    if (!respImplPtr->shouldBeCompressed() || !chooseEncoding(req, encoding))
+    {
+        return response;
+    }
+    return compressResponse(response, encoding);
+}
+
+static void negotiateWebSocketCompression(
+    const HttpRequestImplPtr &req,
+    const HttpResponsePtr &resp,
+    const WebSocketConnectionImplPtr &wsConnPtr)
+{
+    auto &options = HttpAppFrameworkImpl::instance().webSocketCompression();
+    if (!options)
+        return;
+    auto &offers = req->getHeaderBy("sec-websocket-extensions");
+    if (offers.empty())
+        return;
+    WebSocketDeflateParams params;
+    std::string extension;
+    if (acceptDeflateOffer(offers, *options, params, extension))
+    {
+        resp->addHeader("Sec-WebSocket-Extensions", extension);
+        wsConnPtr->enableCompression(*options, params);
     }
-    return response;
 }
 
 static void handleInvalidHttpMethod(
@@ -85,6 +85,14 @@ class HttpServer : trantor::NonCopyable
                            const std::vector<HttpRequestImplPtr> &,
                            const std::shared_ptr<HttpRequestParser> &);
 
+    // HTTP/2 connections
+    static void startHttp2(const trantor::TcpConnectionPtr &,
+                           const std::shared_ptr<HttpRequestParser> &);
+    static void onHttp2Request(const trantor::TcpConnectionPtr &conn,
+                               const Http2ConnectionPtr &http2Conn,
+                               const HttpRequestImplPtr &req,
+                               uint32_t streamId);
+
     struct HttpRequestParamPack
     {
         std::shared_ptr<ControllerBinderBase> binderPtr;
@@ -148,6 +148,8 @@ void ListenerManager::createListeners(
                 auto policy =
                     trantor::TLSPolicy::defaultServerPolicy(cert, key);
                 policy->setConfCmds(cmds).setUseOldTLS(listener.useOldTLS_);
+                if (HttpAppFrameworkImpl::instance().isHttp2Enabled())
+                    policy->setAlpnProtocols({"h2", "http/1.1"});
                 serverPtr->enableSSL(std::move(policy));
             }
             servers_.push_back(serverPtr);
@@ -187,6 +189,8 @@ void ListenerManager::createListeners(
                 auto policy =
                     trantor::TLSPolicy::defaultServerPolicy(cert, key);
                 policy->setConfCmds(cmds).setUseOldTLS(listener.useOldTLS_);
+                if (HttpAppFrameworkImpl::instance().isHttp2Enabled())
+                    policy->setAlpnProtocols({"h2", "http/1.1"});
                 serverPtr->enableSSL(std::move(policy));
             }
             serverPtr->setIoLoops(ioLoops);
@@ -0,0 +1,258 @@
+/**
+ *
+ *  @file LoopMetrics.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "LoopMetrics.h"
+#include "HttpRequestImpl.h"
+#include <drogon/HttpAppFramework.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+
+using namespace drogon;
+using namespace drogon::monitoring;
+
+struct LoopMetrics::LoopState
+{
+    trantor::EventLoop *loop{nullptr};
+    std::string name;
+    // Owned by the collectors
+    Histogram *lag{nullptr};
+    Gauge *queueDelay{nullptr};
+    Gauge *busyRatio{nullptr};
+    Gauge *connections{nullptr};
+    Counter *slowCallbacks{nullptr};
+    // Written by the sampling thread
+    std::atomic<bool> probePending{false};
+    std::atomic<int64_t> probeTime{0};
+    // Only used in the loop
+    trantor::TimerId timerId{trantor::InvalidTimerId};
+    int64_t lastTick{0};
+    int64_t busy{0};
+};
+
+thread_local LoopMetrics::LoopState *LoopMetrics::currentLoop_{nullptr};
+
+// In seconds
+static const std::vector<double> lagBuckets{
+    0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1};
+
+static int64_t now()
+{
+    return trantor::Date::now().microSecondsSinceEpoch();
+}
+
+std::vector<std::shared_ptr<CollectorBase>> LoopMetrics::enable(
+    const Options &options)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!lag_)
+    {
+        options_ = options;
+        slowThreshold_ =
+            static_cast<int64_t>(options.slowCallbackThreshold * 1000000);
+        std::vector<std::string> labels{"loop"};
+        lag_ = std::make_shared<Collector<Histogram>>(
+            "drogon_event_loop_lag_seconds",
+            "The lateness of the timers of the event loops",
+            labels);
+        queueDelay_ = std::make_shared<Collector<Gauge>>(
+            "drogon_event_loop_queue_delay_seconds",
+            "The time the tasks queued to the event loops wait",
+            labels);
+        busyRatio_ = std::make_shared<Collector<Gauge>>(
+            "drogon_event_loop_busy_ratio",
+            "The share of time the event loops spend processing the data "
+            "received by the server",
+            labels);
+        connections_ = std::make_shared<Collector<Gauge>>(
+            "drogon_event_loop_connections",
+            "The number of connections of the server in the event loops",
+            labels);
+        slowCallbacks_ = std::make_shared<Collector<Counter>>(
+            "drogon_event_loop_slow_callbacks_total",
+            "The number of callbacks longer than the threshold",
+            labels);
+        samplerThread_ =
+            std::make_unique<trantor::EventLoopThread>("LoopMetrics");
+        samplerThread_->run();
+        samplerThread_->getLoop()->runEvery(options_.interval,
+                                            [this]() { sample(); });
+        enabled_.store(true, std::memory_order_release);
+        for (auto &loop : loops_)
+            start(loop.second);
+    }
+    return {lag_, queueDelay_, busyRatio_, connections_, slowCallbacks_};
+}
+
+void LoopMetrics::watch(trantor::EventLoop *loop, const std::string &prefix)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loops_.find(loop) != loops_.end())
+        return;
+    auto state = std::make_shared<LoopState>();
+    state->loop = loop;
+    state->name = prefix + std::to_string(prefixCounts_[prefix]++);
+    loops_[loop] = state;
+    if (enabled_)
+        start(state);
+}
+
+void LoopMetrics::unwatch(trantor::EventLoop *loop)
+{
+    std::shared_ptr<LoopState> state;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = loops_.find(loop);
+        if (iter == loops_.end())
+            return;
+        state = std::move(iter->second);
+        loops_.erase(iter);
+    }
+    if (!enabled_)
+        return;
+    loop->runInLoop([state]() {
+        if (state->timerId != trantor::InvalidTimerId)
+            state->loop->invalidateTimer(state->timerId);
+        if (currentLoop_ == state.get())
+            currentLoop_ = nullptr;
+    });
+}
+
+void LoopMetrics::start(const std::shared_ptr<LoopState> &state)
+{
+    std::vector<std::string> labels{state->name};
+    state->lag = lag_->metric(labels,
+                              lagBuckets,
+                              std::chrono::seconds(0),
+                              0,
+                              app().getLoop())
+                     .get();
+    state->queueDelay = queueDelay_->metric(labels).get();
+    state->busyRatio = busyRatio_->metric(labels).get();
+    state->connections = connections_->metric(labels).get();
+    state->slowCallbacks = slowCallbacks_->metric(labels).get();
+    auto interval = options_.interval;
+    state->loop->runInLoop([state, interval]() {
+        currentLoop_ = state.get();
+        state->lastTick = now();
+        std::weak_ptr<LoopState> weakState = state;
+        state->timerId =
+            state->loop->runEvery(interval, [weakState, interval]() {
+                if (auto state = weakState.lock())
+                    tick(*state, interval);
+            });
+    });
+}
+
+void LoopMetrics::tick(LoopState &state, double interval)
+{
+    auto time = now();
+    auto elapsed = time - state.lastTick;
+    auto lag = elapsed - static_cast<int64_t>(interval * 1000000);
+    state.lag->observe((std::max)(lag, int64_t(0)) / 1000000.0);
+    if (elapsed > 0)
+    {
+        state.busyRatio->set(
+            (std::min)(static_cast<double>(state.busy) / elapsed, 1.0));
+    }
+    state.busy = 0;
+    state.lastTick = time;
+}
+
+void LoopMetrics::sample()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto time = now();
+    for (auto &loop : loops_)
+    {
+        auto &state = loop.second;
+        if (state->probePending.exchange(true, std::memory_order_acq_rel))
+        {
+            // The previous probe is still waiting
+            auto waited = time - state->probeTime.load();
+            state->queueDelay->set(waited / 1000000.0);
+            continue;
+        }
+        state->probeTime.store(time);
+        std::weak_ptr<LoopState> weakState = state;
+        state->loop->queueInLoop([weakState, time]() {
+            auto state = weakState.lock();
+            if (!state)
+                return;
+            state->queueDelay->set((now() - time) / 1000000.0);
+            state->probePending.store(false, std::memory_order_release);
+        });
+    }
+}
+
+void LoopMetrics::onConnection(bool connected)
+{
+    if (!currentLoop_)
+        return;
+    if (connected)
+        currentLoop_->connections->increment();
+    else
+        currentLoop_->connections->decrement();
+}
+
+LoopMetrics::BusyScope::BusyScope()
+{
+    if (!LoopMetrics::instance().enabled())
+        return;
+    state_ = currentLoop_;
+    if (state_)
+        start_ = now();
+}
+
+void LoopMetrics::BusyScope::describe(
+    const std::vector<HttpRequestImplPtr> &requests)
+{
+    auto threshold = LoopMetrics::instance().slowThreshold_;
+    if (!state_ || threshold == 0 || now() - start_ < threshold)
+        return;
+    for (auto &req : requests)
+    {
+        if (!description_.empty())
+            description_.append(", ");
+        description_.append(req->methodString()).append(" ");
+        if (req->matchedPathPatternLength() > 0)
+        {
+            description_
+                .append(req->matchedPathPatternData(),
+                        req->matchedPathPatternLength())
+                .append(" (")
+                .append(req->path())
+                .append(")");
+        }
+        else
+        {
+            description_.append(req->path());
+        }
+    }
+}
+
+LoopMetrics::BusyScope::~BusyScope()
+{
+    if (!state_)
+        return;
+    auto elapsed = now() - start_;
+    state_->busy += elapsed;
+    auto threshold = LoopMetrics::instance().slowThreshold_;
+    if (threshold > 0 && elapsed >= threshold)
+    {
+        state_->slowCallbacks->increment();
+        LOG_WARN << "Slow callback in the event loop " << state_->name << ": "
+                 << elapsed / 1000.0 << " ms"
+                 << (description_.empty() ? "" : " processing ")
+                 << description_;
+    }
+}
@@ -0,0 +1,139 @@
+/**
+ *
+ *  @file LoopMetrics.h
+ *  The health metrics of the event loops for the PromExporter plugin
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <drogon/utils/monitoring/Gauge.h>
+#include <drogon/utils/monitoring/Histogram.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Samples the event loops of the application (the IO loops, the main
+ * loop and the loops of the database and redis clients) when enabled by the
+ * PromExporter plugin.
+ *
+ * Every interval, each loop measures the lateness of a timer (the lag) and
+ * the share of the interval spent by the server processing the data received
+ * on its connections (the busy ratio). A task is also queued to each loop
+ * from a sampling thread, the time it waits measures the backlog of the
+ * queue of the loop. The loops don't expose the length of their queues or
+ * the time they spend waiting for events, so the delay and the busy ratio
+ * stand for them.
+ */
+class LoopMetrics : public trantor::NonCopyable
+{
+    struct LoopState;
+
+  public:
+    struct Options
+    {
+        // In seconds
+        double interval{0.1};
+        // The processing of the received data longer than this is logged with
+        // the routes of the requests, in seconds. 0 to disable.
+        double slowCallbackThreshold{0};
+    };
+
+    static LoopMetrics &instance()
+    {
+        // Never destroyed, the clients unwatch their loops when they are
+        // destroyed, which may be after the static objects
+        static LoopMetrics *inst = new LoopMetrics;
+        return *inst;
+    }
+
+    /**
+     * @brief Start sampling, returns the collectors of the metrics to
+     * register. Called before the server starts, the later calls return the
+     * same collectors.
+     */
+    std::vector<std::shared_ptr<monitoring::CollectorBase>> enable(
+        const Options &options);
+
+    bool enabled() const
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Add a loop to sample, its label is the prefix followed by the
+     * number of the loops added with the same prefix before.
+     */
+    void watch(trantor::EventLoop *loop, const std::string &prefix);
+
+    /// Stop sampling a loop, before it is destroyed
+    void unwatch(trantor::EventLoop *loop);
+
+    /// Called in the loop of a connection when it is opened or closed
+    void onConnection(bool connected);
+
+    /**
+     * @brief Measures the processing of the data received in the current
+     * loop, from its construction to its destruction.
+     */
+    class BusyScope : public trantor::NonCopyable
+    {
+      public:
+        BusyScope();
+        ~BusyScope();
+
+        /// Name the requests processed in the slow callback log
+        void describe(const std::vector<HttpRequestImplPtr> &requests);
+
+      private:
+        LoopState *state_{nullptr};
+        int64_t start_{0};
+        std::string description_;
+    };
+
+  private:
+    friend class BusyScope;
+
+    LoopMetrics() = default;
+    void start(const std::shared_ptr<LoopState> &state);
+    static void tick(LoopState &state, double interval);
+    void sample();
+
+    // The state of the loop of the current thread, when sampled
+    static thread_local LoopState *currentLoop_;
+
+    std::atomic<bool> enabled_{false};
+    Options options_;
+    int64_t slowThreshold_{0};
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>> lag_;
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>> queueDelay_;
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>> busyRatio_;
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>> connections_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>>
+        slowCallbacks_;
+    // Queues the probes to the loops
+    std::unique_ptr<trantor::EventLoopThread> samplerThread_;
+    std::mutex mutex_;
+    std::map<trantor::EventLoop *, std::shared_ptr<LoopState>> loops_;
+    std::map<std::string, size_t> prefixCounts_;
+};
+}  // namespace drogon
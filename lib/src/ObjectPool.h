@@ -0,0 +1,249 @@
+/**
+ *
+ *  @file ObjectPool.h
+ *  Per event loop pools of recycled objects
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+namespace internal
+{
+inline std::atomic<bool> objectPoolsEnabled{true};
+
+/// Turn the object pools off to compare with plain allocations, only meant
+/// for benchmarks and tests.
+inline void setObjectPoolsEnabled(bool enabled)
+{
+    objectPoolsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Allocates the control blocks of the pooled shared pointers from a
+ * per thread free list, so taking an object from a pool allocates nothing.
+ * All the blocks of a type have the same size, a block released in another
+ * thread joins the free list of that thread. Blocks released at the exit of
+ * a thread, after its free list was destroyed, are freed.
+ */
+template <typename T>
+class BlockAllocator
+{
+  public:
+    using value_type = T;
+
+    BlockAllocator() = default;
+
+    template <typename U>
+    BlockAllocator(const BlockAllocator<U> &) noexcept
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        auto blocks = freeBlocks();
+        if (n == 1 && blocks && !blocks->empty())
+        {
+            auto p = blocks->back();
+            blocks->pop_back();
+            return static_cast<T *>(p);
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) noexcept
+    {
+        auto blocks = freeBlocks();
+        if (n == 1 && blocks && blocks->size() < maxFreeBlocks)
+        {
+            // The capacity was reserved, this never allocates
+            blocks->push_back(p);
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const BlockAllocator<U> &) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const BlockAllocator<U> &) const noexcept
+    {
+        return false;
+    }
+
+  private:
+    static constexpr size_t maxFreeBlocks = 256;
+
+    struct FreeBlocks : public std::vector<void *>
+    {
+        explicit FreeBlocks(bool &destroyed) : destroyed_(destroyed)
+        {
+            reserve(maxFreeBlocks);
+        }
+
+        ~FreeBlocks()
+        {
+            destroyed_ = true;
+            for (auto p : *this)
+                ::operator delete(p);
+        }
+
+        bool &destroyed_;
+    };
+
+    /// The free list of the current thread, nullptr once it was destroyed at
+    /// the exit of the thread. The shared pointers held by the thread_local
+    /// objects destroyed after it use plain allocations.
+    static FreeBlocks *freeBlocks()
+    {
+        // Trivially destructible, so it can still be read after the free
+        // list is gone
+        thread_local bool destroyed{false};
+        if (destroyed)
+            return nullptr;
+        thread_local FreeBlocks blocks(destroyed);
+        return &blocks;
+    }
+};
+}  // namespace internal
+
+/**
+ * @brief A pool of reusable objects owned by an event loop.
+ *
+ * Every thread running an event loop has its own pool of each type, objects
+ * are taken from the pool of the current thread and go back to it when the
+ * last shared pointer is released, in the loop of the pool whichever thread
+ * releases them. T::recycle() puts a returned object back in a reusable
+ * state, it keeps the buffers worth keeping and resets everything else.
+ */
+template <typename T>
+class ObjectPool : public trantor::NonCopyable,
+                   public std::enable_shared_from_this<ObjectPool<T>>
+{
+  public:
+    static constexpr size_t defaultCapacity = 256;
+
+    ObjectPool(trantor::EventLoop *loop, size_t capacity)
+        : loop_(loop), capacity_(capacity)
+    {
+        objects_.reserve(capacity_);
+    }
+
+    ~ObjectPool()
+    {
+        for (auto p : objects_)
+            delete p;
+    }
+
+    /// The pool of the current thread, nullptr if it runs no event loop
+    static const std::shared_ptr<ObjectPool> &threadPool()
+    {
+        thread_local std::shared_ptr<ObjectPool> pool = []() {
+            auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+            return loop ? std::make_shared<ObjectPool>(loop, defaultCapacity)
+                        : nullptr;
+        }();
+        return pool;
+    }
+
+    /**
+     * @brief Take an object from the pool of the current thread. The
+     * arguments are only used to construct a new object when the pool is
+     * empty, a recycled object is in the state T::recycle() left it in.
+     * Threads without an event loop get plain allocations.
+     */
+    template <typename... Args>
+    static std::shared_ptr<T> acquire(Args &&...args)
+    {
+        auto &pool = threadPool();
+        if (!pool ||
+            !internal::objectPoolsEnabled.load(std::memory_order_relaxed))
+        {
+            return std::make_shared<T>(std::forward<Args>(args)...);
+        }
+        T *p;
+        if (pool->objects_.empty())
+        {
+            p = new T(std::forward<Args>(args)...);
+        }
+        else
+        {
+            p = pool->objects_.back();
+            pool->objects_.pop_back();
+        }
+        return std::shared_ptr<T>(p,
+                                  Deleter{pool->weak_from_this()},
+                                  internal::BlockAllocator<T>());
+    }
+
+    size_t size() const
+    {
+        return objects_.size();
+    }
+
+  private:
+    struct Deleter
+    {
+        std::weak_ptr<ObjectPool> weakPool;
+
+        void operator()(T *p) const
+        {
+            auto pool = weakPool.lock();
+            if (!pool)
+            {
+                delete p;
+                return;
+            }
+            auto loop = pool->loop_;
+            if (loop->isInLoopThread())
+            {
+                pool->recycle(p);
+            }
+            else
+            {
+                loop->queueInLoop(
+                    [pool = std::move(pool), p]() { pool->recycle(p); });
+            }
+        }
+    };
+
+    void recycle(T *p)
+    {
+        assert(loop_->isInLoopThread());
+        if (objects_.size() >= capacity_ ||
+            !internal::objectPoolsEnabled.load(std::memory_order_relaxed))
+        {
+            delete p;
+            return;
+        }
+        p->recycle();
+        objects_.push_back(p);
+    }
+
+    trantor::EventLoop *loop_;
+    size_t capacity_;
+    std::vector<T *> objects_;
+};
+}  // namespace drogon
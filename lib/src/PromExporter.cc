@@ -4,6 +4,8 @@
 #include <drogon/utils/monitoring/Gauge.h>
 #include <drogon/utils/monitoring/Histogram.h>
 #include <drogon/utils/monitoring/Collector.h>
+#include "LoopMetrics.h"
+#include "RequestMetrics.h"
 
 using namespace drogon;
 using namespace drogon::monitoring;
@@ -108,6 +110,62 @@ void PromExporter::initAndStart(const Json::Value &config)
             LOG_ERROR << "collectors must be an array!";
         }
     }
+    auto &requestMetrics = config["request_metrics"];
+    if (requestMetrics.isObject() &&
+        requestMetrics.get("enabled", false).asBool())
+    {
+        RequestMetrics::Options options;
+        options.maxRoutes =
+            requestMetrics.get("max_routes", Json::UInt64(options.maxRoutes))
+                .asUInt64();
+        auto buckets = [](const Json::Value &value,
+                          std::vector<double> &boundaries) {
+            if (value.isNull())
+                return;
+            if (!value.isArray() || value.empty())
+            {
+                LOG_ERROR << "buckets must be a non-empty array!";
+                return;
+            }
+            std::vector<double> values;
+            for (auto const &boundary : value)
+            {
+                if (!values.empty() && boundary.asDouble() <= values.back())
+                {
+                    LOG_ERROR << "buckets must be sorted!";
+                    return;
+                }
+                values.push_back(boundary.asDouble());
+            }
+            boundaries = std::move(values);
+        };
+        buckets(requestMetrics["latency_buckets"], options.latencyBuckets);
+        buckets(requestMetrics["size_buckets"], options.sizeBuckets);
+        for (auto const &collector : RequestMetrics::instance().enable(options))
+        {
+            registerCollector(collector);
+        }
+    }
+    auto &loopMetrics = config["loop_metrics"];
+    if (loopMetrics.isObject() && loopMetrics.get("enabled", false).asBool())
+    {
+        LoopMetrics::Options options;
+        options.interval =
+            loopMetrics.get("interval", options.interval).asDouble();
+        if (options.interval <= 0)
+        {
+            LOG_ERROR << "interval must be positive!";
+            options.interval = LoopMetrics::Options().interval;
+        }
+        options.slowCallbackThreshold =
+            loopMetrics
+                .get("slow_callback_threshold", options.slowCallbackThreshold)
+                .asDouble();
+        for (auto const &collector : LoopMetrics::instance().enable(options))
+        {
+            registerCollector(collector);
+        }
+    }
 }
 
 static std::string exportCollector(
@@ -0,0 +1,238 @@
+/**
+ *
+ *  @file RequestMetrics.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RequestMetrics.h"
+#include <drogon/HttpAppFramework.h>
+#include <unordered_map>
+
+using namespace drogon;
+using namespace drogon::monitoring;
+
+namespace
+{
+const std::string unmatchedRoute{"<unmatched>"};
+const std::string otherRoute{"<other>"};
+const std::vector<std::string> statusClasses{
+    "unknown", "1xx", "2xx", "3xx", "4xx", "5xx"};
+const std::vector<std::string> phaseNames{"queue",
+                                          "middleware",
+                                          "handler",
+                                          "send"};
+
+struct CacheKey
+{
+    const char *pattern;
+    HttpMethod method;
+
+    bool operator==(const CacheKey &other) const
+    {
+        return pattern == other.pattern && method == other.method;
+    }
+};
+
+struct CacheKeyHash
+{
+    size_t operator()(const CacheKey &key) const
+    {
+        return std::hash<const void *>()(key.pattern) * 31 + key.method;
+    }
+};
+}  // namespace
+
+std::vector<std::shared_ptr<CollectorBase>> RequestMetrics::enable(
+    const Options &options)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!requests_)
+    {
+        options_ = options;
+        requests_ = std::make_shared<Collector<Counter>>(
+            "drogon_http_requests_total",
+            "The number of HTTP requests answered",
+            std::vector<std::string>{"method", "route", "status"});
+        inFlight_ = std::make_shared<Collector<Gauge>>(
+            "drogon_http_requests_in_flight",
+            "The number of HTTP requests being processed",
+            std::vector<std::string>{});
+        inFlightGauge_ = inFlight_->metric({}).get();
+        duration_ = std::make_shared<Collector<Histogram>>(
+            "drogon_http_request_duration_seconds",
+            "The time from the parsing of the HTTP requests to their "
+            "responses",
+            std::vector<std::string>{"method", "route"});
+        phases_ = std::make_shared<Collector<Histogram>>(
+            "drogon_http_request_phase_seconds",
+            "The time spent by the HTTP requests in each phase",
+            std::vector<std::string>{"method", "route", "phase"});
+        requestSize_ = std::make_shared<Collector<Histogram>>(
+            "drogon_http_request_size_bytes",
+            "The size of the bodies of the HTTP requests",
+            std::vector<std::string>{"method", "route"});
+        responseSize_ = std::make_shared<Collector<Histogram>>(
+            "drogon_http_response_size_bytes",
+            "The size of the bodies of the HTTP responses",
+            std::vector<std::string>{"method", "route"});
+        enabled_.store(true, std::memory_order_release);
+    }
+    return {requests_,
+            inFlight_,
+            duration_,
+            phases_,
+            requestSize_,
+            responseSize_};
+}
+
+void RequestMetrics::onRouting(HttpRequestImpl &req)
+{
+    req.processingTimes().routing = now();
+    inFlightGauge_->increment();
+}
+
+void RequestMetrics::onResponseQueued(HttpRequestImpl &req,
+                                      const HttpResponse &resp)
+{
+    auto &times = req.processingTimes();
+    if (times.routing == 0)
+        return;
+    auto queued = now();
+    if (times.responded == 0)
+        times.responded = queued;
+    inFlightGauge_->decrement();
+
+    auto &metrics =
+        routeMetrics(req.method(),
+                     std::string_view(req.matchedPathPatternData(),
+                                      req.matchedPathPatternLength()));
+    auto code = static_cast<size_t>(resp.statusCode());
+    auto statusClass = code >= 100 && code < 600 ? code / 100 : 0;
+    requestCounter(metrics, statusClass).increment();
+
+    auto received = req.creationDate().microSecondsSinceEpoch();
+    metrics.duration->observe((queued - received) / 1000000.0);
+    metrics.phases[kQueue]->observe((times.routing - received) / 1000000.0);
+    if (times.handling != 0)
+    {
+        metrics.phases[kMiddleware]->observe(
+            (times.handling - times.routing) / 1000000.0);
+        metrics.phases[kHandler]->observe(
+            (times.responded - times.handling) / 1000000.0);
+    }
+    else
+    {
+        // Answered by an advice, a middleware or the router
+        metrics.phases[kMiddleware]->observe(
+            (times.responded - times.routing) / 1000000.0);
+    }
+    metrics.phases[kSend]->observe((queued - times.responded) / 1000000.0);
+
+    metrics.requestSize->observe(static_cast<double>(req.bodyLength()));
+    auto responseSize = resp.body().length();
+    if (!resp.sendfileName().empty())
+        responseSize = resp.sendfileRange().second;
+    metrics.responseSize->observe(static_cast<double>(responseSize));
+    times = HttpRequestImpl::ProcessingTimes();
+}
+
+void RequestMetrics::onResponseDropped(HttpRequestImpl &req)
+{
+    auto &times = req.processingTimes();
+    if (times.routing == 0)
+        return;
+    inFlightGauge_->decrement();
+    times = HttpRequestImpl::ProcessingTimes();
+}
+
+RequestMetrics::RouteMetrics &RequestMetrics::routeMetrics(
+    HttpMethod method,
+    std::string_view pattern)
+{
+    // The patterns are stored by the routers for the life of the
+    // application, their addresses identify the routes. The route is compared
+    // in case an address is reused by another pattern.
+    thread_local std::unordered_map<CacheKey, RouteMetrics *, CacheKeyHash>
+        cache;
+    CacheKey key{pattern.empty() ? nullptr : pattern.data(), method};
+    auto iter = cache.find(key);
+    if (iter != cache.end() &&
+        (pattern.empty() || iter->second->route == pattern ||
+         iter->second->route == otherRoute))
+    {
+        return *iter->second;
+    }
+    auto &metrics = findOrCreateRouteMetrics(
+        method, pattern.empty() ? unmatchedRoute : std::string(pattern));
+    cache[key] = &metrics;
+    return metrics;
+}
+
+RequestMetrics::RouteMetrics &RequestMetrics::findOrCreateRouteMetrics(
+    HttpMethod method,
+    std::string route)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = routes_.find({method, route});
+    if (iter != routes_.end())
+        return *iter->second;
+    if (routes_.size() >= options_.maxRoutes)
+    {
+        route = otherRoute;
+        iter = routes_.find({method, route});
+        if (iter != routes_.end())
+            return *iter->second;
+    }
+
+    auto metrics = std::make_unique<RouteMetrics>();
+    metrics->method = method;
+    metrics->route = route;
+    std::string methodName{to_string_view(method)};
+    auto loop = app().getLoop();
+    auto histogram =
+        [loop](Collector<Histogram> &collector,
+               const std::vector<std::string> &labels,
+               const std::vector<double> &buckets) {
+            return collector
+                .metric(labels, buckets, std::chrono::seconds(0), 0, loop)
+                .get();
+        };
+    metrics->duration =
+        histogram(*duration_, {methodName, route}, options_.latencyBuckets);
+    for (size_t i = 0; i < kPhaseCount; ++i)
+    {
+        metrics->phases[i] = histogram(*phases_,
+                                       {methodName, route, phaseNames[i]},
+                                       options_.latencyBuckets);
+    }
+    metrics->requestSize =
+        histogram(*requestSize_, {methodName, route}, options_.sizeBuckets);
+    metrics->responseSize =
+        histogram(*responseSize_, {methodName, route}, options_.sizeBuckets);
+    auto &result = *metrics;
+    routes_[{method, route}] = std::move(metrics);
+    return result;
+}
+
+Counter &RequestMetrics::requestCounter(RouteMetrics &metrics,
+                                        size_t statusClass)
+{
+    auto counter =
+        metrics.requests[statusClass].load(std::memory_order_acquire);
+    if (counter)
+        return *counter;
+    counter = requests_
+                  ->metric({std::string(to_string_view(metrics.method)),
+                            metrics.route,
+                            statusClasses[statusClass]})
+                  .get();
+    metrics.requests[statusClass].store(counter, std::memory_order_release);
+    return *counter;
+}
@@ -0,0 +1,162 @@
+/**
+ *
+ *  @file RequestMetrics.h
+ *  The request metrics recorded by the server for the PromExporter plugin
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "HttpRequestImpl.h"
+#include <drogon/HttpResponse.h>
+#include <drogon/utils/monitoring/Collector.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <drogon/utils/monitoring/Gauge.h>
+#include <drogon/utils/monitoring/Histogram.h>
+#include <trantor/utils/NonCopyable.h>
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Records the count, the sizes and the latencies of the requests by
+ * route pattern and method when enabled by the PromExporter plugin.
+ *
+ * The server calls the hooks in this order: onRouting() when the request
+ * starts being processed, onHandling() when the handler is called,
+ * onResponse() when the handler responds and onResponseQueued() when the
+ * response is ready to be written. The latency is split in phases:
+ * - queue: from the parsing of the request to the start of its processing
+ * - middleware: the advices, the routing and the middlewares
+ * - handler: the handler and the post-handling advices, until it responds
+ * - send: the sessions, the pre-sending advices and the compression
+ * The requests rejected before routing (by the synchronous advices or when
+ * the body can't be decompressed) are not recorded.
+ *
+ * The label sets are bounded: the routes are the registered path patterns,
+ * "<unmatched>" for the requests not routed to a controller, and "<other>"
+ * for the routes beyond maxRoutes. The status codes are counted by class.
+ * The response sizes are those of the bodies in memory and of the file
+ * ranges, the streams and the whole files are counted as empty.
+ */
+class RequestMetrics : public trantor::NonCopyable
+{
+  public:
+    struct Options
+    {
+        size_t maxRoutes{500};
+        // In seconds
+        std::vector<double> latencyBuckets{
+            0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1,
+            0.25,   0.5,   1,      2.5,   5,    10};
+        // In bytes
+        std::vector<double> sizeBuckets{
+            64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304};
+    };
+
+    static RequestMetrics &instance()
+    {
+        static RequestMetrics inst;
+        return inst;
+    }
+
+    /**
+     * @brief Start recording, returns the collectors of the metrics to
+     * register. Called before the server starts, the later calls return
+     * the same collectors.
+     */
+    std::vector<std::shared_ptr<monitoring::CollectorBase>> enable(
+        const Options &options);
+
+    bool enabled() const
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    void onRouting(HttpRequestImpl &req);
+
+    void onHandling(HttpRequestImpl &req)
+    {
+        req.processingTimes().handling = now();
+    }
+
+    void onResponse(HttpRequestImpl &req)
+    {
+        auto &times = req.processingTimes();
+        if (times.responded == 0)
+            times.responded = now();
+    }
+
+    void onResponseQueued(HttpRequestImpl &req, const HttpResponse &resp);
+
+    /// The connection closed before the response could be sent
+    void onResponseDropped(HttpRequestImpl &req);
+
+  private:
+    enum Phase
+    {
+        kQueue = 0,
+        kMiddleware,
+        kHandler,
+        kSend,
+        kPhaseCount
+    };
+
+    // The metrics are owned by their collectors, which never remove them
+    struct RouteMetrics
+    {
+        HttpMethod method;
+        std::string route;
+        // By status class, 0 for the invalid status codes. Created when the
+        // first response of the class is sent.
+        std::array<std::atomic<monitoring::Counter *>, 6> requests{};
+        monitoring::Histogram *duration{nullptr};
+        std::array<monitoring::Histogram *, kPhaseCount> phases{};
+        monitoring::Histogram *requestSize{nullptr};
+        monitoring::Histogram *responseSize{nullptr};
+    };
+
+    static int64_t now()
+    {
+        return trantor::Date::now().microSecondsSinceEpoch();
+    }
+
+    RouteMetrics &routeMetrics(HttpMethod method, std::string_view pattern);
+    RouteMetrics &findOrCreateRouteMetrics(HttpMethod method,
+                                           std::string route);
+    monitoring::Counter &requestCounter(RouteMetrics &metrics,
+                                        size_t statusClass);
+
+    std::atomic<bool> enabled_{false};
+    Options options_;
+    std::shared_ptr<monitoring::Collector<monitoring::Counter>> requests_;
+    std::shared_ptr<monitoring::Collector<monitoring::Gauge>> inFlight_;
+    monitoring::Gauge *inFlightGauge_{nullptr};
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>> duration_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>> phases_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>>
+        requestSize_;
+    std::shared_ptr<monitoring::Collector<monitoring::Histogram>>
+        responseSize_;
+    // The metrics of the routes, never removed. The hooks look them up in a
+    // cache of their thread first.
+    std::mutex mutex_;
+    std::map<std::pair<HttpMethod, std::string>, std::unique_ptr<RouteMetrics>>
+        routes_;
+};
+}  // namespace drogon
@@ -0,0 +1,223 @@
+/**
+ *
+ *  @file ResponseStream.cc
+ *  The chunked body of async stream responses
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/HttpResponse.h>
+#include "SendQueue.h"
+#include "StreamEncoder.h"
+#include <sstream>
+
+using namespace drogon;
+
+ResponseStream::ResponseStream(trantor::AsyncStreamPtr asyncStream)
+    : asyncStream_(std::move(asyncStream))
+{
+}
+
+ResponseStream::ResponseStream(trantor::AsyncStreamPtr asyncStream,
+                               std::shared_ptr<StreamEncoder> encoder,
+                               size_t flushSize,
+                               bool chunked,
+                               std::shared_ptr<SendQueue> sendQueue)
+    : asyncStream_(std::move(asyncStream)),
+      encoder_(std::move(encoder)),
+      flushSize_(flushSize),
+      chunked_(chunked),
+      sendQueue_(std::move(sendQueue))
+{
+    if (sendQueue_)
+    {
+        sendQueue_->setSender(
+            [this](const std::string &data, int) { sendData(data); });
+    }
+}
+
+ResponseStream::~ResponseStream()
+{
+    close();
+}
+
+bool ResponseStream::send(const std::string &data)
+{
+    if (!asyncStream_)
+    {
+        return false;
+    }
+    if (sendQueue_)
+    {
+        switch (sendQueue_->admit(data.data(), data.length(), 0))
+        {
+            case SendQueue::Admission::kSend:
+                break;
+            case SendQueue::Admission::kQueued:
+                return true;
+            default:
+                return false;
+        }
+    }
+    return sendData(data);
+}
+
+bool ResponseStream::sendData(const std::string &data)
+{
+    if (!encoder_)
+    {
+        return sendChunk(data);
+    }
+    if (data.empty())
+    {
+        return true;
+    }
+    unflushed_ += data.length();
+    bool flush = unflushed_ >= flushSize_;
+    if (flush)
+        unflushed_ = 0;
+    std::string compressed;
+    if (!encoder_->compress(data.data(), data.length(), flush, compressed))
+    {
+        return false;
+    }
+    // The compressor may keep small inputs until it has a block to output
+    return compressed.empty() || sendChunk(compressed);
+}
+
+bool ResponseStream::flush()
+{
+    if (!asyncStream_)
+    {
+        return false;
+    }
+    if (!encoder_)
+    {
+        return true;
+    }
+    if (sendQueue_)
+    {
+        // The loop may be sending the data held back through the compressor
+        bool sent{false};
+        sendQueue_->runLocked([this, &sent]() { sent = flushEncoder(); });
+        return sent;
+    }
+    return flushEncoder();
+}
+
+bool ResponseStream::flushEncoder()
+{
+    if (unflushed_ == 0)
+    {
+        return true;
+    }
+    unflushed_ = 0;
+    std::string compressed;
+    if (!encoder_->compress(nullptr, 0, true, compressed))
+    {
+        return false;
+    }
+    return compressed.empty() || sendChunk(compressed);
+}
+
+void ResponseStream::close()
+{
+    if (asyncStream_)
+    {
+        if (sendQueue_)
+            sendQueue_->stop(true);
+        if (encoder_)
+        {
+            std::string compressed;
+            if (encoder_->finish(compressed) && !compressed.empty())
+                sendChunk(compressed);
+            encoder_.reset();
+        }
+        if (chunked_)
+        {
+            static std::string closeStream{"0\r\n\r\n"};
+            asyncStream_->send(closeStream);
+        }
+        asyncStream_->close();
+        asyncStream_.reset();
+    }
+}
+
+void ResponseStream::abort()
+{
+    if (asyncStream_)
+    {
+        if (sendQueue_)
+            sendQueue_->stop(false);
+        encoder_.reset();
+        asyncStream_->close();
+        asyncStream_.reset();
+    }
+}
+
+bool ResponseStream::sendChunk(const std::string &data)
+{
+    if (!chunked_)
+    {
+        if (sendQueue_)
+            sendQueue_->addQueued(data.length());
+        return asyncStream_->send(data);
+    }
+    std::ostringstream oss;
+    oss << std::hex << data.length() << "\r\n";
+    oss << data << "\r\n";
+    auto chunk = oss.str();
+    if (sendQueue_)
+        sendQueue_->addQueued(chunk.length());
+    return asyncStream_->send(chunk);
+}
+
+void ResponseStream::setSendQueueLimits(const SendQueueLimits &limits)
+{
+    if (sendQueue_)
+        sendQueue_->setLimits(limits);
+}
+
+size_t ResponseStream::sendQueueSize() const
+{
+    return sendQueue_ ? sendQueue_->size() : 0;
+}
+
+bool ResponseStream::writable() const
+{
+    return !sendQueue_ || sendQueue_->writable();
+}
+
+void ResponseStream::setWritableCallback(const std::function<void()> &callback)
+{
+    if (sendQueue_)
+        sendQueue_->setWritableCallback(callback);
+}
+
+bool ResponseStream::isDrained() const
+{
+    if (!sendQueue_)
+        return asyncStream_ != nullptr;
+    return sendQueue_->isDrained();
+}
+
+void ResponseStream::whenDrained(std::function<void(bool)> &&callback)
+{
+    if (!sendQueue_)
+    {
+        callback(asyncStream_ != nullptr);
+        return;
+    }
+    sendQueue_->whenDrained(std::move(callback));
+}
+
+uint64_t ResponseStream::droppedMessages() const
+{
+    return sendQueue_ ? sendQueue_->droppedMessages() : 0;
+}
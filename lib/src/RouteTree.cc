@@ -0,0 +1,137 @@
+/**
+ *
+ *  @file RouteTree.cc
+ *  Path-segment prefix tree for parameterized http routes
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "RouteTree.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace drogon;
+
+static constexpr std::string_view parameterSegment{"([^/]*)"};
+
+static bool isPlainSegment(std::string_view segment)
+{
+    static constexpr std::string_view regexChars{".[]{}()\\*+?|^$"};
+    return segment.find_first_of(regexChars) == std::string_view::npos;
+}
+
+bool RouteTree::insert(std::string_view pattern, size_t index)
+{
+    if (pattern.empty() || pattern[0] != '/')
+        return false;
+
+    // Validate the whole pattern before touching the tree
+    size_t paramCount = 0;
+    std::vector<std::string_view> segments;
+    size_t pos = 1;
+    while (true)
+    {
+        // The placeholder pattern itself contains a slash
+        size_t end;
+        if (pattern.substr(pos, parameterSegment.size()) == parameterSegment)
+        {
+            end = pos + parameterSegment.size();
+            if (end == pattern.size())
+                end = std::string_view::npos;
+            else if (pattern[end] != '/')
+                return false;
+        }
+        else
+        {
+            end = pattern.find('/', pos);
+        }
+        auto segment = pattern.substr(pos,
+                                      end == std::string_view::npos
+                                          ? std::string_view::npos
+                                          : end - pos);
+        if (segment == parameterSegment)
+        {
+            if (++paramCount > maxParameters)
+                return false;
+        }
+        else if (!isPlainSegment(segment))
+        {
+            return false;
+        }
+        segments.push_back(segment);
+        if (end == std::string_view::npos)
+            break;
+        pos = end + 1;
+    }
+
+    Node *node = &root_;
+    node->minIndex_ = std::min(node->minIndex_, index);
+    for (auto segment : segments)
+    {
+        if (segment == parameterSegment)
+        {
+            if (!node->param_)
+                node->param_ = std::make_unique<Node>();
+            node = node->param_.get();
+        }
+        else
+        {
+            std::string lowered(segment);
+            std::transform(lowered.begin(),
+                           lowered.end(),
+                           lowered.begin(),
+                           [](unsigned char c) { return tolower(c); });
+            auto &literals = node->literals_;
+            auto iter = std::lower_bound(literals.begin(),
+                                         literals.end(),
+                                         lowered,
+                                         [](const auto &item,
+                                            const std::string &key) {
+                                             return item.first < key;
+                                         });
+            if (iter == literals.end() || iter->first != lowered)
+            {
+                iter = literals.emplace(iter,
+                                        std::move(lowered),
+                                        std::make_unique<Node>());
+            }
+            node = iter->second.get();
+        }
+        node->minIndex_ = std::min(node->minIndex_, index);
+    }
+    auto &routes = node->routes_;
+    routes.insert(std::lower_bound(routes.begin(), routes.end(), index),
+                  index);
+    return true;
+}
+
+void RouteTree::clear()
+{
+    root_.literals_.clear();
+    root_.param_.reset();
+    root_.routes_.clear();
+    root_.minIndex_ = npos;
+}
+
+const RouteTree::Node *RouteTree::findLiteral(const Node &node,
+                                              std::string_view segment)
+{
+    auto &literals = node.literals_;
+    if (literals.empty())
+        return nullptr;
+    auto iter = std::lower_bound(literals.begin(),
+                                 literals.end(),
+                                 segment,
+                                 [](const auto &item, std::string_view key) {
+                                     return std::string_view(item.first) < key;
+                                 });
+    if (iter == literals.end() || iter->first != segment)
+        return nullptr;
+    return iter->second.get();
+}
@@ -0,0 +1,159 @@
+/**
+ *
+ *  @file RouteTree.h
+ *  Path-segment prefix tree for parameterized http routes
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief A path-segment prefix tree compiled from the path patterns of the
+ * parameterized http controllers.
+ *
+ * A pattern is accepted by the tree when every segment of it is either a
+ * literal string or a whole-segment placeholder (the "([^/]*)" pattern that
+ * HttpControllersRouter::addHttpPath generates for a "{...}" placeholder).
+ * Patterns that need real regular expression features are rejected by
+ * insert() and must be matched with std::regex by the caller.
+ *
+ * Every route is identified by its registration index. Lookup returns the
+ * smallest index among the matching routes, which keeps the first-match
+ * semantics of a linear scan over the registration order.
+ */
+class RouteTree
+{
+  public:
+    static constexpr size_t maxParameters = 16;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    using Captures = std::array<std::string_view, maxParameters>;
+
+    /**
+     * @brief Add a route to the tree.
+     *
+     * @param pattern The path pattern, e.g. "/api/user/([^/]*)/info".
+     * @param index The registration index of the route.
+     * @return false if the pattern can't be represented by the tree.
+     */
+    bool insert(std::string_view pattern, size_t index);
+    void clear();
+
+    bool empty() const
+    {
+        return root_.minIndex_ == npos;
+    }
+
+    /**
+     * @brief Find the route with the smallest index that matches the path and
+     * is accepted by the predicate.
+     *
+     * @param loweredPath The lower-cased request path.
+     * @param accept Called with the index of every matching candidate.
+     * @param captures Filled with the placeholder values of the found route.
+     * The values refer to the loweredPath.
+     * @param captureCount The number of valid captures.
+     * @return The index of the found route or npos.
+     */
+    template <typename Predicate>
+    size_t match(std::string_view loweredPath,
+                 const Predicate &accept,
+                 Captures &captures,
+                 size_t &captureCount) const
+    {
+        MatchState<Predicate> state{accept, captures, captureCount};
+        state.captureCount = 0;
+        if (loweredPath.empty() || loweredPath[0] != '/')
+            return npos;
+        matchNode(root_, loweredPath, 0, state);
+        return state.bestIndex;
+    }
+
+  private:
+    struct Node
+    {
+        // Sorted by the segment, for binary search with string_view keys
+        std::vector<std::pair<std::string, std::unique_ptr<Node>>> literals_;
+        std::unique_ptr<Node> param_;
+        // Indices of the routes ending at this node, in ascending order
+        std::vector<size_t> routes_;
+        // The smallest route index in this subtree, used for pruning
+        size_t minIndex_{npos};
+    };
+
+    template <typename Predicate>
+    struct MatchState
+    {
+        const Predicate &accept;
+        Captures &captures;
+        size_t &captureCount;
+        Captures current{};
+        size_t bestIndex{npos};
+    };
+
+    template <typename Predicate>
+    void matchNode(const Node &node,
+                   std::string_view path,
+                   size_t depth,
+                   MatchState<Predicate> &state) const
+    {
+        if (node.minIndex_ >= state.bestIndex)
+            return;
+        if (path.empty())
+        {
+            for (auto index : node.routes_)
+            {
+                if (index >= state.bestIndex)
+                    break;
+                if (state.accept(index))
+                {
+                    state.bestIndex = index;
+                    state.captureCount = depth;
+                    for (size_t i = 0; i < depth; ++i)
+                        state.captures[i] = state.current[i];
+                    break;
+                }
+            }
+            return;
+        }
+        // path always begins with '/' here
+        auto end = path.find('/', 1);
+        auto segment = path.substr(1, end == std::string_view::npos
+                                          ? std::string_view::npos
+                                          : end - 1);
+        auto rest = end == std::string_view::npos ? std::string_view{}
+                                                  : path.substr(end);
+        auto child = findLiteral(node, segment);
+        if (child)
+        {
+            matchNode(*child, rest, depth, state);
+        }
+        if (node.param_ && depth < maxParameters)
+        {
+            state.current[depth] = segment;
+            matchNode(*node.param_, rest, depth + 1, state);
+        }
+    }
+
+    static const Node *findLiteral(const Node &node, std::string_view segment);
+
+    Node root_;
+};
+
+}  // namespace drogon
@@ -0,0 +1,351 @@
+/**
+ *
+ *  @file SendQueue.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "SendQueue.h"
+#include <trantor/utils/Logger.h>
+#include <cassert>
+#include <unordered_map>
+
+using namespace drogon;
+
+#ifndef NDEBUG
+namespace
+{
+// The connections whose write complete callback is not for the send queues
+std::mutex reservedMutex;
+std::unordered_map<const trantor::TcpConnection *,
+                   std::weak_ptr<trantor::TcpConnection>>
+    reservedConnections;
+
+bool isReserved(const trantor::TcpConnectionPtr &conn)
+{
+    std::lock_guard<std::mutex> lock(reservedMutex);
+    auto iter = reservedConnections.find(conn.get());
+    return iter != reservedConnections.end() &&
+           iter->second.lock() == conn;
+}
+}  // namespace
+#endif
+
+void SendQueue::reserveWriteCompleteCallback(
+    const trantor::TcpConnectionPtr &conn)
+{
+#ifndef NDEBUG
+    std::lock_guard<std::mutex> lock(reservedMutex);
+    for (auto iter = reservedConnections.begin();
+         iter != reservedConnections.end();)
+    {
+        if (iter->second.expired())
+            iter = reservedConnections.erase(iter);
+        else
+            ++iter;
+    }
+    reservedConnections[conn.get()] = conn;
+#else
+    (void)conn;
+#endif
+}
+
+// Made in the loop of the connection
+SendQueue::SendQueue(const trantor::TcpConnectionPtr &conn)
+    : conn_(conn),
+      loop_(conn->getLoop()),
+      tls_(conn->isSSLConnection()),
+      sent_(conn->getBytesSent()),
+      sentBase_(sent_.load())
+{
+}
+
+SendQueue::~SendQueue()
+{
+    stopTimer();
+}
+
+void SendQueue::setLimits(const SendQueueLimits &limits)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    limits_ = limits;
+    if (limits_.highWaterMark > 0 &&
+        limits_.lowWaterMark > limits_.highWaterMark)
+        limits_.lowWaterMark = limits_.highWaterMark;
+    limited_.store(limits_.highWaterMark > 0 && !stopped_,
+                   std::memory_order_release);
+    if (limits_.highWaterMark == 0 && !backlog_.empty())
+    {
+        // Nothing is held back without limits
+        for (auto &message : backlog_)
+            sender_(message.first, message.second);
+        backlog_.clear();
+        backlogBytes_ = 0;
+    }
+}
+
+void SendQueue::watchWrites()
+{
+    std::weak_ptr<SendQueue> weakPtr = shared_from_this();
+    loop_->runInLoop([weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        auto conn = thisPtr->conn_.lock();
+        if (!conn)
+            return;
+#ifndef NDEBUG
+        // The callback of its owner would be replaced
+        assert(!isReserved(conn));
+#endif
+        conn->setWriteCompleteCallback(
+            [weakPtr](const trantor::TcpConnectionPtr &conn) {
+                if (auto thisPtr = weakPtr.lock())
+                    thisPtr->onWriteComplete(*conn);
+            });
+    });
+}
+
+void SendQueue::onWriteComplete(const trantor::TcpConnection &conn)
+{
+    // Nothing is pending, start counting again from here so that the errors
+    // of the estimate do not add up over the life of the connection
+    std::lock_guard<std::mutex> lock(mutex_);
+    sent_.store(conn.getBytesSent(), std::memory_order_relaxed);
+    sentBase_.store(sent_.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+    queuedBase_.store(queued_.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+    recordsBase_.store(records_.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+}
+
+size_t SendQueue::pendingBytes(const trantor::TcpConnection &conn) const
+{
+    // The counter of trantor is only written and read in the loop
+    if (loop_->isInLoopThread())
+        sent_.store(conn.getBytesSent(), std::memory_order_relaxed);
+    auto base = sentBase_.load();
+    auto written = sent_.load(std::memory_order_relaxed);
+    uint64_t sent = written > base ? written - base : 0;
+    if (tls_)
+    {
+        // At most one record per send() call is written, the overhead of
+        // the records queued is an upper bound
+        uint64_t overhead =
+            (records_.load(std::memory_order_relaxed) - recordsBase_.load()) *
+            recordOverhead;
+        sent = sent > overhead ? sent - overhead : 0;
+    }
+    auto queued = queued_.load(std::memory_order_relaxed) - queuedBase_.load();
+    return queued > sent ? static_cast<size_t>(queued - sent) : 0;
+}
+
+size_t SendQueue::pendingBytes() const
+{
+    auto conn = conn_.lock();
+    return conn ? pendingBytes(*conn) : 0;
+}
+
+size_t SendQueue::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pendingBytes() + backlogBytes_;
+}
+
+SendQueue::Admission SendQueue::admit(const char *data,
+                                      size_t length,
+                                      int type)
+{
+    if (!limited_.load(std::memory_order_acquire))
+        return Admission::kSend;
+    trantor::TcpConnectionPtr conn;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_ || limits_.highWaterMark == 0)
+            return Admission::kSend;
+        if (!backlog_.empty())
+        {
+            // The message is sent after the ones held back
+            pushBack(data, length, type);
+            return Admission::kQueued;
+        }
+        conn = conn_.lock();
+        if (!conn || !conn->connected())
+            return Admission::kClosed;
+        auto pending = pendingBytes(*conn);
+        // A message larger than the mark is sent when nothing is pending
+        if (pending == 0 || pending + length <= limits_.highWaterMark)
+            return Admission::kSend;
+        overflowed_.store(true, std::memory_order_release);
+        startTimer();
+        switch (limits_.policy)
+        {
+            case SendQueueOverflowPolicy::kDropNewest:
+                ++dropped_;
+                return Admission::kDropped;
+            case SendQueueOverflowPolicy::kDropOldest:
+                pushBack(data, length, type);
+                return Admission::kQueued;
+            case SendQueueOverflowPolicy::kClose:
+                break;
+        }
+    }
+    LOG_DEBUG << "Close the connection of " << conn->peerAddr().toIpPort()
+              << ", its send queue is full";
+    conn->forceClose();
+    return Admission::kClosed;
+}
+
+void SendQueue::pushBack(const char *data, size_t length, int type)
+{
+    backlog_.emplace_back(std::string(data, length), type);
+    backlogBytes_ += length;
+    while (backlogBytes_ > limits_.highWaterMark && backlog_.size() > 1)
+    {
+        backlogBytes_ -= backlog_.front().first.length();
+        backlog_.pop_front();
+        ++dropped_;
+    }
+}
+
+bool SendQueue::isDrained() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto conn = conn_.lock();
+    return !stopped_ && conn && conn->connected() && backlog_.empty() &&
+           pendingBytes(*conn) <= limits_.lowWaterMark;
+}
+
+void SendQueue::whenDrained(std::function<void(bool)> &&callback)
+{
+    bool drained;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto conn = conn_.lock();
+        drained = !stopped_ && conn && conn->connected();
+        if (drained && (!backlog_.empty() ||
+                        pendingBytes(*conn) > limits_.lowWaterMark))
+        {
+            drainCallbacks_.push_back(std::move(callback));
+            startTimer();
+            return;
+        }
+    }
+    callback(drained);
+}
+
+void SendQueue::setWritableCallback(const std::function<void()> &callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    writableCallback_ = callback;
+}
+
+void SendQueue::check()
+{
+    std::vector<std::function<void(bool)>> callbacks;
+    std::function<void()> writableCallback;
+    bool connected{true};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_)
+            return;
+        auto conn = conn_.lock();
+        if (!conn || !conn->connected())
+        {
+            connected = false;
+            backlog_.clear();
+            backlogBytes_ = 0;
+            callbacks.swap(drainCallbacks_);
+            stopTimer();
+        }
+        else
+        {
+            auto pending = pendingBytes(*conn);
+            if (pending <= limits_.lowWaterMark)
+            {
+                // Send the messages held back while they fit under the mark
+                while (!backlog_.empty())
+                {
+                    auto length = backlog_.front().first.length();
+                    if (pending > 0 &&
+                        pending + length > limits_.highWaterMark)
+                        break;
+                    auto message = std::move(backlog_.front());
+                    backlog_.pop_front();
+                    backlogBytes_ -= length;
+                    sender_(message.first, message.second);
+                    pending = pendingBytes(*conn);
+                }
+            }
+            if (backlog_.empty() && pending <= limits_.lowWaterMark)
+            {
+                if (overflowed_.exchange(false, std::memory_order_acq_rel))
+                    writableCallback = writableCallback_;
+                callbacks.swap(drainCallbacks_);
+            }
+            if (!overflowed_.load(std::memory_order_acquire) &&
+                drainCallbacks_.empty())
+                stopTimer();
+        }
+    }
+    if (writableCallback)
+        writableCallback();
+    for (auto &callback : callbacks)
+        callback(connected);
+}
+
+void SendQueue::stop(bool flush)
+{
+    std::vector<std::function<void(bool)>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_)
+            return;
+        stopped_ = true;
+        limited_.store(false, std::memory_order_release);
+        auto conn = conn_.lock();
+        if (flush && conn && conn->connected())
+        {
+            for (auto &message : backlog_)
+                sender_(message.first, message.second);
+        }
+        backlog_.clear();
+        backlogBytes_ = 0;
+        sender_ = nullptr;
+        callbacks.swap(drainCallbacks_);
+        stopTimer();
+    }
+    if (callbacks.empty())
+        return;
+    // The coroutines waiting are not resumed by the closing code
+    loop_->queueInLoop([callbacks = std::move(callbacks)]() {
+        for (auto &callback : callbacks)
+            callback(false);
+    });
+}
+
+void SendQueue::startTimer()
+{
+    if (timerId_ != trantor::InvalidTimerId)
+        return;
+    std::weak_ptr<SendQueue> weakPtr = shared_from_this();
+    timerId_ = loop_->runEvery(limits_.checkInterval, [weakPtr]() {
+        if (auto thisPtr = weakPtr.lock())
+            thisPtr->check();
+    });
+}
+
+void SendQueue::stopTimer()
+{
+    if (timerId_ == trantor::InvalidTimerId)
+        return;
+    loop_->invalidateTimer(timerId_);
+    timerId_ = trantor::InvalidTimerId;
+}
@@ -0,0 +1,193 @@
+/**
+ *
+ *  @file SendQueue.h
+ *  The bytes queued on a connection and the limits of its slow clients
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/SendQueueLimits.h>
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief The messages sent through a connection (a WebSocket connection, the
+ * body of a stream response) checked against the limits of its queue.
+ *
+ * trantor does not tell how many bytes a connection has not written yet, so
+ * they are the bytes the owner queued (addQueued()) minus the bytes the
+ * connection wrote, counted from the last time it had written everything
+ * (its write complete callback). On TLS connections the bytes written
+ * include the overhead of the records, which is taken off for each record
+ * queued so the estimate errs on the high side. The data in flight to the
+ * loop when everything is written makes the estimate a little lower.
+ *
+ * The bytes written are read in the loop of the connection (by the timer,
+ * the write complete callback and the calls made in the loop), the other
+ * threads use the last value read, which makes the estimate higher.
+ */
+class SendQueue : public std::enable_shared_from_this<SendQueue>,
+                  public trantor::NonCopyable
+{
+  public:
+    enum class Admission
+    {
+        /// The caller sends the message now
+        kSend,
+        /// The message is held back, it is sent by the sender later
+        kQueued,
+        kDropped,
+        /// The connection is closed
+        kClosed
+    };
+
+    /// Sends the messages held back, the type is the one given to admit()
+    using Sender = std::function<void(const std::string &message, int type)>;
+
+    explicit SendQueue(const trantor::TcpConnectionPtr &conn);
+    ~SendQueue();
+
+    /// Set the function sending the messages held back, before any limits
+    void setSender(Sender &&sender)
+    {
+        sender_ = std::move(sender);
+    }
+
+    /**
+     * @brief Take over the write complete callback of the connection to
+     * correct the estimate of the pending bytes, called once after the
+     * creation. The callback stays installed after the queue is gone, it
+     * then does nothing.
+     *
+     * @note It must not be used on a connection whose write complete
+     * callback belongs to someone else, such as an HTTP/2 connection. Debug
+     * builds assert it on the connections given to
+     * reserveWriteCompleteCallback().
+     */
+    void watchWrites();
+
+    /// Record that the write complete callback of the connection is used by
+    /// its owner, only checked by watchWrites() in debug builds
+    static void reserveWriteCompleteCallback(
+        const trantor::TcpConnectionPtr &conn);
+
+    void setLimits(const SendQueueLimits &limits);
+
+    /// Count the bytes given to the connection, in one send() call
+    void addQueued(size_t length)
+    {
+        queued_.fetch_add(length, std::memory_order_relaxed);
+        if (tls_)
+            records_.fetch_add((length + maxRecordSize - 1) / maxRecordSize,
+                               std::memory_order_relaxed);
+    }
+
+    /// The bytes given to the connection which are not written yet
+    size_t pendingBytes() const;
+
+    /// The pending bytes and the bytes of the messages held back
+    size_t size() const;
+
+    /// Check a message against the limits, see Admission
+    Admission admit(const char *data, size_t length, int type);
+
+    /// Whether the queue is not over the high water mark since a message
+    /// overflowed, i.e. it has not drained to the low water mark yet
+    bool writable() const
+    {
+        return !overflowed_.load(std::memory_order_acquire);
+    }
+
+    /// Whether the queue is at or below the low water mark with no message
+    /// held back
+    bool isDrained() const;
+
+    /// Call the callback once the queue is drained, at once if it is or in
+    /// the loop of the connection later. It gets false if the connection is
+    /// closed first.
+    void whenDrained(std::function<void(bool)> &&callback);
+
+    /// Run the function while the sender does not run, for the state of the
+    /// owner used by the sender
+    template <typename Function>
+    void runLocked(Function &&function)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        function();
+    }
+
+    /// Call the callback in the loop of the connection each time the queue is
+    /// writable again after an overflow
+    void setWritableCallback(const std::function<void()> &callback);
+
+    uint64_t droppedMessages() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Stop checking the queue when the connection or the stream is
+     * closed. The messages held back are sent first if flush is true, and
+     * the callbacks waiting for the queue to drain get false. The sender is
+     * not called after this returns.
+     */
+    void stop(bool flush);
+
+  private:
+    // The plaintext of a TLS record and the most overhead a record adds with
+    // the usual AEAD ciphers (TLS 1.2 AES-GCM, TLS 1.3 is 22 bytes)
+    static constexpr size_t maxRecordSize = 16 * 1024;
+    static constexpr size_t recordOverhead = 29;
+
+    // Reads the bytes written by the connection in its loop, the last value
+    // read otherwise
+    size_t pendingBytes(const trantor::TcpConnection &conn) const;
+    void onWriteComplete(const trantor::TcpConnection &conn);
+    void check();
+    void pushBack(const char *data, size_t length, int type);
+    void startTimer();
+    void stopTimer();
+
+    std::weak_ptr<trantor::TcpConnection> conn_;
+    trantor::EventLoop *loop_;
+    bool tls_;
+    // The bytes written by the connection, when last read in its loop
+    mutable std::atomic<uint64_t> sent_{0};
+    std::atomic<uint64_t> queued_{0};
+    std::atomic<uint64_t> records_{0};
+    // The counters when the connection last had nothing pending
+    std::atomic<uint64_t> sentBase_{0};
+    std::atomic<uint64_t> queuedBase_{0};
+    std::atomic<uint64_t> recordsBase_{0};
+    std::atomic<bool> limited_{false};
+    std::atomic<bool> overflowed_{false};
+    std::atomic<uint64_t> dropped_{0};
+
+    mutable std::mutex mutex_;
+    SendQueueLimits limits_;
+    Sender sender_;
+    std::deque<std::pair<std::string, int>> backlog_;
+    size_t backlogBytes_{0};
+    std::vector<std::function<void(bool)>> drainCallbacks_;
+    std::function<void()> writableCallback_;
+    trantor::TimerId timerId_{trantor::InvalidTimerId};
+    bool stopped_{false};
+};
+}  // namespace drogon
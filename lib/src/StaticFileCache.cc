@@ -0,0 +1,216 @@
+/**
+ *
+ *  @file StaticFileCache.cc
+ *  Process-wide cache of static file responses shared by the IO threads
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "StaticFileCache.h"
+#include <trantor/utils/Logger.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace drogon;
+
+StaticFileCache::~StaticFileCache()
+{
+#ifdef __linux__
+    if (inotifyFd_ >= 0)
+        close(inotifyFd_);
+#endif
+}
+
+void StaticFileCache::init(trantor::EventLoop *loop)
+{
+    loop_ = loop;
+#ifdef __linux__
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0)
+    {
+        LOG_SYSERR << "inotify_init1";
+        return;
+    }
+    // The events are queued by the kernel, reading them once a second keeps
+    // this off the IO threads and is well below the default cache time.
+    timerId_ = loop_->runEvery(1.0, [this]() { readChanges(); });
+#endif
+}
+
+void StaticFileCache::reset()
+{
+    if (loop_ && timerId_ != trantor::InvalidTimerId)
+    {
+        loop_->invalidateTimer(timerId_);
+        timerId_ = trantor::InvalidTimerId;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!nodes_.empty())
+        eraseNode(nodes_.begin());
+#ifdef __linux__
+    if (inotifyFd_ >= 0)
+    {
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+    }
+#endif
+    loop_ = nullptr;
+}
+
+size_t StaticFileCache::entrySize(const Entry &entry)
+{
+    size_t size = 0;
+    for (auto &variant : entry.variants)
+    {
+        if (variant)
+            size += variant->getBody().size();
+    }
+    return size;
+}
+
+StaticFileCache::EntryPtr StaticFileCache::find(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = index_.find(path);
+    if (iter == index_.end())
+        return nullptr;
+    auto nodeIter = iter->second;
+    if (nodeIter->entry->expiry <= std::chrono::steady_clock::now())
+    {
+        eraseNode(nodeIter);
+        return nullptr;
+    }
+    nodes_.splice(nodes_.begin(), nodes_, nodeIter);
+    return nodeIter->entry;
+}
+
+void StaticFileCache::insert(const std::string &path, EntryPtr entry)
+{
+    auto size = entrySize(*entry) + path.size();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size > capacity_)
+        return;
+    auto iter = index_.find(path);
+    if (iter != index_.end())
+        eraseNode(iter->second);
+    nodes_.push_front(Node{path, std::move(entry), size, {}});
+    index_.emplace(path, nodes_.begin());
+    size_ += size;
+    watch(nodes_.front());
+    evict();
+}
+
+void StaticFileCache::erase(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = index_.find(path);
+    if (iter != index_.end())
+        eraseNode(iter->second);
+}
+
+void StaticFileCache::eraseNode(NodeList::iterator iter)
+{
+#ifdef __linux__
+    for (auto wd : iter->watches)
+    {
+        auto watchIter = watchedPaths_.find(wd);
+        if (watchIter == watchedPaths_.end())
+            continue;
+        watchIter->second.erase(iter->path);
+        if (watchIter->second.empty())
+        {
+            inotify_rm_watch(inotifyFd_, wd);
+            watchedPaths_.erase(watchIter);
+        }
+    }
+#endif
+    size_ -= iter->size;
+    index_.erase(iter->path);
+    nodes_.erase(iter);
+}
+
+void StaticFileCache::evict()
+{
+    while (size_ > capacity_ && !nodes_.empty())
+    {
+        LOG_TRACE << "Evict " << nodes_.back().path << " from the file cache";
+        eraseNode(std::prev(nodes_.end()));
+    }
+}
+
+void StaticFileCache::watch(Node &node)
+{
+#ifdef __linux__
+    if (inotifyFd_ < 0)
+        return;
+    for (auto &file : node.entry->files)
+    {
+        // IN_ATTRIB also reports the file being unlinked or replaced by a
+        // rename, as its link count changes
+        int wd = inotify_add_watch(inotifyFd_,
+                                   file.c_str(),
+                                   IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                       IN_MOVE_SELF | IN_DELETE_SELF);
+        if (wd < 0)
+        {
+            LOG_SYSERR << "inotify_add_watch " << file;
+            continue;
+        }
+        watchedPaths_[wd].insert(node.path);
+        node.watches.push_back(wd);
+    }
+#else
+    (void)node;
+#endif
+}
+
+void StaticFileCache::readChanges()
+{
+#ifdef __linux__
+    alignas(struct inotify_event) char buf[4096];
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (inotifyFd_ >= 0)
+    {
+        auto n = read(inotifyFd_, buf, sizeof(buf));
+        if (n <= 0)
+            break;
+        for (char *p = buf; p < buf + n;)
+        {
+            auto event = reinterpret_cast<struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + event->len;
+            auto watchIter = watchedPaths_.find(event->wd);
+            if (watchIter == watchedPaths_.end())
+                continue;
+            if (event->mask & IN_IGNORED)
+            {
+                // The kernel removed the watch (e.g. the file was deleted)
+                auto paths = std::move(watchIter->second);
+                watchedPaths_.erase(watchIter);
+                for (auto &path : paths)
+                {
+                    auto iter = index_.find(path);
+                    if (iter != index_.end())
+                        eraseNode(iter->second);
+                }
+                continue;
+            }
+            auto paths = watchIter->second;
+            for (auto &path : paths)
+            {
+                LOG_TRACE << path << " changed, remove it from the file cache";
+                auto iter = index_.find(path);
+                if (iter != index_.end())
+                    eraseNode(iter->second);
+            }
+        }
+    }
+#endif
+}
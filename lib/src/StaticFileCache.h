@@ -0,0 +1,131 @@
+/**
+ *
+ *  @file StaticFileCache.h
+ *  Process-wide cache of static file responses shared by the IO threads
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpResponse.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Caches the responses of static files for all the IO threads, so a
+ * hot file is held in memory once whatever the number of threads.
+ *
+ * An entry holds the responses of a file and of its precompressed variants
+ * (.br and .gz files). The responses have frozen headers and are never sent
+ * themselves, each request gets a copy sharing the header block and the body.
+ * Entries are evicted in LRU order when the total size of the bodies exceeds
+ * the capacity, when they expire and, on Linux, when one of their files is
+ * changed (inotify).
+ */
+class StaticFileCache : public trantor::NonCopyable
+{
+  public:
+    enum Encoding
+    {
+        kIdentity = 0,
+        kBrotli,
+        kGzip,
+        kEncodingCount
+    };
+
+    struct Entry
+    {
+        // Indexed by Encoding, null if there is no such variant
+        HttpResponsePtr variants[kEncodingCount];
+        // The files the variants were read from, watched for changes
+        std::vector<std::string> files;
+        std::string modifiedTimeStr;
+        std::chrono::steady_clock::time_point expiry{
+            std::chrono::steady_clock::time_point::max()};
+    };
+
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+    StaticFileCache() = default;
+    ~StaticFileCache();
+
+    /// Start watching the cached files, the changes are read on the loop
+    void init(trantor::EventLoop *loop);
+    /// Stop watching and drop all the entries, must be called on the loop
+    void reset();
+
+    void setCapacity(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = bytes;
+    }
+
+    size_t capacity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    /// Return the entry of the path, or nullptr if not cached or expired
+    EntryPtr find(const std::string &path);
+    /// Entries larger than the capacity are not cached
+    void insert(const std::string &path, EntryPtr entry);
+    void erase(const std::string &path);
+
+    /// The total size of the cached bodies in bytes
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    static size_t entrySize(const Entry &entry);
+
+  private:
+    struct Node
+    {
+        std::string path;
+        EntryPtr entry;
+        size_t size;
+        std::vector<int> watches;
+    };
+
+    using NodeList = std::list<Node>;
+
+    void readChanges();
+    // The following methods are called with mutex_ locked
+    void eraseNode(NodeList::iterator iter);
+    void evict();
+    void watch(Node &node);
+
+    mutable std::mutex mutex_;
+    // Most recently used first
+    NodeList nodes_;
+    std::unordered_map<std::string, NodeList::iterator> index_;
+    size_t size_{0};
+    size_t capacity_{64 * 1024 * 1024};
+
+    trantor::EventLoop *loop_{nullptr};
+    trantor::TimerId timerId_{trantor::InvalidTimerId};
+    int inotifyFd_{-1};
+    // inotify watch descriptor -> cached paths using the file
+    std::unordered_map<int, std::unordered_set<std::string>> watchedPaths_;
+};
+}  // namespace drogon
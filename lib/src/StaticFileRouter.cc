@@ -37,20 +37,7 @@ using namespace drogon;
 
 void StaticFileRouter::init(const std::vector<trantor::EventLoop *> &ioLoops)
 {
-    // Max timeout up to about 70 days;
-    staticFilesCacheMap_ = std::make_unique<
-        IOThreadStorage<std::unique_ptr<CacheMap<std::string, char>>>>();
-    staticFilesCacheMap_->init(
-        [&ioLoops](std::unique_ptr<CacheMap<std::string, char>> &mapPtr,
-                   size_t i) {
-            assert(i == ioLoops[i]->index());
-            mapPtr = std::make_unique<CacheMap<std::string, char>>(ioLoops[i],
-                                                                   1.0f,
-                                                                   4,
-                                                                   50);
-        });
-    staticFilesCache_ = std::make_unique<
-        IOThreadStorage<std::unordered_map<std::string, HttpResponsePtr>>>();
+    fileCache_.init(HttpAppFrameworkImpl::instance().getLoop());
     ioLocationsPtr_ =
         std::make_shared<IOThreadStorage<std::vector<Location>>>();
     for (auto *loop : ioLoops)
@@ -64,8 +51,7 @@ void StaticFileRouter::init(const std::vector<trantor::EventLoop *> &ioLoops)
 
 void StaticFileRouter::reset()
 {
-    staticFilesCacheMap_.reset();
-    staticFilesCache_.reset();
+    fileCache_.reset();
     ioLocationsPtr_.reset();
     locations_.clear();
 }
@@ -279,6 +265,8 @@ void StaticFileRouter::route(
     defaultHandler_(req, std::move(callback));
 }
 
+namespace drogon
+{
 // Expand this struct as you need, nothing to worry about
 struct FileStat
 {
@@ -286,6 +274,7 @@ struct FileStat
     struct tm modifiedTime_;
     std::string modifiedTimeStr_;
 };
+}  // namespace drogon
 
 // A wrapper to call stat()
 // std::filesystem::file_time_type::clock::to_time_t still not
@@ -439,21 +428,13 @@ void StaticFileRouter::sendStaticFileResponse(
     }
 
     // find cached response
-    HttpResponsePtr cachedResp;
-    auto &cacheMap = staticFilesCache_->getThreadData();
-    auto iter = cacheMap.find(filePath);
-    if (iter != cacheMap.end())
-    {
-        cachedResp = iter->second;
-    }
+    auto entry = fileCache_.find(filePath);
 
     if (enableLastModify_)
     {
-        if (cachedResp)
+        if (entry)
         {
-            if (static_cast<HttpResponseImpl *>(cachedResp.get())
-                    ->getHeaderBy("last-modified") ==
-                req->getHeaderBy("if-modified-since"))
+            if (entry->modifiedTimeStr == req->getHeaderBy("if-modified-since"))
             {
                 std::shared_ptr<HttpResponseImpl> resp =
                     std::make_shared<HttpResponseImpl>();
@@ -485,10 +466,10 @@ void StaticFileRouter::sendStaticFileResponse(
             }
         }
     }
-    if (cachedResp)
+    if (entry)
     {
         LOG_TRACE << "Using file cache";
-        callback(cachedResp);
+        callback(responseFromCache(*entry, req));
         return;
     }
     // Check existence
@@ -504,105 +485,186 @@ void StaticFileRouter::sendStaticFileResponse(
         }
     }
 
-    HttpResponsePtr resp;
-    auto &acceptEncoding = req->getHeaderBy("accept-encoding");
-
-    if (brStaticFlag_ && acceptEncoding.find("br") != std::string::npos)
+    if (staticFilesCacheTime_ < 0)
     {
-        // Find compressed file first.
-        auto brFileName = filePath + ".br";
-        std::filesystem::path fsBrFile(utils::toNativePath(brFileName));
-        std::error_code err;
-        if (std::filesystem::exists(fsBrFile, err) &&
-            std::filesystem::is_regular_file(fsBrFile, err))
+        auto &acceptEncoding = req->getHeaderBy("accept-encoding");
+        HttpResponsePtr resp;
+        if (brStaticFlag_ && acceptEncoding.find("br") != std::string::npos)
         {
-            auto ct = fileNameToContentTypeAndMime(filePath);
-            resp = HttpResponse::newFileResponse(
-                brFileName, "", ct.first, std::string(ct.second), req);
-            resp->addHeader("Content-Encoding", "br");
+            resp = makeFileResponse(filePath,
+                                    StaticFileCache::kBrotli,
+                                    fileStat,
+                                    defaultContentType,
+                                    req);
         }
+        if (!resp && gzipStaticFlag_ &&
+            acceptEncoding.find("gzip") != std::string::npos)
+        {
+            resp = makeFileResponse(filePath,
+                                    StaticFileCache::kGzip,
+                                    fileStat,
+                                    defaultContentType,
+                                    req);
+        }
+        if (!resp)
+        {
+            resp = makeFileResponse(filePath,
+                                    StaticFileCache::kIdentity,
+                                    fileStat,
+                                    defaultContentType,
+                                    req);
+        }
+        callback(resp);
+        return;
     }
-    if (!resp && gzipStaticFlag_ &&
-        acceptEncoding.find("gzip") != std::string::npos)
+
+    // Read the file and its precompressed variants once for all the threads
+    auto newEntry = std::make_shared<StaticFileCache::Entry>();
+    newEntry->modifiedTimeStr = fileStat.modifiedTimeStr_;
+    if (staticFilesCacheTime_ > 0)
     {
-        // Find compressed file first.
-        auto gzipFileName = filePath + ".gz";
-        std::filesystem::path fsGzipFile(utils::toNativePath(gzipFileName));
-        std::error_code err;
-        if (std::filesystem::exists(fsGzipFile, err) &&
-            std::filesystem::is_regular_file(fsGzipFile, err))
+        newEntry->expiry = std::chrono::steady_clock::now() +
+                           std::chrono::seconds(staticFilesCacheTime_);
+    }
+    for (auto encoding : {StaticFileCache::kIdentity,
+                          StaticFileCache::kBrotli,
+                          StaticFileCache::kGzip})
+    {
+        if ((encoding == StaticFileCache::kBrotli && !brStaticFlag_) ||
+            (encoding == StaticFileCache::kGzip && !gzipStaticFlag_))
+            continue;
+        auto resp = makeFileResponse(
+            filePath, encoding, fileStat, defaultContentType, req);
+        if (!resp)
+            continue;
+        if (resp->statusCode() == k404NotFound)
+        {
+            // The file was removed in the meantime
+            callback(resp);
+            return;
+        }
+        resp->freezeHeaders();
+        if (encoding == StaticFileCache::kIdentity)
         {
-            auto ct = fileNameToContentTypeAndMime(filePath);
-            resp = HttpResponse::newFileResponse(
-                gzipFileName, "", ct.first, std::string(ct.second), req);
-            resp->addHeader("Content-Encoding", "gzip");
+            // Compressed on the fly when the client accepts no precompressed
+            // variant, keep the result if the compression cache is enabled
+            resp->setCacheCompressedBody(true);
         }
+        newEntry->variants[encoding] = std::move(resp);
+        newEntry->files.push_back(filePath + encodingSuffix(encoding));
     }
-    if (!resp)
+    LOG_TRACE << "Save in cache for " << staticFilesCacheTime_ << " seconds";
+    fileCache_.insert(filePath, newEntry);
+    callback(responseFromCache(*newEntry, req));
+}
+
+const char *StaticFileRouter::encodingSuffix(int encoding)
+{
+    switch (encoding)
+    {
+        case StaticFileCache::kBrotli:
+            return ".br";
+        case StaticFileCache::kGzip:
+            return ".gz";
+        default:
+            return "";
+    }
+}
+
+HttpResponsePtr StaticFileRouter::makeFileResponse(
+    const std::string &filePath,
+    int encoding,
+    const FileStat &fileStat,
+    const std::string_view &defaultContentType,
+    const HttpRequestImplPtr &req)
+{
+    auto ct = fileNameToContentTypeAndMime(filePath);
+    HttpResponsePtr resp;
+    if (encoding == StaticFileCache::kIdentity)
     {
-        auto ct = fileNameToContentTypeAndMime(filePath);
         resp = HttpResponse::newFileResponse(
             filePath, "", ct.first, std::string(ct.second), req);
     }
-    if (resp->statusCode() != k404NotFound)
+    else
     {
-        if (resp->getContentType() == CT_APPLICATION_OCTET_STREAM &&
-            !defaultContentType.empty())
+        // Find compressed file first.
+        auto compressedFileName = filePath + encodingSuffix(encoding);
+        std::filesystem::path fsFile(utils::toNativePath(compressedFileName));
+        std::error_code err;
+        if (!std::filesystem::exists(fsFile, err) ||
+            !std::filesystem::is_regular_file(fsFile, err))
         {
-            resp->setContentTypeCodeAndCustomString(CT_CUSTOM,
-                                                    defaultContentType);
+            return nullptr;
         }
-        if (!fileStat.modifiedTimeStr_.empty())
+        resp = HttpResponse::newFileResponse(
+            compressedFileName, "", ct.first, std::string(ct.second), req);
+        if (resp->statusCode() == k404NotFound)
+            return nullptr;
+        resp->addHeader("Content-Encoding",
+                        encoding == StaticFileCache::kBrotli ? "br" : "gzip");
+    }
+    if (resp->statusCode() == k404NotFound)
+        return resp;
+    if (resp->getContentType() == CT_APPLICATION_OCTET_STREAM &&
+        !defaultContentType.empty())
+    {
+        resp->setContentTypeCodeAndCustomString(CT_CUSTOM, defaultContentType);
+    }
+    if (!fileStat.modifiedTimeStr_.empty())
+    {
+        resp->addHeader("Last-Modified", fileStat.modifiedTimeStr_);
+        if (staticFilesCacheTime_ > 0)
         {
-            resp->addHeader("Last-Modified", fileStat.modifiedTimeStr_);
-            if (staticFilesCacheTime_ > 0)
-            {
-                time_t expiry =
-                    time(nullptr) + static_cast<time_t>(staticFilesCacheTime_);
-                struct tm expiryTm;
+            time_t expiry =
+                time(nullptr) + static_cast<time_t>(staticFilesCacheTime_);
+            struct tm expiryTm;
 #ifdef _WIN32
-                gmtime_s(&expiryTm, &expiry);
+            gmtime_s(&expiryTm, &expiry);
 #else
-                gmtime_r(&expiry, &expiryTm);
+            gmtime_r(&expiry, &expiryTm);
 #endif
-                char buf[64];
-                size_t len = strftime(buf,
-                                      sizeof(buf),
-                                      "%a, %d %b %Y %H:%M:%S GMT",
-                                      &expiryTm);
-                resp->addHeader("Expires", std::string(buf, len));
-            }
-        }
-        if (enableRange_)
-        {
-            resp->addHeader("accept-range", "bytes");
+            char buf[64];
+            size_t len = strftime(
+                buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &expiryTm);
+            resp->addHeader("Expires", std::string(buf, len));
         }
-        if (!headers_.empty())
-        {
-            for (auto &header : headers_)
-            {
-                resp->addHeader(header.first, header.second);
-            }
-        }
-        // cache the response for 5 seconds by default
-        if (staticFilesCacheTime_ >= 0)
+    }
+    if (enableRange_)
+    {
+        resp->addHeader("accept-range", "bytes");
+    }
+    if (!headers_.empty())
+    {
+        for (auto &header : headers_)
         {
-            LOG_TRACE << "Save in cache for " << staticFilesCacheTime_
-                      << " seconds";
-            resp->setExpiredTime(staticFilesCacheTime_);
-            staticFilesCache_->getThreadData()[filePath] = resp;
-            staticFilesCacheMap_->getThreadData()->insert(
-                filePath, 0, staticFilesCacheTime_, [this, filePath]() {
-                    LOG_TRACE << "Erase cache";
-                    assert(staticFilesCache_->getThreadData().find(filePath) !=
-                           staticFilesCache_->getThreadData().end());
-                    staticFilesCache_->getThreadData().erase(filePath);
-                });
+            resp->addHeader(header.first, header.second);
         }
-        callback(resp);
-        return;
     }
-    callback(resp);
+    return resp;
+}
+
+HttpResponsePtr StaticFileRouter::responseFromCache(
+    const StaticFileCache::Entry &entry,
+    const HttpRequestImplPtr &req)
+{
+    const HttpResponsePtr *variant = &entry.variants[StaticFileCache::kIdentity];
+    auto &acceptEncoding = req->getHeaderBy("accept-encoding");
+    if (entry.variants[StaticFileCache::kBrotli] &&
+        acceptEncoding.find("br") != std::string::npos)
+    {
+        variant = &entry.variants[StaticFileCache::kBrotli];
+    }
+    else if (entry.variants[StaticFileCache::kGzip] &&
+             acceptEncoding.find("gzip") != std::string::npos)
+    {
+        variant = &entry.variants[StaticFileCache::kGzip];
+    }
+    // The copy shares the frozen headers and the body with the cached
+    // response, which is read by all the IO threads and never sent itself
+    auto resp = std::make_shared<HttpResponseImpl>(
+        *static_cast<const HttpResponseImpl *>(variant->get()));
+    resp->initFromTemplate();
+    return resp;
 }
 
 void StaticFileRouter::setFileTypes(const std::vector<std::string> &types)
@@ -16,7 +16,7 @@
 
 #include "impl_forwards.h"
 #include "MiddlewaresFunction.h"
-#include <drogon/CacheMap.h>
+#include "StaticFileCache.h"
 #include <drogon/IOThreadStorage.h>
 #include <functional>
 #include <set>
@@ -25,6 +25,8 @@
 
 namespace drogon
 {
+struct FileStat;
+
 class StaticFileRouter
 {
   public:
@@ -48,6 +50,16 @@ class StaticFileRouter
         return staticFilesCacheTime_;
     }
 
+    void setStaticFilesCacheSize(size_t bytes)
+    {
+        fileCache_.setCapacity(bytes);
+    }
+
+    size_t staticFilesCacheSize() const
+    {
+        return fileCache_.capacity();
+    }
+
     void setGzipStatic(bool useGzipStatic)
     {
         gzipStaticFlag_ = useGzipStatic;
@@ -120,6 +132,17 @@ class StaticFileRouter
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback);
 
+    static const char *encodingSuffix(int encoding);
+    // Returns nullptr if a precompressed variant doesn't exist
+    HttpResponsePtr makeFileResponse(const std::string &filePath,
+                                     int encoding,
+                                     const FileStat &fileStat,
+                                     const std::string_view &defaultContentType,
+                                     const HttpRequestImplPtr &req);
+    static HttpResponsePtr responseFromCache(
+        const StaticFileCache::Entry &entry,
+        const HttpRequestImplPtr &req);
+
     std::set<std::string> fileTypeSet_{"html",
                                        "js",
                                        "css",
@@ -145,12 +168,7 @@ class StaticFileRouter
     bool enableRange_{true};
     bool gzipStaticFlag_{true};
     bool brStaticFlag_{true};
-    std::unique_ptr<
-        IOThreadStorage<std::unique_ptr<CacheMap<std::string, char>>>>
-        staticFilesCacheMap_;
-    std::unique_ptr<
-        IOThreadStorage<std::unordered_map<std::string, HttpResponsePtr>>>
-        staticFilesCache_;
+    StaticFileCache fileCache_;
     std::vector<std::pair<std::string, std::string>> headers_;
     bool implicitPageEnable_{true};
     std::string implicitPage_{"index.html"};
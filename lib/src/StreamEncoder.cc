@@ -0,0 +1,336 @@
+/**
+ *
+ *  @file StreamEncoder.cc
+ *  Incremental gzip, brotli and zstd compression of streamed bodies
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "StreamEncoder.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+#ifdef USE_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+constexpr size_t outputChunkSize = 16 * 1024;
+
+class GzipEncoder : public StreamEncoder
+{
+  public:
+    GzipEncoder() : StreamEncoder(kGzip)
+    {
+        memset(&strm_, 0, sizeof(strm_));
+        ok_ = deflateInit2(&strm_,
+                           Z_DEFAULT_COMPRESSION,
+                           Z_DEFLATED,
+                           MAX_WBITS + 16,
+                           8,
+                           Z_DEFAULT_STRATEGY) == Z_OK;
+        if (!ok_)
+            LOG_ERROR << "deflateInit2 error!";
+    }
+
+    ~GzipEncoder() override
+    {
+        if (ok_)
+            (void)deflateEnd(&strm_);
+    }
+
+    bool compress(const char *data,
+                  size_t len,
+                  bool flush,
+                  std::string &out) override
+    {
+        return deflateData(data, len, flush ? Z_SYNC_FLUSH : Z_NO_FLUSH, out);
+    }
+
+    bool finish(std::string &out) override
+    {
+        return deflateData(nullptr, 0, Z_FINISH, out);
+    }
+
+  private:
+    bool deflateData(const char *data, size_t len, int mode, std::string &out)
+    {
+        if (!ok_)
+            return false;
+        strm_.next_in = (Bytef *)data;
+        strm_.avail_in = static_cast<uInt>(len);
+        char buf[outputChunkSize];
+        do
+        {
+            strm_.next_out = (Bytef *)buf;
+            strm_.avail_out = sizeof(buf);
+            if (deflate(&strm_, mode) == Z_STREAM_ERROR)
+                return false;
+            out.append(buf, sizeof(buf) - strm_.avail_out);
+        } while (strm_.avail_out == 0);
+        return true;
+    }
+
+    z_stream strm_;
+    bool ok_{false};
+};
+
+#ifdef USE_BROTLI
+class BrotliStreamEncoder : public StreamEncoder
+{
+  public:
+    BrotliStreamEncoder()
+        : StreamEncoder(kBrotli),
+          state_(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr))
+    {
+        // The quality of utils::brotliCompress()
+        if (state_)
+            BrotliEncoderSetParameter(state_, BROTLI_PARAM_QUALITY, 5);
+    }
+
+    ~BrotliStreamEncoder() override
+    {
+        if (state_)
+            BrotliEncoderDestroyInstance(state_);
+    }
+
+    bool compress(const char *data,
+                  size_t len,
+                  bool flush,
+                  std::string &out) override
+    {
+        return encode(data,
+                      len,
+                      flush ? BROTLI_OPERATION_FLUSH : BROTLI_OPERATION_PROCESS,
+                      out);
+    }
+
+    bool finish(std::string &out) override
+    {
+        return encode(nullptr, 0, BROTLI_OPERATION_FINISH, out);
+    }
+
+  private:
+    bool encode(const char *data,
+                size_t len,
+                BrotliEncoderOperation op,
+                std::string &out)
+    {
+        if (!state_)
+            return false;
+        size_t availableIn = len;
+        auto nextIn = (const uint8_t *)data;
+        uint8_t buf[outputChunkSize];
+        do
+        {
+            size_t availableOut = sizeof(buf);
+            auto nextOut = buf;
+            if (!BrotliEncoderCompressStream(state_,
+                                             op,
+                                             &availableIn,
+                                             &nextIn,
+                                             &availableOut,
+                                             &nextOut,
+                                             nullptr))
+                return false;
+            out.append((const char *)buf, sizeof(buf) - availableOut);
+        } while (availableIn > 0 || BrotliEncoderHasMoreOutput(state_) ||
+                 (op == BROTLI_OPERATION_FINISH &&
+                  !BrotliEncoderIsFinished(state_)));
+        return true;
+    }
+
+    BrotliEncoderState *state_;
+};
+#endif
+
+#ifdef USE_ZSTD
+class ZstdStreamEncoder : public StreamEncoder
+{
+  public:
+    ZstdStreamEncoder() : StreamEncoder(kZstd), ctx_(ZSTD_createCCtx())
+    {
+        if (ctx_)
+            ZSTD_CCtx_setParameter(ctx_,
+                                   ZSTD_c_compressionLevel,
+                                   ZSTD_CLEVEL_DEFAULT);
+    }
+
+    ~ZstdStreamEncoder() override
+    {
+        ZSTD_freeCCtx(ctx_);
+    }
+
+    bool compress(const char *data,
+                  size_t len,
+                  bool flush,
+                  std::string &out) override
+    {
+        return encode(data, len, flush ? ZSTD_e_flush : ZSTD_e_continue, out);
+    }
+
+    bool finish(std::string &out) override
+    {
+        return encode(nullptr, 0, ZSTD_e_end, out);
+    }
+
+  private:
+    bool encode(const char *data,
+                size_t len,
+                ZSTD_EndDirective mode,
+                std::string &out)
+    {
+        if (!ctx_)
+            return false;
+        ZSTD_inBuffer input{data, len, 0};
+        char buf[outputChunkSize];
+        bool done;
+        do
+        {
+            ZSTD_outBuffer output{buf, sizeof(buf), 0};
+            auto remaining = ZSTD_compressStream2(ctx_, &output, &input, mode);
+            if (ZSTD_isError(remaining))
+            {
+                LOG_ERROR << "ZSTD_compressStream2 error: "
+                          << ZSTD_getErrorName(remaining);
+                return false;
+            }
+            out.append(buf, output.pos);
+            // A flush or an end is complete when nothing remains in the
+            // context
+            done = mode == ZSTD_e_continue ? input.pos == input.size
+                                           : remaining == 0;
+        } while (!done);
+        return true;
+    }
+
+    ZSTD_CCtx *ctx_;
+};
+#endif
+
+struct CompressingStreamParams
+{
+    std::function<std::size_t(char *, std::size_t)> dataCallback;
+    StreamEncoderPtr encoder;
+    size_t flushSize;
+    std::string input;
+    std::string output;
+    size_t outputPos{0};
+    size_t unflushed{0};
+    bool finished{false};
+};
+
+std::size_t compressingCallback(
+    const std::shared_ptr<CompressingStreamParams> &params,
+    char *buffer,
+    std::size_t size)
+{
+    if (buffer == nullptr)
+    {
+        // Cleanup
+        if (params->dataCallback)
+        {
+            params->dataCallback(nullptr, 0);
+            params->dataCallback = {};
+        }
+        return 0;
+    }
+    while (params->outputPos == params->output.size())
+    {
+        params->output.clear();
+        params->outputPos = 0;
+        if (params->finished || !params->dataCallback)
+            return 0;
+        params->input.resize(size);
+        auto len = params->dataCallback(params->input.data(), size);
+        bool ok;
+        if (len == 0)
+        {
+            params->finished = true;
+            ok = params->encoder->finish(params->output);
+        }
+        else
+        {
+            params->unflushed += len;
+            // A short read means no more data is ready for now
+            bool flush = len < size || params->unflushed >= params->flushSize;
+            if (flush)
+                params->unflushed = 0;
+            ok = params->encoder->compress(params->input.data(),
+                                           len,
+                                           flush,
+                                           params->output);
+        }
+        if (!ok)
+        {
+            LOG_ERROR << "Failed to compress the stream";
+            params->finished = true;
+            params->output.clear();
+            return 0;
+        }
+    }
+    auto len = (std::min)(size, params->output.size() - params->outputPos);
+    memcpy(buffer, params->output.data() + params->outputPos, len);
+    params->outputPos += len;
+    return len;
+}
+}  // namespace
+
+StreamEncoderPtr StreamEncoder::newEncoder(Encoding encoding)
+{
+    switch (encoding)
+    {
+        case kGzip:
+            return std::make_shared<GzipEncoder>();
+#ifdef USE_BROTLI
+        case kBrotli:
+            return std::make_shared<BrotliStreamEncoder>();
+#endif
+#ifdef USE_ZSTD
+        case kZstd:
+            return std::make_shared<ZstdStreamEncoder>();
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+const char *StreamEncoder::encodingName(Encoding encoding)
+{
+    switch (encoding)
+    {
+        case kBrotli:
+            return "br";
+        case kZstd:
+            return "zstd";
+        default:
+            return "gzip";
+    }
+}
+
+std::function<std::size_t(char *, std::size_t)> drogon::compressStreamCallback(
+    std::function<std::size_t(char *, std::size_t)> callback,
+    StreamEncoderPtr encoder,
+    size_t flushSize)
+{
+    auto params = std::make_shared<CompressingStreamParams>();
+    params->dataCallback = std::move(callback);
+    params->encoder = std::move(encoder);
+    params->flushSize = flushSize;
+    return [params](char *buffer, std::size_t size) {
+        return compressingCallback(params, buffer, size);
+    };
+}
@@ -0,0 +1,86 @@
+/**
+ *
+ *  @file StreamEncoder.h
+ *  Incremental gzip, brotli and zstd compression of streamed bodies
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief Compresses a body that is produced in pieces, e.g. by a stream
+ * response. The compressed data is appended to a string as the codec
+ * produces it, a flush makes everything given so far decodable by the peer.
+ */
+class StreamEncoder : public trantor::NonCopyable
+{
+  public:
+    enum Encoding
+    {
+        kGzip = 0,
+        kBrotli,
+        kZstd
+    };
+
+    /// Return nullptr if the encoding is not supported by this build
+    static std::shared_ptr<StreamEncoder> newEncoder(Encoding encoding);
+
+    /// The value of the content-encoding header
+    static const char *encodingName(Encoding encoding);
+
+    virtual ~StreamEncoder() = default;
+
+    /**
+     * @brief Compress data and append the output to out.
+     * @param flush If true, all the compressed data is output, at the cost of
+     * some compression ratio.
+     * @return false on error
+     */
+    virtual bool compress(const char *data,
+                          size_t len,
+                          bool flush,
+                          std::string &out) = 0;
+
+    /// End the compressed stream, nothing can be compressed after it
+    virtual bool finish(std::string &out) = 0;
+
+    Encoding encoding() const
+    {
+        return encoding_;
+    }
+
+  protected:
+    explicit StreamEncoder(Encoding encoding) : encoding_(encoding)
+    {
+    }
+
+  private:
+    Encoding encoding_;
+};
+
+using StreamEncoderPtr = std::shared_ptr<StreamEncoder>;
+
+/**
+ * @brief Wrap the data callback of a stream response, so it returns the
+ * compressed data. The output is flushed when the callback returns less than
+ * it was asked for (no more data is ready) or after flushSize bytes.
+ */
+std::function<std::size_t(char *, std::size_t)> compressStreamCallback(
+    std::function<std::size_t(char *, std::size_t)> callback,
+    StreamEncoderPtr encoder,
+    size_t flushSize);
+}  // namespace drogon
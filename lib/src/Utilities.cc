@@ -20,6 +20,9 @@
 #include <brotli/decode.h>
 #include <brotli/encode.h>
 #endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 #ifdef _WIN32
 #include <rpc.h>
 #include <direct.h>
@@ -906,6 +909,11 @@ std::string urlDecode(const char *begin, const char *end)
 
 /* Compress gzip data */
 std::string gzipCompress(const char *data, const size_t ndata)
+{
+    return gzipCompress(data, ndata, Z_DEFAULT_COMPRESSION);
+}
+
+std::string gzipCompress(const char *data, const size_t ndata, int level)
 {
     z_stream strm = {nullptr,
                      0,
@@ -924,7 +932,7 @@ std::string gzipCompress(const char *data, const size_t ndata)
     if (data && ndata > 0)
     {
         if (deflateInit2(&strm,
-                         Z_DEFAULT_COMPRESSION,
+                         level,
                          Z_DEFLATED,
                          MAX_WBITS + 16,
                          8,
@@ -1199,13 +1207,18 @@ int createPath(const std::string &path)
 }
 #ifdef USE_BROTLI
 std::string brotliCompress(const char *data, const size_t ndata)
+{
+    return brotliCompress(data, ndata, 5);
+}
+
+std::string brotliCompress(const char *data, const size_t ndata, int quality)
 {
     std::string ret;
     if (ndata == 0)
         return ret;
     ret.resize(BrotliEncoderMaxCompressedSize(ndata));
     size_t encodedSize{ret.size()};
-    auto r = BrotliEncoderCompress(5,
+    auto r = BrotliEncoderCompress(quality,
                                    BROTLI_DEFAULT_WINDOW,
                                    BROTLI_DEFAULT_MODE,
                                    ndata,
@@ -1265,6 +1278,15 @@ std::string brotliCompress(const char * /*data*/, const size_t /*ndata*/)
     abort();
 }
 
+std::string brotliCompress(const char * /*data*/,
+                           const size_t /*ndata*/,
+                           int /*quality*/)
+{
+    LOG_ERROR << "If you do not have the brotli package installed, you cannot "
+                 "use brotliCompress()";
+    abort();
+}
+
 std::string brotliDecompress(const char * /*data*/, const size_t /*ndata*/)
 {
     LOG_ERROR << "If you do not have the brotli package installed, you cannot "
@@ -1272,6 +1294,85 @@ std::string brotliDecompress(const char * /*data*/, const size_t /*ndata*/)
     abort();
 }
 #endif
+#ifdef USE_ZSTD
+std::string zstdCompress(const char *data, const size_t ndata)
+{
+    return zstdCompress(data, ndata, ZSTD_CLEVEL_DEFAULT);
+}
+
+std::string zstdCompress(const char *data, const size_t ndata, int level)
+{
+    std::string ret;
+    if (ndata == 0)
+        return ret;
+    ret.resize(ZSTD_compressBound(ndata));
+    auto r = ZSTD_compress(ret.data(), ret.size(), data, ndata, level);
+    if (ZSTD_isError(r))
+    {
+        LOG_ERROR << "ZSTD_compress error: " << ZSTD_getErrorName(r);
+        ret.resize(0);
+    }
+    else
+        ret.resize(r);
+    return ret;
+}
+
+std::string zstdDecompress(const char *data, const size_t ndata)
+{
+    if (ndata == 0)
+        return std::string(data, ndata);
+
+    auto s = ZSTD_createDStream();
+    std::string decompressed(ZSTD_DStreamOutSize(), 0);
+    ZSTD_inBuffer input{data, ndata, 0};
+    size_t totalOut{0};
+    while (true)
+    {
+        if (totalOut == decompressed.size())
+            decompressed.resize(totalOut * 2);
+        ZSTD_outBuffer output{decompressed.data() + totalOut,
+                              decompressed.size() - totalOut,
+                              0};
+        auto r = ZSTD_decompressStream(s, &output, &input);
+        totalOut += output.pos;
+        if (ZSTD_isError(r))
+        {
+            totalOut = 0;
+            break;
+        }
+        // Done when the frame is complete, or when all the input is consumed
+        // and the decoder has no more output to give
+        if (r == 0 || (input.pos == input.size && output.pos < output.size))
+            break;
+    }
+    ZSTD_freeDStream(s);
+    decompressed.resize(totalOut);
+    return decompressed;
+}
+#else
+std::string zstdCompress(const char * /*data*/, const size_t /*ndata*/)
+{
+    LOG_ERROR << "If you do not have the zstd package installed, you cannot "
+                 "use zstdCompress()";
+    abort();
+}
+
+std::string zstdCompress(const char * /*data*/,
+                         const size_t /*ndata*/,
+                         int /*level*/)
+{
+    LOG_ERROR << "If you do not have the zstd package installed, you cannot "
+                 "use zstdCompress()";
+    abort();
+}
+
+std::string zstdDecompress(const char * /*data*/, const size_t /*ndata*/)
+{
+    LOG_ERROR << "If you do not have the zstd package installed, you cannot "
+                 "use zstdDecompress()";
+    abort();
+}
+#endif
 
 std::string getMd5(const char *data, const size_t dataLen)
 {
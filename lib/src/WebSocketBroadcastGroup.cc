@@ -0,0 +1,336 @@
+/**
+ *
+ *  @file WebSocketBroadcastGroup.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/WebSocketBroadcastGroup.h>
+#include "WebSocketConnectionImpl.h"
+#include <trantor/utils/Logger.h>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+struct BroadcastMessage
+{
+    // The frame of the uncompressed message, shared by the connections
+    std::shared_ptr<std::string> frame;
+    size_t headerLength;
+    WebSocketMessageType type;
+
+    const char *payload() const
+    {
+        return frame->data() + headerLength;
+    }
+
+    size_t length() const
+    {
+        return frame->length() - headerLength;
+    }
+};
+
+using BroadcastMessagePtr = std::shared_ptr<const BroadcastMessage>;
+
+// The compressed frames of a message, for each set of compression
+// parameters
+using CompressedFrames =
+    std::vector<std::pair<const WebSocketDeflater *,
+                          std::shared_ptr<std::string>>>;
+}  // namespace
+
+struct WebSocketBroadcastGroup::LoopGroup
+    : public std::enable_shared_from_this<LoopGroup>
+{
+    struct Member
+    {
+        WebSocketConnectionImplPtr conn;
+        // The last message skipped with the kCoalesce policy
+        BroadcastMessagePtr coalesced;
+    };
+
+    LoopGroup(trantor::EventLoop *eventLoop, const Options &groupOptions)
+        : loop(eventLoop), options(groupOptions)
+    {
+    }
+
+    void deliver(const BroadcastMessagePtr &message);
+    void send(Member &member,
+              const BroadcastMessage &message,
+              CompressedFrames &compressedFrames);
+    void sendCoalesced();
+
+    trantor::EventLoop *loop;
+    Options options;
+    std::atomic<size_t> size{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> closed{0};
+    // Only used in the loop
+    std::unordered_map<const WebSocketConnectionImpl *, Member> members;
+    trantor::TimerId timerId{trantor::InvalidTimerId};
+};
+
+void WebSocketBroadcastGroup::LoopGroup::deliver(
+    const BroadcastMessagePtr &message)
+{
+    CompressedFrames compressedFrames;
+    for (auto iter = members.begin(); iter != members.end();)
+    {
+        auto &member = iter->second;
+        if (!member.conn->connected())
+        {
+            iter = members.erase(iter);
+            --size;
+            continue;
+        }
+        if (member.conn->pendingBytes() > options.highWaterMark)
+        {
+            if (options.policy == SlowConsumerPolicy::kClose)
+            {
+                LOG_DEBUG << "Close the slow WebSocket connection of "
+                          << member.conn->peerAddr().toIpPort();
+                ++closed;
+                member.conn->forceClose();
+                iter = members.erase(iter);
+                --size;
+                continue;
+            }
+            if (options.policy == SlowConsumerPolicy::kDrop ||
+                member.coalesced)
+                ++dropped;
+            if (options.policy == SlowConsumerPolicy::kCoalesce)
+            {
+                member.coalesced = message;
+                if (timerId == trantor::InvalidTimerId)
+                {
+                    std::weak_ptr<LoopGroup> weakPtr = shared_from_this();
+                    timerId =
+                        loop->runEvery(options.coalesceInterval, [weakPtr]() {
+                            if (auto thisPtr = weakPtr.lock())
+                                thisPtr->sendCoalesced();
+                        });
+                }
+            }
+            ++iter;
+            continue;
+        }
+        if (member.coalesced)
+        {
+            // Replaced by this message
+            member.coalesced.reset();
+            ++dropped;
+        }
+        send(member, *message, compressedFrames);
+        ++iter;
+    }
+}
+
+void WebSocketBroadcastGroup::LoopGroup::send(
+    Member &member,
+    const BroadcastMessage &message,
+    CompressedFrames &compressedFrames)
+{
+    auto &conn = member.conn;
+    auto deflater = conn->deflater();
+    if (deflater && deflater->shouldCompress(message.length()) &&
+        (message.type == WebSocketMessageType::Text ||
+         message.type == WebSocketMessageType::Binary))
+    {
+        if (!deflater->resetsContext())
+        {
+            // The output depends on the previous messages of the connection
+            conn->send(message.payload(), message.length(), message.type);
+            return;
+        }
+        for (auto &compressed : compressedFrames)
+        {
+            if (compressed.first->sameOutput(*deflater))
+            {
+                conn->sendFrame(compressed.second);
+                return;
+            }
+        }
+        auto frame = conn->makeCompressedFrame(message.payload(),
+                                               message.length(),
+                                               message.type);
+        if (frame)
+        {
+            compressedFrames.emplace_back(deflater, frame);
+            conn->sendFrame(frame);
+            return;
+        }
+    }
+    conn->sendFrame(message.frame);
+}
+
+void WebSocketBroadcastGroup::LoopGroup::sendCoalesced()
+{
+    bool waiting{false};
+    for (auto &iter : members)
+    {
+        auto &member = iter.second;
+        if (!member.coalesced || !member.conn->connected())
+            continue;
+        if (member.conn->pendingBytes() > options.highWaterMark)
+        {
+            waiting = true;
+            continue;
+        }
+        auto message = std::move(member.coalesced);
+        // The frames are compressed again, the messages may differ
+        CompressedFrames frames;
+        send(member, *message, frames);
+    }
+    if (!waiting)
+    {
+        loop->invalidateTimer(timerId);
+        timerId = trantor::InvalidTimerId;
+    }
+}
+
+WebSocketBroadcastGroup::WebSocketBroadcastGroup() = default;
+
+WebSocketBroadcastGroup::WebSocketBroadcastGroup(const Options &options)
+    : options_(options)
+{
+}
+
+WebSocketBroadcastGroup::~WebSocketBroadcastGroup()
+{
+    for (auto &iter : loops_)
+    {
+        auto group = iter.second;
+        group->loop->runInLoop([group]() {
+            if (group->timerId != trantor::InvalidTimerId)
+                group->loop->invalidateTimer(group->timerId);
+            group->members.clear();
+        });
+    }
+}
+
+void WebSocketBroadcastGroup::add(const WebSocketConnectionPtr &conn)
+{
+    auto connImpl = std::dynamic_pointer_cast<WebSocketConnectionImpl>(conn);
+    if (!connImpl)
+    {
+        LOG_ERROR << "Only the WebSocket connections of drogon can be added "
+                     "to a broadcast group";
+        return;
+    }
+    if (!connImpl->isServer())
+    {
+        // The shared frames are unmasked, clients must mask theirs
+        LOG_ERROR << "Only the WebSocket connections of the server can be "
+                     "added to a broadcast group";
+        return;
+    }
+    auto loop = connImpl->getLoop();
+    std::shared_ptr<LoopGroup> group;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &loopGroup = loops_[loop];
+        if (!loopGroup)
+            loopGroup = std::make_shared<LoopGroup>(loop, options_);
+        group = loopGroup;
+    }
+    loop->runInLoop([group, connImpl = std::move(connImpl)]() mutable {
+        auto key = connImpl.get();
+        if (group->members
+                .emplace(key, LoopGroup::Member{std::move(connImpl), nullptr})
+                .second)
+            ++group->size;
+    });
+}
+
+void WebSocketBroadcastGroup::remove(const WebSocketConnectionPtr &conn)
+{
+    auto connImpl = std::dynamic_pointer_cast<WebSocketConnectionImpl>(conn);
+    if (!connImpl)
+        return;
+    auto loop = connImpl->getLoop();
+    std::shared_ptr<LoopGroup> group;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iter = loops_.find(loop);
+        if (iter == loops_.end())
+            return;
+        group = iter->second;
+    }
+    loop->runInLoop([group, key = connImpl.get()]() {
+        if (group->members.erase(key) > 0)
+            --group->size;
+    });
+}
+
+size_t WebSocketBroadcastGroup::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t size{0};
+    for (auto &iter : loops_)
+        size += iter.second->size.load(std::memory_order_relaxed);
+    return size;
+}
+
+void WebSocketBroadcastGroup::broadcast(const char *msg,
+                                        uint64_t len,
+                                        WebSocketMessageType type)
+{
+    auto frame = WebSocketConnectionImpl::makeFrame(msg, len, type);
+    auto headerLength = frame->length() - len;
+    auto message = std::make_shared<const BroadcastMessage>(
+        BroadcastMessage{std::move(frame), headerLength, type});
+    std::vector<std::shared_ptr<LoopGroup>> groups;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        groups.reserve(loops_.size());
+        for (auto &iter : loops_)
+            groups.push_back(iter.second);
+    }
+    // One task per loop delivers the message to all its connections
+    for (auto &group : groups)
+    {
+        group->loop->runInLoop(
+            [group, message]() { group->deliver(message); });
+    }
+}
+
+void WebSocketBroadcastGroup::broadcast(std::string_view msg,
+                                        WebSocketMessageType type)
+{
+    broadcast(msg.data(), msg.length(), type);
+}
+
+void WebSocketBroadcastGroup::broadcastJson(const Json::Value &json,
+                                            WebSocketMessageType type)
+{
+    auto msg = WebSocketConnectionImpl::writeJson(json);
+    broadcast(msg.data(), msg.length(), type);
+}
+
+uint64_t WebSocketBroadcastGroup::droppedMessages() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t dropped{0};
+    for (auto &iter : loops_)
+        dropped += iter.second->dropped.load(std::memory_order_relaxed);
+    return dropped;
+}
+
+uint64_t WebSocketBroadcastGroup::closedConnections() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t closed{0};
+    for (auto &iter : loops_)
+        closed += iter.second->closed.load(std::memory_order_relaxed);
+    return closed;
+}
@@ -144,6 +144,11 @@ void WebSocketClientImpl::connectToServerInLoop()
     wsAccept_ = utils::base64Encode(accKey, 20);
 
     upgradeRequest_->addHeader("Sec-WebSocket-Key", wsKey_);
+    if (compressionOptions_)
+    {
+        upgradeRequest_->addHeader("Sec-WebSocket-Extensions",
+                                   makeDeflateOffer(*compressionOptions_));
+    }
     // upgradeRequest_->addHeader("Sec-WebSocket-Version","13");
 
     assert(!tcpClientPtr_);
@@ -248,9 +253,17 @@ void WebSocketClientImpl::onRecvMessage(
         auto resp = responseParser->responseImpl();
         responseParser->reset();
         auto acceptStr = resp->getHeaderBy("sec-websocket-accept");
+        auto &extensions = resp->getHeaderBy("sec-websocket-extensions");
+        WebSocketDeflateParams deflateParams;
+        bool compressionEnabled{false};
 
         if (resp->statusCode() != k101SwitchingProtocols ||
-            acceptStr != wsAccept_)
+            acceptStr != wsAccept_ ||
+            (compressionOptions_ &&
+             !parseDeflateResponse(extensions,
+                                   *compressionOptions_,
+                                   deflateParams,
+                                   compressionEnabled)))
         {
             requestCallback_(ReqResult::BadResponse,
                              nullptr,
@@ -280,6 +293,9 @@ void WebSocketClientImpl::onRecvMessage(
         upgraded_ = true;
         websockConnPtr_ =
             std::make_shared<WebSocketConnectionImpl>(connPtr, false);
+        if (compressionEnabled)
+            websockConnPtr_->enableCompression(*compressionOptions_,
+                                               deflateParams);
         websockConnPtr_->setPingMessage("", std::chrono::seconds{30});
         auto thisPtr = shared_from_this();
         std::weak_ptr<WebSocketClientImpl> weakPtr = thisPtr;
@@ -21,6 +21,7 @@
 #include <trantor/utils/NonCopyable.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 
 namespace drogon
@@ -56,6 +57,11 @@ class WebSocketClientImpl
     void addSSLConfigs(const std::vector<std::pair<std::string, std::string>>
                            &sslConfCmds) override;
 
+    void enableCompression(const WebSocketCompressionOptions &options) override
+    {
+        compressionOptions_ = options;
+    }
+
     trantor::EventLoop *getLoop() override
     {
         return loop_;
@@ -91,6 +97,7 @@ class WebSocketClientImpl
     std::string clientCertPath_;
     std::string clientKeyPath_;
     std::vector<std::pair<std::string, std::string>> sslConfCmds_;
+    std::optional<WebSocketCompressionOptions> compressionOptions_;
 
     HttpRequestPtr upgradeRequest_;
     std::function<void(std::string &&,
@@ -0,0 +1,513 @@
+/**
+ *
+ *  @file WebSocketCompression.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "WebSocketCompression.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+struct Extension
+{
+    std::string name;
+    std::vector<std::pair<std::string, std::optional<std::string>>> params;
+    bool valid{true};
+};
+
+const char deflateName[] = "permessage-deflate";
+// Not in RFC 7692, the peers only use the dictionary when they agree on it
+const char dictionaryParam[] = "drogon_dictionary";
+// The tail of the blocks flushed with Z_SYNC_FLUSH, which is not sent
+const char flushTail[] = {'\x00', '\x00', '\xff', '\xff'};
+const size_t chunkSize = 16 * 1024;
+
+std::string_view trim(std::string_view str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+        str.remove_prefix(1);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+        str.remove_suffix(1);
+    return str;
+}
+
+// Split on the separator outside of the quoted strings
+std::vector<std::string_view> split(std::string_view str, char separator)
+{
+    std::vector<std::string_view> parts;
+    bool quoted{false};
+    size_t start{0};
+    for (size_t i = 0; i < str.length(); ++i)
+    {
+        if (quoted && str[i] == '\\')
+            ++i;
+        else if (str[i] == '"')
+            quoted = !quoted;
+        else if (!quoted && str[i] == separator)
+        {
+            parts.push_back(trim(str.substr(start, i - start)));
+            start = i + 1;
+        }
+    }
+    parts.push_back(trim(str.substr(start)));
+    return parts;
+}
+
+std::string unquote(std::string_view value)
+{
+    if (value.length() < 2 || value.front() != '"' || value.back() != '"')
+        return std::string(value);
+    std::string result;
+    for (size_t i = 1; i + 1 < value.length(); ++i)
+    {
+        if (value[i] == '\\' && i + 2 < value.length())
+            ++i;
+        result.push_back(value[i]);
+    }
+    return result;
+}
+
+std::string toLower(std::string_view str)
+{
+    std::string result(str);
+    std::transform(result.begin(), result.end(), result.begin(), [](char c) {
+        return static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    });
+    return result;
+}
+
+std::vector<Extension> parseExtensions(std::string_view header)
+{
+    std::vector<Extension> extensions;
+    for (auto element : split(header, ','))
+    {
+        if (element.empty())
+            continue;
+        auto parts = split(element, ';');
+        Extension extension;
+        extension.name = toLower(parts[0]);
+        extension.valid = !extension.name.empty();
+        for (size_t i = 1; i < parts.size(); ++i)
+        {
+            auto pos = parts[i].find('=');
+            auto name = toLower(trim(parts[i].substr(0, pos)));
+            if (name.empty())
+                extension.valid = false;
+            std::optional<std::string> value;
+            if (pos != std::string_view::npos)
+                value = unquote(trim(parts[i].substr(pos + 1)));
+            extension.params.emplace_back(std::move(name), std::move(value));
+        }
+        extensions.push_back(std::move(extension));
+    }
+    return extensions;
+}
+
+// The window bits 8 to 15, 0 if the value is invalid
+int parseWindowBits(const std::string &value)
+{
+    if (value.empty() || value.length() > 2 ||
+        !std::all_of(value.begin(), value.end(), [](char c) {
+            return c >= '0' && c <= '9';
+        }))
+        return 0;
+    auto bits = std::stoi(value);
+    return bits >= 8 && bits <= 15 ? bits : 0;
+}
+
+std::string dictionaryId(const std::string &dictionary)
+{
+    return utils::getMd5(dictionary).substr(0, 16);
+}
+}  // namespace
+
+std::string drogon::makeDeflateOffer(const WebSocketCompressionOptions &options)
+{
+    std::string offer = deflateName;
+    if (!options.serverContextTakeover)
+        offer.append("; server_no_context_takeover");
+    if (!options.clientContextTakeover)
+        offer.append("; client_no_context_takeover");
+    if (options.serverMaxWindowBits < 15)
+    {
+        offer.append("; server_max_window_bits=")
+            .append(std::to_string(options.serverMaxWindowBits));
+    }
+    offer.append("; client_max_window_bits");
+    if (options.clientMaxWindowBits < 15)
+        offer.append("=").append(std::to_string(options.clientMaxWindowBits));
+    if (options.dictionary.empty())
+        return offer;
+    // Servers which do not know the dictionary accept the second offer
+    return offer + "; " + dictionaryParam + "=" +
+           dictionaryId(options.dictionary) + ", " + offer;
+}
+
+bool drogon::acceptDeflateOffer(std::string_view offers,
+                                const WebSocketCompressionOptions &options,
+                                WebSocketDeflateParams &params,
+                                std::string &response)
+{
+    for (auto &offer : parseExtensions(offers))
+    {
+        if (offer.name != deflateName || !offer.valid)
+            continue;
+        bool valid{true};
+        bool serverNoContextTakeover{false};
+        bool clientNoContextTakeover{false};
+        int serverBits{0};
+        bool clientBitsOffered{false};
+        int clientBits{15};
+        bool useDictionary{false};
+        std::set<std::string> seen;
+        for (auto &[name, value] : offer.params)
+        {
+            if (!seen.insert(name).second)
+            {
+                valid = false;
+            }
+            else if (name == "server_no_context_takeover")
+            {
+                serverNoContextTakeover = true;
+                valid = valid && !value;
+            }
+            else if (name == "client_no_context_takeover")
+            {
+                clientNoContextTakeover = true;
+                valid = valid && !value;
+            }
+            else if (name == "server_max_window_bits")
+            {
+                serverBits = value ? parseWindowBits(*value) : 0;
+                valid = valid && serverBits != 0;
+            }
+            else if (name == "client_max_window_bits")
+            {
+                clientBitsOffered = true;
+                if (value)
+                {
+                    clientBits = parseWindowBits(*value);
+                    valid = valid && clientBits != 0;
+                }
+            }
+            else if (name == dictionaryParam)
+            {
+                useDictionary = true;
+                valid = valid && value && !options.dictionary.empty() &&
+                        *value == dictionaryId(options.dictionary);
+            }
+            else
+            {
+                valid = false;
+            }
+        }
+        if (!valid)
+            continue;
+
+        params.serverNoContextTakeover =
+            serverNoContextTakeover || !options.serverContextTakeover;
+        params.clientNoContextTakeover =
+            clientNoContextTakeover || !options.clientContextTakeover;
+        params.serverMaxWindowBits =
+            (std::min)(serverBits ? serverBits : 15,
+                       options.serverMaxWindowBits);
+        // The window of the client can only be limited when it offers to
+        params.clientMaxWindowBits =
+            clientBitsOffered
+                ? (std::min)(clientBits, options.clientMaxWindowBits)
+                : 15;
+        params.useDictionary = useDictionary;
+
+        response = deflateName;
+        if (params.serverNoContextTakeover)
+            response.append("; server_no_context_takeover");
+        if (params.clientNoContextTakeover)
+            response.append("; client_no_context_takeover");
+        if (serverBits || params.serverMaxWindowBits < 15)
+        {
+            response.append("; server_max_window_bits=")
+                .append(std::to_string(params.serverMaxWindowBits));
+        }
+        if (params.clientMaxWindowBits < 15)
+        {
+            response.append("; client_max_window_bits=")
+                .append(std::to_string(params.clientMaxWindowBits));
+        }
+        if (useDictionary)
+        {
+            response.append("; ")
+                .append(dictionaryParam)
+                .append("=")
+                .append(dictionaryId(options.dictionary));
+        }
+        return true;
+    }
+    return false;
+}
+
+bool drogon::parseDeflateResponse(std::string_view response,
+                                  const WebSocketCompressionOptions &options,
+                                  WebSocketDeflateParams &params,
+                                  bool &enabled)
+{
+    enabled = false;
+    auto extensions = parseExtensions(response);
+    if (extensions.empty())
+        return true;
+    // Only permessage-deflate was offered
+    if (extensions.size() > 1 || extensions[0].name != deflateName ||
+        !extensions[0].valid)
+        return false;
+
+    WebSocketDeflateParams result;
+    bool serverBitsReceived{false};
+    std::set<std::string> seen;
+    for (auto &[name, value] : extensions[0].params)
+    {
+        if (!seen.insert(name).second)
+            return false;
+        if (name == "server_no_context_takeover")
+        {
+            if (value)
+                return false;
+            result.serverNoContextTakeover = true;
+        }
+        else if (name == "client_no_context_takeover")
+        {
+            if (value)
+                return false;
+            result.clientNoContextTakeover = true;
+        }
+        else if (name == "server_max_window_bits")
+        {
+            result.serverMaxWindowBits = value ? parseWindowBits(*value) : 0;
+            if (result.serverMaxWindowBits == 0 ||
+                result.serverMaxWindowBits > options.serverMaxWindowBits)
+                return false;
+            serverBitsReceived = true;
+        }
+        else if (name == "client_max_window_bits")
+        {
+            result.clientMaxWindowBits = value ? parseWindowBits(*value) : 0;
+            if (result.clientMaxWindowBits == 0)
+                return false;
+        }
+        else if (name == dictionaryParam)
+        {
+            if (!value || options.dictionary.empty() ||
+                *value != dictionaryId(options.dictionary))
+                return false;
+            result.useDictionary = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    // The server must accept the parameters offered for its side
+    if ((!options.serverContextTakeover && !result.serverNoContextTakeover) ||
+        (options.serverMaxWindowBits < 15 && !serverBitsReceived))
+        return false;
+    if (!options.clientContextTakeover)
+        result.clientNoContextTakeover = true;
+    result.clientMaxWindowBits =
+        (std::min)(result.clientMaxWindowBits, options.clientMaxWindowBits);
+    params = result;
+    enabled = true;
+    return true;
+}
+
+WebSocketDeflater::WebSocketDeflater(const WebSocketCompressionOptions &options,
+                                     const WebSocketDeflateParams &params,
+                                     bool isServer)
+    : memLevel_(options.memLevel),
+      level_(options.compressionLevel),
+      minSize_(options.minSize)
+{
+    windowBits_ =
+        isServer ? params.serverMaxWindowBits : params.clientMaxWindowBits;
+    resetDeflate_ = isServer ? params.serverNoContextTakeover
+                             : params.clientNoContextTakeover;
+    resetInflate_ = isServer ? params.clientNoContextTakeover
+                             : params.serverNoContextTakeover;
+    // zlib does not support raw deflate streams with a window of 8 bits, the
+    // messages are sent uncompressed, which is always allowed.
+    compressionEnabled_ = windowBits_ > 8;
+    if (params.useDictionary)
+        dictionary_ = options.dictionary;
+}
+
+WebSocketDeflater::~WebSocketDeflater()
+{
+    if (deflateReady_)
+        deflateEnd(&deflateStream_);
+    if (inflateReady_)
+        inflateEnd(&inflateStream_);
+}
+
+bool WebSocketDeflater::compress(const char *data,
+                                 size_t length,
+                                 std::string &output)
+{
+    if (!deflateReady_)
+    {
+        if (deflateInit2(&deflateStream_,
+                         level_,
+                         Z_DEFLATED,
+                         -windowBits_,
+                         memLevel_,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            LOG_ERROR << "Failed to initialize the WebSocket compressor";
+            compressionEnabled_ = false;
+            return false;
+        }
+        deflateReady_ = true;
+        if (!dictionary_.empty())
+        {
+            deflateSetDictionary(
+                &deflateStream_,
+                reinterpret_cast<const Bytef *>(dictionary_.data()),
+                static_cast<uInt>(dictionary_.length()));
+        }
+    }
+    output.clear();
+    deflateStream_.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    deflateStream_.avail_in = static_cast<uInt>(length);
+    do
+    {
+        auto size = output.size();
+        auto chunk = (std::max)(chunkSize, length / 2 + 16);
+        output.resize(size + chunk);
+        deflateStream_.next_out = reinterpret_cast<Bytef *>(&output[size]);
+        deflateStream_.avail_out = static_cast<uInt>(chunk);
+        auto ret = deflate(&deflateStream_, Z_SYNC_FLUSH);
+        output.resize(size + chunk - deflateStream_.avail_out);
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            LOG_ERROR << "Failed to compress a WebSocket message: " << ret;
+            return false;
+        }
+    } while (deflateStream_.avail_out == 0);
+
+    if (output.size() >= sizeof(flushTail) &&
+        output.compare(output.size() - sizeof(flushTail),
+                       sizeof(flushTail),
+                       flushTail,
+                       sizeof(flushTail)) == 0)
+        output.resize(output.size() - sizeof(flushTail));
+    // An empty message is sent as an empty stored block
+    if (output.empty())
+        output.push_back('\0');
+    if (resetDeflate_)
+    {
+        deflateReset(&deflateStream_);
+        if (!dictionary_.empty())
+        {
+            deflateSetDictionary(
+                &deflateStream_,
+                reinterpret_cast<const Bytef *>(dictionary_.data()),
+                static_cast<uInt>(dictionary_.length()));
+        }
+    }
+    return true;
+}
+
+bool WebSocketDeflater::decompress(const char *data,
+                                   size_t length,
+                                   std::string &output,
+                                   size_t maxSize)
+{
+    if (!inflateReady_)
+    {
+        // The peer may use any window up to the agreed one
+        if (inflateInit2(&inflateStream_, -15) != Z_OK)
+        {
+            LOG_ERROR << "Failed to initialize the WebSocket decompressor";
+            return false;
+        }
+        inflateReady_ = true;
+        if (!dictionary_.empty())
+        {
+            inflateSetDictionary(
+                &inflateStream_,
+                reinterpret_cast<const Bytef *>(dictionary_.data()),
+                static_cast<uInt>(dictionary_.length()));
+        }
+    }
+    output.clear();
+    if (!inflateInput(data, length, output, maxSize) ||
+        !inflateInput(flushTail, sizeof(flushTail), output, maxSize))
+    {
+        // The stream is unusable, the connection is closed
+        return false;
+    }
+    if (resetInflate_)
+    {
+        inflateReset(&inflateStream_);
+        if (!dictionary_.empty())
+        {
+            inflateSetDictionary(
+                &inflateStream_,
+                reinterpret_cast<const Bytef *>(dictionary_.data()),
+                static_cast<uInt>(dictionary_.length()));
+        }
+    }
+    return true;
+}
+
+bool WebSocketDeflater::inflateInput(const char *data,
+                                     size_t length,
+                                     std::string &output,
+                                     size_t maxSize)
+{
+    inflateStream_.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    inflateStream_.avail_in = static_cast<uInt>(length);
+    while (true)
+    {
+        auto size = output.size();
+        auto chunk = (std::max)(chunkSize, length * 2);
+        output.resize(size + chunk);
+        inflateStream_.next_out = reinterpret_cast<Bytef *>(&output[size]);
+        inflateStream_.avail_out = static_cast<uInt>(chunk);
+        auto ret = inflate(&inflateStream_, Z_SYNC_FLUSH);
+        output.resize(size + chunk - inflateStream_.avail_out);
+        if (ret == Z_STREAM_END)
+        {
+            // A final block ends the context, the next one starts a new one
+            inflateReset(&inflateStream_);
+            if (!dictionary_.empty())
+            {
+                inflateSetDictionary(
+                    &inflateStream_,
+                    reinterpret_cast<const Bytef *>(dictionary_.data()),
+                    static_cast<uInt>(dictionary_.length()));
+            }
+            return output.size() <= maxSize;
+        }
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+            return false;
+        if (output.size() > maxSize)
+            return false;
+        if (inflateStream_.avail_out != 0)
+            return true;
+    }
+}
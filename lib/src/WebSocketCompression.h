@@ -0,0 +1,129 @@
+/**
+ *
+ *  @file WebSocketCompression.h
+ *  The negotiation and the compressors of permessage-deflate (RFC 7692)
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/WebSocketCompression.h>
+#include <trantor/utils/NonCopyable.h>
+#include <zlib.h>
+#include <string>
+#include <string_view>
+
+namespace drogon
+{
+/// The parameters of permessage-deflate agreed in the handshake
+struct WebSocketDeflateParams
+{
+    // The server (the client) resets its compressor after each message
+    bool serverNoContextTakeover{false};
+    bool clientNoContextTakeover{false};
+    int serverMaxWindowBits{15};
+    int clientMaxWindowBits{15};
+    bool useDictionary{false};
+};
+
+/// The Sec-WebSocket-Extensions header of the upgrade request of a client
+std::string makeDeflateOffer(const WebSocketCompressionOptions &options);
+
+/**
+ * @brief Choose the first acceptable permessage-deflate offer of the
+ * Sec-WebSocket-Extensions header of a client.
+ *
+ * @return false if there is none, otherwise the parameters and the
+ * Sec-WebSocket-Extensions header of the response are set.
+ */
+bool acceptDeflateOffer(std::string_view offers,
+                        const WebSocketCompressionOptions &options,
+                        WebSocketDeflateParams &params,
+                        std::string &response);
+
+/**
+ * @brief Check the Sec-WebSocket-Extensions header of the response of the
+ * server to the offer of the client.
+ *
+ * @return false if the response is invalid and the connection must fail.
+ * Otherwise enabled is set to whether the server accepted the offer, and the
+ * parameters are set when it did.
+ */
+bool parseDeflateResponse(std::string_view response,
+                          const WebSocketCompressionOptions &options,
+                          WebSocketDeflateParams &params,
+                          bool &enabled);
+
+/**
+ * @brief The compressor of the messages sent and the decompressor of the
+ * messages received on a connection. The streams are created on first use.
+ */
+class WebSocketDeflater : public trantor::NonCopyable
+{
+  public:
+    WebSocketDeflater(const WebSocketCompressionOptions &options,
+                      const WebSocketDeflateParams &params,
+                      bool isServer);
+    ~WebSocketDeflater();
+
+    /// Whether a message of this length is sent compressed
+    bool shouldCompress(size_t length) const
+    {
+        return compressionEnabled_ && length >= minSize_;
+    }
+
+    /// Whether the compressor is reset after each message, its output then
+    /// only depends on the message
+    bool resetsContext() const
+    {
+        return resetDeflate_;
+    }
+
+    /// Whether the compressors compress the messages to the same data, when
+    /// both reset their context
+    bool sameOutput(const WebSocketDeflater &other) const
+    {
+        return resetDeflate_ && other.resetDeflate_ &&
+               windowBits_ == other.windowBits_ &&
+               memLevel_ == other.memLevel_ && level_ == other.level_ &&
+               dictionary_ == other.dictionary_;
+    }
+
+    /// Compress the payload of a message, false on zlib errors
+    bool compress(const char *data, size_t length, std::string &output);
+
+    /// Decompress the payload of a message, false on corrupt data or when
+    /// the message is larger than maxSize
+    bool decompress(const char *data,
+                    size_t length,
+                    std::string &output,
+                    size_t maxSize);
+
+  private:
+    bool inflateInput(const char *data,
+                      size_t length,
+                      std::string &output,
+                      size_t maxSize);
+
+    z_stream deflateStream_{};
+    z_stream inflateStream_{};
+    bool deflateReady_{false};
+    bool inflateReady_{false};
+    bool compressionEnabled_{true};
+    // Reset the compressor (the decompressor) after each message
+    bool resetDeflate_{false};
+    bool resetInflate_{false};
+    int windowBits_{15};
+    int memLevel_{8};
+    int level_{Z_DEFAULT_COMPRESSION};
+    size_t minSize_{0};
+    std::string dictionary_;
+};
+}  // namespace drogon
@@ -14,6 +14,7 @@
 
 #include "WebSocketConnectionImpl.h"
 #include "HttpAppFrameworkImpl.h"
+#include "utils/WebSocketMask.h"
 #include <json/value.h>
 #include <json/writer.h>
 #include <thread>
@@ -28,8 +29,16 @@ WebSocketConnectionImpl::WebSocketConnectionImpl(
       localAddr_(conn->localAddr()),
       peerAddr_(conn->peerAddr()),
       isServer_(isServer),
-      usingMask_(false)
+      usingMask_(false),
+      sendQueue_(std::make_shared<SendQueue>(conn))
 {
+    sendQueue_->setSender([this](const std::string &message, int type) {
+        auto messageType = static_cast<WebSocketMessageType>(type);
+        sendMessage(message.data(),
+                    message.length(),
+                    toOpcode(messageType, message.length()));
+    });
+    sendQueue_->watchWrites();
 }
 
 WebSocketConnectionImpl::~WebSocketConnectionImpl()
@@ -37,82 +46,165 @@ WebSocketConnectionImpl::~WebSocketConnectionImpl()
     shutdown();
 }
 
-void WebSocketConnectionImpl::send(const char *msg,
-                                   uint64_t len,
-                                   const WebSocketMessageType type)
+unsigned char WebSocketConnectionImpl::toOpcode(WebSocketMessageType type,
+                                                uint64_t len)
 {
-    unsigned char opcode;
+    (void)len;
     if (type == WebSocketMessageType::Text)
-        opcode = 1;
+        return 1;
     else if (type == WebSocketMessageType::Binary)
-        opcode = 2;
+        return 2;
     else if (type == WebSocketMessageType::Close)
     {
         assert(len <= 125);
-        opcode = 8;
+        return 8;
     }
     else if (type == WebSocketMessageType::Ping)
     {
         assert(len <= 125);
-        opcode = 9;
+        return 9;
     }
     else if (type == WebSocketMessageType::Pong)
     {
         assert(len <= 125);
-        opcode = 10;
+        return 10;
     }
-    else
+    assert(0);
+    return 0;
+}
+
+void WebSocketConnectionImpl::send(const char *msg,
+                                   uint64_t len,
+                                   const WebSocketMessageType type)
+{
+    auto opcode = toOpcode(type, len);
+    // The control frames are not limited
+    if (opcode <= 2 &&
+        sendQueue_->admit(msg, len, static_cast<int>(type)) !=
+            SendQueue::Admission::kSend)
+        return;
+    sendMessage(msg, len, opcode);
+}
+
+void WebSocketConnectionImpl::sendMessage(const char *msg,
+                                          uint64_t len,
+                                          unsigned char opcode)
+{
+    if (deflater_ && opcode <= 2 && deflater_->shouldCompress(len))
     {
-        opcode = 0;
-        assert(0);
+        std::string compressed;
+        std::lock_guard<std::mutex> lock(deflateMutex_);
+        if (deflater_->compress(msg, len, compressed))
+        {
+            // The frames are sent in the order of the compression
+            sendWsData(compressed.data(), compressed.length(), opcode, true);
+            return;
+        }
     }
     sendWsData(msg, len, opcode);
 }
 
-void WebSocketConnectionImpl::sendWsData(const char *msg,
-                                         uint64_t len,
-                                         unsigned char opcode)
+std::shared_ptr<std::string> WebSocketConnectionImpl::makeFrame(
+    const char *msg,
+    uint64_t len,
+    WebSocketMessageType type,
+    bool compressed)
 {
-    LOG_TRACE << "send " << len << " bytes";
+    char header[14];
+    auto headerLen =
+        formatFrameHeader(header, len, toOpcode(type, len), compressed, false);
+    auto frame = std::make_shared<std::string>();
+    frame->reserve(headerLen + len);
+    frame->append(header, headerLen).append(msg, len);
+    return frame;
+}
 
-    // Format the frame
-    std::string bytesFormatted;
-    bytesFormatted.resize(len + 10);
-    bytesFormatted[0] = char(0x80 | (opcode & 0x0f));
+std::shared_ptr<std::string> WebSocketConnectionImpl::makeCompressedFrame(
+    const char *msg,
+    uint64_t len,
+    WebSocketMessageType type)
+{
+    if (!deflater_ || !deflater_->shouldCompress(len))
+        return nullptr;
+    std::string compressed;
+    {
+        std::lock_guard<std::mutex> lock(deflateMutex_);
+        if (!deflater_->compress(msg, len, compressed))
+            return nullptr;
+    }
+    return makeFrame(compressed.data(), compressed.length(), type, true);
+}
+
+void WebSocketConnectionImpl::sendFrame(
+    const std::shared_ptr<std::string> &frame)
+{
+    sendQueue_->addQueued(frame->length());
+    tcpConnectionPtr_->send(frame);
+}
+
+void WebSocketConnectionImpl::enableCompression(
+    const WebSocketCompressionOptions &options,
+    const WebSocketDeflateParams &params)
+{
+    deflater_ = std::make_unique<WebSocketDeflater>(options, params, isServer_);
+    parser_.enableCompression();
+}
 
-    int indexStartRawData = -1;
+// The payloads from this size are not copied into the frames sent from the
+// loop. Smaller ones are sent with the header in one write, the payload of a
+// second write shorter than a segment would wait for the ACK of the header
+// with the Nagle algorithm.
+static const uint64_t zeroCopySize = 64 * 1024;
 
+size_t WebSocketConnectionImpl::formatFrameHeader(char *header,
+                                                  uint64_t len,
+                                                  unsigned char opcode,
+                                                  bool compressed,
+                                                  bool masked)
+{
+    header[0] = char(0x80 | (compressed ? 0x40 : 0) | (opcode & 0x0f));
+    size_t headerLen;
     if (len <= 125)
     {
-        bytesFormatted[1] = static_cast<char>(len);
-        indexStartRawData = 2;
+        header[1] = static_cast<char>(len);
+        headerLen = 2;
     }
     else if (len <= 65535)
     {
-        bytesFormatted[1] = 126;
-        bytesFormatted[2] = ((len >> 8) & 255);
-        bytesFormatted[3] = ((len) & 255);
-        LOG_TRACE << "bytes[2]=" << (size_t)bytesFormatted[2];
-        LOG_TRACE << "bytes[3]=" << (size_t)bytesFormatted[3];
-        indexStartRawData = 4;
+        header[1] = 126;
+        header[2] = static_cast<char>((len >> 8) & 255);
+        header[3] = static_cast<char>(len & 255);
+        headerLen = 4;
     }
     else
     {
-        bytesFormatted[1] = 127;
-        bytesFormatted[2] = ((len >> 56) & 255);
-        bytesFormatted[3] = ((len >> 48) & 255);
-        bytesFormatted[4] = ((len >> 40) & 255);
-        bytesFormatted[5] = ((len >> 32) & 255);
-        bytesFormatted[6] = ((len >> 24) & 255);
-        bytesFormatted[7] = ((len >> 16) & 255);
-        bytesFormatted[8] = ((len >> 8) & 255);
-        bytesFormatted[9] = ((len) & 255);
-
-        indexStartRawData = 10;
+        header[1] = 127;
+        for (int i = 0; i < 8; ++i)
+            header[2 + i] = static_cast<char>((len >> (56 - 8 * i)) & 255);
+        headerLen = 10;
+    }
+    if (masked)
+    {
+        header[1] = static_cast<char>(header[1] | 0x80);
+        headerLen += 4;
     }
+    return headerLen;
+}
+
+void WebSocketConnectionImpl::sendWsData(const char *msg,
+                                         uint64_t len,
+                                         unsigned char opcode,
+                                         bool compressed)
+{
+    LOG_TRACE << "send " << len << " bytes";
+
+    char header[14];
+    auto headerLen =
+        formatFrameHeader(header, len, opcode, compressed, !isServer_);
+    sendQueue_->addQueued(headerLen + len);
     if (!isServer_)
     {
-        int random;
+        uint32_t random;
         // Use the cached randomness if no one else is also using it. Otherwise
         // generate one from scratch.
         if (!usingMask_.exchange(true, std::memory_order_acq_rel))
@@ -144,22 +236,32 @@ void WebSocketConnectionImpl::sendWsData(const char *msg,
                 abort();
             }
         }
+        memcpy(&header[headerLen - 4], &random, sizeof(random));
 
-        bytesFormatted[1] = (bytesFormatted[1] | 0x80);
-        bytesFormatted.resize(indexStartRawData + 4 + len);
-        memcpy(&bytesFormatted[indexStartRawData], &random, sizeof(random));
-        for (size_t i = 0; i < len; ++i)
-        {
-            bytesFormatted[indexStartRawData + 4 + i] =
-                (msg[i] ^ bytesFormatted[indexStartRawData + (i % 4)]);
-        }
+        // The payload is masked while it is copied into the frame
+        std::string frame;
+        frame.resize(headerLen + len);
+        memcpy(&frame[0], header, headerLen);
+        utils::maskWebSocketData(
+            &frame[headerLen],
+            msg,
+            len,
+            reinterpret_cast<const unsigned char *>(&header[headerLen - 4]));
+        tcpConnectionPtr_->send(std::move(frame));
+        return;
     }
-    else
+    if (len >= zeroCopySize && tcpConnectionPtr_->getLoop()->isInLoopThread())
     {
-        bytesFormatted.resize(indexStartRawData);
-        bytesFormatted.append(msg, len);
+        // Nothing can be sent between the two parts in the loop. The
+        // connection writes the payload to the socket or copies what it can't.
+        tcpConnectionPtr_->send(header, headerLen);
+        tcpConnectionPtr_->send(msg, len);
+        return;
     }
-    tcpConnectionPtr_->send(std::move(bytesFormatted));
+    std::string frame;
+    frame.reserve(headerLen + len);
+    frame.append(header, headerLen).append(msg, len);
+    tcpConnectionPtr_->send(std::move(frame));
 }
 
 void WebSocketConnectionImpl::send(const std::string_view msg,
@@ -170,6 +272,12 @@ void WebSocketConnectionImpl::send(const std::string_view msg,
 
 void WebSocketConnectionImpl::sendJson(const Json::Value &json,
                                        const WebSocketMessageType type)
+{
+    auto msg = writeJson(json);
+    send(msg.data(), msg.length(), type);
+}
+
+std::string WebSocketConnectionImpl::writeJson(const Json::Value &json)
 {
     static std::once_flag once;
     static Json::StreamWriterBuilder builder;
@@ -187,8 +295,7 @@ void WebSocketConnectionImpl::sendJson(const Json::Value &json,
             builder["precisionType"] = precision.second;
         }
     });
-    auto msg = writeString(builder, json);
-    send(msg.data(), msg.length(), type);
+    return writeString(builder, json);
 }
 
 const trantor::InetAddress &WebSocketConnectionImpl::localAddr() const
@@ -216,6 +323,8 @@ void WebSocketConnectionImpl::WebSocketConnectionImpl::shutdown(
     const std::string &reason)
 {
     tcpConnectionPtr_->getLoop()->invalidateTimer(pingTimerId_);
+    // Nothing is sent after the close frame
+    sendQueue_->stop(true);
     if (!tcpConnectionPtr_->connected())
         return;
     std::string message;
@@ -309,6 +418,16 @@ bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
             LOG_ERROR << "Bad frame: all control frames MUST NOT be fragmented";
             return false;
         }
+        // rfc7692-6: only the first frame of a data message is marked
+        bool isCompressed = (((*buffer)[0] & 0x40) == 0x40);
+        if (isCompressed &&
+            (!compressionEnabled_ || opcode == 0 || isControlFrame))
+        {
+            LOG_ERROR << "Bad frame: unexpected RSV1 bit";
+            return false;
+        }
+        if (opcode == 1 || opcode == 2)
+            compressed_ = isCompressed;
         auto secondByte = (*buffer)[1];
         size_t length = secondByte & 127;
         int isMasked = (secondByte & 0x80);
@@ -384,15 +503,19 @@ bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
                 auto indexFirstDataByte = indexFirstMask + 4;
                 auto rawData = buffer->peek() + indexFirstDataByte;
                 auto oldLen = message_.length();
-                message_.resize(oldLen + length);
-                for (size_t i = 0; i < length; ++i)
-                {
-                    message_[oldLen + i] = (rawData[i] ^ masks[i % 4]);
-                }
+                // Unmask in place, appending copies the data without
+                // filling the string first
+                message_.append(rawData, length);
+                utils::maskWebSocketData(
+                    &message_[oldLen],
+                    &message_[oldLen],
+                    length,
+                    reinterpret_cast<const unsigned char *>(masks));
                 buffer->retrieve(indexFirstMask + 4 + length);
                 if (isFin)
                 {
                     gotAll_ = true;
+                    messageCompressed_ = !isControlFrame && compressed_;
                     return true;
                 }
             }
@@ -412,6 +535,7 @@ bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
                 if (isFin)
                 {
                     gotAll_ = true;
+                    messageCompressed_ = !isControlFrame && compressed_;
                     return true;
                 }
             }
@@ -439,6 +563,28 @@ void WebSocketConnectionImpl::onNewMessage(
             WebSocketMessageType type;
             if (parser_.gotAll(message, type))
             {
+                if (parser_.compressed())
+                {
+                    // The size of the messages of the clients is limited
+                    auto maxSize =
+                        isServer_ ? HttpAppFrameworkImpl::instance()
+                                        .getClientMaxWebSocketMessageSize()
+                                  : (std::numeric_limits<size_t>::max)();
+                    std::string decompressed;
+                    if (!deflater_->decompress(message.data(),
+                                               message.length(),
+                                               decompressed,
+                                               maxSize))
+                    {
+                        LOG_ERROR << "Failed to decompress a WebSocket "
+                                     "message";
+                        shutdown(decompressed.size() > maxSize
+                                     ? CloseCode::kMessageTooBig
+                                     : CloseCode::kProtocolError);
+                        return;
+                    }
+                    message.swap(decompressed);
+                }
                 if (type == WebSocketMessageType::Ping)
                 {
                     // ping
@@ -15,8 +15,12 @@
 #pragma once
 
 #include "impl_forwards.h"
+#include "WebSocketCompression.h"
+#include "SendQueue.h"
 #include <drogon/WebSocketConnection.h>
 #include <json/value.h>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/TcpConnection.h>
@@ -41,10 +45,26 @@ class WebSocketMessageParser
         return true;
     }
 
+    /// Whether the last message got was compressed (with the RSV1 bit set)
+    bool compressed() const
+    {
+        return messageCompressed_;
+    }
+
+    /// Accept the frames with the RSV1 bit set once permessage-deflate is
+    /// negotiated
+    void enableCompression()
+    {
+        compressionEnabled_ = true;
+    }
+
   private:
     std::string message_;
     WebSocketMessageType type_;
     bool gotAll_{false};
+    bool compressionEnabled_{false};
+    bool compressed_{false};
+    bool messageCompressed_{false};
 };
 
 class WebSocketConnectionImpl final
@@ -83,6 +103,86 @@ class WebSocketConnectionImpl final
 
     void disablePing() override;
 
+    void setSendQueueLimits(const SendQueueLimits &limits) override
+    {
+        sendQueue_->setLimits(limits);
+    }
+
+    size_t sendQueueSize() const override
+    {
+        return sendQueue_->size();
+    }
+
+    bool writable() const override
+    {
+        return sendQueue_->writable();
+    }
+
+    void setWritableCallback(const std::function<void()> &callback) override
+    {
+        sendQueue_->setWritableCallback(callback);
+    }
+
+    bool isDrained() const override
+    {
+        return sendQueue_->isDrained();
+    }
+
+    void whenDrained(std::function<void(bool)> &&callback) override
+    {
+        sendQueue_->whenDrained(std::move(callback));
+    }
+
+    uint64_t droppedMessages() const override
+    {
+        return sendQueue_->droppedMessages();
+    }
+
+    trantor::EventLoop *getLoop() const
+    {
+        return tcpConnectionPtr_->getLoop();
+    }
+
+    bool isServer() const
+    {
+        return isServer_;
+    }
+
+    /// The bytes of the frames sent which are not written to the socket yet,
+    /// the handshake response makes it a little lower.
+    size_t pendingBytes() const
+    {
+        return sendQueue_->pendingBytes();
+    }
+
+    /// Send a frame made by makeFrame(), which may be shared by connections
+    void sendFrame(const std::shared_ptr<std::string> &frame);
+
+    /// Make a frame of the server, unmasked
+    static std::shared_ptr<std::string> makeFrame(const char *msg,
+                                                  uint64_t len,
+                                                  WebSocketMessageType type,
+                                                  bool compressed = false);
+
+    /// Make a frame of the message compressed by this connection, nullptr if
+    /// the message is sent uncompressed
+    std::shared_ptr<std::string> makeCompressedFrame(const char *msg,
+                                                     uint64_t len,
+                                                     WebSocketMessageType type);
+
+    const WebSocketDeflater *deflater() const
+    {
+        return deflater_.get();
+    }
+
+    /// Serialize the JSON messages as sendJson() does
+    static std::string writeJson(const Json::Value &json);
+
+    /// Compress the messages with the parameters of permessage-deflate
+    /// negotiated in the handshake, called before any message is sent.
+    void enableCompression(const WebSocketCompressionOptions &options,
+                           const WebSocketDeflateParams &params);
+
     void setMessageCallback(
         const std::function<void(std::string &&,
                                  const WebSocketConnectionImplPtr &,
@@ -104,6 +204,7 @@ class WebSocketConnectionImpl final
     {
         if (pingTimerId_ != trantor::InvalidTimerId)
             tcpConnectionPtr_->getLoop()->invalidateTimer(pingTimerId_);
+        sendQueue_->stop(false);
         closeCallback_(shared_from_this());
     }
 
@@ -116,6 +217,10 @@ class WebSocketConnectionImpl final
     trantor::TimerId pingTimerId_{trantor::InvalidTimerId};
     std::vector<uint32_t> masks_;
     std::atomic<bool> usingMask_;
+    std::shared_ptr<SendQueue> sendQueue_;
+    std::unique_ptr<WebSocketDeflater> deflater_;
+    // The messages are sent from any thread
+    std::mutex deflateMutex_;
 
     std::function<void(std::string &&,
                        const WebSocketConnectionImplPtr &,
@@ -125,7 +230,19 @@ class WebSocketConnectionImpl final
                               const WebSocketMessageType &) {};
     std::function<void(const WebSocketConnectionImplPtr &)> closeCallback_ =
         [](const WebSocketConnectionImplPtr &) {};
-    void sendWsData(const char *msg, uint64_t len, unsigned char opcode);
+    static unsigned char toOpcode(WebSocketMessageType type, uint64_t len);
+    void sendMessage(const char *msg, uint64_t len, unsigned char opcode);
+    // Write the header of a frame of len bytes, the masking key is left to
+    // the caller. Returns the length of the header, 14 bytes at most.
+    static size_t formatFrameHeader(char *header,
+                                    uint64_t len,
+                                    unsigned char opcode,
+                                    bool compressed,
+                                    bool masked);
+    void sendWsData(const char *msg,
+                    uint64_t len,
+                    unsigned char opcode,
+                    bool compressed = false);
     void disablePingInLoop();
     void setPingMessageInLoop(std::string &&message,
                               const std::chrono::duration<double> &interval);
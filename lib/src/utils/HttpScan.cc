@@ -0,0 +1,377 @@
+/**
+ *
+ *  @file HttpScan.cc
+ *  Vectorized delimiter search and character validation for HTTP parsing
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpScan.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define DROGON_HTTP_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+struct CharTable
+{
+    bool reject[256];
+};
+
+constexpr CharTable makeTokenTable()
+{
+    CharTable table{};
+    for (int c = 0; c < 256; ++c)
+    {
+        bool isToken = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+                       (c >= 'A' && c <= 'Z');
+        for (const char *p = "!#$%&'*+-.^_`|~"; *p; ++p)
+        {
+            if (c == *p)
+                isToken = true;
+        }
+        table.reject[c] = !isToken;
+    }
+    return table;
+}
+
+constexpr CharTable makeControlTable()
+{
+    CharTable table{};
+    for (int c = 0; c < 256; ++c)
+    {
+        table.reject[c] = (c < 0x20 && c != '\t') || c == 0x7f;
+    }
+    return table;
+}
+
+constexpr CharTable tokenTable = makeTokenTable();
+constexpr CharTable controlTable = makeControlTable();
+
+// Byte ranges (inclusive pairs) that contain every rejected byte, in the
+// format of the SSE4.2 range comparison. They may contain accepted bytes
+// (e.g. '|' and '~' in 0x7b-0xff), every hit is verified with the table.
+// The arrays are padded to 16 bytes for the unaligned 16 byte load.
+alignas(16) constexpr char tokenRanges[17] =
+    "\x00 "   // control chars and SP
+    "\"\""    // 0x22
+    "()"      // 0x28-0x29
+    ",,"      // 0x2c
+    "//"      // 0x2f
+    ":@"      // 0x3a-0x40
+    "[]"      // 0x5b-0x5d
+    "{\xff";  // 0x7b-0xff
+constexpr int tokenRangesSize = 16;
+alignas(16) constexpr char controlRanges[17] = "\x00\x08\x0a\x1f\x7f\x7f";
+constexpr int controlRangesSize = 6;
+
+using FindCRLF = const char *(*)(const char *, const char *);
+using FindInRanges = const char *(*)(const char *,
+                                     const char *,
+                                     const char *,
+                                     int,
+                                     const CharTable &);
+
+struct Kernels
+{
+    const char *name;
+    FindCRLF findCRLF;
+    FindInRanges findInRanges;
+};
+
+const char *findCRLFScalar(const char *begin, const char *end)
+{
+    while (begin < end)
+    {
+        auto cr = static_cast<const char *>(memchr(begin, '\r', end - begin));
+        if (!cr || cr + 1 == end)
+            return nullptr;
+        if (cr[1] == '\n')
+            return cr;
+        begin = cr + 1;
+    }
+    return nullptr;
+}
+
+const char *findInRangesScalar(const char *begin,
+                               const char *end,
+                               const char *,
+                               int,
+                               const CharTable &table)
+{
+    for (; begin < end; ++begin)
+    {
+        if (table.reject[static_cast<unsigned char>(*begin)])
+            return begin;
+    }
+    return end;
+}
+
+#ifdef DROGON_HTTP_SCAN_X86
+__attribute__((target("sse4.2"))) const char *findCRLFSse42(
+    const char *begin,
+    const char *end)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const char *p = begin;
+    while (end - p >= 16)
+    {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        auto mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, cr)));
+        while (mask)
+        {
+            auto idx = __builtin_ctz(mask);
+            if (p + idx + 1 == end)
+                return nullptr;
+            if (p[idx + 1] == '\n')
+                return p + idx;
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+    return findCRLFScalar(p, end);
+}
+
+__attribute__((target("sse4.2"))) const char *findInRangesSse42(
+    const char *begin,
+    const char *end,
+    const char *ranges,
+    int rangesSize,
+    const CharTable &table)
+{
+    const auto rangesVec =
+        _mm_load_si128(reinterpret_cast<const __m128i *>(ranges));
+    const char *p = begin;
+    while (end - p >= 16)
+    {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int idx = _mm_cmpestri(rangesVec,
+                               rangesSize,
+                               bytes,
+                               16,
+                               _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES |
+                                   _SIDD_UBYTE_OPS);
+        if (idx == 16)
+        {
+            p += 16;
+            continue;
+        }
+        p += idx;
+        if (table.reject[static_cast<unsigned char>(*p)])
+            return p;
+        ++p;
+    }
+    return findInRangesScalar(p, end, ranges, rangesSize, table);
+}
+
+__attribute__((target("avx2"))) const char *findCRLFAvx2(const char *begin,
+                                                         const char *end)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const char *p = begin;
+    while (end - p >= 32)
+    {
+        auto bytes =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        auto mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, cr)));
+        while (mask)
+        {
+            auto idx = __builtin_ctz(mask);
+            if (p + idx + 1 == end)
+                return nullptr;
+            if (p[idx + 1] == '\n')
+                return p + idx;
+            mask &= mask - 1;
+        }
+        p += 32;
+    }
+    // Don't call the SSE kernel here, mixing legacy SSE and AVX code costs a
+    // state transition. The 128 bit intrinsics are VEX encoded in this
+    // function.
+    if (end - p >= 16)
+    {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        auto mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))));
+        while (mask)
+        {
+            auto idx = __builtin_ctz(mask);
+            if (p + idx + 1 == end)
+                return nullptr;
+            if (p[idx + 1] == '\n')
+                return p + idx;
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+    return findCRLFScalar(p, end);
+}
+
+// AVX2 has no string comparison instruction, every range is checked with
+// an unsigned (byte - low) <= (high - low) comparison.
+__attribute__((target("avx2"))) const char *findInRangesAvx2(
+    const char *begin,
+    const char *end,
+    const char *ranges,
+    int rangesSize,
+    const CharTable &table)
+{
+    __m256i lows[8];
+    __m256i spans[8];
+    const int count = rangesSize / 2;
+    for (int i = 0; i < count; ++i)
+    {
+        auto low = static_cast<unsigned char>(ranges[2 * i]);
+        auto high = static_cast<unsigned char>(ranges[2 * i + 1]);
+        lows[i] = _mm256_set1_epi8(static_cast<char>(low));
+        spans[i] = _mm256_set1_epi8(static_cast<char>(high - low));
+    }
+    const char *p = begin;
+    while (end - p >= 32)
+    {
+        auto bytes =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        auto hits = _mm256_setzero_si256();
+        for (int i = 0; i < count; ++i)
+        {
+            auto offset = _mm256_sub_epi8(bytes, lows[i]);
+            hits = _mm256_or_si256(
+                hits,
+                _mm256_cmpeq_epi8(_mm256_min_epu8(offset, spans[i]), offset));
+        }
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        while (mask)
+        {
+            auto idx = __builtin_ctz(mask);
+            if (table.reject[static_cast<unsigned char>(p[idx])])
+                return p + idx;
+            mask &= mask - 1;
+        }
+        p += 32;
+    }
+    if (end - p >= 16)
+    {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        auto hits = _mm_setzero_si128();
+        for (int i = 0; i < count; ++i)
+        {
+            auto offset =
+                _mm_sub_epi8(bytes, _mm256_castsi256_si128(lows[i]));
+            hits = _mm_or_si128(
+                hits,
+                _mm_cmpeq_epi8(
+                    _mm_min_epu8(offset, _mm256_castsi256_si128(spans[i])),
+                    offset));
+        }
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        while (mask)
+        {
+            auto idx = __builtin_ctz(mask);
+            if (table.reject[static_cast<unsigned char>(p[idx])])
+                return p + idx;
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+    return findInRangesScalar(p, end, ranges, rangesSize, table);
+}
+#endif
+
+constexpr Kernels scalarKernels{"scalar", findCRLFScalar, findInRangesScalar};
+#ifdef DROGON_HTTP_SCAN_X86
+constexpr Kernels sse42Kernels{"sse4.2", findCRLFSse42, findInRangesSse42};
+constexpr Kernels avx2Kernels{"avx2", findCRLFAvx2, findInRangesAvx2};
+#endif
+
+const Kernels *selectKernels(const char *name)
+{
+#ifdef DROGON_HTTP_SCAN_X86
+    __builtin_cpu_init();
+    bool hasSse42 = __builtin_cpu_supports("sse4.2");
+    bool hasAvx2 = hasSse42 && __builtin_cpu_supports("avx2");
+    if (!name)
+    {
+        if (hasAvx2)
+            return &avx2Kernels;
+        if (hasSse42)
+            return &sse42Kernels;
+        return &scalarKernels;
+    }
+    if (strcmp(name, avx2Kernels.name) == 0)
+        return hasAvx2 ? &avx2Kernels : nullptr;
+    if (strcmp(name, sse42Kernels.name) == 0)
+        return hasSse42 ? &sse42Kernels : nullptr;
+#endif
+    if (!name || strcmp(name, scalarKernels.name) == 0)
+        return &scalarKernels;
+    return nullptr;
+}
+
+std::atomic<const Kernels *> currentKernels{nullptr};
+
+inline const Kernels &kernels()
+{
+    auto k = currentKernels.load(std::memory_order_relaxed);
+    if (!k)
+    {
+        k = selectKernels(nullptr);
+        currentKernels.store(k, std::memory_order_relaxed);
+    }
+    return *k;
+}
+}  // namespace
+
+namespace drogon
+{
+namespace utils
+{
+const char *findCRLF(const char *begin, const char *end)
+{
+    return kernels().findCRLF(begin, end);
+}
+
+const char *findNonTokenChar(const char *begin, const char *end)
+{
+    return kernels().findInRanges(
+        begin, end, tokenRanges, tokenRangesSize, tokenTable);
+}
+
+const char *findControlChar(const char *begin, const char *end)
+{
+    return kernels().findInRanges(
+        begin, end, controlRanges, controlRangesSize, controlTable);
+}
+
+const char *httpScanKernelName()
+{
+    return kernels().name;
+}
+
+namespace internal
+{
+bool setHttpScanKernel(const char *name)
+{
+    auto k = selectKernels(name);
+    if (!k)
+        return false;
+    currentKernels.store(k, std::memory_order_relaxed);
+    return true;
+}
+}  // namespace internal
+
+}  // namespace utils
+}  // namespace drogon
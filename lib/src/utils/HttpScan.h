@@ -0,0 +1,59 @@
+/**
+ *
+ *  @file HttpScan.h
+ *  Vectorized delimiter search and character validation for HTTP parsing
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace drogon
+{
+namespace utils
+{
+/**
+ * @brief Find the first CRLF in [begin, end).
+ * @return A pointer to the '\r' of the CRLF, or nullptr if not found.
+ */
+const char *findCRLF(const char *begin, const char *end);
+
+/**
+ * @brief Find the first byte in [begin, end) that is not a token character
+ * (tchar, rfc9110-5.6.2), i.e. not allowed in a method or a field name.
+ * @return A pointer to the byte, or end if all bytes are valid.
+ */
+const char *findNonTokenChar(const char *begin, const char *end);
+
+/**
+ * @brief Find the first control character (other than HTAB) or DEL in
+ * [begin, end), these are not allowed in request targets and field values.
+ * @return A pointer to the byte, or end if all bytes are valid.
+ */
+const char *findControlChar(const char *begin, const char *end);
+
+/**
+ * @brief The name of the scanning kernel selected for this CPU, one of
+ * "avx2", "sse4.2" and "scalar".
+ */
+const char *httpScanKernelName();
+
+namespace internal
+{
+/**
+ * @brief Force a kernel by name, used by tests and benchmarks to compare the
+ * kernels. Returns false if the kernel isn't supported on this CPU.
+ */
+bool setHttpScanKernel(const char *name);
+}  // namespace internal
+
+}  // namespace utils
+}  // namespace drogon
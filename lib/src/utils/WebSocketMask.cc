@@ -0,0 +1,229 @@
+/**
+ *
+ *  @file WebSocketMask.cc
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "WebSocketMask.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define DROGON_WS_MASK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+// The kernels take the key rotated to the offset, all the block sizes are
+// multiples of 4 so the key stays aligned with the blocks.
+using MaskData = void (*)(char *, const char *, size_t, const unsigned char *);
+
+struct Kernels
+{
+    const char *name;
+    MaskData maskData;
+};
+
+void maskTail(char *dst,
+              const char *src,
+              size_t length,
+              const unsigned char *key)
+{
+    for (size_t i = 0; i < length; ++i)
+        dst[i] = static_cast<char>(src[i] ^ key[i % 4]);
+}
+
+void maskDataScalar(char *dst,
+                    const char *src,
+                    size_t length,
+                    const unsigned char *key)
+{
+    uint32_t key32;
+    memcpy(&key32, key, 4);
+    const uint64_t key64 = (static_cast<uint64_t>(key32) << 32) | key32;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, src + i, 8);
+        word ^= key64;
+        memcpy(dst + i, &word, 8);
+    }
+    maskTail(dst + i, src + i, length - i, key);
+}
+
+#ifdef DROGON_WS_MASK_X86
+__attribute__((target("sse2"))) void maskDataSse2(char *dst,
+                                                  const char *src,
+                                                  size_t length,
+                                                  const unsigned char *key)
+{
+    int32_t key32;
+    memcpy(&key32, key, 4);
+    const __m128i key128 = _mm_set1_epi32(key32);
+    size_t i = 0;
+    for (; i + 64 <= length; i += 64)
+    {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        auto b =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 16));
+        auto c =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 32));
+        auto d =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 48));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_xor_si128(a, key128));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 16),
+                         _mm_xor_si128(b, key128));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 32),
+                         _mm_xor_si128(c, key128));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 48),
+                         _mm_xor_si128(d, key128));
+    }
+    for (; i + 16 <= length; i += 16)
+    {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_xor_si128(a, key128));
+    }
+    maskTail(dst + i, src + i, length - i, key);
+}
+
+__attribute__((target("avx2"))) void maskDataAvx2(char *dst,
+                                                  const char *src,
+                                                  size_t length,
+                                                  const unsigned char *key)
+{
+    int32_t key32;
+    memcpy(&key32, key, 4);
+    const __m256i key256 = _mm256_set1_epi32(key32);
+    size_t i = 0;
+    for (; i + 64 <= length; i += 64)
+    {
+        auto a =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        auto b = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(src + i + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm256_xor_si256(a, key256));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 32),
+                            _mm256_xor_si256(b, key256));
+    }
+    // The 128 bit intrinsics are VEX encoded in this function, see
+    // HttpScan.cc
+    if (i + 32 <= length)
+    {
+        auto a =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            _mm256_xor_si256(a, key256));
+        i += 32;
+    }
+    if (i + 16 <= length)
+    {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(dst + i),
+            _mm_xor_si128(a, _mm256_castsi256_si128(key256)));
+        i += 16;
+    }
+    maskTail(dst + i, src + i, length - i, key);
+}
+#endif
+
+constexpr Kernels scalarKernels{"scalar", maskDataScalar};
+#ifdef DROGON_WS_MASK_X86
+constexpr Kernels sse2Kernels{"sse2", maskDataSse2};
+constexpr Kernels avx2Kernels{"avx2", maskDataAvx2};
+#endif
+
+const Kernels *selectKernels(const char *name)
+{
+#ifdef DROGON_WS_MASK_X86
+    __builtin_cpu_init();
+    bool hasSse2 = __builtin_cpu_supports("sse2");
+    bool hasAvx2 = hasSse2 && __builtin_cpu_supports("avx2");
+    if (!name)
+    {
+        if (hasAvx2)
+            return &avx2Kernels;
+        if (hasSse2)
+            return &sse2Kernels;
+        return &scalarKernels;
+    }
+    if (strcmp(name, avx2Kernels.name) == 0)
+        return hasAvx2 ? &avx2Kernels : nullptr;
+    if (strcmp(name, sse2Kernels.name) == 0)
+        return hasSse2 ? &sse2Kernels : nullptr;
+#endif
+    if (!name || strcmp(name, scalarKernels.name) == 0)
+        return &scalarKernels;
+    return nullptr;
+}
+
+std::atomic<const Kernels *> currentKernels{nullptr};
+
+inline const Kernels &kernels()
+{
+    auto k = currentKernels.load(std::memory_order_relaxed);
+    if (!k)
+    {
+        k = selectKernels(nullptr);
+        currentKernels.store(k, std::memory_order_relaxed);
+    }
+    return *k;
+}
+}  // namespace
+
+namespace drogon
+{
+namespace utils
+{
+void maskWebSocketData(char *dst,
+                       const char *src,
+                       size_t length,
+                       const unsigned char key[4],
+                       size_t offset)
+{
+    const unsigned char rotated[4] = {key[offset % 4],
+                                      key[(offset + 1) % 4],
+                                      key[(offset + 2) % 4],
+                                      key[(offset + 3) % 4]};
+    // Short payloads (most chat messages) do not pay for the dispatch
+    if (length < 16)
+    {
+        maskTail(dst, src, length, rotated);
+        return;
+    }
+    kernels().maskData(dst, src, length, rotated);
+}
+
+const char *webSocketMaskKernelName()
+{
+    return kernels().name;
+}
+
+namespace internal
+{
+bool setWebSocketMaskKernel(const char *name)
+{
+    auto k = selectKernels(name);
+    if (!k)
+        return false;
+    currentKernels.store(k, std::memory_order_relaxed);
+    return true;
+}
+}  // namespace internal
+
+}  // namespace utils
+}  // namespace drogon
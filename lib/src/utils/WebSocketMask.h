@@ -0,0 +1,53 @@
+/**
+ *
+ *  @file WebSocketMask.h
+ *  Vectorized masking of the payloads of WebSocket frames
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace drogon
+{
+namespace utils
+{
+/**
+ * @brief XOR length bytes of src with the masking key of a frame
+ * (rfc6455-5.3) into dst, which may be src to unmask in place.
+ *
+ * @param offset The position of src in the payload, the key is applied from
+ * its byte offset % 4.
+ */
+void maskWebSocketData(char *dst,
+                       const char *src,
+                       size_t length,
+                       const unsigned char key[4],
+                       size_t offset = 0);
+
+/**
+ * @brief The name of the masking kernel selected for this CPU, one of
+ * "avx2", "sse2" and "scalar".
+ */
+const char *webSocketMaskKernelName();
+
+namespace internal
+{
+/**
+ * @brief Force a kernel by name, used by tests and benchmarks to compare the
+ * kernels, nullptr selects the default one. Returns false if the kernel
+ * isn't supported on this CPU.
+ */
+bool setWebSocketMaskKernel(const char *name);
+}  // namespace internal
+
+}  // namespace utils
+}  // namespace drogon
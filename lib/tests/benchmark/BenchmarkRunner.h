@@ -0,0 +1,216 @@
+/**
+ *
+ *  @file BenchmarkRunner.h
+ *  A minimal harness timing operations and counting their heap allocations
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <json/json.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+
+// Every heap allocation of the process is counted, include this header in
+// one translation unit of the benchmark only.
+static std::atomic<size_t> benchmarkAllocations{0};
+
+void *operator new(std::size_t size)
+{
+    benchmarkAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+/**
+ * @brief Runs each benchmark in batches growing until one lasts the minimum
+ * time, then reports the operations per second and the allocations per
+ * operation of that batch.
+ *
+ * Options:
+ *   --filter=<text>    only run the benchmarks whose name contains the text
+ *   --min-time=<sec>   the minimum duration of the measured batch (0.5)
+ *   --json=<file>      also write the results in the file
+ *   --baseline=<file>  compare with the results written by --json before,
+ *                      a benchmark is a regression when it is slower by more
+ *                      than --max-regression percents (10) or allocates more
+ *                      per operation, main() then fails
+ */
+class BenchmarkRunner
+{
+  public:
+    BenchmarkRunner(int argc, char *argv[])
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg.compare(0, 9, "--filter=") == 0)
+                filter_ = arg.substr(9);
+            else if (arg.compare(0, 11, "--min-time=") == 0)
+                minTime_ = std::strtod(arg.c_str() + 11, nullptr);
+            else if (arg.compare(0, 7, "--json=") == 0)
+                jsonFile_ = arg.substr(7);
+            else if (arg.compare(0, 11, "--baseline=") == 0)
+                loadBaseline(arg.substr(11));
+            else if (arg.compare(0, 17, "--max-regression=") == 0)
+                maxRegression_ = std::strtod(arg.c_str() + 17, nullptr);
+            else
+                std::cerr << "unknown option " << arg << std::endl;
+        }
+        results_["benchmarks"] = Json::arrayValue;
+    }
+
+    bool enabled(const std::string &name) const
+    {
+        return filter_.empty() || name.find(filter_) != std::string::npos;
+    }
+
+    /// Time op(), which performs one operation
+    template <typename Operation>
+    void run(const std::string &name, Operation &&op)
+    {
+        if (!enabled(name))
+            return;
+        // Warm up the caches, pools and buffers
+        for (size_t i = 0; i < 10; ++i)
+            op();
+        size_t iterations = 1;
+        while (true)
+        {
+            auto allocations = benchmarkAllocations.load();
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; ++i)
+                op();
+            auto elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+            allocations = benchmarkAllocations.load() - allocations;
+            if (elapsed >= minTime_ || iterations >= (size_t{1} << 40))
+            {
+                report(name, iterations, elapsed, allocations);
+                return;
+            }
+            // Aim past the minimum time, growing 10 times at most
+            auto factor = elapsed > 0 ? minTime_ * 1.4 / elapsed : 10;
+            iterations = static_cast<size_t>(
+                iterations * (factor < 2 ? 2 : factor > 10 ? 10 : factor));
+        }
+    }
+
+    /// Write the JSON results if asked, returns the exit code of main()
+    int finish()
+    {
+        if (!jsonFile_.empty())
+        {
+            std::ofstream file(jsonFile_);
+            if (!file)
+            {
+                std::cerr << "can't write " << jsonFile_ << std::endl;
+                return 1;
+            }
+            Json::StreamWriterBuilder builder;
+            builder["indentation"] = "  ";
+            std::unique_ptr<Json::StreamWriter> writer(
+                builder.newStreamWriter());
+            writer->write(results_, &file);
+            file << std::endl;
+        }
+        if (regressions_ > 0)
+        {
+            std::cout << regressions_ << " regression(s) against the baseline"
+                      << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+  private:
+    void loadBaseline(const std::string &path)
+    {
+        std::ifstream file(path);
+        Json::Value root;
+        Json::CharReaderBuilder builder;
+        std::string errors;
+        if (!file || !Json::parseFromStream(builder, file, &root, &errors))
+        {
+            std::cerr << "can't read the baseline " << path << std::endl;
+            std::exit(1);
+        }
+        for (auto &result : root["benchmarks"])
+            baseline_[result["name"].asString()] = result;
+    }
+
+    void report(const std::string &name,
+                size_t iterations,
+                double elapsed,
+                size_t allocations)
+    {
+        auto nsPerOp = elapsed * 1e9 / iterations;
+        auto opsPerSecond = iterations / elapsed;
+        auto allocationsPerOp = static_cast<double>(allocations) / iterations;
+        std::cout << std::left << std::setw(36) << name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(12)
+                  << nsPerOp << " ns/op " << std::setw(14) << opsPerSecond
+                  << " ops/s " << std::setprecision(2) << std::setw(8)
+                  << allocationsPerOp << " allocs/op";
+        if (baseline_.isMember(name))
+        {
+            auto &previous = baseline_[name];
+            auto change =
+                (nsPerOp / previous["ns_per_op"].asDouble() - 1) * 100;
+            std::cout << std::showpos << std::setw(8) << change << "%"
+                      << std::noshowpos;
+            if (change > maxRegression_ ||
+                allocationsPerOp >
+                    previous["allocations_per_op"].asDouble() + 0.01)
+            {
+                ++regressions_;
+                std::cout << " REGRESSION";
+            }
+        }
+        std::cout << std::endl;
+        Json::Value result;
+        result["name"] = name;
+        result["iterations"] = static_cast<Json::UInt64>(iterations);
+        result["ns_per_op"] = nsPerOp;
+        result["ops_per_second"] = opsPerSecond;
+        result["allocations_per_op"] = allocationsPerOp;
+        results_["benchmarks"].append(std::move(result));
+    }
+
+    std::string filter_;
+    double minTime_{0.5};
+    std::string jsonFile_;
+    Json::Value results_;
+    // The baseline results by name
+    Json::Value baseline_{Json::objectValue};
+    double maxRegression_{10};
+    size_t regressions_{0};
+};
@@ -0,0 +1,108 @@
+/**
+ *
+ *  @file HttpPipelineBenchmark.cc
+ *  Measures the rendering of a batch of pipelined responses
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "../../lib/src/HttpResponseImpl.h"
+#include <trantor/utils/MsgBuffer.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+struct Result
+{
+    double nsPerResponse;
+    double copiedPerResponse;
+};
+
+// Renders <depth> responses per batch like HttpServer::sendResponses. The
+// sink stands for the connection, only the bytes that pass through the
+// batch buffer count as copied.
+template <typename Render>
+static Result run(const std::vector<HttpResponsePtr> &responses,
+                  size_t rounds,
+                  Render &&render)
+{
+    trantor::MsgBuffer buffer;
+    size_t copied = 0;
+    std::function<void(const char *, size_t)> send =
+        [&buffer, &copied](const char *data, size_t len) {
+            if (data == buffer.peek())
+                copied += len;
+        };
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        for (auto &resp : responses)
+        {
+            render(static_cast<HttpResponseImpl *>(resp.get()), buffer, send);
+        }
+        send(buffer.peek(), buffer.readableBytes());
+        buffer.retrieveAll();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    auto count = static_cast<double>(rounds * responses.size());
+    return {elapsed / count, copied / count};
+}
+
+int main(int argc, char *argv[])
+{
+    size_t depth = 16;
+    size_t bodySize = 64 * 1024;
+    if (argc > 1)
+        depth = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2)
+        bodySize = std::strtoul(argv[2], nullptr, 10);
+    const size_t rounds = 2000;
+
+    std::vector<HttpResponsePtr> responses;
+    for (size_t i = 0; i < depth; ++i)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setBody(
+            std::string(bodySize, static_cast<char>('a' + i % 26)));
+        responses.push_back(resp);
+    }
+
+    auto concatenated =
+        run(responses,
+            rounds,
+            [](HttpResponseImpl *resp,
+               trantor::MsgBuffer &buffer,
+               const std::function<void(const char *, size_t)> &) {
+                resp->renderToBuffer(buffer);
+            });
+    auto batched =
+        run(responses,
+            rounds,
+            [](HttpResponseImpl *resp,
+               trantor::MsgBuffer &buffer,
+               const std::function<void(const char *, size_t)> &send) {
+                resp->renderToBatch(buffer, send);
+            });
+
+    std::cout << "depth: " << depth << ", body: " << bodySize << " bytes"
+              << std::endl;
+    std::cout << "concatenated: " << concatenated.nsPerResponse
+              << " ns/response, " << concatenated.copiedPerResponse
+              << " bytes copied/response" << std::endl;
+    std::cout << "batched:      " << batched.nsPerResponse << " ns/response, "
+              << batched.copiedPerResponse << " bytes copied/response"
+              << std::endl;
+    return 0;
+}
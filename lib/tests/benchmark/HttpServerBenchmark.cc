@@ -0,0 +1,343 @@
+/**
+ *
+ *  @file HttpServerBenchmark.cc
+ *  Measures the hot path of the HTTP server, from the parsing of a request
+ *  to a full round trip on the loopback interface
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "BenchmarkRunner.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include "../../lib/src/HttpRequestParser.h"
+#include "../../lib/src/HttpResponseImpl.h"
+#include "../../lib/src/RouteTree.h"
+#include "../../lib/src/SessionManager.h"
+#include <drogon/drogon.h>
+#include <drogon/utils/Utilities.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/TcpClient.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <cstdlib>
+#include <future>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+
+// Printed at the end so that the lookups are not optimized out
+static size_t checksum = 0;
+
+static const std::string smallRequest =
+    "GET /api/v1/health HTTP/1.1\r\n"
+    "Host: localhost:8080\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+static const std::string browserRequest =
+    "GET /articles/2024/05/http-parsing-performance?ref=home HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, "
+    "like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;"
+    "q=0.8\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Referer: https://www.example.com/\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Cookie: JSESSIONID=8f14e45fceea167a5a36dedd4bea2543; theme=dark; "
+    "_ga=GA1.1.1234567890.1700000000\r\n"
+    "\r\n";
+
+static const std::string postRequest =
+    "POST /api/v2/orders/12345/items HTTP/1.1\r\n"
+    "Host: api.example.com\r\n"
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Content-Length: 27\r\n"
+    "Accept: application/json\r\n"
+    "\r\n"
+    "{\"sku\":\"A-1024\",\"count\":3}";
+
+// The request the browser request is parsed into, for the lookups
+static HttpRequestImplPtr newBrowserRequest()
+{
+    auto req = std::make_shared<HttpRequestImpl>(nullptr);
+    auto p = browserRequest.data() + browserRequest.find("\r\n") + 2;
+    while (p[0] != '\r')
+    {
+        auto end = strstr(p, "\r\n");
+        req->addHeader(p, strchr(p, ':'), end);
+        p = end + 2;
+    }
+    return req;
+}
+
+static void benchmarkRouting(BenchmarkRunner &runner)
+{
+    auto all = [](size_t) { return true; };
+    RouteTree::Captures captures;
+    size_t count;
+
+    RouteTree single;
+    single.insert("/api/v1/items", 0);
+    runner.run("route/static", [&]() {
+        checksum += single.match("/api/v1/items", all, captures, count);
+    });
+
+    RouteTree many;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        many.insert("/api/v1/resource" + std::to_string(i) +
+                        "/([^/]*)/detail",
+                    i);
+    }
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < 1024; ++i)
+    {
+        paths.push_back("/api/v1/resource" + std::to_string(i * 7919 % 1000) +
+                        "/" + std::to_string(i) + "/detail");
+    }
+    size_t n = 0;
+    runner.run("route/placeholder_1000_routes", [&]() {
+        checksum +=
+            many.match(paths[n++ % paths.size()], all, captures, count);
+    });
+
+    // Patterns the tree rejects are matched with std::regex by the router
+    std::regex regex("/api/v1/files/([0-9]+)\\.(png|jpg)",
+                     std::regex_constants::icase);
+    runner.run("route/regex", [&]() {
+        std::cmatch result;
+        checksum += std::regex_match("/api/v1/files/1024.png", result, regex);
+    });
+}
+
+static void benchmarkRequests(BenchmarkRunner &runner)
+{
+    auto req = newBrowserRequest();
+    runner.run("header/get", [&]() {
+        checksum += req->getHeader("user-agent").size();
+    });
+    runner.run("header/get_missing", [&]() {
+        checksum += req->getHeader("x-forwarded-for").size();
+    });
+    runner.run("cookie/get", [&]() {
+        checksum += req->getCookie("JSESSIONID").size();
+    });
+}
+
+static void benchmarkResponses(BenchmarkRunner &runner)
+{
+    trantor::MsgBuffer output;
+    runner.run("render/plaintext", [&]() {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setContentTypeCode(CT_TEXT_PLAIN);
+        resp->setBody("Hello, World!");
+        static_cast<HttpResponseImpl *>(resp.get())->renderToBuffer(output);
+        output.retrieveAll();
+    });
+    runner.run("render/json", [&]() {
+        Json::Value json;
+        json["message"] = "Hello, World!";
+        json["id"] = 1024;
+        json["tags"].append("fast");
+        json["tags"].append("small");
+        auto resp = HttpResponse::newHttpJsonResponse(std::move(json));
+        static_cast<HttpResponseImpl *>(resp.get())->renderToBuffer(output);
+        output.retrieveAll();
+    });
+
+    Json::Value rows;
+    for (int i = 0; i < 100; ++i)
+    {
+        Json::Value row;
+        row["id"] = i;
+        row["randomNumber"] = i * 7919 % 10000;
+        rows.append(row);
+    }
+    runner.run("json/serialize_100_rows", [&]() {
+        auto resp = HttpResponse::newHttpJsonResponse(rows);
+        static_cast<HttpResponseImpl *>(resp.get())->renderToBuffer(output);
+        output.retrieveAll();
+    });
+
+    std::string text;
+    while (text.size() < 16 * 1024)
+    {
+        text += "<tr><td>" + std::to_string(text.size()) +
+                "</td><td>A fortune cookie says hello</td></tr>\n";
+    }
+    runner.run("compress/gzip_16k", [&]() {
+        utils::gzipCompress(text.data(), text.size());
+    });
+#ifdef USE_BROTLI
+    runner.run("compress/brotli_16k", [&]() {
+        utils::brotliCompress(text.data(), text.size());
+    });
+#endif
+#ifdef USE_ZSTD
+    runner.run("compress/zstd_16k", [&]() {
+        utils::zstdCompress(text.data(), text.size());
+    });
+#endif
+}
+
+// Runs in the loop of the connection, as the server does
+static void benchmarkParsing(BenchmarkRunner &runner,
+                             const trantor::TcpConnectionPtr &conn)
+{
+    auto parser = std::make_shared<HttpRequestParser>(conn);
+    parser->reset();
+    trantor::MsgBuffer buffer;
+    auto parse = [&](const std::string &request) {
+        buffer.append(request);
+        if (parser->parseRequest(&buffer) != 1)
+        {
+            std::cerr << "failed to parse the request" << std::endl;
+            std::exit(1);
+        }
+        parser->reset();
+    };
+    runner.run("parse/small_get", [&]() { parse(smallRequest); });
+    runner.run("parse/browser_get", [&]() { parse(browserRequest); });
+    runner.run("parse/post_json", [&]() { parse(postRequest); });
+}
+
+static void benchmarkSessions(BenchmarkRunner &runner,
+                              trantor::EventLoop *loop)
+{
+    std::vector<AdviceStartSessionCallback> startAdvices;
+    std::vector<AdviceDestroySessionCallback> destroyAdvices;
+    SessionManager manager(loop, 1200, startAdvices, destroyAdvices, []() {
+        return utils::getUuid();
+    });
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        ids.push_back(utils::getUuid());
+        manager.getSession(ids.back(), false);
+    }
+    size_t n = 0;
+    runner.run("session/get_10000_sessions", [&]() {
+        manager.getSession(ids[n++ % ids.size()], false);
+    });
+}
+
+static void benchmarkRoundTrips(BenchmarkRunner &runner, uint16_t port)
+{
+    auto client = HttpClient::newHttpClient("127.0.0.1", port);
+    auto roundTrip = [&client](const std::string &path) {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath(path);
+        auto [result, resp] = client->sendRequest(req, 10);
+        if (result != ReqResult::Ok || resp->statusCode() != k200OK)
+        {
+            std::cerr << "failed to get " << path << std::endl;
+            std::exit(1);
+        }
+    };
+    runner.run("roundtrip/plaintext", [&]() { roundTrip("/plaintext"); });
+    runner.run("roundtrip/placeholder",
+               [&]() { roundTrip("/items/1024/detail"); });
+    runner.run("roundtrip/json", [&]() { roundTrip("/json"); });
+}
+
+/**
+ * Run with --filter=<text> to select benchmarks, --json=<file> to save the
+ * results and --baseline=<file> to compare with saved results, see
+ * BenchmarkRunner.h. The allocations of the round trips are those of the
+ * client and of the server together.
+ */
+int main(int argc, char *argv[])
+{
+    BenchmarkRunner runner(argc, argv);
+    benchmarkRouting(runner);
+    benchmarkRequests(runner);
+    benchmarkResponses(runner);
+
+    app()
+        .setLogLevel(trantor::Logger::kWarn)
+        .setThreadNum(1)
+        .disableSigtermHandling()
+        .addListener("127.0.0.1", 0)
+        .registerHandler("/plaintext",
+                         [](const HttpRequestPtr &,
+                            std::function<void(const HttpResponsePtr &)>
+                                &&callback) {
+                             auto resp = HttpResponse::newHttpResponse();
+                             resp->setContentTypeCode(CT_TEXT_PLAIN);
+                             resp->setBody("Hello, World!");
+                             callback(resp);
+                         })
+        .registerHandler("/items/{id}/detail",
+                         [](const HttpRequestPtr &,
+                            std::function<void(const HttpResponsePtr &)>
+                                &&callback,
+                            const std::string &id) {
+                             auto resp = HttpResponse::newHttpResponse();
+                             resp->setBody(id);
+                             callback(resp);
+                         })
+        .registerHandler("/json",
+                         [](const HttpRequestPtr &,
+                            std::function<void(const HttpResponsePtr &)>
+                                &&callback) {
+                             Json::Value json;
+                             json["message"] = "Hello, World!";
+                             callback(HttpResponse::newHttpJsonResponse(
+                                 std::move(json)));
+                         });
+    std::promise<uint16_t> listening;
+    app().registerBeginningAdvice([&listening]() {
+        app().getLoop()->queueInLoop([&listening]() {
+            listening.set_value(app().getListeners()[0].toPort());
+        });
+    });
+    std::thread server([]() { app().run(); });
+    auto port = listening.get_future().get();
+
+    // The parser and the sessions belong to an event loop, like in the
+    // server. The parser needs a connection, to the server here.
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    std::promise<trantor::TcpConnectionPtr> connected;
+    auto tcpClient = std::make_shared<trantor::TcpClient>(
+        loop, trantor::InetAddress("127.0.0.1", port), "benchmark");
+    tcpClient->setConnectionCallback(
+        [&connected](const trantor::TcpConnectionPtr &conn) {
+            if (conn->connected())
+                connected.set_value(conn);
+        });
+    tcpClient->connect();
+    auto conn = connected.get_future().get();
+    std::promise<void> done;
+    loop->queueInLoop([&]() {
+        benchmarkParsing(runner, conn);
+        benchmarkSessions(runner, loop);
+        tcpClient.reset();
+        done.set_value();
+    });
+    done.get_future().get();
+    conn.reset();
+
+    benchmarkRoundTrips(runner, port);
+
+    app().getLoop()->queueInLoop([]() { app().quit(); });
+    server.join();
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+    return runner.finish();
+}
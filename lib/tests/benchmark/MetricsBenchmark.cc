@@ -0,0 +1,165 @@
+/**
+ *
+ *  @file MetricsBenchmark.cc
+ *  Measures the monitoring metrics updated by many threads at once
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/monitoring/Counter.h>
+#include <drogon/utils/monitoring/Histogram.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon::monitoring;
+
+// The counter and the histogram as they were before sharding, one mutex per
+// metric
+class LockedCounter
+{
+  public:
+    void increment()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        value_++;
+    }
+
+  private:
+    std::mutex mutex_;
+    double value_{0};
+};
+
+class LockedHistogram
+{
+  public:
+    explicit LockedHistogram(const std::vector<double> &boundaries)
+        : boundaries_(boundaries), buckets_(boundaries.size() + 1)
+    {
+    }
+
+    void observe(double value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sum_ += value;
+        ++count_;
+        for (size_t i = 0; i < boundaries_.size(); i++)
+        {
+            if (value <= boundaries_[i])
+            {
+                buckets_[i] += 1;
+                return;
+            }
+        }
+        buckets_.back() += 1;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::vector<double> boundaries_;
+    std::vector<uint64_t> buckets_;
+    uint64_t count_{0};
+    double sum_{0};
+};
+
+// Every thread calls op(i) <operations> times, returns the ns per operation
+// of a thread
+template <typename Operation>
+static double run(size_t threadCount, size_t operations, Operation &&op)
+{
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    std::vector<double> elapsed(threadCount);
+    for (size_t t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            ++ready;
+            while (!go)
+                std::this_thread::yield();
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < operations; ++i)
+                op(i);
+            elapsed[t] = std::chrono::duration<double, std::nano>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        });
+    }
+    while (ready < threadCount)
+        std::this_thread::yield();
+    go = true;
+    for (auto &thread : threads)
+        thread.join();
+    return *std::max_element(elapsed.begin(), elapsed.end()) / operations;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t operations = 1000000;
+    if (argc > 1)
+        maxThreads = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2)
+        operations = std::strtoul(argv[2], nullptr, 10);
+
+    // Request latencies in seconds, like PromExporter users record them
+    const std::vector<double> boundaries{
+        0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1};
+    std::vector<double> latencies;
+    for (size_t i = 0; i < 1024; ++i)
+        latencies.push_back((i * 7919 % 1000) / 2000.0);
+
+    std::cout << "ns per operation and thread, " << operations
+              << " operations per thread" << std::endl;
+    std::cout << "threads  locked counter  counter  locked histogram  "
+                 "histogram"
+              << std::endl;
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        LockedCounter lockedCounter;
+        auto counter = std::make_shared<Counter>("requests",
+                                                 std::vector<std::string>{},
+                                                 std::vector<std::string>{});
+        LockedHistogram lockedHistogram(boundaries);
+        auto histogram =
+            std::make_shared<Histogram>("latency",
+                                        std::vector<std::string>{},
+                                        std::vector<std::string>{},
+                                        boundaries,
+                                        std::chrono::seconds(0),
+                                        0);
+        auto lockedCounterTime = run(threads, operations, [&](size_t) {
+            lockedCounter.increment();
+        });
+        auto counterTime =
+            run(threads, operations, [&](size_t) { counter->increment(); });
+        auto lockedHistogramTime = run(threads, operations, [&](size_t i) {
+            lockedHistogram.observe(latencies[i % latencies.size()]);
+        });
+        auto histogramTime = run(threads, operations, [&](size_t i) {
+            histogram->observe(latencies[i % latencies.size()]);
+        });
+        if (counter->collect()[0].value != threads * operations)
+        {
+            std::cerr << "lost increments" << std::endl;
+            return 1;
+        }
+        std::cout << threads << "  " << lockedCounterTime << "  "
+                  << counterTime << "  " << lockedHistogramTime << "  "
+                  << histogramTime << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ *
+ *  @file ObjectPoolBenchmark.cc
+ *  Counts the heap allocations per request with and without object pools
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "BenchmarkRunner.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include "../../lib/src/HttpResponseImpl.h"
+#include "../../lib/src/ObjectPool.h"
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/MsgBuffer.h>
+#include <cstring>
+#include <string>
+
+using namespace drogon;
+
+// What the server does for a small GET request: take a request from the
+// parser, fill it, create a response and render it.
+static void serve(trantor::EventLoop *loop,
+                  trantor::MsgBuffer &output,
+                  const std::string &body)
+{
+    static const char *headers[] = {"Host: localhost:8080",
+                                    "User-Agent: press",
+                                    "Accept: */*",
+                                    "Connection: keep-alive"};
+    auto req = ObjectPool<HttpRequestImpl>::acquire(loop);
+    static const std::string method = "GET";
+    static const std::string path = "/api/v1/items";
+    req->setMethod(method.data(), method.data() + method.length());
+    req->setPath(path.data(), path.data() + path.length());
+    for (auto header : headers)
+    {
+        auto end = header + strlen(header);
+        req->addHeader(header, strchr(header, ':'), end);
+    }
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setBody(body);
+    static_cast<HttpResponseImpl *>(resp.get())->renderToBuffer(output);
+    output.retrieveAll();
+}
+
+int main(int argc, char *argv[])
+{
+    BenchmarkRunner runner(argc, argv);
+    // The pools belong to the event loop of the current thread
+    trantor::EventLoop loop;
+    trantor::MsgBuffer output;
+    const std::string body(512, 'a');
+
+    internal::setObjectPoolsEnabled(false);
+    runner.run("request/plain", [&]() { serve(&loop, output, body); });
+    internal::setObjectPoolsEnabled(true);
+    runner.run("request/pooled", [&]() { serve(&loop, output, body); });
+    return runner.finish();
+}
@@ -0,0 +1,100 @@
+/**
+ *
+ *  @file RouteTreeBenchmark.cc
+ *  Compares the route tree with the linear std::regex scan it replaced
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "../../lib/src/RouteTree.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+// Registers <routeCount> routes like /api/v1/resource<N>/([^/]*)/detail and
+// looks up paths spread over all of them.
+int main(int argc, char *argv[])
+{
+    size_t routeCount = 1000;
+    size_t lookups = 200000;
+    if (argc > 1)
+        routeCount = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2)
+        lookups = std::strtoul(argv[2], nullptr, 10);
+
+    RouteTree tree;
+    std::vector<std::regex> regexes;
+    regexes.reserve(routeCount);
+    for (size_t i = 0; i < routeCount; ++i)
+    {
+        auto pattern =
+            "/api/v1/resource" + std::to_string(i) + "/([^/]*)/detail";
+        if (!tree.insert(pattern, i))
+        {
+            std::cerr << "failed to insert " << pattern << std::endl;
+            return 1;
+        }
+        regexes.emplace_back(pattern, std::regex_constants::icase);
+    }
+
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < 1024; ++i)
+    {
+        paths.push_back("/api/v1/resource" +
+                        std::to_string((i * 7919) % routeCount) + "/" +
+                        std::to_string(i) + "/detail");
+    }
+
+    auto all = [](size_t) { return true; };
+    size_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i)
+    {
+        RouteTree::Captures captures;
+        size_t count;
+        checksum += tree.match(paths[i % paths.size()], all, captures, count);
+    }
+    auto treeTime = std::chrono::steady_clock::now() - start;
+
+    // The regex scan is much slower, use fewer iterations
+    size_t regexLookups = lookups / 100 + 1;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < regexLookups; ++i)
+    {
+        std::smatch result;
+        const auto &path = paths[i % paths.size()];
+        for (size_t j = 0; j < regexes.size(); ++j)
+        {
+            if (std::regex_match(path, result, regexes[j]))
+            {
+                checksum += j;
+                break;
+            }
+        }
+    }
+    auto regexTime = std::chrono::steady_clock::now() - start;
+
+    auto perLookup = [](auto duration, size_t count) {
+        return std::chrono::duration<double, std::nano>(duration).count() /
+               count;
+    };
+    std::cout << "routes: " << routeCount << std::endl;
+    std::cout << "route tree:  " << perLookup(treeTime, lookups)
+              << " ns/lookup" << std::endl;
+    std::cout << "regex scan:  " << perLookup(regexTime, regexLookups)
+              << " ns/lookup" << std::endl;
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ *
+ *  @file WebSocketBenchmark.cc
+ *  Measures the cost of the WebSocket messages and the bytes they save
+ *
+ *  Copyright 2026, Drogon.  All rights reserved.
+ *  https://github.com/drogonframework/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "BenchmarkRunner.h"
+#include "../../lib/src/WebSocketCompression.h"
+#include "../../lib/src/utils/WebSocketMask.h"
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+// Messages of a JSON feed, similar to each other as most feeds are
+static std::vector<std::string> feedMessages()
+{
+    std::vector<std::string> messages;
+    const char *symbols[] = {"DRGN", "TRNT", "ORM", "REDIS", "HTTP"};
+    for (int i = 0; i < 64; ++i)
+    {
+        messages.push_back(
+            R"({"type":"quote","symbol":")" + std::string(symbols[i % 5]) +
+            R"(","bid":)" + std::to_string(100 + i % 13) + "." +
+            std::to_string(i % 100) + R"(,"ask":)" +
+            std::to_string(101 + i % 11) + R"(,"volume":)" +
+            std::to_string(1000 + i * 37) +
+            R"(,"exchange":"example","timestamp":)" +
+            std::to_string(1700000000000 + i * 250) + "}");
+    }
+    return messages;
+}
+
+static void benchmarkCompression(BenchmarkRunner &runner,
+                                 const std::string &name,
+                                 const WebSocketCompressionOptions &options,
+                                 const WebSocketDeflateParams &params)
+{
+    auto messages = feedMessages();
+    WebSocketDeflater server(options, params, true);
+    auto client = std::make_unique<WebSocketDeflater>(options, params, false);
+    size_t index{0};
+    std::string compressed, decompressed;
+    size_t raw{0}, sent{0};
+    runner.run("deflate/" + name, [&]() {
+        auto &message = messages[index++ % messages.size()];
+        server.compress(message.data(), message.length(), compressed);
+        raw += message.length();
+        sent += compressed.length();
+    });
+    if (raw > 0)
+    {
+        std::cout << "  deflate/" << name << ": " << sent * 100.0 / raw
+                  << "% of the bytes" << std::endl;
+    }
+
+    // The messages are decompressed in the order they are compressed
+    std::vector<std::string> stream;
+    WebSocketDeflater sender(options, params, true);
+    for (size_t i = 0; i < 4096; ++i)
+    {
+        auto &message = messages[i % messages.size()];
+        sender.compress(message.data(), message.length(), compressed);
+        stream.push_back(compressed);
+    }
+    index = 0;
+    runner.run("inflate/" + name, [&]() {
+        if (index == stream.size())
+        {
+            // Start the stream again with a new context
+            client =
+                std::make_unique<WebSocketDeflater>(options, params, false);
+            index = 0;
+        }
+        auto &message = stream[index++];
+        client->decompress(message.data(),
+                           message.length(),
+                           decompressed,
+                           (std::numeric_limits<size_t>::max)());
+    });
+}
+
+// The masking of the payloads compared with a copy, which is the least a
+// frame costs
+static void benchmarkMasking(BenchmarkRunner &runner)
+{
+    const unsigned char key[4] = {0x37, 0xfa, 0x21, 0x3d};
+    for (size_t size : {125, 4096, 1024 * 1024})
+    {
+        std::string payload(size, 'x'), output(size, '\0');
+        auto suffix = "/" + std::to_string(size);
+        runner.run("memcpy" + suffix, [&]() {
+            memcpy(&output[0], payload.data(), size);
+        });
+        runner.run("mask/bytewise" + suffix, [&]() {
+            for (size_t i = 0; i < size; ++i)
+                output[i] = static_cast<char>(payload[i] ^ key[i % 4]);
+        });
+        for (auto kernel : {"scalar", "sse2", "avx2"})
+        {
+            if (!utils::internal::setWebSocketMaskKernel(kernel))
+                continue;
+            runner.run(std::string("mask/") + kernel + suffix, [&]() {
+                utils::maskWebSocketData(&output[0], payload.data(), size, key);
+            });
+        }
+        utils::internal::setWebSocketMaskKernel(nullptr);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    BenchmarkRunner runner(argc, argv);
+    benchmarkMasking(runner);
+
+    WebSocketCompressionOptions options;
+    WebSocketDeflateParams params;
+    benchmarkCompression(runner, "context_takeover", options, params);
+
+    params.serverNoContextTakeover = true;
+    params.clientNoContextTakeover = true;
+    benchmarkCompression(runner, "no_context_takeover", options, params);
+
+    options.dictionary = feedMessages()[0];
+    params.useDictionary = true;
+    benchmarkCompression(runner,
+                         "no_context_takeover_dictionary",
+                         options,
+                         params);
+
+    options.dictionary.clear();
+    params = WebSocketDeflateParams{};
+    params.serverMaxWindowBits = 10;
+    params.clientMaxWindowBits = 10;
+    options.memLevel = 4;
+    benchmarkCompression(runner, "window_10_mem_4", options, params);
+    return runner.finish();
+}
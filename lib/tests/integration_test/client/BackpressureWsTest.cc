@@ -0,0 +1,83 @@
+#include <drogon/WebSocketClient.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/drogon_test.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+using namespace drogon;
+
+struct BackpressureState
+{
+    WebSocketClientPtr client;
+    std::atomic<int> small{0};
+    std::atomic<int> received{0};
+    std::shared_ptr<drogon::test::CaseBase> TEST_CTX;
+};
+
+static void floodServer(const std::shared_ptr<drogon::test::CaseBase> &ctx,
+                        uint16_t port,
+                        bool useSSL)
+{
+    auto state = std::make_shared<BackpressureState>();
+    state->TEST_CTX = ctx;
+    state->client = WebSocketClient::newWebSocketClient(
+        "127.0.0.1", port, useSSL, nullptr, false, false);
+    std::weak_ptr<BackpressureState> weakState = state;
+    state->client->setMessageHandler([weakState](
+                                         const std::string &message,
+                                         const WebSocketClientPtr &,
+                                         const WebSocketMessageType &type) {
+        auto state = weakState.lock();
+        if (!state)
+            return;
+        auto TEST_CTX = state->TEST_CTX;
+        if (type == WebSocketMessageType::Binary)
+        {
+            if (message.length() == 1)
+            {
+                ++state->small;
+                return;
+            }
+            CHECK(message.length() == 32 * 1024);
+            ++state->received;
+        }
+        else if (type == WebSocketMessageType::Text)
+        {
+            // The server drained its queue and tells how many messages it
+            // dropped, the others were all received before. The small ones
+            // were sent below the limits and none is dropped.
+            CHECK(state->small == 4096);
+            CHECK(state->received + std::stoi(message) == 64);
+            CHECK(state->received > 0);
+            state->client->stop();
+            state->client.reset();
+        }
+    });
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath("/backpressure");
+    state->client->connectToServer(req,
+                                   [state](ReqResult r,
+                                           const HttpResponsePtr &resp,
+                                           const WebSocketClientPtr &wsPtr) {
+                                       auto TEST_CTX = state->TEST_CTX;
+                                       REQUIRE(r == ReqResult::Ok);
+                                       REQUIRE(resp != nullptr);
+                                       wsPtr->getConnection()->send("flood");
+                                   });
+}
+
+DROGON_TEST(BackpressureWsTest)
+{
+    floodServer(TEST_CTX, 8848, false);
+}
+
+DROGON_TEST(BackpressureWssTest)
+{
+    // The bytes written on TLS connections include the overhead of the
+    // records, the server must still see its queue drained
+    if (!app().supportSSL())
+        return;
+    floodServer(TEST_CTX, 8849, true);
+}
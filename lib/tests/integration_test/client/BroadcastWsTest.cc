@@ -0,0 +1,76 @@
+#include <drogon/WebSocketClient.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/drogon_test.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using namespace drogon;
+
+static const int kBroadcastClientCount = 12;
+
+struct BroadcastState
+{
+    std::vector<WebSocketClientPtr> clients;
+    std::atomic<int> connected{0};
+    std::atomic<int> received{0};
+    std::string message;
+    std::shared_ptr<drogon::test::CaseBase> TEST_CTX;
+};
+
+DROGON_TEST(BroadcastWsTest)
+{
+    auto state = std::make_shared<BroadcastState>();
+    state->TEST_CTX = TEST_CTX;
+    // Long enough to be compressed
+    for (int i = 0; i < 20; ++i)
+        state->message.append("{\"symbol\":\"DRGN\",\"price\":" +
+                              std::to_string(100 + i) + "}");
+    for (int i = 0; i < kBroadcastClientCount; ++i)
+    {
+        auto wsPtr = WebSocketClient::newWebSocketClient("127.0.0.1", 8848);
+        // Plain clients, and clients with permessage-deflate with and
+        // without the context of the server
+        if (i % 3 != 0)
+        {
+            WebSocketCompressionOptions options;
+            options.serverContextTakeover = (i % 3 == 1);
+            wsPtr->enableCompression(options);
+        }
+        state->clients.push_back(wsPtr);
+    }
+    for (auto &wsPtr : state->clients)
+    {
+        std::weak_ptr<BroadcastState> weakState = state;
+        wsPtr->setMessageHandler([weakState](const std::string &message,
+                                             const WebSocketClientPtr &,
+                                             const WebSocketMessageType &type) {
+            auto state = weakState.lock();
+            if (!state || type != WebSocketMessageType::Text)
+                return;
+            auto TEST_CTX = state->TEST_CTX;
+            CHECK(message == state->message);
+            if (++state->received == kBroadcastClientCount)
+            {
+                for (auto &client : state->clients)
+                    client->stop();
+                state->clients.clear();
+            }
+        });
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath("/broadcast");
+        wsPtr->connectToServer(
+            req,
+            [state](ReqResult r,
+                    const HttpResponsePtr &resp,
+                    const WebSocketClientPtr &wsPtr) {
+                auto TEST_CTX = state->TEST_CTX;
+                REQUIRE(r == ReqResult::Ok);
+                REQUIRE(resp != nullptr);
+                // All the clients are in the group, one of them broadcasts
+                if (++state->connected == kBroadcastClientCount)
+                    wsPtr->getConnection()->send(state->message);
+            });
+    }
+}
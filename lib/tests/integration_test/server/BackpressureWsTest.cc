@@ -0,0 +1,38 @@
+#include "BackpressureWsTest.h"
+using namespace example;
+
+void BackpressureWsTest::handleNewMessage(const WebSocketConnectionPtr &conn,
+                                          std::string &&message,
+                                          const WebSocketMessageType &type)
+{
+    if (type != WebSocketMessageType::Text || message != "flood")
+        return;
+    // Many small messages first, on TLS each one adds the overhead of a record
+    // to the bytes written but none to the bytes queued
+    for (int i = 0; i < 4096; ++i)
+        conn->send("s", WebSocketMessageType::Binary);
+    // Much more than the limits, the client gets what is not dropped
+    std::string part(32 * 1024, 'x');
+    for (int i = 0; i < 64; ++i)
+        conn->send(part, WebSocketMessageType::Binary);
+    std::weak_ptr<WebSocketConnection> weakConn = conn;
+    conn->whenDrained([weakConn](bool drained) {
+        auto conn = weakConn.lock();
+        if (conn && drained)
+            conn->send(std::to_string(conn->droppedMessages()));
+    });
+}
+
+void BackpressureWsTest::handleConnectionClosed(const WebSocketConnectionPtr &)
+{
+}
+
+void BackpressureWsTest::handleNewConnection(const HttpRequestPtr &,
+                                             const WebSocketConnectionPtr &conn)
+{
+    SendQueueLimits limits;
+    limits.highWaterMark = 256 * 1024;
+    limits.lowWaterMark = 64 * 1024;
+    limits.policy = SendQueueOverflowPolicy::kDropOldest;
+    conn->setSendQueueLimits(limits);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <drogon/WebSocketController.h>
+using namespace drogon;
+
+namespace example
+{
+class BackpressureWsTest
+    : public drogon::WebSocketController<BackpressureWsTest>
+{
+  public:
+    void handleNewMessage(const WebSocketConnectionPtr &,
+                          std::string &&,
+                          const WebSocketMessageType &) override;
+    void handleConnectionClosed(const WebSocketConnectionPtr &) override;
+    void handleNewConnection(const HttpRequestPtr &,
+                             const WebSocketConnectionPtr &) override;
+    WS_PATH_LIST_BEGIN
+    WS_PATH_ADD("/backpressure", "drogon::LocalHostFilter", Get);
+    WS_PATH_LIST_END
+};
+}  // namespace example
@@ -0,0 +1,21 @@
+#include "BroadcastWsTest.h"
+using namespace example;
+
+void BroadcastWsTest::handleNewMessage(const WebSocketConnectionPtr &,
+                                       std::string &&message,
+                                       const WebSocketMessageType &type)
+{
+    if (type == WebSocketMessageType::Text)
+        room_.broadcast(message);
+}
+
+void BroadcastWsTest::handleConnectionClosed(const WebSocketConnectionPtr &conn)
+{
+    room_.remove(conn);
+}
+
+void BroadcastWsTest::handleNewConnection(const HttpRequestPtr &,
+                                          const WebSocketConnectionPtr &conn)
+{
+    room_.add(conn);
+}
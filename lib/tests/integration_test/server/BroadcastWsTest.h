@@ -0,0 +1,23 @@
+#pragma once
+#include <drogon/WebSocketController.h>
+#include <drogon/WebSocketBroadcastGroup.h>
+using namespace drogon;
+
+namespace example
+{
+class BroadcastWsTest : public drogon::WebSocketController<BroadcastWsTest>
+{
+  public:
+    void handleNewMessage(const WebSocketConnectionPtr &,
+                          std::string &&,
+                          const WebSocketMessageType &) override;
+    void handleConnectionClosed(const WebSocketConnectionPtr &) override;
+    void handleNewConnection(const HttpRequestPtr &,
+                             const WebSocketConnectionPtr &) override;
+    WS_PATH_LIST_BEGIN
+    WS_PATH_ADD("/broadcast", "drogon::LocalHostFilter", Get);
+    WS_PATH_LIST_END
+  private:
+    WebSocketBroadcastGroup room_;
+};
+}  // namespace example
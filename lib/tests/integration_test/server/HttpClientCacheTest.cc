@@ -0,0 +1,44 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpCacheStore.h>
+#include <drogon/HttpClient.h>
+
+using namespace drogon;
+
+DROGON_TEST(HttpClientCacheRevalidationTest)
+{
+    auto client =
+        HttpClient::newHttpClient("http://127.0.0.1:8848", app().getLoop());
+    client->setCacheStore(HttpCacheStore::newMemoryStore(1024 * 1024));
+
+    // Static files have a Last-Modified header and no freshness, the stored
+    // response is stale at once and revalidated by the next request
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath("/index.html");
+    auto [result, resp] = client->sendRequest(req);
+    REQUIRE(result == ReqResult::Ok);
+    REQUIRE(resp->statusCode() == k200OK);
+    REQUIRE(!resp->getHeader("last-modified").empty());
+    std::string body(resp->body());
+    CHECK(!body.empty());
+    CHECK(client->cacheMetrics().misses == 1);
+
+    // The same request object again, the validators are not added to it
+    CHECK(req->getHeader("if-modified-since").empty());
+    CHECK(req->getHeader("if-none-match").empty());
+    std::tie(result, resp) = client->sendRequest(req);
+    REQUIRE(result == ReqResult::Ok);
+    CHECK(resp->statusCode() == k200OK);
+    CHECK(resp->body() == body);
+    CHECK(client->cacheMetrics().revalidated == 1);
+    CHECK(req->getHeader("if-modified-since").empty());
+    CHECK(req->getHeader("if-none-match").empty());
+
+    // And once more, it is still not a conditional request of the user
+    std::tie(result, resp) = client->sendRequest(req);
+    REQUIRE(result == ReqResult::Ok);
+    CHECK(resp->statusCode() == k200OK);
+    CHECK(resp->body() == body);
+    CHECK(client->cacheMetrics().revalidated == 2);
+    CHECK(client->cacheMetrics().misses == 1);
+}
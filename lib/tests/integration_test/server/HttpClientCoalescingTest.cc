@@ -0,0 +1,146 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpClient.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+
+using namespace drogon;
+
+DROGON_TEST(HttpClientCoalescingTest)
+{
+    auto client =
+        HttpClient::newHttpClient("http://127.0.0.1:8848", app().getLoop());
+    client->enableRequestCoalescing();
+
+    const int identicalRequests = 10;
+    const int totalRequests = identicalRequests + 3;
+    struct Completions
+    {
+        std::atomic<int> completed{0};
+        std::atomic<int> failed{0};
+        std::vector<HttpResponsePtr> responses;
+        std::promise<void> done;
+    };
+    // Shared with the callbacks, which may outlive the test if it times out
+    auto completions = std::make_shared<Completions>();
+    auto allDone = completions->done.get_future();
+    // Sent in the loop of the client, no response can arrive in between
+    app().getLoop()->runInLoop([client, completions]() {
+        for (int i = 0; i < totalRequests; ++i)
+        {
+            auto req = HttpRequest::newHttpRequest();
+            req->setPath("/pipe");
+            if (i == identicalRequests)
+            {
+                req->setParameter("other", "1");
+            }
+            else if (i == identicalRequests + 1)
+            {
+                req->setMethod(Post);
+                req->setBody("body");
+            }
+            else if (i == identicalRequests + 2)
+            {
+                // The session of another user
+                req->addCookie("session", "other");
+            }
+            client->sendRequest(req,
+                                [completions, i](ReqResult result,
+                                                 const HttpResponsePtr &resp) {
+                                    if (result != ReqResult::Ok)
+                                    {
+                                        completions->failed++;
+                                    }
+                                    else if (i < identicalRequests)
+                                    {
+                                        completions->responses.push_back(resp);
+                                    }
+                                    if (++completions->completed ==
+                                        totalRequests)
+                                    {
+                                        completions->done.set_value();
+                                    }
+                                });
+        }
+    });
+    REQUIRE(allDone.wait_for(std::chrono::seconds(30)) ==
+            std::future_status::ready);
+    CHECK(completions->failed == 0);
+
+    // One request for the identical ones, one with the other parameter and
+    // one with the cookie, the POST is not coalesced
+    auto metrics = client->coalescingMetrics();
+    CHECK(metrics.sent == 3);
+    CHECK(metrics.merged == static_cast<size_t>(identicalRequests - 1));
+    auto &responses = completions->responses;
+    REQUIRE(responses.size() == static_cast<size_t>(identicalRequests));
+    for (auto &resp : responses)
+    {
+        CHECK(resp == responses.front());
+    }
+
+    // Nothing in flight any more, the request is sent
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath("/pipe");
+    auto [result, resp] = client->sendRequest(req);
+    CHECK(result == ReqResult::Ok);
+    CHECK(client->coalescingMetrics().sent == 4);
+}
+
+DROGON_TEST(HttpClientCoalescingRangeTest)
+{
+    auto client =
+        HttpClient::newHttpClient("http://127.0.0.1:8848", app().getLoop());
+    client->enableRequestCoalescing();
+
+    struct Results
+    {
+        HttpResponsePtr plain;
+        HttpResponsePtr ranged;
+        std::atomic<int> completed{0};
+        std::promise<void> done;
+    };
+    auto results = std::make_shared<Results>();
+    auto allDone = results->done.get_future();
+    // Sent in the loop of the client, no response can arrive in between
+    app().getLoop()->runInLoop([client, results]() {
+        for (int i = 0; i < 2; ++i)
+        {
+            auto req = HttpRequest::newHttpRequest();
+            req->setPath("/range-test.txt");
+            if (i == 1)
+            {
+                req->addHeader("range", "bytes=0-19");
+            }
+            client->sendRequest(req,
+                                [results, i](ReqResult result,
+                                             const HttpResponsePtr &resp) {
+                                    if (result == ReqResult::Ok)
+                                    {
+                                        (i == 0 ? results->plain
+                                                : results->ranged) = resp;
+                                    }
+                                    if (++results->completed == 2)
+                                    {
+                                        results->done.set_value();
+                                    }
+                                });
+        }
+    });
+    REQUIRE(allDone.wait_for(std::chrono::seconds(30)) ==
+            std::future_status::ready);
+
+    // Each request got its own answer
+    REQUIRE(results->plain != nullptr);
+    REQUIRE(results->ranged != nullptr);
+    CHECK(results->plain->statusCode() == k200OK);
+    CHECK(results->plain->body().length() == 1000000);
+    CHECK(results->ranged->statusCode() == k206PartialContent);
+    CHECK(results->ranged->body().length() == 20);
+    // The ranged request is not a candidate at all
+    CHECK(client->coalescingMetrics().sent == 1);
+    CHECK(client->coalescingMetrics().merged == 0);
+}
@@ -0,0 +1,70 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpClientPool.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+
+using namespace drogon;
+
+DROGON_TEST(HttpClientPoolTest)
+{
+    auto pool = HttpClientPool::newHttpClientPool("http://127.0.0.1:8848",
+                                                  1,
+                                                  4,
+                                                  {app().getLoop()});
+
+    auto metrics = pool->metrics();
+    CHECK(metrics.connections == 0);
+    CHECK(metrics.requestsSent == 0);
+
+    const int totalRequests = 20;
+    struct Completions
+    {
+        std::atomic<int> completed{0};
+        std::atomic<int> succeeded{0};
+        std::promise<void> done;
+    };
+    // Shared with the callbacks, which may outlive the test if it times out
+    auto completions = std::make_shared<Completions>();
+    auto allDone = completions->done.get_future();
+
+    for (int i = 0; i < totalRequests; ++i)
+    {
+        auto req = HttpRequest::newHttpRequest();
+        // Most responses of /pipe are delayed, keeping the connections busy
+        req->setPath("/pipe");
+
+        pool->sendRequest(req,
+                          [completions](ReqResult result,
+                                        const HttpResponsePtr &) {
+                              if (result == ReqResult::Ok)
+                              {
+                                  completions->succeeded++;
+                              }
+                              if (++completions->completed == totalRequests)
+                              {
+                                  completions->done.set_value();
+                              }
+                          });
+    }
+
+    REQUIRE(allDone.wait_for(std::chrono::seconds(30)) ==
+            std::future_status::ready);
+    CHECK(completions->succeeded == totalRequests);
+
+    // The pool grew under load but not beyond its maximum
+    metrics = pool->metrics();
+    CHECK(metrics.requestsSent == static_cast<size_t>(totalRequests));
+    CHECK(metrics.connections > 1);
+    CHECK(metrics.connections <= 4);
+    CHECK(metrics.connectionsOpened == metrics.connections);
+    CHECK(metrics.outstandingRequests == 0);
+    CHECK(metrics.busyConnections == 0);
+    CHECK(pool->outstandingRequests() == 0);
+
+    auto [result, resp] = pool->sendRequest(HttpRequest::newHttpRequest());
+    CHECK(result == ReqResult::Ok);
+    CHECK(resp != nullptr);
+}
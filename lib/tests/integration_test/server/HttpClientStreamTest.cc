@@ -0,0 +1,64 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpClient.h>
+#include <atomic>
+#include <future>
+#include <string>
+
+using namespace drogon;
+
+DROGON_TEST(HttpClientStreamTest)
+{
+    auto client = HttpClient::newHttpClient("http://127.0.0.1:8848");
+
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath("/index.html");
+    auto [result, resp] = client->sendRequest(req);
+    REQUIRE(result == ReqResult::Ok);
+    REQUIRE(resp->body().length() > 0);
+    std::string expected(resp->body());
+
+    // The body arrives through the data callback, not in the response
+    auto body = std::make_shared<std::string>();
+    std::promise<ReqResult> finished;
+    auto f = finished.get_future();
+    req = HttpRequest::newHttpRequest();
+    req->setPath("/index.html");
+    client->sendStreamRequest(
+        req,
+        [TEST_CTX](ReqResult r, const HttpResponsePtr &response) {
+            REQUIRE(r == ReqResult::Ok);
+            CHECK(response->statusCode() == k200OK);
+            CHECK(response->body().empty());
+        },
+        [body](const char *data, size_t length) {
+            body->append(data, length);
+            return true;
+        },
+        [&finished](ReqResult r) { finished.set_value(r); });
+    CHECK(f.get() == ReqResult::Ok);
+    CHECK(*body == expected);
+
+    // Stopping the transfer skips the finish callback
+    std::promise<bool> stopped;
+    auto stoppedFuture = stopped.get_future();
+    std::atomic<bool> finishCalled{false};
+    req = HttpRequest::newHttpRequest();
+    req->setPath("/index.html");
+    client->sendStreamRequest(
+        req,
+        [](ReqResult, const HttpResponsePtr &) {},
+        [&stopped](const char *, size_t) {
+            stopped.set_value(true);
+            return false;
+        },
+        [&finishCalled](ReqResult) { finishCalled = true; });
+    CHECK(stoppedFuture.get());
+
+    // The client reconnects after the stopped transfer
+    req = HttpRequest::newHttpRequest();
+    req->setPath("/index.html");
+    std::tie(result, resp) = client->sendRequest(req);
+    CHECK(result == ReqResult::Ok);
+    CHECK(resp->body() == expected);
+    CHECK(!finishCalled);
+}
@@ -253,6 +253,8 @@ int main()
     std::string opaque("drogonOpaque");
     // Load configuration
     app().loadConfigFile("config.example.json");
+    // Accept the permessage-deflate offers of the WebSocket tests
+    app().enableWebSocketCompression();
     app().setImplicitPageEnable(true);
     app().setImplicitPage("page.html");
     auto &json = app().getCustomConfig();
@@ -0,0 +1,62 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/Utilities.h>
+#include "../../lib/src/CompressionCache.h"
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace drogon;
+
+static CompressionCache::BodyPtr waitFor(CompressionCache &cache,
+                                         CompressionCache::Encoding encoding,
+                                         const std::string &body)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        if (auto compressed = cache.find(encoding, body))
+            return compressed;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return nullptr;
+}
+
+DROGON_TEST(CompressionCache)
+{
+    std::string body;
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        body.append(std::to_string(i));
+    }
+    auto &cache = CompressionCache::instance();
+
+    // Disabled by default, nothing is queued
+    cache.init();
+    CHECK(cache.find(StreamEncoder::kGzip, body) == nullptr);
+    CHECK(cache.size() == 0);
+
+    cache.setCapacity(1024 * 1024);
+    cache.init();
+    // The first lookup misses and queues the compression
+    CHECK(cache.find(StreamEncoder::kGzip, body) == nullptr);
+    auto compressed = waitFor(cache, StreamEncoder::kGzip, body);
+    REQUIRE(compressed != nullptr);
+    CHECK(utils::gzipDecompress(compressed->data(), compressed->length()) ==
+          body);
+    CHECK(cache.size() == compressed->length());
+
+    // Keyed by the content, not by the buffer
+    std::string copy = body;
+    CHECK(cache.find(StreamEncoder::kGzip, copy) == compressed);
+
+    // The queued bodies don't take more memory than the cache
+    cache.setCapacity(body.length());
+    copy.append("x");
+    CHECK(cache.find(StreamEncoder::kGzip, copy) == nullptr);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(cache.find(StreamEncoder::kGzip, copy) == nullptr);
+
+    cache.reset();
+    CHECK(cache.size() == 0);
+    CHECK(cache.find(StreamEncoder::kGzip, body) == nullptr);
+    cache.setCapacity(0);
+}
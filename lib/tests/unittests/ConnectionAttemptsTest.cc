@@ -0,0 +1,203 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/ConnectionAttempts.h"
+#include "../../lib/src/DnsCache.h"
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/TcpServer.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+// Runs f in the loop and waits for it
+template <typename F>
+void runAndWait(trantor::EventLoop *loop, F &&f)
+{
+    std::promise<void> done;
+    loop->runInLoop([&]() {
+        f();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+// Connects to the addresses of a hostname given by a stub resolver
+struct Harness
+{
+    explicit Harness(trantor::EventLoop *loop) : loop(loop)
+    {
+    }
+
+    // The clients whose connection succeeds report a failed TLS handshake,
+    // as a broken endpoint would, up to this number
+    int brokenHandshakes{0};
+    trantor::EventLoop *loop;
+    std::shared_ptr<ConnectionAttempts> attempts;
+    std::shared_ptr<trantor::TcpClient> winner;
+    int clientsMade{0};
+    // Set by the error callback
+    ReqResult error{ReqResult::Ok};
+    // True when a client connected, false on error
+    std::promise<bool> finished;
+
+    void connect(const DnsCache::Addresses &resolved)
+    {
+        DnsCache dnsCache(
+            [resolved](const std::string &, DnsCache::Callback &&callback) {
+                callback(resolved);
+            });
+        DnsCache::Addresses addrs;
+        dnsCache.resolve("happy-eyeballs.test",
+                         [&addrs](const DnsCache::Addresses &a) {
+                             addrs = a;
+                         });
+        runAndWait(loop, [this, addrs]() {
+            attempts = std::make_shared<ConnectionAttempts>(
+                loop,
+                0.1,
+                [this](const trantor::InetAddress &addr) {
+                    return newClient(addr);
+                },
+                [this](ReqResult result) {
+                    error = result;
+                    finished.set_value(false);
+                });
+            attempts->start(addrs);
+        });
+    }
+
+    std::shared_ptr<trantor::TcpClient> newClient(
+        const trantor::InetAddress &addr)
+    {
+        ++clientsMade;
+        auto client = std::make_shared<trantor::TcpClient>(loop, addr, "test");
+        std::weak_ptr<trantor::TcpClient> weakClient = client;
+        client->setConnectionCallback(
+            [this, weakClient](const trantor::TcpConnectionPtr &conn) {
+                auto client = weakClient.lock();
+                if (!client || !conn->connected())
+                    return;
+                if (brokenHandshakes > 0)
+                {
+                    --brokenHandshakes;
+                    attempts->failed(client, ReqResult::HandshakeError);
+                    return;
+                }
+                if (attempts->connected(client))
+                {
+                    winner = client;
+                    finished.set_value(true);
+                }
+            });
+        client->setConnectionErrorCallback([this, weakClient]() {
+            if (auto client = weakClient.lock())
+                attempts->failed(client, ReqResult::BadServerAddress);
+        });
+        return client;
+    }
+
+    bool wait()
+    {
+        auto f = finished.get_future();
+        if (f.wait_for(std::chrono::seconds(10)) != std::future_status::ready)
+            return false;
+        return f.get();
+    }
+
+    void stop()
+    {
+        runAndWait(loop, [this]() {
+            attempts->stop();
+            if (winner)
+                winner->stop();
+            winner.reset();
+            attempts.reset();
+        });
+    }
+};
+
+// A port nobody listens on
+uint16_t closedPort()
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    uint16_t port{0};
+    runAndWait(loopThread.getLoop(), [&]() {
+        trantor::TcpServer server(loopThread.getLoop(),
+                                  trantor::InetAddress("127.0.0.1", 0),
+                                  "closed");
+        port = server.address().toPort();
+    });
+    return port;
+}
+}  // namespace
+
+DROGON_TEST(ConnectionAttemptsTest)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    std::unique_ptr<trantor::TcpServer> server;
+    runAndWait(loop, [&]() {
+        server = std::make_unique<trantor::TcpServer>(
+            loop, trantor::InetAddress("127.0.0.1", 0), "test");
+        server->setRecvMessageCallback(
+            [](const trantor::TcpConnectionPtr &, trantor::MsgBuffer *) {});
+        server->setConnectionCallback([](const trantor::TcpConnectionPtr &) {
+        });
+        server->start();
+    });
+    auto port = server->address().toPort();
+    REQUIRE(port != 0);
+    auto refused = closedPort();
+    REQUIRE(refused != 0);
+
+    // The unreachable address (TEST-NET-1) comes first, it fails or times
+    // out and the next one is tried
+    {
+        Harness harness(loop);
+        harness.connect({trantor::InetAddress("192.0.2.1", port),
+                         trantor::InetAddress("127.0.0.1", port)});
+        CHECK(harness.wait());
+        CHECK(harness.clientsMade == 2);
+        runAndWait(loop, [&]() {
+            CHECK(harness.winner != nullptr);
+            if (harness.winner)
+            {
+                CHECK(harness.winner->connection()->peerAddr().toIp() ==
+                      "127.0.0.1");
+            }
+            CHECK(!harness.attempts->connecting());
+        });
+        harness.stop();
+    }
+
+    // A failed TLS handshake doesn't end the other attempts
+    {
+        Harness harness(loop);
+        harness.brokenHandshakes = 1;
+        harness.connect({trantor::InetAddress("127.0.0.1", port),
+                         trantor::InetAddress("127.0.0.1", port)});
+        CHECK(harness.wait());
+        CHECK(harness.clientsMade == 2);
+        harness.stop();
+    }
+
+    // All the addresses fail, the error is the one of the last attempt
+    {
+        Harness harness(loop);
+        harness.brokenHandshakes = 1;
+        harness.connect({trantor::InetAddress("127.0.0.1", refused),
+                         trantor::InetAddress("127.0.0.1", port)});
+        CHECK(!harness.wait());
+        CHECK(harness.clientsMade == 2);
+        CHECK(harness.error == ReqResult::HandshakeError);
+        harness.stop();
+    }
+
+    runAndWait(loop, [&]() { server.reset(); });
+}
@@ -0,0 +1,182 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/DnsCache.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+// Answers the queries when told to, like a slow name server
+struct StubResolver
+{
+    std::vector<std::pair<std::string, DnsCache::Callback>> queries;
+    size_t count{0};
+
+    DnsCache::ResolveFunction function()
+    {
+        return [this](const std::string &hostname,
+                      DnsCache::Callback &&callback) {
+            ++count;
+            queries.emplace_back(hostname, std::move(callback));
+        };
+    }
+
+    void answer(const DnsCache::Addresses &addrs)
+    {
+        auto pending = std::move(queries);
+        queries.clear();
+        for (auto &query : pending)
+        {
+            query.second(addrs);
+        }
+    }
+};
+
+struct Result
+{
+    bool called{false};
+    DnsCache::Addresses addrs;
+
+    DnsCache::Callback callback()
+    {
+        return [this](const DnsCache::Addresses &a) {
+            called = true;
+            addrs = a;
+        };
+    }
+};
+}  // namespace
+
+DROGON_TEST(DnsCacheLookup)
+{
+    StubResolver resolver;
+    DnsCache cache(resolver.function());
+    cache.setStaleTtl(0);
+    const DnsCache::Addresses addrs{trantor::InetAddress("127.0.0.1", 0),
+                                    trantor::InetAddress("::1", 0, true)};
+
+    // The lookups waiting for the same hostname share the query
+    Result r1, r2;
+    cache.resolve("example.com", r1.callback());
+    cache.resolve("example.com", r2.callback());
+    CHECK(resolver.count == 1);
+    CHECK(!r1.called);
+    resolver.answer(addrs);
+    CHECK(r1.called);
+    CHECK(r2.called);
+    CHECK(r1.addrs.size() == 2);
+    CHECK(r2.addrs.size() == 2);
+
+    // Then it is cached, the callback is called at once
+    Result r3;
+    cache.resolve("example.com", r3.callback());
+    CHECK(r3.called);
+    CHECK(r3.addrs.size() == 2);
+    CHECK(resolver.count == 1);
+
+    // A failed query is cached too, the any address is dropped
+    Result r4, r5;
+    cache.resolve("bad.example.com", r4.callback());
+    resolver.answer({trantor::InetAddress()});
+    CHECK(r4.called);
+    CHECK(r4.addrs.empty());
+    cache.resolve("bad.example.com", r5.callback());
+    CHECK(r5.called);
+    CHECK(r5.addrs.empty());
+    CHECK(resolver.count == 2);
+
+    cache.clear();
+    CHECK(cache.size() == 0);
+}
+
+DROGON_TEST(DnsCacheExpiry)
+{
+    StubResolver resolver;
+    DnsCache cache(resolver.function());
+    cache.setTtl(0.05);
+    cache.setNegativeTtl(0.05);
+    cache.setStaleTtl(0);
+    const DnsCache::Addresses addrs{trantor::InetAddress("127.0.0.1", 0)};
+
+    Result r1;
+    cache.resolve("example.com", r1.callback());
+    resolver.answer(addrs);
+    CHECK(r1.called);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Expired and not served stale, the lookup waits for a new query
+    Result r2;
+    cache.resolve("example.com", r2.callback());
+    CHECK(!r2.called);
+    CHECK(resolver.count == 2);
+    resolver.answer({});
+    CHECK(r2.called);
+    CHECK(r2.addrs.empty());
+
+    // The negative entry expires as well
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Result r3;
+    cache.resolve("example.com", r3.callback());
+    CHECK(!r3.called);
+    resolver.answer(addrs);
+    CHECK(r3.addrs.size() == 1);
+}
+
+DROGON_TEST(DnsCacheStaleWhileRevalidate)
+{
+    StubResolver resolver;
+    DnsCache cache(resolver.function());
+    cache.setTtl(0.05);
+    cache.setStaleTtl(10);
+    const DnsCache::Addresses oldAddrs{trantor::InetAddress("127.0.0.1", 0)};
+    const DnsCache::Addresses newAddrs{trantor::InetAddress("127.0.0.2", 0)};
+
+    Result r1;
+    cache.resolve("example.com", r1.callback());
+    resolver.answer(oldAddrs);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // The stale addresses are returned while one query refreshes them
+    Result r2, r3;
+    cache.resolve("example.com", r2.callback());
+    cache.resolve("example.com", r3.callback());
+    CHECK(r2.called);
+    CHECK(r3.called);
+    REQUIRE(r2.addrs.size() == 1);
+    CHECK(r2.addrs[0].toIp() == "127.0.0.1");
+    CHECK(resolver.count == 2);
+
+    // A failed refresh keeps them
+    resolver.answer({});
+    Result r4;
+    cache.resolve("example.com", r4.callback());
+    REQUIRE(r4.addrs.size() == 1);
+    CHECK(r4.addrs[0].toIp() == "127.0.0.1");
+    CHECK(resolver.count == 3);
+
+    resolver.answer(newAddrs);
+    Result r5;
+    cache.resolve("example.com", r5.callback());
+    REQUIRE(r5.addrs.size() == 1);
+    CHECK(r5.addrs[0].toIp() == "127.0.0.2");
+    CHECK(resolver.count == 3);
+}
+
+DROGON_TEST(InterleaveAddressFamilies)
+{
+    const DnsCache::Addresses addrs{trantor::InetAddress("10.0.0.1", 0),
+                                    trantor::InetAddress("10.0.0.2", 0),
+                                    trantor::InetAddress("10.0.0.3", 0),
+                                    trantor::InetAddress("::1", 0, true),
+                                    trantor::InetAddress("::2", 0, true)};
+    auto sorted = interleaveAddressFamilies(addrs);
+    REQUIRE(sorted.size() == 5);
+    CHECK(sorted[0].toIp() == "::1");
+    CHECK(sorted[1].toIp() == "10.0.0.1");
+    CHECK(sorted[2].toIp() == "::2");
+    CHECK(sorted[3].toIp() == "10.0.0.2");
+    CHECK(sorted[4].toIp() == "10.0.0.3");
+}
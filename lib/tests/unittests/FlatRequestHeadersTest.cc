@@ -0,0 +1,67 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HttpRequestImpl.h"
+#include <string>
+#include <string_view>
+
+using namespace drogon;
+
+static void addLine(HttpRequestImpl &req, std::string_view line)
+{
+    auto colon = line.find(':');
+    req.addHeaderToFlatStorage(line.data(),
+                               line.data() + colon,
+                               line.data() + line.size());
+}
+
+DROGON_TEST(FlatRequestHeaders)
+{
+    HttpRequestImpl req(nullptr);
+    req.setVersion(Version::kHttp11);
+    addLine(req, "Host: example.com");
+    addLine(req, "Content-Type:  application/json  ");
+    addLine(req, "X-Dup: first");
+    addLine(req, "X-Dup: second");
+    addLine(req, "Cookie: a=1; b=2");
+    addLine(req, "Connection: close");
+
+    SUBSECTION(Views)
+    {
+        CHECK(req.getHeaderViewBy("host") == "example.com");
+        CHECK(req.getHeaderViewBy("content-type") == "application/json");
+        CHECK(req.getHeaderViewBy("x-dup") == "first");
+        CHECK(req.getHeaderViewBy("cookie").empty());
+        CHECK(req.getHeaderViewBy("missing").empty());
+        CHECK(req.keepAlive() == false);
+        CHECK(req.contentType() == CT_APPLICATION_JSON);
+    }
+
+    SUBSECTION(Materialize)
+    {
+        CHECK(req.getHeader("Host") == "example.com");
+        CHECK(req.headers().size() == 4);
+        CHECK(req.headers().count("cookie") == 0);
+        CHECK(req.getCookie("a") == "1");
+        CHECK(req.getCookie("b") == "2");
+        CHECK(req.cookies().size() == 2);
+    }
+
+    SUBSECTION(Modify)
+    {
+        req.addHeader("X-New", "new");
+        CHECK(req.getHeaderViewBy("x-new") == "new");
+        CHECK(req.getHeaderViewBy("host") == "example.com");
+        req.removeHeaderBy("host");
+        CHECK(req.getHeaderViewBy("host").empty());
+        req.addCookie("c", "3");
+        CHECK(req.getCookie("a") == "1");
+        CHECK(req.getCookie("c") == "3");
+    }
+
+    SUBSECTION(Reset)
+    {
+        req.reset();
+        CHECK(req.getHeaderViewBy("host").empty());
+        CHECK(req.headers().empty());
+        CHECK(req.cookies().empty());
+    }
+}
@@ -0,0 +1,156 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/Hpack.h"
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace drogon;
+using Fields = std::vector<std::pair<std::string, std::string>>;
+
+static std::string fromHex(const char *hex)
+{
+    std::string data;
+    while (*hex)
+    {
+        if (*hex == ' ')
+        {
+            ++hex;
+            continue;
+        }
+        unsigned value;
+        sscanf(hex, "%2x", &value);
+        data.push_back(static_cast<char>(value));
+        hex += 2;
+    }
+    return data;
+}
+
+static bool decode(HpackDecoder &decoder, const std::string &block, Fields &out)
+{
+    out.clear();
+    return decoder.decode(
+        reinterpret_cast<const uint8_t *>(block.data()),
+        block.size(),
+        [&out](std::string_view name, std::string_view value) {
+            out.emplace_back(name, value);
+        });
+}
+
+DROGON_TEST(HpackDecodeRfcExamples)
+{
+    // RFC 7541 C.4, requests with Huffman coding sharing a dynamic table
+    HpackDecoder decoder;
+    Fields fields;
+    CHECK(decode(decoder,
+                 fromHex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"),
+                 fields));
+    Fields expected{{":method", "GET"},
+                    {":scheme", "http"},
+                    {":path", "/"},
+                    {":authority", "www.example.com"}};
+    CHECK(fields == expected);
+    CHECK(decode(decoder, fromHex("8286 84be 5886 a8eb 1064 9cbf"), fields));
+    expected.emplace_back("cache-control", "no-cache");
+    CHECK(fields == expected);
+    CHECK(decode(decoder,
+                 fromHex("8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b "
+                         "b8e8 b4bf"),
+                 fields));
+    expected = {{":method", "GET"},
+                {":scheme", "https"},
+                {":path", "/index.html"},
+                {":authority", "www.example.com"},
+                {"custom-key", "custom-value"}};
+    CHECK(fields == expected);
+}
+
+DROGON_TEST(HpackRoundTrip)
+{
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    size_t firstSize = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        Fields headers{{":status", "200"},
+                       {"content-type", "text/html; charset=utf-8"},
+                       {"server", "drogon"},
+                       {"content-length", std::to_string(i * 1000)},
+                       {"set-cookie", "id=1"},
+                       {"x-binary", std::string("\x01\xff value", 8)}};
+        std::string block;
+        encoder.beginBlock(block);
+        for (auto &header : headers)
+            encoder.encode(header.first, header.second, block);
+        Fields fields;
+        CHECK(decode(decoder, block, fields));
+        CHECK(fields == headers);
+        if (i == 0)
+            firstSize = block.size();
+        else
+            // Repeated fields are sent as indexes of the dynamic table
+            CHECK(block.size() < firstSize);
+    }
+    // A smaller table is announced at the start of the next block
+    encoder.setMaxTableSize(0);
+    encoder.setMaxTableSize(100);
+    std::string block;
+    encoder.beginBlock(block);
+    encoder.encode("server", "drogon", block);
+    Fields fields;
+    CHECK(decode(decoder, block, fields));
+    CHECK(fields.size() == 1);
+    CHECK(fields[0].first == "server");
+    CHECK(fields[0].second == "drogon");
+}
+
+DROGON_TEST(HpackHuffman)
+{
+    std::string all;
+    for (int i = 0; i < 256; ++i)
+        all.push_back(static_cast<char>(i));
+    std::string encoded;
+    hpack::huffmanEncode(all, encoded);
+    CHECK(encoded.size() == hpack::huffmanEncodedLength(all));
+    std::string decoded;
+    CHECK(hpack::huffmanDecode(reinterpret_cast<const uint8_t *>(
+                                   encoded.data()),
+                               encoded.size(),
+                               decoded));
+    CHECK(decoded == all);
+    // The padding must be the most significant bits of EOS, all ones
+    const uint8_t badPadding[] = {0x00};
+    decoded.clear();
+    CHECK(!hpack::huffmanDecode(badPadding, sizeof(badPadding), decoded));
+}
+
+DROGON_TEST(HpackInvalidBlocks)
+{
+    HpackDecoder decoder;
+    Fields fields;
+    // Index 0 and indexes past the tables are errors
+    CHECK(!decode(decoder, fromHex("80"), fields));
+    CHECK(!decode(decoder, fromHex("ff 00"), fields));
+    // A truncated literal
+    CHECK(!decode(decoder, fromHex("40 0a 63 75"), fields));
+}
+
+DROGON_TEST(HpackHeaderListSize)
+{
+    HpackDecoder decoder;
+    decoder.setMaxHeaderListSize(200);
+    Fields fields;
+    // custom-key: custom-value added to the table (54 bytes), then 5 indexes
+    // of it, the fields past 200 bytes are dropped
+    auto block = fromHex("400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d "
+                         "7661 6c75 65be bebe bebe");
+    CHECK(decode(decoder, block, fields));
+    CHECK(decoder.headerListTooLarge());
+    CHECK(fields.size() == 3);
+    // The table is still updated by the fields dropped
+    CHECK(decode(decoder, fromHex("be"), fields));
+    CHECK(!decoder.headerListTooLarge());
+    REQUIRE(fields.size() == 1);
+    CHECK(fields[0].first == "custom-key");
+    CHECK(fields[0].second == "custom-value");
+}
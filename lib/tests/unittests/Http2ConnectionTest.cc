@@ -0,0 +1,406 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpResponse.h>
+#include "../../lib/src/Http2Connection.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include <trantor/net/EventLoopThread.h>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+enum : uint8_t
+{
+    kData = 0x0,
+    kHeaders = 0x1,
+    kRstStream = 0x3,
+    kSettings = 0x4,
+    kPing = 0x6,
+    kGoAway = 0x7,
+    kWindowUpdate = 0x8,
+    kContinuation = 0x9
+};
+
+enum : uint8_t
+{
+    kEndStream = 0x1,
+    kEndHeaders = 0x4
+};
+
+struct Frame
+{
+    uint8_t type;
+    uint8_t flags;
+    uint32_t streamId;
+    std::string payload;
+};
+
+std::string uint32ToString(uint32_t value)
+{
+    std::string data(4, '\0');
+    data[0] = static_cast<char>(value >> 24);
+    data[1] = static_cast<char>(value >> 16);
+    data[2] = static_cast<char>(value >> 8);
+    data[3] = static_cast<char>(value);
+    return data;
+}
+
+uint32_t readUint32(const std::string &data, size_t offset = 0)
+{
+    auto p = reinterpret_cast<const uint8_t *>(data.data()) + offset;
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+           (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+std::string frame(uint8_t type,
+                  uint8_t flags,
+                  uint32_t streamId,
+                  const std::string &payload = {})
+{
+    std::string data;
+    data.push_back(static_cast<char>(payload.size() >> 16));
+    data.push_back(static_cast<char>(payload.size() >> 8));
+    data.push_back(static_cast<char>(payload.size()));
+    data.push_back(static_cast<char>(type));
+    data.push_back(static_cast<char>(flags));
+    data.append(uint32ToString(streamId));
+    data.append(payload);
+    return data;
+}
+
+std::string setting(uint16_t id, uint32_t value)
+{
+    std::string data;
+    data.push_back(static_cast<char>(id >> 8));
+    data.push_back(static_cast<char>(id));
+    data.append(uint32ToString(value));
+    return data;
+}
+
+// GET / with the authority localhost, without changes to the table
+const std::string getRequest{"\x82\x86\x84\x01\x09localhost"};
+
+/**
+ * Drives a server connection from the test thread as a client would, the
+ * connection only runs in its loop.
+ */
+class TestClient
+{
+  public:
+    explicit TestClient(trantor::EventLoop *loop) : loop_(loop)
+    {
+        run([this]() {
+            connection_ = std::make_shared<Http2Connection>(loop_);
+            connection_->setRequestCallback(
+                [this](const HttpRequestImplPtr &req, uint32_t streamId) {
+                    requests.emplace_back(req, streamId);
+                });
+            connection_->setSendCallback([this](const char *data,
+                                                size_t len) {
+                output_.append(data, len);
+            });
+            connection_->setCloseCallback([this]() { closed = true; });
+            connection_->start();
+        });
+    }
+
+    ~TestClient()
+    {
+        run([this]() { connection_.reset(); });
+    }
+
+    void run(const std::function<void()> &function)
+    {
+        std::promise<void> done;
+        loop_->queueInLoop([&function, &done]() {
+            function();
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
+
+    /// The preface of the client and its SETTINGS frame
+    void start(const std::string &settings = {})
+    {
+        send(std::string(Http2Connection::clientPreface) +
+             frame(kSettings, 0, 0, settings));
+    }
+
+    void send(const std::string &data)
+    {
+        run([this, &data]() {
+            trantor::MsgBuffer buffer;
+            buffer.append(data);
+            connection_->onMessage(&buffer);
+        });
+    }
+
+    void respond(uint32_t streamId, const std::string &body)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setBody(body);
+        run([this, streamId, &resp]() {
+            connection_->sendResponse(streamId, resp, false);
+        });
+    }
+
+    size_t streamCount()
+    {
+        size_t count = 0;
+        run([this, &count]() { count = connection_->streamCount(); });
+        return count;
+    }
+
+    /// The frames received since the last call
+    std::vector<Frame> frames()
+    {
+        std::string output;
+        run([this, &output]() { output.swap(output_); });
+        std::vector<Frame> frames;
+        size_t pos = 0;
+        while (pos + 9 <= output.size())
+        {
+            auto p = reinterpret_cast<const uint8_t *>(output.data()) + pos;
+            size_t length = (size_t(p[0]) << 16) | (size_t(p[1]) << 8) | p[2];
+            Frame frame;
+            frame.type = p[3];
+            frame.flags = p[4];
+            frame.streamId = readUint32(output, pos + 5) & 0x7fffffff;
+            frame.payload = output.substr(pos + 9, length);
+            frames.push_back(std::move(frame));
+            pos += 9 + length;
+        }
+        return frames;
+    }
+
+    /// The fields of the header block of a HEADERS frame
+    std::vector<std::pair<std::string, std::string>> decode(
+        const Frame &frame)
+    {
+        std::vector<std::pair<std::string, std::string>> fields;
+        decoder_.decode(reinterpret_cast<const uint8_t *>(
+                            frame.payload.data()),
+                        frame.payload.size(),
+                        [&fields](std::string_view name,
+                                  std::string_view value) {
+                            fields.emplace_back(name, value);
+                        });
+        return fields;
+    }
+
+    std::vector<std::pair<HttpRequestImplPtr, uint32_t>> requests;
+    bool closed{false};
+
+  private:
+    trantor::EventLoop *loop_;
+    std::shared_ptr<Http2Connection> connection_;
+    std::string output_;
+    HpackDecoder decoder_;
+};
+
+const Frame *findFrame(const std::vector<Frame> &frames, uint8_t type)
+{
+    for (auto &frame : frames)
+    {
+        if (frame.type == type)
+            return &frame;
+    }
+    return nullptr;
+}
+
+std::string dataOf(const std::vector<Frame> &frames, uint32_t streamId)
+{
+    std::string data;
+    for (auto &frame : frames)
+    {
+        if (frame.type == kData && frame.streamId == streamId)
+            data.append(frame.payload);
+    }
+    return data;
+}
+}  // namespace
+
+DROGON_TEST(Http2ConnectionRequestResponse)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    TestClient client(loopThread.getLoop());
+
+    // The SETTINGS of the server announce the limits of the header lists
+    auto frames = client.frames();
+    REQUIRE(!frames.empty());
+    CHECK(frames[0].type == kSettings);
+    CHECK(frames[0].payload.find(
+              setting(0x6, Http2Connection::maxHeaderListSize)) !=
+          std::string::npos);
+
+    client.start();
+    client.send(frame(kHeaders, kEndHeaders | kEndStream, 1, getRequest));
+    REQUIRE(client.requests.size() == 1);
+    auto &req = client.requests[0].first;
+    CHECK(client.requests[0].second == 1);
+    CHECK(req->method() == Get);
+    CHECK(req->path() == "/");
+    CHECK(req->getHeader("host") == "localhost");
+
+    client.frames();
+    client.respond(1, "hello");
+    frames = client.frames();
+    auto headers = findFrame(frames, kHeaders);
+    REQUIRE(headers != nullptr);
+    CHECK(headers->streamId == 1);
+    auto fields = client.decode(*headers);
+    REQUIRE(!fields.empty());
+    CHECK(fields[0].first == ":status");
+    CHECK(fields[0].second == "200");
+    CHECK(dataOf(frames, 1) == "hello");
+    CHECK((frames.back().flags & kEndStream) != 0);
+    CHECK(client.streamCount() == 0);
+}
+
+DROGON_TEST(Http2ConnectionFlowControl)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    TestClient client(loopThread.getLoop());
+
+    // The windows of the streams are 3 bytes
+    client.start(setting(0x4, 3));
+    client.send(frame(kHeaders, kEndHeaders | kEndStream, 1, getRequest));
+    REQUIRE(client.requests.size() == 1);
+    client.frames();
+    client.respond(1, "hello");
+    auto frames = client.frames();
+    CHECK(dataOf(frames, 1) == "hel");
+    CHECK((frames.back().flags & kEndStream) == 0);
+    CHECK(client.streamCount() == 1);
+
+    client.send(frame(kWindowUpdate, 0, 1, uint32ToString(2)));
+    frames = client.frames();
+    CHECK(dataOf(frames, 1) == "lo");
+    REQUIRE(!frames.empty());
+    CHECK((frames.back().flags & kEndStream) != 0);
+    CHECK(client.streamCount() == 0);
+
+    // The connection window can not exceed 2^31-1 bytes
+    client.send(frame(kWindowUpdate, 0, 0, uint32ToString(0x7fffffff)));
+    frames = client.frames();
+    auto goAway = findFrame(frames, kGoAway);
+    REQUIRE(goAway != nullptr);
+    CHECK(readUint32(goAway->payload, 4) == 0x3);
+    CHECK(client.closed);
+}
+
+DROGON_TEST(Http2ConnectionFramingErrors)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    {
+        // The first frame of the client must be its SETTINGS
+        TestClient client(loopThread.getLoop());
+        client.send(std::string(Http2Connection::clientPreface) +
+                    frame(kPing, 0, 0, std::string(8, '\0')));
+        auto goAway = findFrame(client.frames(), kGoAway);
+        REQUIRE(goAway != nullptr);
+        CHECK(readUint32(goAway->payload, 4) == 0x1);
+    }
+    {
+        // PING frames are 8 bytes long
+        TestClient client(loopThread.getLoop());
+        client.start();
+        client.send(frame(kPing, 0, 0, std::string(7, '\0')));
+        auto goAway = findFrame(client.frames(), kGoAway);
+        REQUIRE(goAway != nullptr);
+        CHECK(readUint32(goAway->payload, 4) == 0x6);
+    }
+    {
+        // Frames larger than SETTINGS_MAX_FRAME_SIZE
+        TestClient client(loopThread.getLoop());
+        client.start();
+        client.send(frame(kData, 0, 1, std::string(16385, 'a')));
+        auto goAway = findFrame(client.frames(), kGoAway);
+        REQUIRE(goAway != nullptr);
+        CHECK(readUint32(goAway->payload, 4) == 0x6);
+    }
+    {
+        // Nothing can come between the frames of a header block
+        TestClient client(loopThread.getLoop());
+        client.start();
+        client.send(frame(kHeaders, 0, 1, getRequest) +
+                    frame(kPing, 0, 0, std::string(8, '\0')));
+        auto goAway = findFrame(client.frames(), kGoAway);
+        REQUIRE(goAway != nullptr);
+        CHECK(readUint32(goAway->payload, 4) == 0x1);
+        CHECK(client.requests.empty());
+    }
+}
+
+DROGON_TEST(Http2ConnectionHeaderListTooLarge)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    TestClient client(loopThread.getLoop());
+    client.start();
+
+    // A 4000 byte field added to the table, then referenced by 20000 one
+    // byte indexes: 80 MB of headers in a 24 KB block
+    std::string block{"\x82\x86\x84"};
+    block.append("\x40\x05x-big\x7f\xa1\x1e");
+    block.append(4000, 'a');
+    block.append(20000, '\xbe');
+    std::string frames{frame(kHeaders, kEndStream, 1, block.substr(0, 16384))};
+    frames.append(frame(kContinuation, kEndHeaders, 1, block.substr(16384)));
+    client.frames();
+    client.send(frames);
+    CHECK(client.requests.empty());
+    auto received = client.frames();
+    auto headers = findFrame(received, kHeaders);
+    REQUIRE(headers != nullptr);
+    CHECK(headers->streamId == 1);
+    auto fields = client.decode(*headers);
+    REQUIRE(!fields.empty());
+    CHECK(fields[0].second == "431");
+    CHECK(findFrame(received, kGoAway) == nullptr);
+    CHECK(client.streamCount() == 0);
+
+    // The table of the connection is still in sync with the client
+    client.send(frame(kHeaders,
+                      kEndHeaders | kEndStream,
+                      3,
+                      getRequest + std::string("\xbe")));
+    REQUIRE(client.requests.size() == 1);
+    CHECK(client.requests[0].second == 3);
+    CHECK(client.requests[0].first->getHeader("x-big") ==
+          std::string(4000, 'a'));
+}
+
+DROGON_TEST(Http2ConnectionRapidReset)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    TestClient client(loopThread.getLoop());
+    client.start();
+
+    // Streams opened and cancelled at once
+    std::string frames;
+    for (uint32_t i = 0; i <= Http2Connection::maxResetStreams; ++i)
+    {
+        uint32_t streamId = 2 * i + 1;
+        frames.append(
+            frame(kHeaders, kEndHeaders | kEndStream, streamId, getRequest));
+        frames.append(frame(kRstStream, 0, streamId, uint32ToString(0x8)));
+    }
+    client.frames();
+    client.send(frames);
+    CHECK(client.requests.size() == Http2Connection::maxResetStreams + 1);
+    auto goAway = findFrame(client.frames(), kGoAway);
+    REQUIRE(goAway != nullptr);
+    // ENHANCE_YOUR_CALM
+    CHECK(readUint32(goAway->payload, 4) == 0xb);
+    CHECK(client.closed);
+}
@@ -0,0 +1,197 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HttpClientCache.h"
+#include "../../lib/src/HttpRequestImpl.h"
+#include <cmath>
+#include <memory>
+#include <string>
+
+using namespace drogon;
+
+static HttpResponsePtr newResponse(const std::string &cacheControl)
+{
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setBody("cached body");
+    if (!cacheControl.empty())
+    {
+        resp->addHeader("cache-control", cacheControl);
+    }
+    return resp;
+}
+
+DROGON_TEST(HttpCacheControlTest)
+{
+    auto cacheControl = parseCacheControl(
+        "Max-Age=60, s-maxage=\"30\", no-cache, stale-while-revalidate=10");
+    CHECK(cacheControl.maxAge == 60);
+    CHECK(cacheControl.sMaxAge == 30);
+    CHECK(cacheControl.noCache);
+    CHECK(cacheControl.staleWhileRevalidate == 10);
+    CHECK(!cacheControl.noStore);
+    CHECK(!cacheControl.isPrivate);
+
+    cacheControl = parseCacheControl("private, max-age=abc, must-revalidate");
+    CHECK(cacheControl.isPrivate);
+    CHECK(cacheControl.mustRevalidate);
+    CHECK(cacheControl.maxAge < 0);
+    CHECK(cacheControl.sMaxAge < 0);
+}
+
+DROGON_TEST(HttpCacheEntryTest)
+{
+    SafeStringMap<std::string> reqHeaders;
+    auto now = trantor::Date::now();
+
+    auto entry = newHttpCacheEntry(newResponse("max-age=60"), reqHeaders, now);
+    REQUIRE(entry != nullptr);
+    CHECK(entry->freshnessLifetime == 60);
+    CHECK(!entry->mustRevalidate);
+    CHECK(entry->age(now) == 0);
+    CHECK(entry->size > entry->response->body().length());
+
+    // The cache is shared, s-maxage wins and forbids serving stale
+    entry = newHttpCacheEntry(newResponse("max-age=60, s-maxage=5"),
+                              reqHeaders,
+                              now);
+    REQUIRE(entry != nullptr);
+    CHECK(entry->freshnessLifetime == 5);
+    CHECK(entry->mustRevalidate);
+
+    CHECK(newHttpCacheEntry(newResponse("no-store, max-age=60"),
+                            reqHeaders,
+                            now) == nullptr);
+    CHECK(newHttpCacheEntry(newResponse("private, max-age=60"),
+                            reqHeaders,
+                            now) == nullptr);
+    // Neither fresh nor revalidatable
+    CHECK(newHttpCacheEntry(newResponse(""), reqHeaders, now) == nullptr);
+    auto resp = newResponse("max-age=60");
+    resp->setStatusCode(k500InternalServerError);
+    CHECK(newHttpCacheEntry(resp, reqHeaders, now) == nullptr);
+
+    // A validator is enough, the response is revalidated before each use
+    resp = newResponse("no-cache");
+    resp->addHeader("etag", "\"v1\"");
+    entry = newHttpCacheEntry(resp, reqHeaders, now);
+    REQUIRE(entry != nullptr);
+    CHECK(entry->freshnessLifetime == 0);
+    CHECK(entry->mustRevalidate);
+
+    // The age given by the server counts
+    resp = newResponse("max-age=60, stale-while-revalidate=30");
+    resp->addHeader("age", "10");
+    entry = newHttpCacheEntry(resp, reqHeaders, now);
+    REQUIRE(entry != nullptr);
+    CHECK(std::fabs(entry->age(now) - 10) < 0.001);
+    CHECK(entry->staleWhileRevalidate == 30);
+
+    // Credentials are only stored when allowed
+    reqHeaders["authorization"] = "Bearer token";
+    CHECK(newHttpCacheEntry(newResponse("max-age=60"), reqHeaders, now) ==
+          nullptr);
+    CHECK(newHttpCacheEntry(newResponse("public, max-age=60"),
+                            reqHeaders,
+                            now) != nullptr);
+}
+
+DROGON_TEST(HttpCacheVaryTest)
+{
+    SafeStringMap<std::string> reqHeaders;
+    reqHeaders["accept-encoding"] = "gzip";
+    auto now = trantor::Date::now();
+
+    auto resp = newResponse("max-age=60");
+    resp->addHeader("vary", "Accept-Encoding, Accept-Language");
+    auto entry = newHttpCacheEntry(resp, reqHeaders, now);
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->vary.size() == 2);
+
+    auto req = std::make_shared<HttpRequestImpl>(nullptr);
+    req->addHeader("accept-encoding", "gzip");
+    CHECK(httpCacheVaryMatches(*entry, *req));
+    req->addHeader("accept-language", "fr");
+    CHECK(!httpCacheVaryMatches(*entry, *req));
+
+    resp = newResponse("max-age=60");
+    resp->addHeader("vary", "*");
+    CHECK(newHttpCacheEntry(resp, reqHeaders, now) == nullptr);
+}
+
+DROGON_TEST(HttpCacheRefreshTest)
+{
+    SafeStringMap<std::string> reqHeaders;
+    auto now = trantor::Date::now();
+    auto resp = newResponse("max-age=0");
+    resp->addHeader("etag", "\"v1\"");
+    auto entry = newHttpCacheEntry(resp, reqHeaders, now);
+    REQUIRE(entry != nullptr);
+
+    auto notModified = HttpResponse::newHttpResponse();
+    notModified->setStatusCode(k304NotModified);
+    notModified->addHeader("cache-control", "max-age=120");
+    auto later = now.after(30);
+    auto refreshed = refreshHttpCacheEntry(*entry, notModified, later);
+    CHECK(refreshed->response == entry->response);
+    CHECK(refreshed->freshnessLifetime == 120);
+    CHECK(refreshed->age(later) == 0);
+
+    // Without freshness information, the stored one applies again
+    notModified->removeHeader("cache-control");
+    refreshed = refreshHttpCacheEntry(*entry, notModified, later);
+    CHECK(refreshed->freshnessLifetime == 0);
+    CHECK(refreshed->age(later) == 0);
+}
+
+DROGON_TEST(HttpCacheCopyTest)
+{
+    SafeStringMap<std::string> reqHeaders;
+    auto resp = newResponse("max-age=60");
+    auto entry = newHttpCacheEntry(resp, reqHeaders, trantor::Date::now());
+    REQUIRE(entry != nullptr);
+    // The user of the response received changes it after it is stored
+    CHECK(entry->response != resp);
+    resp->addHeader("x-changed", "1");
+    resp->setBody("changed");
+    CHECK(entry->response->getHeader("x-changed").empty());
+    CHECK(entry->response->body() == "cached body");
+
+    auto first = copyCachedResponse(entry->response);
+    auto second = copyCachedResponse(entry->response);
+    CHECK(first != second);
+    CHECK(first->body() == "cached body");
+    CHECK(first->getHeader("cache-control") == "max-age=60");
+    first->removeHeader("cache-control");
+    first->setBody("first");
+    CHECK(second->getHeader("cache-control") == "max-age=60");
+    CHECK(second->body() == "cached body");
+    CHECK(entry->response->body() == "cached body");
+}
+
+DROGON_TEST(HttpCacheMemoryStoreTest)
+{
+    auto store = HttpCacheStore::newMemoryStore(1000);
+    auto newEntry = [](size_t size) {
+        auto entry = std::make_shared<HttpCacheEntry>();
+        entry->size = size;
+        return entry;
+    };
+    store->put("a", newEntry(400));
+    store->put("b", newEntry(400));
+    CHECK(store->get("a") != nullptr);
+    // b is the least recently used
+    store->put("c", newEntry(400));
+    CHECK(store->get("a") != nullptr);
+    CHECK(store->get("b") == nullptr);
+    CHECK(store->get("c") != nullptr);
+
+    // Replaced, not added
+    store->put("c", newEntry(500));
+    CHECK(store->get("a") != nullptr);
+    CHECK(store->get("c")->size == 500);
+
+    // Larger than the store
+    store->put("d", newEntry(2000));
+    CHECK(store->get("d") == nullptr);
+
+    store->erase("a");
+    CHECK(store->get("a") == nullptr);
+}
@@ -258,3 +258,59 @@ DROGON_TEST(ClearHeaders)
     // verify path unchanged
     CHECK(req->path() == "/api/test");
 }
+
+DROGON_TEST(FrozenHeadersResponse)
+{
+    auto templ = HttpResponse::newHttpResponse(k200OK, CT_APPLICATION_JSON);
+    templ->addHeader("X-Api", "v1");
+    templ->freezeHeaders();
+    auto templImpl = std::dynamic_pointer_cast<HttpResponseImpl>(templ);
+    REQUIRE(templImpl != nullptr);
+    CHECK(templImpl->headersFrozen());
+    CHECK(templ->getHeader("x-api") == "v1");
+
+    auto resp = std::dynamic_pointer_cast<HttpResponseImpl>(
+        HttpResponse::newHttpResponseFromTemplate(templ, "{\"a\":1}"));
+    REQUIRE(resp != nullptr);
+    CHECK(resp->headersFrozen());
+    CHECK(resp->getHeader("X-Api") == "v1");
+    CHECK(resp->contentType() == CT_APPLICATION_JSON);
+    // The server sets these on every response, unchanged values keep the
+    // frozen block
+    resp->setVersion(Version::kHttp11);
+    resp->setCloseConnection(false);
+    CHECK(resp->headersFrozen());
+
+    auto buffer = resp->renderToBuffer();
+    auto str = std::string{buffer->peek(), buffer->readableBytes()};
+    CHECK(str.find("HTTP/1.1 200 OK\r\n") == 0);
+    CHECK(str.find("x-api: v1\r\n") != std::string::npos);
+    CHECK(str.find("content-type: application/json") != std::string::npos);
+    CHECK(str.find("content-length: 7\r\n") != std::string::npos);
+    CHECK(str.find("\r\n\r\n{\"a\":1}") == str.size() - 11);
+
+    // The template is not affected by the body of the new response
+    buffer = templImpl->renderToBuffer();
+    str = std::string{buffer->peek(), buffer->readableBytes()};
+    CHECK(str.find("content-length: 0\r\n") != std::string::npos);
+
+    // Modifying the headers thaws only the modified response
+    resp->addHeader("X-Extra", "1");
+    CHECK(!resp->headersFrozen());
+    CHECK(resp->getHeader("x-api") == "v1");
+    CHECK(templImpl->headersFrozen());
+    buffer = resp->renderToBuffer();
+    str = std::string{buffer->peek(), buffer->readableBytes()};
+    CHECK(str.find("x-api: v1\r\n") != std::string::npos);
+    CHECK(str.find("x-extra: 1\r\n") != std::string::npos);
+    CHECK(str.find("content-length: 7\r\n") != std::string::npos);
+
+    resp = std::dynamic_pointer_cast<HttpResponseImpl>(
+        HttpResponse::newHttpResponseFromTemplate(templ, "{}"));
+    resp->setCloseConnection(true);
+    CHECK(!resp->headersFrozen());
+    buffer = resp->renderToBuffer();
+    str = std::string{buffer->peek(), buffer->readableBytes()};
+    CHECK(str.find("connection: close\r\n") != std::string::npos);
+    CHECK(str.find("content-length: 2\r\n") != std::string::npos);
+}
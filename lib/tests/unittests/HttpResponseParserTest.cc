@@ -0,0 +1,64 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/HttpResponseImpl.h"
+#include "../../lib/src/HttpResponseParser.h"
+#include <trantor/utils/MsgBuffer.h>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+DROGON_TEST(HttpResponseParserStreamChunks)
+{
+    HttpResponseParser parser(nullptr);
+    bool headersReceived{false};
+    std::vector<std::string> pieces;
+    parser.setStreamCallbacks(
+        [&headersReceived]() { headersReceived = true; },
+        [&pieces](const char *data, size_t length) {
+            pieces.emplace_back(data, length);
+            return true;
+        });
+    trantor::MsgBuffer buffer;
+    buffer.append("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n");
+    // A chunk of 64 KiB
+    buffer.append("10000\r\n");
+    CHECK(parser.parseResponse(&buffer));
+    CHECK(headersReceived);
+    CHECK(pieces.empty());
+
+    // The start of the chunk is delivered before the rest arrives
+    std::string part(1000, 'a');
+    buffer.append(part);
+    CHECK(parser.parseResponse(&buffer));
+    REQUIRE(pieces.size() == 1UL);
+    CHECK(pieces[0] == part);
+    CHECK(buffer.readableBytes() == 0UL);
+
+    buffer.append(std::string(0x10000 - part.size(), 'b'));
+    buffer.append("\r");
+    CHECK(parser.parseResponse(&buffer));
+    CHECK(pieces.size() == 2UL);
+    CHECK(!parser.gotAll());
+    buffer.append("\n3\r\nxyz\r\n0\r\n\r\n");
+    CHECK(parser.parseResponse(&buffer));
+    CHECK(parser.gotAll());
+
+    std::string body;
+    for (auto &piece : pieces)
+        body.append(piece);
+    CHECK(body.size() == 0x10003UL);
+    CHECK(body.substr(0, part.size()) == part);
+    CHECK(body.substr(0x10000) == "xyz");
+    CHECK(parser.responseImpl()->getBody().empty());
+}
+
+DROGON_TEST(HttpResponseParserBadChunkEnd)
+{
+    HttpResponseParser parser(nullptr);
+    parser.setStreamCallbacks([]() {},
+                              [](const char *, size_t) { return true; });
+    trantor::MsgBuffer buffer;
+    buffer.append("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n");
+    buffer.append("3\r\nabcX\r\n");
+    CHECK(!parser.parseResponse(&buffer));
+}
@@ -0,0 +1,72 @@
+#include "../../lib/src/utils/HttpScan.h"
+#include <drogon/drogon_test.h>
+#include <random>
+#include <string>
+
+using namespace drogon::utils;
+
+static const char *scalarFindCRLF(const char *begin, const char *end)
+{
+    for (auto p = begin; p + 1 < end; ++p)
+    {
+        if (p[0] == '\r' && p[1] == '\n')
+            return p;
+    }
+    return nullptr;
+}
+
+DROGON_TEST(HttpScanTest)
+{
+    const auto defaultKernel = std::string(httpScanKernelName());
+
+    SUBSECTION(Basic)
+    {
+        std::string line = "GET /index.html HTTP/1.1\r\nHost: a\r\n";
+        auto begin = line.data();
+        auto end = begin + line.size();
+        CHECK(findCRLF(begin, end) == begin + 24);
+        CHECK(findCRLF(begin, begin + 25) == nullptr);
+        CHECK(findNonTokenChar(begin, begin + 3) == begin + 3);
+        CHECK(findNonTokenChar(begin, end) == begin + 3);
+        CHECK(findControlChar(begin, end) == begin + 24);
+        std::string value = "text/html;\tq=0.9";
+        CHECK(findControlChar(value.data(), value.data() + value.size()) ==
+              value.data() + value.size());
+        std::string name = "X-Custom_Header~|^`";
+        CHECK(findNonTokenChar(name.data(), name.data() + name.size()) ==
+              name.data() + name.size());
+    }
+
+    SUBSECTION(KernelsAgree)
+    {
+        std::mt19937 rng(42);
+        const char *kernels[] = {"scalar", "sse4.2", "avx2"};
+        for (int iteration = 0; iteration < 2000; ++iteration)
+        {
+            std::string data(rng() % 100, 'a');
+            for (auto &c : data)
+            {
+                auto r = rng() % 16;
+                c = r == 0   ? '\r'
+                    : r == 1 ? '\n'
+                    : r == 2 ? static_cast<char>(rng() % 256)
+                             : static_cast<char>('a' + rng() % 26);
+            }
+            auto begin = data.data() + (data.empty() ? 0 : rng() % data.size());
+            auto end = data.data() + data.size();
+            for (auto kernel : kernels)
+            {
+                if (!internal::setHttpScanKernel(kernel))
+                    continue;
+                CHECK(findCRLF(begin, end) == scalarFindCRLF(begin, end));
+                internal::setHttpScanKernel("scalar");
+                auto token = findNonTokenChar(begin, end);
+                auto control = findControlChar(begin, end);
+                internal::setHttpScanKernel(kernel);
+                CHECK(findNonTokenChar(begin, end) == token);
+                CHECK(findControlChar(begin, end) == control);
+            }
+        }
+        internal::setHttpScanKernel(defaultKernel.c_str());
+    }
+}
@@ -0,0 +1,84 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/LoopMetrics.h"
+#include <trantor/net/EventLoopThread.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+using namespace drogon::monitoring;
+
+// The value of the sample of the loop, -1 when missing
+static double sampleValue(const std::shared_ptr<CollectorBase> &collector,
+                          const std::string &loop,
+                          const std::string &sampleName)
+{
+    for (auto &group : collector->collect())
+    {
+        if (group.metric->labels().empty() ||
+            group.metric->labels()[0].second != loop)
+            continue;
+        for (auto &sample : group.samples)
+        {
+            if (sample.name == sampleName)
+                return sample.value;
+        }
+    }
+    return -1;
+}
+
+DROGON_TEST(LoopMetricsTest)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    auto &loopMetrics = LoopMetrics::instance();
+    loopMetrics.watch(loop, "test");
+
+    LoopMetrics::Options options;
+    options.interval = 0.01;
+    options.slowCallbackThreshold = 0.005;
+    auto collectors = loopMetrics.enable(options);
+    REQUIRE(collectors.size() == 5);
+    auto &lag = collectors[0];
+    auto &queueDelay = collectors[1];
+    auto &busyRatio = collectors[2];
+    auto &connections = collectors[3];
+    auto &slowCallbacks = collectors[4];
+
+    std::promise<void> done;
+    loop->queueInLoop([&done, &loopMetrics]() {
+        loopMetrics.onConnection(true);
+        loopMetrics.onConnection(true);
+        loopMetrics.onConnection(false);
+        {
+            LoopMetrics::BusyScope busyScope;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        done.set_value();
+    });
+    done.get_future().get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    CHECK(sampleValue(lag, "test0", lag->name() + "_count") > 0);
+    CHECK(sampleValue(queueDelay, "test0", queueDelay->name()) >= 0);
+    CHECK(sampleValue(busyRatio, "test0", busyRatio->name()) >= 0);
+    CHECK(sampleValue(connections, "test0", connections->name()) == 1);
+    CHECK(sampleValue(slowCallbacks, "test0", slowCallbacks->name()) == 1);
+
+    // The data processed outside of the sampled loops is not measured
+    {
+        LoopMetrics::BusyScope busyScope;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(sampleValue(slowCallbacks, "test0", slowCallbacks->name()) == 1);
+
+    loopMetrics.unwatch(loop);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto count = sampleValue(lag, "test0", lag->name() + "_count");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(sampleValue(lag, "test0", lag->name() + "_count") == count);
+}
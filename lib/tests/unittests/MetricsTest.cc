@@ -0,0 +1,92 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/monitoring/Counter.h>
+#include <drogon/utils/monitoring/Gauge.h>
+#include <drogon/utils/monitoring/Histogram.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace drogon::monitoring;
+
+static void runThreads(size_t count, const std::function<void()> &func)
+{
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; ++i)
+        threads.emplace_back(func);
+    for (auto &thread : threads)
+        thread.join();
+}
+
+DROGON_TEST(ShardedCounterTest)
+{
+    auto counter = std::make_shared<Counter>("requests",
+                                             std::vector<std::string>{},
+                                             std::vector<std::string>{});
+    runThreads(8, [&counter]() {
+        for (int i = 0; i < 10000; ++i)
+            counter->increment();
+        counter->increment(0.5);
+    });
+    CHECK(counter->collect()[0].value == 80004);
+    counter->reset();
+    CHECK(counter->collect()[0].value == 0);
+    counter->increment();
+    CHECK(counter->collect()[0].value == 1);
+}
+
+DROGON_TEST(ShardedGaugeTest)
+{
+    auto gauge = std::make_shared<Gauge>("connections",
+                                         std::vector<std::string>{},
+                                         std::vector<std::string>{});
+    runThreads(8, [&gauge]() {
+        for (int i = 0; i < 10000; ++i)
+        {
+            gauge->increment(2);
+            gauge->decrement();
+        }
+    });
+    CHECK(gauge->collect()[0].value == 80000);
+    gauge->set(5);
+    CHECK(gauge->collect()[0].value == 5);
+    gauge->decrement(2);
+    CHECK(gauge->collect()[0].value == 3);
+    gauge->reset();
+    CHECK(gauge->collect()[0].value == 0);
+}
+
+DROGON_TEST(ShardedHistogramTest)
+{
+    auto histogram = std::make_shared<Histogram>("latency",
+                                                 std::vector<std::string>{},
+                                                 std::vector<std::string>{},
+                                                 std::vector<double>{1, 2, 4},
+                                                 std::chrono::seconds(0),
+                                                 0);
+    runThreads(4, [&histogram]() {
+        for (int i = 0; i < 1000; ++i)
+        {
+            histogram->observe(0.5);
+            histogram->observe(2);
+            histogram->observe(3);
+            histogram->observe(8);
+        }
+    });
+    auto samples = histogram->collect();
+    REQUIRE(samples.size() == 6);
+    // The buckets are cumulative, a value equal to a bound is counted in its
+    // bucket
+    CHECK(samples[0].exLabels[0].second == std::to_string(1.0));
+    CHECK(samples[0].value == 4000);
+    CHECK(samples[1].value == 8000);
+    CHECK(samples[2].value == 12000);
+    CHECK(samples[3].exLabels[0].second == "+Inf");
+    CHECK(samples[3].value == 16000);
+    CHECK(samples[4].name == "latency_sum");
+    CHECK(samples[4].value == 4000 * (0.5 + 2 + 3 + 8));
+    CHECK(samples[5].name == "latency_count");
+    CHECK(samples[5].value == 16000);
+}
@@ -1,5 +1,13 @@
 #include <drogon/PubSubService.h>
 #include <drogon/drogon_test.h>
+#include <trantor/net/EventLoopThread.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 DROGON_TEST(PubSubServiceTest)
 {
@@ -16,3 +24,184 @@ DROGON_TEST(PubSubServiceTest)
     service.unsubscribe("topic1", id);
     CHECK(service.size() == 0UL);
 }
+
+DROGON_TEST(PubSubServiceShardsTest)
+{
+    drogon::PubSubService<int> service;
+    int received{0};
+    std::vector<drogon::SubscriberID> ids;
+    for (int i = 0; i < 1000; ++i)
+    {
+        ids.push_back(service.subscribe(
+            "topic" + std::to_string(i),
+            [&received](const std::string &, const int &message) {
+                received += message;
+            }));
+    }
+    CHECK(service.size() == 1000UL);
+    for (int i = 0; i < 1000; ++i)
+        service.publish("topic" + std::to_string(i), 1);
+    CHECK(received == 1000);
+    CHECK(!service.isTopicEmpty("topic500"));
+    service.removeTopic("topic500");
+    CHECK(service.isTopicEmpty("topic500"));
+    for (int i = 0; i < 1000; ++i)
+        service.unsubscribe("topic" + std::to_string(i), ids[i]);
+    CHECK(service.size() == 0UL);
+}
+
+DROGON_TEST(PubSubServiceConcurrencyTest)
+{
+    drogon::PubSubService<int> service;
+    std::atomic<int> received{0};
+    service.subscribe("topic", [&received](const std::string &, const int &) {
+        ++received;
+    });
+    std::atomic<bool> done{false};
+    // Subscriptions change while the messages are published
+    std::thread subscriber([&service, &done]() {
+        while (!done)
+        {
+            auto id = service.subscribe("topic",
+                                        [](const std::string &, const int &) {
+                                        });
+            service.unsubscribe("topic", id);
+        }
+    });
+    std::vector<std::thread> publishers;
+    for (int i = 0; i < 4; ++i)
+    {
+        publishers.emplace_back([&service]() {
+            for (int j = 0; j < 10000; ++j)
+                service.publish("topic", j);
+        });
+    }
+    for (auto &publisher : publishers)
+        publisher.join();
+    done = true;
+    subscriber.join();
+    CHECK(received == 40000);
+    CHECK(service.size() == 1UL);
+}
+
+DROGON_TEST(PubSubServiceUnsubscribeTest)
+{
+    drogon::PubSubService<int> service;
+    std::promise<void> started;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic<bool> handlerDone{false};
+    auto id = service.subscribe(
+        "topic", [&](const std::string &, const int &) {
+            started.set_value();
+            released.wait();
+            // The subscriptions of any shard can change meanwhile
+            for (int i = 0; i < 32; ++i)
+            {
+                auto name = "other" + std::to_string(i);
+                service.unsubscribe(
+                    name,
+                    service.subscribe(name,
+                                      [](const std::string &, const int &) {
+                                      }));
+            }
+            handlerDone = true;
+        });
+    std::thread publisher([&service]() { service.publish("topic", 1); });
+    started.get_future().wait();
+
+    // Unsubscribing waits for the handler
+    std::atomic<bool> unsubscribed{false};
+    bool handlerDoneFirst{false};
+    std::thread unsubscriber([&]() {
+        service.unsubscribe("topic", id);
+        handlerDoneFirst = handlerDone;
+        unsubscribed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!unsubscribed);
+    release.set_value();
+    publisher.join();
+    unsubscriber.join();
+    CHECK(handlerDoneFirst);
+    CHECK(service.size() == 0UL);
+
+    // A handler can unsubscribe itself
+    int calls{0};
+    drogon::SubscriberID self{0};
+    self = service.subscribe("self", [&](const std::string &, const int &) {
+        ++calls;
+        service.unsubscribe("self", self);
+    });
+    service.publish("self", 1);
+    service.publish("self", 2);
+    CHECK(calls == 1);
+    CHECK(service.size() == 0UL);
+}
+
+DROGON_TEST(PubSubServiceLoopTest)
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    drogon::PubSubService<int> service;
+
+    std::vector<int> received;
+    bool inLoop{true};
+    std::promise<void> allReceived;
+    service.subscribe(
+        "topic",
+        [&](const std::string &, const int &message) {
+            inLoop = inLoop && loop->isInLoopThread();
+            received.push_back(message);
+            if (received.size() == 200)
+                allReceived.set_value();
+        },
+        loop);
+    int unsubscribedCalls{0};
+    auto id = service.subscribe(
+        "topic",
+        [&unsubscribedCalls](const std::string &, const int &) {
+            ++unsubscribedCalls;
+        },
+        loop);
+
+    // The messages published while the loop is busy wait for it, the ones
+    // published before unsubscribing are not delivered after
+    std::promise<void> release;
+    auto released = release.get_future();
+    loop->queueInLoop([&released]() { released.wait(); });
+    for (int i = 0; i < 100; ++i)
+        service.publish("topic", i);
+    service.unsubscribe("topic", id);
+    release.set_value();
+    for (int i = 100; i < 200; ++i)
+        service.publish("topic", i);
+
+    REQUIRE(allReceived.get_future().wait_for(std::chrono::seconds(30)) ==
+            std::future_status::ready);
+    CHECK(inLoop);
+    CHECK(unsubscribedCalls == 0);
+    bool ordered{true};
+    for (int i = 0; i < 200; ++i)
+        ordered = ordered && received[i] == i;
+    CHECK(ordered);
+
+    // Neither are the ones published before the topic is removed
+    int removedCalls{0};
+    service.subscribe(
+        "removed",
+        [&removedCalls](const std::string &, const int &) { ++removedCalls; },
+        loop);
+    std::promise<void> releaseAgain;
+    auto releasedAgain = releaseAgain.get_future();
+    loop->queueInLoop([&releasedAgain]() { releasedAgain.wait(); });
+    service.publish("removed", 1);
+    service.removeTopic("removed");
+    releaseAgain.set_value();
+    std::promise<void> drained;
+    loop->queueInLoop([&drained]() { drained.set_value(); });
+    REQUIRE(drained.get_future().wait_for(std::chrono::seconds(30)) ==
+            std::future_status::ready);
+    CHECK(removedCalls == 0);
+}
@@ -0,0 +1,122 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpResponse.h>
+#include "../../lib/src/RequestMetrics.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+using namespace drogon::monitoring;
+
+// The value of the sample of the metric with the given label values
+static double sampleValue(const std::shared_ptr<CollectorBase> &collector,
+                          const std::vector<std::string> &labelValues,
+                          const std::string &sampleName)
+{
+    for (auto &group : collector->collect())
+    {
+        auto &labels = group.metric->labels();
+        if (labels.size() != labelValues.size())
+            continue;
+        bool matched = true;
+        for (size_t i = 0; i < labels.size(); ++i)
+            matched = matched && labels[i].second == labelValues[i];
+        if (!matched)
+            continue;
+        for (auto &sample : group.samples)
+        {
+            if (sample.name == sampleName)
+                return sample.value;
+        }
+    }
+    return -1;
+}
+
+static double requestCount(const std::shared_ptr<CollectorBase> &requests,
+                           const std::string &route,
+                           const std::string &status)
+{
+    return sampleValue(requests, {"GET", route, status}, requests->name());
+}
+
+static void answer(const std::string &pattern,
+                   HttpStatusCode code,
+                   bool handled,
+                   const std::string &body = "")
+{
+    auto &metrics = RequestMetrics::instance();
+    HttpRequestImpl req(nullptr);
+    req.setMethod(Get);
+    req.setMatchedPathPattern(pattern);
+    req.setCreationDate(trantor::Date::now());
+    metrics.onRouting(req);
+    if (handled)
+        metrics.onHandling(req);
+    metrics.onResponse(req);
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setStatusCode(code);
+    resp->setBody(body);
+    metrics.onResponseQueued(req, *resp);
+}
+
+DROGON_TEST(RequestMetricsTest)
+{
+    RequestMetrics::Options options;
+    options.maxRoutes = 3;
+    auto collectors = RequestMetrics::instance().enable(options);
+    REQUIRE(collectors.size() == 6);
+    auto &requests = collectors[0];
+    auto &inFlight = collectors[1];
+    auto &duration = collectors[2];
+    auto &phases = collectors[3];
+    auto &responseSize = collectors[5];
+
+    // The patterns are kept by the routers for the life of the application
+    static const std::string itemPattern{"/items/{id}"};
+    static const std::string userPattern{"/users/{id}"};
+    static const std::string orderPattern{"/orders/{id}"};
+    static const std::string cartPattern{"/cart"};
+
+    answer(itemPattern, k200OK, true, "hello");
+    answer(itemPattern, k201Created, true);
+    answer(itemPattern, k404NotFound, true);
+    CHECK(requestCount(requests, itemPattern, "2xx") == 2);
+    CHECK(requestCount(requests, itemPattern, "4xx") == 1);
+    CHECK(sampleValue(duration,
+                      {"GET", itemPattern},
+                      duration->name() + "_count") == 3);
+    CHECK(sampleValue(phases,
+                      {"GET", itemPattern, "handler"},
+                      phases->name() + "_count") == 3);
+    CHECK(sampleValue(responseSize,
+                      {"GET", itemPattern},
+                      responseSize->name() + "_sum") == 5);
+    CHECK(sampleValue(inFlight, {}, inFlight->name()) == 0);
+
+    // Answered before reaching a handler
+    answer("", k404NotFound, false);
+    CHECK(requestCount(requests, "<unmatched>", "4xx") == 1);
+    CHECK(sampleValue(phases,
+                      {"GET", "<unmatched>", "middleware"},
+                      phases->name() + "_count") == 1);
+    CHECK(sampleValue(phases,
+                      {"GET", "<unmatched>", "handler"},
+                      phases->name() + "_count") == 0);
+
+    // Beyond maxRoutes
+    answer(userPattern, k200OK, true);
+    answer(orderPattern, k200OK, true);
+    answer(cartPattern, k500InternalServerError, true);
+    CHECK(requestCount(requests, userPattern, "2xx") == 1);
+    CHECK(requestCount(requests, "<other>", "2xx") == 1);
+    CHECK(requestCount(requests, "<other>", "5xx") == 1);
+
+    // The connection closed before the response
+    auto &metrics = RequestMetrics::instance();
+    HttpRequestImpl req(nullptr);
+    req.setMethod(Get);
+    metrics.onRouting(req);
+    CHECK(sampleValue(inFlight, {}, inFlight->name()) == 1);
+    metrics.onResponseDropped(req);
+    CHECK(sampleValue(inFlight, {}, inFlight->name()) == 0);
+}
@@ -0,0 +1,71 @@
+#include "../../lib/src/RouteTree.h"
+#include <drogon/drogon_test.h>
+
+using namespace drogon;
+
+DROGON_TEST(RouteTreeTest)
+{
+    RouteTree tree;
+    CHECK(tree.empty());
+    CHECK(tree.insert("/api/User/([^/]*)/info", 0));
+    CHECK(tree.insert("/api/([^/]*)/([^/]*)", 1));
+    CHECK(tree.insert("/api/user/([^/]*)", 2));
+    // Patterns that need regex features are rejected
+    CHECK(tree.insert("/api/a.b/([^/]*)", 3) == false);
+    CHECK(tree.insert("/api/v([^/]*)/list", 4) == false);
+    CHECK(tree.insert("api/([^/]*)", 5) == false);
+    CHECK(tree.empty() == false);
+
+    RouteTree::Captures captures;
+    size_t count{0};
+    auto all = [](size_t) { return true; };
+    auto none = [](size_t) { return false; };
+
+    SUBSECTION(Literal)
+    {
+        CHECK(tree.match("/api/user/42/info", all, captures, count) == 0);
+        REQUIRE(count == 1);
+        CHECK(captures[0] == "42");
+    }
+
+    SUBSECTION(FirstRegisteredWins)
+    {
+        CHECK(tree.match("/api/user/42", all, captures, count) == 1);
+        REQUIRE(count == 2);
+        CHECK(captures[0] == "user");
+        CHECK(captures[1] == "42");
+    }
+
+    SUBSECTION(Predicate)
+    {
+        auto onlyTwo = [](size_t i) { return i == 2; };
+        CHECK(tree.match("/api/user/42", onlyTwo, captures, count) == 2);
+        REQUIRE(count == 1);
+        CHECK(captures[0] == "42");
+    }
+
+    SUBSECTION(EmptySegment)
+    {
+        CHECK(tree.match("/api/user/", all, captures, count) == 1);
+        REQUIRE(count == 2);
+        CHECK(captures[1].empty());
+    }
+
+    SUBSECTION(NotFound)
+    {
+        CHECK(tree.match("/api", all, captures, count) == RouteTree::npos);
+        CHECK(tree.match("/api/user/42/info/more", all, captures, count) ==
+              RouteTree::npos);
+        CHECK(tree.match("/api/user/42", none, captures, count) ==
+              RouteTree::npos);
+        CHECK(tree.match("", all, captures, count) == RouteTree::npos);
+    }
+
+    SUBSECTION(Clear)
+    {
+        tree.clear();
+        CHECK(tree.empty());
+        CHECK(tree.match("/api/user/42", all, captures, count) ==
+              RouteTree::npos);
+    }
+}
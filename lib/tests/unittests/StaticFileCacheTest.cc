@@ -0,0 +1,68 @@
+#include <drogon/drogon_test.h>
+#include <drogon/HttpResponse.h>
+#include "../../lib/src/StaticFileCache.h"
+
+using namespace drogon;
+
+static StaticFileCache::EntryPtr makeEntry(size_t bodySize)
+{
+    auto entry = std::make_shared<StaticFileCache::Entry>();
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setBody(std::string(bodySize, 'x'));
+    entry->variants[StaticFileCache::kIdentity] = resp;
+    return entry;
+}
+
+DROGON_TEST(StaticFileCacheLru)
+{
+    StaticFileCache cache;
+    cache.setCapacity(1000);
+    cache.insert("/a", makeEntry(300));
+    cache.insert("/b", makeEntry(300));
+    cache.insert("/c", makeEntry(300));
+    CHECK(cache.size() == 906);
+
+    // Touch /a, so /b is the least recently used
+    CHECK(cache.find("/a") != nullptr);
+    cache.insert("/d", makeEntry(300));
+    CHECK(cache.find("/b") == nullptr);
+    CHECK(cache.find("/a") != nullptr);
+    CHECK(cache.find("/c") != nullptr);
+    CHECK(cache.find("/d") != nullptr);
+    CHECK(cache.size() == 906);
+
+    // Too large for the cache
+    cache.insert("/e", makeEntry(2000));
+    CHECK(cache.find("/e") == nullptr);
+    CHECK(cache.size() == 906);
+
+    // Replacing an entry doesn't count it twice
+    cache.insert("/a", makeEntry(100));
+    CHECK(cache.size() == 706);
+
+    cache.erase("/c");
+    CHECK(cache.find("/c") == nullptr);
+    CHECK(cache.size() == 404);
+
+    // Shrinking takes effect on the next insertion
+    cache.setCapacity(300);
+    cache.insert("/f", makeEntry(10));
+    CHECK(cache.find("/d") == nullptr);
+    CHECK(cache.find("/a") != nullptr);
+    CHECK(cache.find("/f") != nullptr);
+    CHECK(cache.size() == 114);
+}
+
+DROGON_TEST(StaticFileCacheExpiry)
+{
+    StaticFileCache cache;
+    auto entry = std::make_shared<StaticFileCache::Entry>();
+    entry->expiry = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+    cache.insert("/old", entry);
+    CHECK(cache.find("/old") == nullptr);
+    CHECK(cache.size() == 0);
+
+    entry = std::make_shared<StaticFileCache::Entry>();
+    cache.insert("/forever", entry);
+    CHECK(cache.find("/forever") == entry);
+}
@@ -0,0 +1,97 @@
+#include <drogon/drogon_test.h>
+#include <drogon/utils/Utilities.h>
+#include "../../lib/src/StreamEncoder.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+static std::string decompress(StreamEncoder::Encoding encoding,
+                              const std::string &data)
+{
+    switch (encoding)
+    {
+        case StreamEncoder::kBrotli:
+            return utils::brotliDecompress(data.data(), data.length());
+        case StreamEncoder::kZstd:
+            return utils::zstdDecompress(data.data(), data.length());
+        default:
+            return utils::gzipDecompress(data.data(), data.length());
+    }
+}
+
+static std::vector<StreamEncoder::Encoding> supportedEncodings()
+{
+    std::vector<StreamEncoder::Encoding> encodings{StreamEncoder::kGzip};
+#ifdef USE_BROTLI
+    encodings.push_back(StreamEncoder::kBrotli);
+#endif
+#ifdef USE_ZSTD
+    encodings.push_back(StreamEncoder::kZstd);
+#endif
+    return encodings;
+}
+
+DROGON_TEST(StreamEncoderFlush)
+{
+    for (auto encoding : supportedEncodings())
+    {
+        auto encoder = StreamEncoder::newEncoder(encoding);
+        REQUIRE(encoder != nullptr);
+        std::string event = "data: {\"id\": 1, \"value\": \"hello\"}\n\n";
+        std::string out;
+        CHECK(encoder->compress(event.data(), event.length(), true, out));
+        // Everything given before a flush can be decoded
+        CHECK(!out.empty());
+        std::string all = event;
+        for (int i = 0; i < 100; ++i)
+        {
+            CHECK(encoder->compress(event.data(), event.length(), false, out));
+            all += event;
+        }
+        CHECK(encoder->finish(out));
+        CHECK(decompress(encoding, out) == all);
+        // Repeated events compress well
+        CHECK(out.length() < all.length() / 4);
+    }
+}
+
+DROGON_TEST(StreamEncoderCallback)
+{
+    std::string body;
+    for (size_t i = 0; i < 20000; ++i)
+    {
+        body.append(std::to_string(i));
+    }
+    for (auto encoding : supportedEncodings())
+    {
+        size_t pos = 0;
+        bool cleanedUp = false;
+        auto callback = compressStreamCallback(
+            [&](char *buffer, size_t size) -> size_t {
+                if (!buffer)
+                {
+                    cleanedUp = true;
+                    return 0;
+                }
+                // Short reads, like a producer waiting for data
+                auto len = (std::min)({size, body.length() - pos, size_t(700)});
+                memcpy(buffer, body.data() + pos, len);
+                pos += len;
+                return len;
+            },
+            StreamEncoder::newEncoder(encoding),
+            4096);
+        std::string out;
+        char buffer[1000];
+        while (auto len = callback(buffer, sizeof(buffer)))
+        {
+            out.append(buffer, len);
+        }
+        callback(nullptr, 0);
+        CHECK(cleanedUp);
+        CHECK(decompress(encoding, out) == body);
+    }
+}
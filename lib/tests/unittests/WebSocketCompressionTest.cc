@@ -0,0 +1,193 @@
+#include <drogon/drogon_test.h>
+#include "../../lib/src/WebSocketCompression.h"
+#include <limits>
+#include <string>
+
+using namespace drogon;
+
+static const size_t unlimited = (std::numeric_limits<size_t>::max)();
+
+static std::string feedMessage(int i)
+{
+    return R"({"type":"quote","symbol":"DRGN","price":)" +
+           std::to_string(100 + i % 7) + R"(,"volume":)" +
+           std::to_string(1000 + i) + R"(,"exchange":"example"})";
+}
+
+DROGON_TEST(WebSocketDeflateNegotiation)
+{
+    WebSocketCompressionOptions server;
+    WebSocketDeflateParams params;
+    std::string response;
+
+    // The default offer of the clients of drogon
+    auto offer = makeDeflateOffer(WebSocketCompressionOptions{});
+    CHECK(offer == "permessage-deflate; client_max_window_bits");
+    REQUIRE(acceptDeflateOffer(offer, server, params, response));
+    CHECK(response == "permessage-deflate");
+    CHECK(params.serverNoContextTakeover == false);
+    CHECK(params.clientMaxWindowBits == 15);
+
+    // The parameters of the client are accepted, limited by the server
+    server.serverMaxWindowBits = 12;
+    REQUIRE(acceptDeflateOffer(
+        "permessage-deflate; server_no_context_takeover; "
+        "server_max_window_bits=14; client_max_window_bits",
+        server,
+        params,
+        response));
+    CHECK(response ==
+          "permessage-deflate; server_no_context_takeover; "
+          "server_max_window_bits=12");
+    CHECK(params.serverNoContextTakeover);
+    CHECK(params.serverMaxWindowBits == 12);
+
+    // The invalid offers are skipped
+    CHECK(!acceptDeflateOffer(
+        "x-webkit-deflate-frame", server, params, response));
+    CHECK(!acceptDeflateOffer(
+        "permessage-deflate; unknown", server, params, response));
+    CHECK(!acceptDeflateOffer("permessage-deflate; server_max_window_bits=7",
+                              server,
+                              params,
+                              response));
+    CHECK(!acceptDeflateOffer(
+        "permessage-deflate; client_max_window_bits; client_max_window_bits",
+        server,
+        params,
+        response));
+    REQUIRE(acceptDeflateOffer(
+        "permessage-deflate; server_max_window_bits=\"ten\", "
+        "permessage-deflate; client_max_window_bits=\"10\"",
+        server,
+        params,
+        response));
+    CHECK(params.clientMaxWindowBits == 10);
+
+    // The responses of the servers
+    WebSocketCompressionOptions client;
+    bool enabled{true};
+    CHECK(parseDeflateResponse("", client, params, enabled));
+    CHECK(!enabled);
+    CHECK(parseDeflateResponse("permessage-deflate; client_max_window_bits=9",
+                               client,
+                               params,
+                               enabled));
+    CHECK(enabled);
+    CHECK(params.clientMaxWindowBits == 9);
+    CHECK(!parseDeflateResponse("permessage-deflate; unknown=1",
+                                client,
+                                params,
+                                enabled));
+    CHECK(!parseDeflateResponse("permessage-deflate, permessage-deflate",
+                                client,
+                                params,
+                                enabled));
+    // The server must accept the limits offered for its own side
+    client.serverContextTakeover = false;
+    CHECK(!parseDeflateResponse("permessage-deflate", client, params, enabled));
+}
+
+DROGON_TEST(WebSocketDeflateDictionary)
+{
+    WebSocketCompressionOptions withDictionary;
+    withDictionary.dictionary = feedMessage(0);
+    WebSocketCompressionOptions without;
+    WebSocketDeflateParams params;
+    std::string response;
+
+    // Servers without the dictionary accept the plain offer
+    auto offer = makeDeflateOffer(withDictionary);
+    REQUIRE(acceptDeflateOffer(offer, without, params, response));
+    CHECK(!params.useDictionary);
+    REQUIRE(acceptDeflateOffer(offer, withDictionary, params, response));
+    CHECK(params.useDictionary);
+    bool enabled{false};
+    REQUIRE(parseDeflateResponse(response, withDictionary, params, enabled));
+    CHECK(params.useDictionary);
+
+    WebSocketDeflater server(withDictionary, params, true);
+    WebSocketDeflater client(withDictionary, params, false);
+    WebSocketDeflater plain(without, WebSocketDeflateParams{}, true);
+    auto message = feedMessage(1);
+    std::string compressed, plainCompressed, decompressed;
+    REQUIRE(server.compress(message.data(), message.length(), compressed));
+    REQUIRE(plain.compress(message.data(), message.length(), plainCompressed));
+    CHECK(compressed.length() < plainCompressed.length());
+    REQUIRE(client.decompress(
+        compressed.data(), compressed.length(), decompressed, unlimited));
+    CHECK(decompressed == message);
+}
+
+DROGON_TEST(WebSocketDeflateRoundTrip)
+{
+    WebSocketCompressionOptions options;
+    for (auto takeover : {true, false})
+    {
+        WebSocketDeflateParams params;
+        params.serverNoContextTakeover = !takeover;
+        params.clientNoContextTakeover = !takeover;
+        WebSocketDeflater server(options, params, true);
+        WebSocketDeflater client(options, params, false);
+        size_t first{0}, last{0};
+        for (int i = 0; i < 20; ++i)
+        {
+            auto message = feedMessage(i);
+            std::string compressed, decompressed;
+            REQUIRE(
+                server.compress(message.data(), message.length(), compressed));
+            REQUIRE(client.decompress(compressed.data(),
+                                      compressed.length(),
+                                      decompressed,
+                                      unlimited));
+            CHECK(decompressed == message);
+            if (i == 0)
+                first = compressed.length();
+            last = compressed.length();
+        }
+        // The context makes the similar messages much smaller
+        if (takeover)
+            CHECK(last < first / 2);
+        else
+            CHECK(last >= first - 2);
+    }
+
+    // The messages larger than the limit are rejected
+    WebSocketDeflater server(options, WebSocketDeflateParams{}, true);
+    WebSocketDeflater client(options, WebSocketDeflateParams{}, false);
+    std::string message(100000, 'a'), compressed, decompressed;
+    REQUIRE(server.compress(message.data(), message.length(), compressed));
+    CHECK(compressed.length() < 1000);
+    CHECK(!client.decompress(
+        compressed.data(), compressed.length(), decompressed, 50000));
+
+    // Corrupt data is rejected
+    WebSocketDeflater other(options, WebSocketDeflateParams{}, false);
+    std::string garbage("\xff\xff\xff\xff\xff\xff", 6);
+    CHECK(!other.decompress(
+        garbage.data(), garbage.length(), decompressed, unlimited));
+
+    // The empty messages
+    WebSocketDeflater empty(options, WebSocketDeflateParams{}, true);
+    REQUIRE(empty.compress("", 0, compressed));
+    CHECK(compressed.length() == 1);
+    WebSocketDeflater emptyClient(options, WebSocketDeflateParams{}, false);
+    REQUIRE(emptyClient.decompress(
+        compressed.data(), compressed.length(), decompressed, unlimited));
+    CHECK(decompressed.empty());
+}
+
+DROGON_TEST(WebSocketDeflateMinSize)
+{
+    WebSocketCompressionOptions options;
+    options.minSize = 100;
+    WebSocketDeflater deflater(options, WebSocketDeflateParams{}, true);
+    CHECK(!deflater.shouldCompress(99));
+    CHECK(deflater.shouldCompress(100));
+
+    // zlib does not support raw windows of 8 bits
+    WebSocketDeflateParams params;
+    params.serverMaxWindowBits = 8;
+    WebSocketDeflater small(options, params, true);
+    CHECK(!small.shouldCompress(1000));
+}
@@ -0,0 +1,62 @@
+#include "../../lib/src/utils/WebSocketMask.h"
+#include <drogon/drogon_test.h>
+#include <random>
+#include <string>
+
+using namespace drogon::utils;
+
+DROGON_TEST(WebSocketMaskTest)
+{
+    const auto defaultKernel = std::string(webSocketMaskKernelName());
+
+    SUBSECTION(Basic)
+    {
+        // rfc6455-5.7, a masked "Hello"
+        const unsigned char key[4] = {0x37, 0xfa, 0x21, 0x3d};
+        std::string masked("\x7f\x9f\x4d\x51\x58", 5);
+        std::string data(5, '\0');
+        maskWebSocketData(&data[0], masked.data(), masked.size(), key);
+        CHECK(data == "Hello");
+        // Masking twice restores the data, in place
+        maskWebSocketData(&data[0], data.data(), data.size(), key);
+        CHECK(data == masked);
+        // The second part of a payload continues with the key
+        maskWebSocketData(&data[0], masked.data(), 2, key);
+        maskWebSocketData(&data[2], masked.data() + 2, 3, key, 2);
+        CHECK(data == "Hello");
+    }
+
+    SUBSECTION(KernelsAgree)
+    {
+        std::mt19937 rng(42);
+        const char *kernels[] = {"scalar", "sse2", "avx2"};
+        for (int iteration = 0; iteration < 500; ++iteration)
+        {
+            std::string data(rng() % 300, '\0');
+            for (auto &c : data)
+                c = static_cast<char>(rng() % 256);
+            const unsigned char key[4] = {static_cast<unsigned char>(rng()),
+                                          static_cast<unsigned char>(rng()),
+                                          static_cast<unsigned char>(rng()),
+                                          static_cast<unsigned char>(rng())};
+            size_t offset = rng() % 4;
+            std::string expected(data.size(), '\0');
+            for (size_t i = 0; i < data.size(); ++i)
+                expected[i] = data[i] ^ key[(offset + i) % 4];
+            for (auto kernel : kernels)
+            {
+                if (!internal::setWebSocketMaskKernel(kernel))
+                    continue;
+                std::string result(data.size(), '\0');
+                maskWebSocketData(
+                    &result[0], data.data(), data.size(), key, offset);
+                CHECK(result == expected);
+                result = data;
+                maskWebSocketData(
+                    &result[0], result.data(), result.size(), key, offset);
+                CHECK(result == expected);
+            }
+        }
+        internal::setWebSocketMaskKernel(defaultKernel.c_str());
+    }
+}
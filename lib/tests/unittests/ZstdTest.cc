@@ -0,0 +1,29 @@
+#include <drogon/utils/Utilities.h>
+#include <drogon/drogon_test.h>
+#include <string>
+using namespace drogon::utils;
+
+DROGON_TEST(ZstdTest)
+{
+    SUBSECTION(shortText)
+    {
+        std::string source{"123中文顶替要枯械"};
+        auto compressed = zstdCompress(source.data(), source.length());
+        auto decompressed =
+            zstdDecompress(compressed.data(), compressed.length());
+        CHECK(source == decompressed);
+    }
+
+    SUBSECTION(longText)
+    {
+        std::string source;
+        for (size_t i = 0; i < 100000; i++)
+        {
+            source.append(std::to_string(i));
+        }
+        auto compressed = zstdCompress(source.data(), source.length());
+        auto decompressed =
+            zstdDecompress(compressed.data(), compressed.length());
+        CHECK(source == decompressed);
+    }
+}
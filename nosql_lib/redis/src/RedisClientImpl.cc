@@ -16,6 +16,7 @@
 #include "RedisClientImpl.h"
 #include "RedisSubscriberImpl.h"
 #include "RedisTransactionImpl.h"
+#include "../../lib/src/LoopMetrics.h"
 #include "../../lib/src/TaskTimeoutFlag.h"
 
 using namespace drogon::nosql;
@@ -53,6 +54,10 @@ RedisClientImpl::RedisClientImpl(const trantor::InetAddress &serverAddress,
 void RedisClientImpl::init()
 {
     loops_.start();
+    for (auto loop : loops_.getLoops())
+    {
+        LoopMetrics::instance().watch(loop, "redis");
+    }
     for (size_t i = 0; i < numberOfConnections_; ++i)
     {
         auto loop = loops_.getNextLoop();
@@ -238,6 +243,10 @@ void RedisClientImpl::execCommandAsync(
 RedisClientImpl::~RedisClientImpl()
 {
     closeAll();
+    for (auto loop : loops_.getLoops())
+    {
+        LoopMetrics::instance().unwatch(loop);
+    }
 }
 
 void RedisClientImpl::closeAll()
@@ -14,6 +14,7 @@
 
 #include "DbClientImpl.h"
 #include "DbConnection.h"
+#include "../../lib/src/LoopMetrics.h"
 #include "../../lib/src/TaskTimeoutFlag.h"
 #include <drogon/config.h>
 #include <string_view>
@@ -76,6 +77,10 @@ void DbClientImpl::init()
 {
     // LOG_DEBUG << loops_.getLoopNum();
     loops_.start();
+    for (auto loop : loops_.getLoops())
+    {
+        LoopMetrics::instance().watch(loop, "db");
+    }
     if (type_ == ClientType::PostgreSQL || type_ == ClientType::Mysql)
     {
         for (size_t i = 0; i < numberOfConnections_; ++i)
@@ -99,6 +104,10 @@ void DbClientImpl::init()
 DbClientImpl::~DbClientImpl() noexcept
 {
     closeAll();
+    for (auto loop : loops_.getLoops())
+    {
+        LoopMetrics::instance().unwatch(loop);
+    }
 }
 
 void DbClientImpl::closeAll()